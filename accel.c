@@ -0,0 +1,160 @@
+#include <math.h>
+#include <string.h>
+
+#include "accel.h"
+
+void accel_default_params(accel_params_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->curve = ACCEL_CURVE_OFF;
+    p->offset = 2;
+    p->accel = 26;         // ~0.1 per count/ms
+    p->exponent = 256;     // 1.0
+    p->cap = 4 * ACCEL_Q8_ONE;
+    p->midpoint = 20;
+    p->max_speed = 255;
+}
+
+static float curve_points(const accel_params_t *p, float v)
+{
+    if (p->n_points == 0)
+    {
+        return 1.0f;
+    }
+    if (v <= p->points[0].speed)
+    {
+        return p->points[0].gain / 256.0f;
+    }
+
+    for (uint8_t i = 1; i < p->n_points && i < ACCEL_POINTS_MAX; i++)
+    {
+        const accel_point_t *a = &p->points[i - 1];
+        const accel_point_t *b = &p->points[i];
+        if (v <= b->speed)
+        {
+            float t = b->speed > a->speed ? (v - a->speed) / (float)(b->speed - a->speed) : 1.0f;
+            return (a->gain + t * (b->gain - a->gain)) / 256.0f;
+        }
+    }
+
+    uint8_t last = p->n_points < ACCEL_POINTS_MAX ? p->n_points - 1 : ACCEL_POINTS_MAX - 1;
+    return p->points[last].gain / 256.0f;
+}
+
+uint16_t accel_gain_direct(const accel_params_t *p, uint32_t speed_q4)
+{
+    float v = speed_q4 / 16.0f;
+    float k = p->accel / 256.0f;
+    float over = v > p->offset ? v - p->offset : 0.0f;
+    float gain;
+
+    switch (p->curve)
+    {
+    case ACCEL_CURVE_LINEAR:
+        gain = 1.0f + k * over;
+        break;
+    case ACCEL_CURVE_POWER:
+        gain = 1.0f + powf(k * over, p->exponent / 256.0f);
+        break;
+    case ACCEL_CURVE_SIGMOID:
+    {
+        float cap = p->cap ? p->cap / 256.0f : 2.0f;
+        gain = 1.0f + (cap - 1.0f) / (1.0f + expf(-k * (v - p->midpoint)));
+        break;
+    }
+    case ACCEL_CURVE_POINTS:
+        gain = curve_points(p, v);
+        break;
+    case ACCEL_CURVE_OFF:
+    default:
+        gain = 1.0f;
+        break;
+    }
+
+    if (p->cap && gain > p->cap / 256.0f)
+    {
+        gain = p->cap / 256.0f;
+    }
+    if (gain < 0.0f)
+    {
+        gain = 0.0f;
+    }
+
+    float q8 = gain * 256.0f + 0.5f;
+    return q8 > UINT16_MAX ? UINT16_MAX : (uint16_t)q8;
+}
+
+void accel_init(accel_t *a)
+{
+    memset(a, 0, sizeof(*a));
+    accel_default_params(&a->params);
+    for (int i = 0; i < ACCEL_LUT_SIZE; i++)
+    {
+        a->lut[i] = ACCEL_Q8_ONE;
+    }
+}
+
+bool accel_configure(accel_t *a, const accel_params_t *p)
+{
+    if (memcmp(&a->params, p, sizeof(*p)) == 0)
+    {
+        return false;
+    }
+
+    // smallest shift that maps max_speed (Q4) into the table
+    uint32_t top = (uint32_t)(p->max_speed ? p->max_speed : 1) << 4;
+    uint8_t shift = 0;
+    while ((top >> shift) >= ACCEL_LUT_SIZE)
+    {
+        shift++;
+    }
+
+    for (uint32_t i = 0; i < ACCEL_LUT_SIZE; i++)
+    {
+        // sample each bucket at its centre
+        uint32_t speed_q4 = (i << shift) + ((1u << shift) >> 1);
+        a->lut[i] = accel_gain_direct(p, speed_q4);
+    }
+
+    a->params = *p;
+    a->shift = shift;
+    a->enabled = p->curve != ACCEL_CURVE_OFF;
+
+    return true;
+}
+
+static inline int16_t scale(int16_t d, uint16_t gain, int32_t *rem)
+{
+    int32_t v = (int32_t)d * gain + *rem;
+    int32_t out = v >> 8;
+
+    *rem = v - (out << 8);
+    if (out > INT16_MAX)
+    {
+        out = INT16_MAX;
+    }
+    if (out < INT16_MIN)
+    {
+        out = INT16_MIN;
+    }
+    return (int16_t)out;
+}
+
+void accel_apply(accel_t *a, int16_t *dx, int16_t *dy, uint32_t dt_us)
+{
+    if (!a->enabled)
+    {
+        return;
+    }
+
+    uint16_t gain = accel_gain_lut(a, accel_speed_q4(*dx, *dy, dt_us));
+
+    *dx = scale(*dx, gain, &a->rem_x);
+    *dy = scale(*dy, gain, &a->rem_y);
+}
+
+void accel_reset(accel_t *a)
+{
+    a->rem_x = 0;
+    a->rem_y = 0;
+}
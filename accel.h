@@ -0,0 +1,111 @@
+#ifndef ACCEL_H
+#define ACCEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Pointer acceleration. The gain curve is evaluated once into a fixed-point
+ * table when the parameters change; per sample the cost is one speed estimate,
+ * one table load and two multiplies.
+ *
+ * Units: speed in counts per millisecond, Q4 (16 = 1 count/ms). Gains Q8 (256 = 1.0).
+ */
+
+#define ACCEL_LUT_SIZE 256
+#define ACCEL_POINTS_MAX 8
+
+#define ACCEL_Q8_ONE 256
+
+typedef enum
+{
+    ACCEL_CURVE_OFF = 0,
+    ACCEL_CURVE_LINEAR,  // 1 + accel * (v - offset)
+    ACCEL_CURVE_POWER,   // 1 + (accel * (v - offset)) ^ exponent
+    ACCEL_CURVE_SIGMOID, // 1 + (cap - 1) / (1 + e^(-accel * (v - midpoint)))
+    ACCEL_CURVE_POINTS,  // piecewise linear through points[]
+} accel_curve_t;
+
+typedef struct
+{
+    uint16_t speed; // counts/ms
+    uint16_t gain;  // Q8
+} accel_point_t;
+
+typedef struct
+{
+    uint8_t curve;        // accel_curve_t
+    uint8_t n_points;
+    uint16_t offset;      // counts/ms with no acceleration
+    uint16_t accel;       // Q8, slope / scale / steepness per curve
+    uint16_t exponent;    // Q8, power curve only
+    uint16_t cap;         // Q8, maximum gain, 0 = uncapped
+    uint16_t midpoint;    // counts/ms, sigmoid only
+    uint16_t max_speed;   // counts/ms covered by the table, faster samples use the last entry
+    accel_point_t points[ACCEL_POINTS_MAX]; // ascending speed
+} accel_params_t;
+
+typedef struct
+{
+    accel_params_t params;
+    uint16_t lut[ACCEL_LUT_SIZE];
+    uint8_t shift; // speed_q4 >> shift = table index
+    bool enabled;
+    int32_t rem_x; // sub-count remainders, Q8
+    int32_t rem_y;
+} accel_t;
+
+void accel_default_params(accel_params_t *p);
+
+void accel_init(accel_t *a);
+
+/**
+ * @brief Apply new parameters, rebuilding the table only if they differ.
+ *        Not safe against a concurrent accel_apply(): while samples flow,
+ *        configure a copy and hand the whole accel_t over between bursts.
+ * @return true if the table was rebuilt
+ */
+bool accel_configure(accel_t *a, const accel_params_t *p);
+
+/**
+ * @brief Reference evaluation of the curve (floating point), used to build the table.
+ * @return gain Q8
+ */
+uint16_t accel_gain_direct(const accel_params_t *p, uint32_t speed_q4);
+
+/**
+ * @brief Speed of a sample in counts/ms Q4, using max + 3/8 min for |v|.
+ */
+static inline uint32_t accel_speed_q4(int16_t dx, int16_t dy, uint32_t dt_us)
+{
+    uint32_t ax = dx < 0 ? -dx : dx;
+    uint32_t ay = dy < 0 ? -dy : dy;
+    uint32_t hi = ax > ay ? ax : ay;
+    uint32_t lo = ax > ay ? ay : ax;
+    uint32_t mag = hi + ((3 * lo) >> 3);
+
+    if (dt_us == 0)
+    {
+        dt_us = 1;
+    }
+    return (mag * 16000u) / dt_us;
+}
+
+static inline uint16_t accel_gain_lut(const accel_t *a, uint32_t speed_q4)
+{
+    uint32_t i = speed_q4 >> a->shift;
+    return a->lut[i < ACCEL_LUT_SIZE ? i : ACCEL_LUT_SIZE - 1];
+}
+
+/**
+ * @brief Scale one sample in place. Fractions are carried to the next sample, so
+ *        slow motion under a gain below 1 is not lost.
+ */
+void accel_apply(accel_t *a, int16_t *dx, int16_t *dy, uint32_t dt_us);
+
+/**
+ * @brief Drop carried remainders, call when motion stops.
+ */
+void accel_reset(accel_t *a);
+
+#endif
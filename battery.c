@@ -0,0 +1,165 @@
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_adc/adc_oneshot.h"
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_log.h"
+
+#include "pins.h"
+#include "nimble.h"
+#include "battery_level.h"
+#include "battery.h"
+
+static const char *TAG = "battery";
+
+#ifndef CONFIG_BATTERY_ADC_GPIO
+#define CONFIG_BATTERY_ADC_GPIO BATTERY_ADC_GPIO
+#endif
+#ifndef CONFIG_BATTERY_DIVIDER_MUL
+#define CONFIG_BATTERY_DIVIDER_MUL 2 /* cell mV = pin mV * MUL / DIV */
+#endif
+#ifndef CONFIG_BATTERY_DIVIDER_DIV
+#define CONFIG_BATTERY_DIVIDER_DIV 1
+#endif
+#ifndef CONFIG_BATTERY_SAMPLE_PERIOD_MS
+#define CONFIG_BATTERY_SAMPLE_PERIOD_MS 30000
+#endif
+#ifndef CONFIG_BATTERY_OVERSAMPLE
+#define CONFIG_BATTERY_OVERSAMPLE 16
+#endif
+#ifndef CONFIG_BATTERY_FILTER_SHIFT
+#define CONFIG_BATTERY_FILTER_SHIFT 2 /* EMA weight 1/4 per sample period */
+#endif
+#ifndef CONFIG_BATTERY_HYSTERESIS
+#define CONFIG_BATTERY_HYSTERESIS 2 /* percent */
+#endif
+
+static adc_oneshot_unit_handle_t adc_handle;
+static adc_cali_handle_t cali_handle;
+static adc_channel_t adc_channel;
+
+static battery_monitor_t monitor;
+static volatile uint8_t level = 100;
+static volatile uint16_t voltage_mv;
+
+// pin millivolts, the divider is applied by battery_monitor_update()
+static esp_err_t sample_pin_mv(uint16_t *samples)
+{
+    for (int i = 0; i < CONFIG_BATTERY_OVERSAMPLE; i++)
+    {
+        int raw = 0;
+        esp_err_t ret = adc_oneshot_read(adc_handle, adc_channel, &raw);
+        if (ret != ESP_OK)
+        {
+            return ret;
+        }
+
+        int pin_mv = 0;
+        if (cali_handle == NULL || adc_cali_raw_to_voltage(cali_handle, raw, &pin_mv) != ESP_OK)
+        {
+            pin_mv = raw * 3300 / 4095; // uncalibrated fallback
+        }
+        samples[i] = (uint16_t)pin_mv;
+    }
+
+    return ESP_OK;
+}
+
+static void battery_task(void *pv)
+{
+    (void)pv;
+    uint16_t samples[CONFIG_BATTERY_OVERSAMPLE];
+
+    for (;;)
+    {
+        if (sample_pin_mv(samples) == ESP_OK)
+        {
+            bool notify = battery_monitor_update(&monitor, samples, CONFIG_BATTERY_OVERSAMPLE);
+
+            voltage_mv = monitor.voltage_mv;
+            level = monitor.level;
+            if (notify)
+            {
+                ble_hid_battery_report(level);
+                ESP_LOGI(TAG, "battery %umV %u%%", voltage_mv, level);
+            }
+        }
+        else
+        {
+            ESP_LOGW(TAG, "adc read failed");
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_BATTERY_SAMPLE_PERIOD_MS));
+    }
+}
+
+esp_err_t wake_battery(void)
+{
+    esp_err_t ret;
+    adc_unit_t unit;
+
+    ret = adc_oneshot_io_to_channel(CONFIG_BATTERY_ADC_GPIO, &unit, &adc_channel);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "GPIO%d is not an ADC pin", CONFIG_BATTERY_ADC_GPIO);
+        return ret;
+    }
+
+    adc_oneshot_unit_init_cfg_t unit_cfg = {
+        .unit_id = unit,
+    };
+    ret = adc_oneshot_new_unit(&unit_cfg, &adc_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "adc unit init failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    adc_oneshot_chan_cfg_t chan_cfg = {
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    ret = adc_oneshot_config_channel(adc_handle, adc_channel, &chan_cfg);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "adc channel config failed: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+#if ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+    adc_cali_line_fitting_config_t cali_cfg = {
+        .unit_id = unit,
+        .atten = ADC_ATTEN_DB_12,
+        .bitwidth = ADC_BITWIDTH_DEFAULT,
+    };
+    if (adc_cali_create_scheme_line_fitting(&cali_cfg, &cali_handle) != ESP_OK)
+    {
+        ESP_LOGW(TAG, "no adc calibration, using raw scale");
+        cali_handle = NULL;
+    }
+#endif
+
+    battery_monitor_init(&monitor, CONFIG_BATTERY_FILTER_SHIFT, CONFIG_BATTERY_HYSTERESIS, CONFIG_BATTERY_DIVIDER_MUL,
+                         CONFIG_BATTERY_DIVIDER_DIV);
+
+    // lowest priority: one burst of ADC reads every sample period, never in the way of the input tasks
+    if (xTaskCreate(battery_task, "battery_task", 2048, NULL, tskIDLE_PRIORITY, NULL) != pdPASS)
+    {
+        ESP_LOGE(TAG, "xTaskCreate battery_task failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
+
+uint8_t battery_level(void)
+{
+    return level;
+}
+
+uint16_t battery_voltage_mv(void)
+{
+    return voltage_mv;
+}
@@ -0,0 +1,23 @@
+#ifndef BATTERY_H
+#define BATTERY_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+/**
+ * @brief Set up the battery ADC channel and start the low priority sampling task.
+ *        The level is pushed to the BLE battery service only when it changes.
+ */
+esp_err_t wake_battery(void);
+
+/**
+ * @brief Last reported battery level in percent, 100 until the first sample is taken.
+ */
+uint8_t battery_level(void);
+
+/**
+ * @brief Last filtered cell voltage in millivolts, 0 until the first sample is taken.
+ */
+uint16_t battery_voltage_mv(void);
+
+#endif
@@ -0,0 +1,151 @@
+#include "battery_level.h"
+
+const battery_curve_point_t battery_curve_lipo[] = {
+    {4200, 100},
+    {4100, 90},
+    {4000, 78},
+    {3900, 65},
+    {3800, 50},
+    {3750, 40},
+    {3700, 30},
+    {3650, 20},
+    {3600, 12},
+    {3500, 5},
+    {3300, 0},
+};
+
+const size_t battery_curve_lipo_len = sizeof(battery_curve_lipo) / sizeof(battery_curve_lipo[0]);
+
+uint16_t battery_oversample(const uint16_t *samples, size_t n)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    uint32_t sum = 0;
+    uint16_t lo = UINT16_MAX;
+    uint16_t hi = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        sum += samples[i];
+        if (samples[i] < lo)
+        {
+            lo = samples[i];
+        }
+        if (samples[i] > hi)
+        {
+            hi = samples[i];
+        }
+    }
+
+    if (n < 3)
+    {
+        return (uint16_t)(sum / n);
+    }
+
+    // trimmed mean: one outlier on either side does not move the result
+    return (uint16_t)((sum - lo - hi) / (n - 2));
+}
+
+void battery_filter_init(battery_filter_t *f, uint8_t shift)
+{
+    f->mv_q8 = 0;
+    f->shift = shift;
+    f->primed = false;
+}
+
+uint16_t battery_filter_update(battery_filter_t *f, uint16_t mv)
+{
+    uint32_t in_q8 = (uint32_t)mv << 8;
+
+    if (!f->primed)
+    {
+        f->mv_q8 = in_q8;
+        f->primed = true;
+    }
+    else
+    {
+        // y += (x - y) / 2^shift, done in signed arithmetic since x can be below y
+        int32_t diff = (int32_t)in_q8 - (int32_t)f->mv_q8;
+        f->mv_q8 = (uint32_t)((int32_t)f->mv_q8 + (diff >> f->shift));
+    }
+
+    return (uint16_t)((f->mv_q8 + 0x80) >> 8);
+}
+
+uint8_t battery_curve_lookup(const battery_curve_point_t *curve, size_t n, uint16_t mv)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    if (mv >= curve[0].mv)
+    {
+        return curve[0].percent;
+    }
+
+    for (size_t i = 1; i < n; i++)
+    {
+        if (mv >= curve[i].mv)
+        {
+            const battery_curve_point_t *hi = &curve[i - 1];
+            const battery_curve_point_t *lo = &curve[i];
+            uint32_t span_mv = hi->mv - lo->mv;
+            uint32_t span_pct = hi->percent - lo->percent;
+
+            return (uint8_t)(lo->percent + ((mv - lo->mv) * span_pct + span_mv / 2) / span_mv);
+        }
+    }
+
+    return curve[n - 1].percent;
+}
+
+uint8_t battery_level_hysteresis(uint8_t reported, uint8_t measured, uint8_t band)
+{
+    // always let the extremes through so "full" and "empty" are reported exactly
+    if (measured == 0 || measured == 100)
+    {
+        return measured;
+    }
+
+    if (measured + band < reported || measured > reported + band)
+    {
+        return measured;
+    }
+
+    return reported;
+}
+
+void battery_monitor_init(battery_monitor_t *m, uint8_t filter_shift, uint8_t band, uint16_t div_mul,
+                          uint16_t div_div)
+{
+    battery_filter_init(&m->filter, filter_shift);
+    m->div_mul = div_mul;
+    m->div_div = div_div ? div_div : 1;
+    m->band = band;
+    m->voltage_mv = 0;
+    m->level = 100;
+    m->reported = false;
+}
+
+bool battery_monitor_update(battery_monitor_t *m, const uint16_t *pin_mv, size_t n)
+{
+    uint32_t cell_mv = (uint32_t)battery_oversample(pin_mv, n) * m->div_mul / m->div_div;
+
+    m->voltage_mv = battery_filter_update(&m->filter, cell_mv > UINT16_MAX ? UINT16_MAX : (uint16_t)cell_mv);
+
+    uint8_t measured = battery_curve_lookup(battery_curve_lipo, battery_curve_lipo_len, m->voltage_mv);
+    uint8_t next = m->reported ? battery_level_hysteresis(m->level, measured, m->band) : measured;
+
+    if (m->reported && next == m->level)
+    {
+        return false;
+    }
+
+    m->level = next;
+    m->reported = true;
+    return true;
+}
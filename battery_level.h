@@ -0,0 +1,77 @@
+#ifndef BATTERY_LEVEL_H
+#define BATTERY_LEVEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Battery level math, kept free of ESP-IDF headers so it also builds on the host.
+ * battery.c does the ADC work and feeds millivolts in here.
+ */
+
+typedef struct
+{
+    uint16_t mv;     // cell voltage
+    uint8_t percent; // remaining capacity at that voltage
+} battery_curve_point_t;
+
+typedef struct
+{
+    uint32_t mv_q8; // filtered cell voltage, Q24.8
+    uint8_t shift;  // EMA weight is 1 / (1 << shift)
+    bool primed;
+} battery_filter_t;
+
+/* Everything battery_task() keeps between sample periods. */
+typedef struct
+{
+    battery_filter_t filter;
+    uint16_t div_mul;    // cell mV = pin mV * div_mul / div_div
+    uint16_t div_div;
+    uint8_t band;        // hysteresis, percent
+    uint16_t voltage_mv; // filtered cell voltage
+    uint8_t level;       // last reported percent
+    bool reported;
+} battery_monitor_t;
+
+/* Single-cell Li-ion/LiPo discharge curve, highest voltage first. */
+extern const battery_curve_point_t battery_curve_lipo[];
+extern const size_t battery_curve_lipo_len;
+
+/**
+ * @brief Average n raw samples, dropping the smallest and the largest one.
+ *        Falls back to a plain mean when n < 3.
+ */
+uint16_t battery_oversample(const uint16_t *samples, size_t n);
+
+void battery_filter_init(battery_filter_t *f, uint8_t shift);
+
+/**
+ * @brief Push one oversampled reading, return the filtered voltage.
+ *        The first reading primes the filter so boot does not ramp up from 0.
+ */
+uint16_t battery_filter_update(battery_filter_t *f, uint16_t mv);
+
+/**
+ * @brief Map voltage to percent by linear interpolation between curve points.
+ */
+uint8_t battery_curve_lookup(const battery_curve_point_t *curve, size_t n, uint16_t mv);
+
+/**
+ * @brief Only move the reported level once the new value leaves a +-band window,
+ *        so a level sitting on a boundary does not notify back and forth.
+ */
+uint8_t battery_level_hysteresis(uint8_t reported, uint8_t measured, uint8_t band);
+
+void battery_monitor_init(battery_monitor_t *m, uint8_t filter_shift, uint8_t band, uint16_t div_mul,
+                          uint16_t div_div);
+
+/**
+ * @brief One sample period from n raw pin readings (mV): oversample, divider,
+ *        filter, curve, hysteresis against the last reported level.
+ * @return true if the level is to be notified, always on the first call
+ */
+bool battery_monitor_update(battery_monitor_t *m, const uint16_t *pin_mv, size_t n);
+
+#endif
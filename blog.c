@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "blog.h"
+
+#define RING_MASK (CONFIG_BLOG_RING_LEN - 1)
+
+static const char *const formats[BLOG_EVENT_COUNT] = {
+#define BLOG_FMT(id, fmt) fmt,
+    BLOG_EVENTS(BLOG_FMT)
+#undef BLOG_FMT
+};
+
+void blog_write(blog_ring_t *r, uint16_t id, uint32_t t_us, uint8_t core, const uint32_t *args, size_t nargs)
+{
+    uint32_t n = __atomic_fetch_add(&r->head, 1, __ATOMIC_RELAXED);
+    blog_rec_t *rec = &r->rec[n & RING_MASK];
+
+    if (nargs > BLOG_ARGS_MAX)
+    {
+        nargs = BLOG_ARGS_MAX;
+    }
+
+    // invalidate first, so a reader cannot take half of this and half of the previous record
+    __atomic_store_n(&rec->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    rec->t_us = t_us;
+    rec->id = id;
+    rec->nargs = (uint8_t)nargs;
+    rec->core = core;
+    for (size_t i = 0; i < nargs; i++)
+    {
+        rec->arg[i] = args[i];
+    }
+    __atomic_store_n(&rec->seq, n + 1, __ATOMIC_RELEASE);
+}
+
+bool blog_read(blog_ring_t *r, uint32_t *cursor, blog_rec_t *out, uint32_t *lost)
+{
+    for (;;)
+    {
+        uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        uint32_t n = *cursor;
+
+        if (head == n)
+        {
+            return false;
+        }
+        if (head - n > CONFIG_BLOG_RING_LEN)
+        {
+            // lapped: everything older than one ring is gone
+            *lost += head - n - CONFIG_BLOG_RING_LEN;
+            *cursor = n = head - CONFIG_BLOG_RING_LEN;
+        }
+
+        const blog_rec_t *rec = &r->rec[n & RING_MASK];
+        uint32_t seq = __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE);
+        if (seq == 0 || (int32_t)(seq - (n + 1)) < 0)
+        {
+            return false; // claimed but not published yet, read it next time
+        }
+        if (seq != n + 1)
+        {
+            // a newer writer already took the slot
+            (*lost)++;
+            (*cursor)++;
+            continue;
+        }
+
+        *out = *rec;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&rec->seq, __ATOMIC_RELAXED) != seq)
+        {
+            // overwritten while copying
+            (*lost)++;
+            (*cursor)++;
+            continue;
+        }
+        out->seq = seq;
+        (*cursor)++;
+        return true;
+    }
+}
+
+const char *blog_format_str(uint16_t id)
+{
+    return id < BLOG_EVENT_COUNT ? formats[id] : NULL;
+}
+
+static const char hex[] = "0123456789abcdef";
+
+static char *put_hex(char *p, uint32_t v, int bytes)
+{
+    // little endian, byte by byte
+    for (int i = 0; i < bytes; i++, v >>= 8)
+    {
+        *p++ = hex[(v >> 4) & 0xF];
+        *p++ = hex[v & 0xF];
+    }
+    return p;
+}
+
+size_t blog_encode_line(const blog_rec_t *rec, char *buf, size_t cap)
+{
+    char *p = buf;
+    uint8_t nargs = rec->nargs > BLOG_ARGS_MAX ? BLOG_ARGS_MAX : rec->nargs;
+
+    if (cap < BLOG_LINE_MAX)
+    {
+        return 0;
+    }
+    *p++ = '@';
+    *p++ = 'B';
+    p = put_hex(p, rec->seq, 4);
+    p = put_hex(p, rec->t_us, 4);
+    p = put_hex(p, rec->id, 2);
+    p = put_hex(p, nargs, 1);
+    p = put_hex(p, rec->core, 1);
+    for (uint8_t i = 0; i < nargs; i++)
+    {
+        p = put_hex(p, rec->arg[i], 4);
+    }
+    *p++ = '\n';
+    *p = '\0';
+    return (size_t)(p - buf);
+}
+
+static int nibble(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static bool get_hex(const char **p, uint32_t *v, int bytes)
+{
+    *v = 0;
+    for (int i = 0; i < bytes; i++)
+    {
+        int hi = nibble((*p)[0]);
+        int lo = hi < 0 ? -1 : nibble((*p)[1]);
+        if (lo < 0)
+        {
+            return false;
+        }
+        *v |= (uint32_t)(hi << 4 | lo) << (8 * i);
+        *p += 2;
+    }
+    return true;
+}
+
+bool blog_decode_line(const char *line, blog_rec_t *rec)
+{
+    const char *p = strstr(line, "@B");
+    uint32_t v;
+
+    if (p == NULL)
+    {
+        return false;
+    }
+    p += 2;
+    memset(rec, 0, sizeof(*rec));
+
+    if (!get_hex(&p, &rec->seq, 4) || !get_hex(&p, &rec->t_us, 4) || !get_hex(&p, &v, 2))
+    {
+        return false;
+    }
+    rec->id = (uint16_t)v;
+    if (!get_hex(&p, &v, 1) || v > BLOG_ARGS_MAX)
+    {
+        return false;
+    }
+    rec->nargs = (uint8_t)v;
+    if (!get_hex(&p, &v, 1))
+    {
+        return false;
+    }
+    rec->core = (uint8_t)v;
+    for (uint8_t i = 0; i < rec->nargs; i++)
+    {
+        if (!get_hex(&p, &rec->arg[i], 4))
+        {
+            return false;
+        }
+    }
+    return *p == '\0' || *p == '\n' || *p == '\r';
+}
+
+bool blog_format(const blog_rec_t *rec, char *buf, size_t cap)
+{
+    const char *f = blog_format_str(rec->id);
+    size_t len = 0;
+    uint8_t used = 0;
+
+    if (f == NULL || cap == 0)
+    {
+        return false;
+    }
+
+    while (*f && len + 1 < cap)
+    {
+        if (*f != '%')
+        {
+            buf[len++] = *f++;
+            continue;
+        }
+        if (f[1] == '%')
+        {
+            buf[len++] = '%';
+            f += 2;
+            continue;
+        }
+
+        // one conversion at a time, so a format can never reach past the recorded arguments
+        char spec[16];
+        size_t n = 0;
+        spec[n++] = *f++;
+        while (*f && strchr("-+ #0123456789", *f) && n < sizeof(spec) - 2)
+        {
+            spec[n++] = *f++;
+        }
+        if (*f == '\0' || !strchr("diuxXc", *f) || used >= rec->nargs)
+        {
+            buf[len] = '\0';
+            return false;
+        }
+        char conv = *f++;
+        spec[n++] = conv;
+        spec[n] = '\0';
+
+        uint32_t a = rec->arg[used++];
+        int w = (conv == 'd' || conv == 'i' || conv == 'c') ? snprintf(buf + len, cap - len, spec, (int)(int32_t)a)
+                                                            : snprintf(buf + len, cap - len, spec, (unsigned)a);
+        if (w < 0)
+        {
+            buf[len] = '\0';
+            return false;
+        }
+        len += (size_t)w < cap - len ? (size_t)w : cap - len - 1;
+    }
+    buf[len] = '\0';
+    return true;
+}
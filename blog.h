@@ -0,0 +1,116 @@
+#ifndef BLOG_H
+#define BLOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+
+/*
+ * Binary log: a format id and up to four raw 32-bit arguments go into a RAM
+ * ring; nothing is formatted on the device. No IDF dependency.
+ *
+ * Writers from any task or core claim a slot with one atomic add and
+ * publish it through its sequence number, so logging never blocks and
+ * never takes a lock. When the reader falls behind, the oldest records are
+ * overwritten; the reader notices from the sequence numbers and counts them
+ * as lost. Records leave the device as "@B<hex>" lines (blog_encode_line())
+ * and tools/blog_decode.c turns them back into text with the table below.
+ *
+ * Formats only take integer conversions (d i u x X c with flags and width).
+ */
+
+#define BLOG_EVENTS(X)                                                                   \
+    X(HID_START, "hid start")                                                            \
+    X(HID_STOP, "hid stop")                                                              \
+    X(HID_CONNECT, "hid connect")                                                        \
+    X(HID_DISCONNECT, "hid disconnect; reason %d")                                       \
+    X(HID_UP, "hid start up")                                                            \
+    X(HID_DOWN, "hid shut down")                                                         \
+    X(HID_PROTOCOL, "protocol mode[%u] %u (0 boot, 1 report)")                           \
+    X(HID_CONTROL, "control[%u] %u (0 suspend, 1 exit suspend)")                         \
+    X(HID_OUTPUT, "output[%u] id %u len %u")                                             \
+    X(HID_FEATURE, "feature[%u] id %u len %u")                                           \
+    X(HID_DATA, "  %08x %08x %08x %08x")                                                 \
+    X(GAP_CONNECT, "gap connect; status %d handle %u")                                   \
+    X(GAP_DISCONNECT, "gap disconnect; reason %d")                                       \
+    X(GAP_CONN_UPDATE, "gap conn update; status %d")                                     \
+    X(GAP_CONN_PARAMS, "gap interval %u x 1.25 ms latency %u timeout %u x 10 ms")        \
+    X(GAP_CONN_REQUEST, "gap conn request; interval %u..%u latency %u")                  \
+    X(GAP_ADV_COMPLETE, "gap advertise complete; reason %d")                             \
+    X(GAP_SUBSCRIBE, "gap subscribe; handle %u attr %u notify %x indicate %x")           \
+    X(GAP_MTU, "gap mtu; handle %u cid %u mtu %u")                                       \
+    X(GAP_ENC_CHANGE, "gap encryption change; status %d")                                \
+    X(GAP_PASSKEY, "gap passkey action %u; inject %d")                                   \
+    X(CPI, "cpi %u x %u")                                                                \
+    X(SENSOR_MODE, "sensor mode %u")                                                     \
+    X(ACCEL_CURVE, "accel curve %d")
+
+typedef enum
+{
+#define BLOG_ENUM(id, fmt) BLOG_##id,
+    BLOG_EVENTS(BLOG_ENUM)
+#undef BLOG_ENUM
+    BLOG_EVENT_COUNT
+} blog_id_t;
+
+#ifndef CONFIG_BLOG_RING_LEN
+#define CONFIG_BLOG_RING_LEN 128 /* records, power of two */
+#endif
+
+#define BLOG_ARGS_MAX 4
+#define BLOG_LINE_MAX (2 + 2 * (12 + 4 * BLOG_ARGS_MAX) + 2) // "@B", hex, "\n", NUL
+
+_Static_assert((CONFIG_BLOG_RING_LEN & (CONFIG_BLOG_RING_LEN - 1)) == 0, "CONFIG_BLOG_RING_LEN must be a power of two");
+
+typedef struct
+{
+    uint32_t seq; // claim number + 1, 0 while the slot is being written
+    uint32_t t_us;
+    uint16_t id;
+    uint8_t nargs;
+    uint8_t core;
+    uint32_t arg[BLOG_ARGS_MAX];
+} blog_rec_t;
+
+typedef struct
+{
+    blog_rec_t rec[CONFIG_BLOG_RING_LEN];
+    uint32_t head; // claims so far
+} blog_ring_t;
+
+/**
+ * @brief Record one event, any context. Arguments past BLOG_ARGS_MAX are dropped.
+ */
+void blog_write(blog_ring_t *r, uint16_t id, uint32_t t_us, uint8_t core, const uint32_t *args, size_t nargs);
+
+/**
+ * @brief Single reader. Copies the record at *cursor and advances it.
+ * @param lost records overwritten before they could be read are added here
+ * @return false when nothing complete is left to read
+ */
+bool blog_read(blog_ring_t *r, uint32_t *cursor, blog_rec_t *out, uint32_t *lost);
+
+const char *blog_format_str(uint16_t id);
+
+/**
+ * @brief "@B" and the record in hex, newline terminated.
+ * @return length without the terminator
+ */
+size_t blog_encode_line(const blog_rec_t *rec, char *buf, size_t cap);
+
+/**
+ * @brief Parse a line written by blog_encode_line(), leading text before "@B" is skipped.
+ */
+bool blog_decode_line(const char *line, blog_rec_t *rec);
+
+/**
+ * @brief Expand the record's format with its arguments.
+ * @return false if the id is unknown or the format wants more arguments than recorded
+ */
+bool blog_format(const blog_rec_t *rec, char *buf, size_t cap);
+
+#endif
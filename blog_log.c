@@ -0,0 +1,55 @@
+#include <stdio.h>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
+#include "blog_log.h"
+
+#ifndef CONFIG_BLOG_DRAIN_MS
+#define CONFIG_BLOG_DRAIN_MS 100 /* 0 = keep records in RAM only */
+#endif
+
+static blog_ring_t ring;
+
+void blog_log(uint16_t id, const uint32_t *args, size_t nargs)
+{
+    blog_write(&ring, id, (uint32_t)esp_timer_get_time(), (uint8_t)esp_cpu_get_core_id(), args, nargs);
+}
+
+static void blog_task(void *pv)
+{
+    (void)pv;
+    uint32_t cursor = 0;
+    uint32_t lost = 0;
+    blog_rec_t rec;
+    char line[BLOG_LINE_MAX];
+
+    for (;;)
+    {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_BLOG_DRAIN_MS));
+        // lost records show up as sequence gaps on the host, nothing to print here
+        while (blog_read(&ring, &cursor, &rec, &lost))
+        {
+            size_t len = blog_encode_line(&rec, line, sizeof(line));
+            fwrite(line, 1, len, stdout);
+        }
+        fflush(stdout);
+    }
+}
+
+esp_err_t wake_blog(void)
+{
+    if (CONFIG_BLOG_DRAIN_MS == 0)
+    {
+        return ESP_OK;
+    }
+
+    if (xTaskCreate(blog_task, "blog", 2048, NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,30 @@
+#ifndef BLOG_LOG_H
+#define BLOG_LOG_H
+
+#include "esp_err.h"
+
+#include "blog.h"
+
+/*
+ * Device side of blog.h: one ring in RAM, stamped with esp_timer and the
+ * core id, drained to the console as "@B" lines just above idle. Use it
+ * instead of ESP_LOGI on connection and input paths; ESP_LOGE/W stay for
+ * the fatal ones, which must show up even if the drain task never runs.
+ *
+ *   BLOG(GAP_CONNECT, status, handle);
+ *
+ * Arguments are converted to uint32_t, the decoder gives them back their
+ * sign for %d.
+ */
+#define BLOG(id, ...)                                                                                                  \
+    blog_log(BLOG_##id, (const uint32_t[]){0, __VA_ARGS__} + 1,                                                        \
+             sizeof((const uint32_t[]){0, __VA_ARGS__}) / sizeof(uint32_t) - 1)
+
+void blog_log(uint16_t id, const uint32_t *args, size_t nargs);
+
+/**
+ * @brief Start draining every CONFIG_BLOG_DRAIN_MS. With 0, records only stay in the ring for a debugger or core dump.
+ */
+esp_err_t wake_blog(void);
+
+#endif
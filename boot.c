@@ -0,0 +1,125 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "boot.h"
+
+static const char *TAG = "boot";
+
+static const char *const mark_names[BOOT_MARK_COUNT] = {
+    [BOOT_MARK_ADVERTISING] = "advertising",
+    [BOOT_MARK_SENSOR_READY] = "sensor ready",
+    [BOOT_MARK_FIRST_REPORT] = "first report",
+};
+
+// esp_timer counts from early startup, before app_main
+static volatile uint32_t marks_us[BOOT_MARK_COUNT];
+
+typedef struct
+{
+    const boot_step_t *step;
+    EventGroupHandle_t done;
+    uint32_t bit;
+    int64_t start_us;
+    int64_t end_us;
+    esp_err_t ret;
+} boot_job_t;
+
+static void boot_step_task(void *pv)
+{
+    boot_job_t *job = pv;
+
+    if (job->step->deps)
+    {
+        xEventGroupWaitBits(job->done, job->step->deps, pdFALSE, pdTRUE, portMAX_DELAY);
+    }
+
+    job->start_us = esp_timer_get_time();
+    job->ret = job->step->fn();
+    job->end_us = esp_timer_get_time();
+
+    xEventGroupSetBits(job->done, job->bit);
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_run(const boot_step_t *steps, size_t n)
+{
+    boot_job_t jobs[BOOT_STEPS_MAX];
+    uint32_t all = 0;
+
+    if (n == 0 || n > BOOT_STEPS_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    // only earlier steps may be depended on, which also rules out cycles
+    for (size_t i = 0; i < n; i++)
+    {
+        if (steps[i].deps & ~(BOOT_DEP(i) - 1))
+        {
+            ESP_LOGE(TAG, "step %s depends on itself or a later step", steps[i].name);
+            return ESP_ERR_INVALID_ARG;
+        }
+    }
+
+    EventGroupHandle_t done = xEventGroupCreate();
+    if (done == NULL)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+
+    int64_t t0 = esp_timer_get_time();
+
+    for (size_t i = 0; i < n; i++)
+    {
+        jobs[i] = (boot_job_t){.step = &steps[i], .done = done, .bit = BOOT_DEP(i), .ret = ESP_OK};
+        all |= BOOT_DEP(i);
+
+        if (xTaskCreatePinnedToCore(boot_step_task, steps[i].name, steps[i].stack, &jobs[i],
+                                    steps[i].priority, NULL, steps[i].core) != pdPASS)
+        {
+            // run it here instead, the table order already respects dependencies
+            ESP_LOGW(TAG, "no task for %s, running inline", steps[i].name);
+            xEventGroupWaitBits(done, steps[i].deps, pdFALSE, pdTRUE, portMAX_DELAY);
+            jobs[i].start_us = esp_timer_get_time();
+            jobs[i].ret = steps[i].fn();
+            jobs[i].end_us = esp_timer_get_time();
+            xEventGroupSetBits(done, jobs[i].bit);
+        }
+    }
+
+    xEventGroupWaitBits(done, all, pdFALSE, pdTRUE, portMAX_DELAY);
+    vEventGroupDelete(done);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        ESP_LOGI(TAG, "%-10s %6lld .. %6lld us%s", steps[i].name, jobs[i].start_us - t0, jobs[i].end_us - t0,
+                 jobs[i].ret == ESP_OK ? "" : " FAILED");
+        if (jobs[i].ret != ESP_OK)
+        {
+            ESP_LOGW(TAG, "%s: %s", steps[i].name, esp_err_to_name(jobs[i].ret));
+        }
+    }
+    ESP_LOGI(TAG, "bring-up took %lld us", esp_timer_get_time() - t0);
+
+    return ESP_OK;
+}
+
+void boot_mark(boot_mark_t mark)
+{
+    if (mark >= BOOT_MARK_COUNT || marks_us[mark])
+    {
+        return;
+    }
+
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    marks_us[mark] = now ? now : 1;
+
+    ESP_LOGI(TAG, "cold boot to %s: %lu us", mark_names[mark], (unsigned long)marks_us[mark]);
+}
+
+uint32_t boot_mark_us(boot_mark_t mark)
+{
+    return mark < BOOT_MARK_COUNT ? marks_us[mark] : 0;
+}
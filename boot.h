@@ -0,0 +1,53 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+/*
+ * Boot orchestrator: runs bring-up steps on their own tasks as soon as the
+ * steps they depend on have finished, so independent work (BLE stack, sensor
+ * power-up) overlaps instead of running back to back.
+ */
+
+#define BOOT_STEPS_MAX 16
+
+#define BOOT_DEP(i) (1u << (i)) // dependency on step i of the same table
+
+typedef struct
+{
+    const char *name;
+    esp_err_t (*fn)(void);
+    uint32_t deps;  // BOOT_DEP() mask of earlier steps
+    int core;       // tskNO_AFFINITY or a core id
+    uint32_t stack; // bytes
+    uint8_t priority;
+} boot_step_t;
+
+typedef enum
+{
+    BOOT_MARK_ADVERTISING = 0, // first advertising start
+    BOOT_MARK_SENSOR_READY,
+    BOOT_MARK_FIRST_REPORT, // first HID report sent
+    BOOT_MARK_COUNT,
+} boot_mark_t;
+
+/**
+ * @brief Run all steps, return once every step has finished.
+ *        A failed step is logged; steps depending on it still run.
+ * @return ESP_ERR_INVALID_ARG for a bad table (dependency on itself or a later step)
+ */
+esp_err_t boot_run(const boot_step_t *steps, size_t n);
+
+/**
+ * @brief Record a milestone, only the first call per mark counts. Safe from any task.
+ */
+void boot_mark(boot_mark_t mark);
+
+/**
+ * @brief Microseconds from cold boot to the mark, 0 if not reached yet.
+ */
+uint32_t boot_mark_us(boot_mark_t mark);
+
+#endif
@@ -0,0 +1,126 @@
+#include <string.h>
+
+#include "capture.h"
+
+#define RING_MASK (CONFIG_CAPTURE_RING_FRAMES - 1)
+
+static uint8_t crc8(const uint8_t *p, size_t n)
+{
+    uint8_t crc = 0;
+    while (n--)
+    {
+        crc ^= *p++;
+        for (int i = 0; i < 8; i++)
+        {
+            crc = (crc & 0x80) ? (uint8_t)(crc << 1 ^ 0x07) : (uint8_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get_u16(const uint8_t *p) { return (uint16_t)(p[0] | p[1] << 8); }
+
+void capture_encode(const capture_frame_t *f, uint8_t out[CAPTURE_FRAME_LEN])
+{
+    out[0] = CAPTURE_SYNC0;
+    out[1] = CAPTURE_SYNC1;
+    put_u16(out + 2, f->seq);
+    put_u16(out + 4, (uint16_t)f->t_us);
+    put_u16(out + 6, (uint16_t)(f->t_us >> 16));
+    memcpy(out + 8, f->raw, SURFACE_BURST_LEN);
+    put_u16(out + 20, (uint16_t)f->dx);
+    put_u16(out + 22, (uint16_t)f->dy);
+    out[24] = f->flags;
+    out[25] = crc8(out + 2, CAPTURE_FRAME_LEN - 3);
+}
+
+bool capture_ring_push(capture_ring_t *r, capture_frame_t *f)
+{
+    uint32_t head = r->head;
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+
+    // the number is spent either way, so the receiver sees the gap
+    f->seq = r->seq++;
+    if (head - tail >= CONFIG_CAPTURE_RING_FRAMES)
+    {
+        r->dropped++;
+        return false;
+    }
+
+    capture_encode(f, r->frame[head & RING_MASK]);
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+size_t capture_ring_peek(capture_ring_t *r, const uint8_t **data)
+{
+    uint32_t tail = r->tail;
+    uint32_t n = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - tail;
+    uint32_t to_end = CONFIG_CAPTURE_RING_FRAMES - (tail & RING_MASK);
+
+    *data = r->frame[tail & RING_MASK];
+    return (n < to_end ? n : to_end) * CAPTURE_FRAME_LEN;
+}
+
+void capture_ring_release(capture_ring_t *r, size_t bytes)
+{
+    __atomic_store_n(&r->tail, r->tail + (uint32_t)(bytes / CAPTURE_FRAME_LEN), __ATOMIC_RELEASE);
+}
+
+// drop the first byte and slide to the next sync candidate
+static void resync(capture_decoder_t *d)
+{
+    size_t i = 1;
+    while (i < d->len && d->buf[i] != CAPTURE_SYNC0)
+    {
+        i++;
+    }
+    d->skipped += (uint32_t)i;
+    d->len -= i;
+    memmove(d->buf, d->buf + i, d->len);
+}
+
+bool capture_decode(capture_decoder_t *d, uint8_t byte, capture_frame_t *out)
+{
+    d->buf[d->len++] = byte;
+
+    for (;;)
+    {
+        if (d->len >= 1 && d->buf[0] != CAPTURE_SYNC0)
+        {
+            resync(d);
+            continue;
+        }
+        if (d->len >= 2 && d->buf[1] != CAPTURE_SYNC1)
+        {
+            resync(d);
+            continue;
+        }
+        if (d->len < CAPTURE_FRAME_LEN)
+        {
+            return false;
+        }
+        if (crc8(d->buf + 2, CAPTURE_FRAME_LEN - 3) != d->buf[CAPTURE_FRAME_LEN - 1])
+        {
+            d->bad_crc++;
+            resync(d);
+            continue;
+        }
+        break;
+    }
+
+    out->seq = get_u16(d->buf + 2);
+    out->t_us = get_u16(d->buf + 4) | (uint32_t)get_u16(d->buf + 6) << 16;
+    memcpy(out->raw, d->buf + 8, SURFACE_BURST_LEN);
+    out->dx = (int16_t)get_u16(d->buf + 20);
+    out->dy = (int16_t)get_u16(d->buf + 22);
+    out->flags = d->buf[24];
+    d->len = 0;
+    return true;
+}
@@ -0,0 +1,98 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+
+#include "surface.h"
+
+/*
+ * Raw sensor capture: one fixed-size frame per motion burst, for tuning
+ * off-device. No IDF dependency; capture_uart.c moves the frames out and
+ * tools/capture_rec.c reads them back.
+ *
+ * Frame, little endian, CAPTURE_FRAME_LEN bytes:
+ *   0  A5 5A      sync
+ *   2  seq u16    one per burst, dropped ones included: a gap is a loss
+ *   4  t_us u32   esp_timer at the read
+ *   8  raw[12]    the burst as read from the sensor
+ *   20 dx, dy i16 deltas after the surface gate, 0 when it held them back
+ *   24 flags      CAPTURE_FLAG_*
+ *   25 crc8       poly 0x07 over bytes 2..24
+ */
+
+#define CAPTURE_SYNC0 0xA5
+#define CAPTURE_SYNC1 0x5A
+#define CAPTURE_FRAME_LEN 26
+
+#define CAPTURE_FLAG_PASS 0x01 // the surface gate let the motion through
+
+#ifndef CONFIG_CAPTURE_RING_FRAMES
+#define CONFIG_CAPTURE_RING_FRAMES 64 /* power of two */
+#endif
+
+_Static_assert((CONFIG_CAPTURE_RING_FRAMES & (CONFIG_CAPTURE_RING_FRAMES - 1)) == 0,
+               "CONFIG_CAPTURE_RING_FRAMES must be a power of two");
+
+typedef struct
+{
+    uint16_t seq;
+    uint32_t t_us;
+    uint8_t raw[SURFACE_BURST_LEN];
+    int16_t dx;
+    int16_t dy;
+    uint8_t flags;
+} capture_frame_t;
+
+/*
+ * Encoded frames between one producer (the move task) and one consumer (the
+ * transport). A full ring drops the new frame, the producer never waits.
+ */
+typedef struct
+{
+    uint8_t frame[CONFIG_CAPTURE_RING_FRAMES][CAPTURE_FRAME_LEN];
+    uint32_t head; // frames pushed
+    uint32_t tail; // frames released
+    uint16_t seq;
+    uint32_t dropped;
+} capture_ring_t;
+
+typedef struct
+{
+    uint8_t buf[CAPTURE_FRAME_LEN];
+    size_t len;
+    uint32_t skipped; // bytes thrown away looking for a frame
+    uint32_t bad_crc;
+} capture_decoder_t;
+
+void capture_encode(const capture_frame_t *f, uint8_t out[CAPTURE_FRAME_LEN]);
+
+/**
+ * @brief Producer side. Numbers the frame and queues it.
+ * @return false if the ring was full and the frame dropped
+ */
+bool capture_ring_push(capture_ring_t *r, capture_frame_t *f);
+
+/**
+ * @brief Consumer side. The oldest queued frames that lie back to back in memory.
+ * @return byte count, a multiple of CAPTURE_FRAME_LEN, 0 when empty
+ */
+size_t capture_ring_peek(capture_ring_t *r, const uint8_t **data);
+
+/**
+ * @brief Consumer side. Hand back bytes returned by capture_ring_peek() once they are sent.
+ */
+void capture_ring_release(capture_ring_t *r, size_t bytes);
+
+/**
+ * @brief Feed one received byte, resyncs on garbage and CRC errors.
+ * @return true when *out holds a complete frame
+ */
+bool capture_decode(capture_decoder_t *d, uint8_t byte, capture_frame_t *out);
+
+#endif
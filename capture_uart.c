@@ -0,0 +1,149 @@
+#include <string.h>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+
+#include "pins.h"
+#include "stats.h"
+#include "capture_uart.h"
+
+#ifndef CONFIG_CAPTURE_UART_PORT
+#define CONFIG_CAPTURE_UART_PORT 1
+#endif
+#ifndef CONFIG_CAPTURE_UART_BAUD
+#define CONFIG_CAPTURE_UART_BAUD 2000000 /* 26 bytes at 1 kHz fit with room to spare */
+#endif
+#ifndef CONFIG_ESP_CONSOLE_UART_NUM
+#define CONFIG_ESP_CONSOLE_UART_NUM (-1) /* console not on a UART */
+#endif
+#ifndef CONFIG_CAPTURE_UART_TX_BUF
+#define CONFIG_CAPTURE_UART_TX_BUF 2048
+#endif
+
+#if portNUM_PROCESSORS > 1
+#define CAPTURE_CORE 1 /* with the move task, away from the NimBLE host */
+#else
+#define CAPTURE_CORE tskNO_AFFINITY
+#endif
+
+static const char *TAG = "capture";
+
+static capture_ring_t ring;
+static bool active;
+static TaskHandle_t sender;
+
+static void capture_task(void *pv)
+{
+    (void)pv;
+    const uint8_t *data;
+    size_t n;
+
+    for (;;)
+    {
+        n = capture_ring_peek(&ring, &data);
+        if (n == 0)
+        {
+            if (!__atomic_load_n(&active, __ATOMIC_ACQUIRE))
+            {
+                // drained and off: sleep until capture_enable() turns it back on
+                ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+                continue;
+            }
+            // the move task does not wake us, one tick of frames is what the ring is sized for
+            vTaskDelay(1);
+            continue;
+        }
+        // blocks while the driver's TX buffer is full, which is the backpressure
+        if (uart_write_bytes(CONFIG_CAPTURE_UART_PORT, data, n) < 0)
+        {
+            vTaskDelay(1);
+            continue;
+        }
+        capture_ring_release(&ring, n);
+    }
+}
+
+static esp_err_t uart_start(void)
+{
+    esp_err_t err;
+
+    if (CONFIG_CAPTURE_UART_PORT != CONFIG_ESP_CONSOLE_UART_NUM)
+    {
+        uart_config_t cfg = {
+            .baud_rate = CONFIG_CAPTURE_UART_BAUD,
+            .data_bits = UART_DATA_8_BITS,
+            .parity = UART_PARITY_DISABLE,
+            .stop_bits = UART_STOP_BITS_1,
+            .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+            .source_clk = UART_SCLK_DEFAULT,
+        };
+        err = uart_param_config(CONFIG_CAPTURE_UART_PORT, &cfg);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+        err = uart_set_pin(CONFIG_CAPTURE_UART_PORT, CAPTURE_UART_TX_GPIO, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE,
+                           UART_PIN_NO_CHANGE);
+        if (err != ESP_OK)
+        {
+            return err;
+        }
+    }
+    if (!uart_is_driver_installed(CONFIG_CAPTURE_UART_PORT))
+    {
+        // RX buffer is the driver minimum, nothing is read
+        return uart_driver_install(CONFIG_CAPTURE_UART_PORT, UART_HW_FIFO_LEN(CONFIG_CAPTURE_UART_PORT) * 2,
+                                   CONFIG_CAPTURE_UART_TX_BUF, 0, NULL, 0);
+    }
+    return ESP_OK;
+}
+
+esp_err_t capture_enable(bool on)
+{
+    if (on && sender == NULL)
+    {
+        // claimed here so a failure reaches the caller, retried on the next start
+        esp_err_t err = uart_start();
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "UART%d setup failed: %s", CONFIG_CAPTURE_UART_PORT, esp_err_to_name(err));
+            return err;
+        }
+        if (xTaskCreatePinnedToCore(capture_task, "capture", 2560, NULL, tskIDLE_PRIORITY + 1, &sender, CAPTURE_CORE) !=
+            pdPASS)
+        {
+            return ESP_ERR_NO_MEM;
+        }
+    }
+    if (on != active)
+    {
+        ESP_LOGI(TAG, "%s, UART%d at %d baud", on ? "streaming" : "stopped", CONFIG_CAPTURE_UART_PORT,
+                 CONFIG_CAPTURE_UART_BAUD);
+    }
+    __atomic_store_n(&active, on, __ATOMIC_RELEASE);
+    if (on)
+    {
+        xTaskNotifyGive(sender);
+    }
+    return ESP_OK;
+}
+
+bool capture_enabled(void) { return __atomic_load_n(&active, __ATOMIC_ACQUIRE); }
+
+void capture_burst(uint32_t t_us, const uint8_t raw[SURFACE_BURST_LEN], int16_t dx, int16_t dy, uint8_t flags)
+{
+    if (!__atomic_load_n(&active, __ATOMIC_RELAXED))
+    {
+        return;
+    }
+
+    capture_frame_t f = {.t_us = t_us, .dx = dx, .dy = dy, .flags = flags};
+    memcpy(f.raw, raw, SURFACE_BURST_LEN);
+    if (!capture_ring_push(&ring, &f))
+    {
+        stats_inc(STATS_CAPTURE_DROPS);
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef CAPTURE_UART_H
+#define CAPTURE_UART_H
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+
+#include "capture.h"
+
+/*
+ * Streams capture.h frames out of a UART while capture is on. By default
+ * that is UART1 on CAPTURE_UART_TX_GPIO into any USB-serial adapter, so the
+ * console and the blog lines on UART0 stay readable. Port 0 goes out over
+ * the board's USB bridge instead, mixed with the console.
+ *
+ * The sender runs just above idle on the sensor core and the move task only
+ * copies a frame into the ring, so the BLE path never waits on the wire:
+ * when the UART cannot keep up, frames are dropped and counted. While capture
+ * is off the sender sleeps on a notification.
+ */
+
+/**
+ * @brief Start or stop streaming. The UART is claimed on the first start.
+ * @return the UART driver error if it cannot be set up, ESP_ERR_NO_MEM without a sender task
+ */
+esp_err_t capture_enable(bool on);
+
+bool capture_enabled(void);
+
+/**
+ * @brief Queue one burst, from the move task. Does nothing while capture is off.
+ */
+void capture_burst(uint32_t t_us, const uint8_t raw[SURFACE_BURST_LEN], int16_t dx, int16_t dy, uint8_t flags);
+
+#endif
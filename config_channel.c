@@ -0,0 +1,357 @@
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+
+#include "battery.h"
+#include "paw3395.h"
+#include "settings.h"
+#include "mouse_api.h"
+#include "nimble.h"
+#include "config_channel.h"
+#include "boot.h"
+#include "stats.h"
+#include "capture_uart.h"
+
+static const char *TAG = "config";
+
+#define STATS_PAGE_DEVICE 0
+#define STATS_PAGE_SURFACE 1
+#define STATS_PAGE_SURFACE_COUNTERS 2
+#define STATS_PAGE_SENSOR_HEALTH 3
+#define STATS_PAGE_BOOT 4
+#define STATS_PAGE_COUNTERS 0x10     // + n: counters 3n..3n+2 (u32 each); page 0x10 takes a new snapshot
+#define STATS_PAGE_COUNTER_DIFF 0x20 // + n: the same counters, change between the last two snapshots
+#define STATS_PAGE_COUNTER_SPAN 0x10
+#define STATS_PER_PAGE 3
+
+/* the BLE host task is the only caller, no locking */
+static stats_snapshot_t counters_now, counters_prev;
+static uint8_t macro_staged[MACRO_CODE_MAX];
+
+static int counters_page(uint8_t index, bool diff, uint8_t *out, size_t cap, size_t *len)
+{
+    stats_snapshot_t delta;
+    const stats_snapshot_t *s = &counters_now;
+    unsigned first = index * STATS_PER_PAGE;
+
+    if (first >= STATS_COUNT || cap < STATS_PER_PAGE * 4)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    if (index == 0 && !diff)
+    {
+        counters_prev = counters_now;
+        stats_snapshot(&counters_now);
+    }
+    if (diff)
+    {
+        stats_diff(&counters_now, &counters_prev, &delta);
+        s = &delta;
+    }
+
+    *len = 0;
+    for (unsigned i = first; i < STATS_COUNT && i < first + STATS_PER_PAGE; i++)
+    {
+        memcpy(out + *len, &s->v[i], 4);
+        *len += 4;
+    }
+    return CONFIG_STATUS_OK;
+}
+
+static int op_get_dpi(uint16_t *dpi)
+{
+    *dpi = api_get_dpi();
+    return CONFIG_STATUS_OK;
+}
+
+static int op_set_dpi(uint16_t dpi)
+{
+    if (dpi == 0)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    api_set_dpi(dpi);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_get_rate(uint16_t *hz)
+{
+    *hz = api_get_report_rate();
+    return CONFIG_STATUS_OK;
+}
+
+static int op_set_rate(uint16_t hz)
+{
+    api_set_report_rate(hz);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_get_debounce(uint16_t *click_us, uint16_t *scroll_us)
+{
+    api_get_debounce(click_us, scroll_us);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_set_debounce(uint16_t click_us, uint16_t scroll_us)
+{
+    api_set_debounce(click_us, scroll_us);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_get_sensor_mode(uint8_t *mode)
+{
+    *mode = paw3395_get_mode();
+    return CONFIG_STATUS_OK;
+}
+
+static int op_set_sensor_mode(uint8_t mode)
+{
+    if (paw3395_set_mode(mode) != ESP_OK)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    settings_set_sensor_mode(mode);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_get_accel(accel_params_t *params)
+{
+    api_get_accel(params);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_set_accel(const accel_params_t *params)
+{
+    api_set_accel(params);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_get_xform(motion_xform_params_t *params)
+{
+    api_get_xform(params);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_set_xform(const motion_xform_params_t *params)
+{
+    api_set_xform(params);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_get_cpi_stages(cpi_stages_t *stages)
+{
+    api_cpi_get_stages(stages);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_set_cpi_stage(uint8_t index, uint16_t x, uint16_t y, uint8_t count)
+{
+    return api_cpi_set_stage(index, x, y, count) ? CONFIG_STATUS_OK : CONFIG_STATUS_BAD_VALUE;
+}
+
+static int op_select_cpi_stage(uint8_t index)
+{
+    return api_cpi_select(index) ? CONFIG_STATUS_OK : CONFIG_STATUS_BAD_VALUE;
+}
+
+static int op_get_surface(surface_params_t *params)
+{
+    api_get_surface(params);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_set_surface(const surface_params_t *params)
+{
+    api_set_surface(params);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_get_capture(uint8_t *on)
+{
+    *on = capture_enabled();
+    return CONFIG_STATUS_OK;
+}
+
+static int op_set_capture(uint8_t on)
+{
+    return capture_enable(on) == ESP_OK ? CONFIG_STATUS_OK : CONFIG_STATUS_FAILED;
+}
+
+static int op_get_filter(motion_filter_params_t *params)
+{
+    api_get_filter(params);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_set_filter(const motion_filter_params_t *params)
+{
+    api_set_filter(params);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_write_macro(uint8_t offset, const uint8_t *data, uint8_t n)
+{
+    memcpy(macro_staged + offset, data, n);
+    return CONFIG_STATUS_OK;
+}
+
+static int op_store_macro(uint8_t slot, uint8_t chord, uint8_t len)
+{
+    return api_macro_store(slot, chord, macro_staged, len) ? CONFIG_STATUS_OK : CONFIG_STATUS_BAD_VALUE;
+}
+
+static int op_clear_macro(uint8_t slot)
+{
+    return api_macro_store(slot, 0, macro_staged, 0) ? CONFIG_STATUS_OK : CONFIG_STATUS_BAD_VALUE;
+}
+
+static int op_play_macro(uint8_t slot)
+{
+    // an empty slot has nothing to play
+    return api_macro_play(slot) ? CONFIG_STATUS_OK : CONFIG_STATUS_BAD_VALUE;
+}
+
+static int op_get_macro(uint8_t slot, macro_slot_t *macro)
+{
+    return api_macro_get(slot, macro) ? CONFIG_STATUS_OK : CONFIG_STATUS_BAD_VALUE;
+}
+
+static int op_get_stats(uint8_t page, uint8_t *out, size_t cap, size_t *len)
+{
+    switch (page)
+    {
+    case STATS_PAGE_DEVICE:
+    {
+        // uptime s (u32) | battery mV (u16) | battery % | connected
+        if (cap < 8)
+        {
+            return CONFIG_STATUS_FAILED;
+        }
+        uint32_t uptime_s = (uint32_t)(esp_timer_get_time() / 1000000);
+        uint16_t mv = battery_voltage_mv();
+        memcpy(out, &uptime_s, 4);
+        memcpy(out + 4, &mv, 2);
+        out[6] = battery_level();
+        out[7] = ble_mounted();
+        *len = 8;
+        return CONFIG_STATUS_OK;
+    }
+    case STATS_PAGE_SURFACE:
+    {
+        // SQUAL | raw data sum | shutter (u16) | lifted
+        surface_stats_t st;
+        if (cap < 5)
+        {
+            return CONFIG_STATUS_FAILED;
+        }
+        paw3395_get_surface(NULL, &st);
+        out[0] = st.squal;
+        out[1] = st.raw_sum;
+        memcpy(out + 2, &st.shutter, 2);
+        out[4] = st.lifted;
+        *len = 5;
+        return CONFIG_STATUS_OK;
+    }
+    case STATS_PAGE_SURFACE_COUNTERS:
+    {
+        // lift-offs (u16) | gated samples (u32) | samples (u32)
+        surface_stats_t st;
+        if (cap < 10)
+        {
+            return CONFIG_STATUS_FAILED;
+        }
+        paw3395_get_surface(NULL, &st);
+        memcpy(out, &st.lift_count, 2);
+        memcpy(out + 2, &st.gated, 4);
+        memcpy(out + 6, &st.samples, 4);
+        *len = 10;
+        return CONFIG_STATUS_OK;
+    }
+    case STATS_PAGE_SENSOR_HEALTH:
+    {
+        // faults (u32) | re-inits (u32) | last fault | checks (u32)
+        sensor_health_t h;
+        if (cap < 13)
+        {
+            return CONFIG_STATUS_FAILED;
+        }
+        paw3395_get_health(&h);
+        memcpy(out, &h.faults, 4);
+        memcpy(out + 4, &h.reinits, 4);
+        out[8] = h.last_fault;
+        memcpy(out + 9, &h.checks, 4);
+        *len = 13;
+        return CONFIG_STATUS_OK;
+    }
+    case STATS_PAGE_BOOT:
+    {
+        // cold boot to advertising | sensor ready | first report, us (u32 each, 0 = not yet)
+        if (cap < 12)
+        {
+            return CONFIG_STATUS_FAILED;
+        }
+        for (int i = 0; i < 3; i++)
+        {
+            uint32_t us = boot_mark_us((boot_mark_t)i);
+            memcpy(out + 4 * i, &us, 4);
+        }
+        *len = 12;
+        return CONFIG_STATUS_OK;
+    }
+    default:
+        if (page >= STATS_PAGE_COUNTERS && page < STATS_PAGE_COUNTERS + STATS_PAGE_COUNTER_SPAN)
+        {
+            return counters_page(page - STATS_PAGE_COUNTERS, false, out, cap, len);
+        }
+        if (page >= STATS_PAGE_COUNTER_DIFF && page < STATS_PAGE_COUNTER_DIFF + STATS_PAGE_COUNTER_SPAN)
+        {
+            return counters_page(page - STATS_PAGE_COUNTER_DIFF, true, out, cap, len);
+        }
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+}
+
+static const config_ops_t config_ops = {
+    .get_dpi = op_get_dpi,
+    .set_dpi = op_set_dpi,
+    .get_rate = op_get_rate,
+    .set_rate = op_set_rate,
+    .get_debounce = op_get_debounce,
+    .set_debounce = op_set_debounce,
+    .get_sensor_mode = op_get_sensor_mode,
+    .set_sensor_mode = op_set_sensor_mode,
+    .get_accel = op_get_accel,
+    .set_accel = op_set_accel,
+    .get_xform = op_get_xform,
+    .set_xform = op_set_xform,
+    .get_cpi_stages = op_get_cpi_stages,
+    .set_cpi_stage = op_set_cpi_stage,
+    .select_cpi_stage = op_select_cpi_stage,
+    .get_surface = op_get_surface,
+    .set_surface = op_set_surface,
+    .get_filter = op_get_filter,
+    .set_filter = op_set_filter,
+    .get_capture = op_get_capture,
+    .set_capture = op_set_capture,
+    .write_macro = op_write_macro,
+    .store_macro = op_store_macro,
+    .clear_macro = op_clear_macro,
+    .play_macro = op_play_macro,
+    .get_macro = op_get_macro,
+    .get_stats = op_get_stats,
+};
+
+size_t config_channel_handle(const uint8_t *req, size_t len, uint8_t *rsp, size_t cap)
+{
+    size_t n = config_proto_handle(&config_ops, req, len, rsp, cap);
+
+    if (n)
+    {
+        ESP_LOGD(TAG, "cmd 0x%02x status %d", rsp[0] & ~CONFIG_RSP_FLAG, rsp[2]);
+    }
+
+    return n;
+}
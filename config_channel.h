@@ -0,0 +1,15 @@
+#ifndef CONFIG_CHANNEL_H
+#define CONFIG_CHANNEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "config_proto.h"
+
+/**
+ * @brief Run one config request from the vendor HID report against the live device.
+ * @return response length to publish as the CONFIG_REPORT_ID feature value, 0 for none
+ */
+size_t config_channel_handle(const uint8_t *req, size_t len, uint8_t *rsp, size_t cap);
+
+#endif
@@ -0,0 +1,640 @@
+#include <string.h>
+
+#include "config_proto.h"
+
+typedef int (*config_handler_t)(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len);
+
+typedef struct
+{
+    uint8_t cmd;
+    uint8_t args_len; // minimum argument bytes
+    config_handler_t handler;
+} config_entry_t;
+
+static inline uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline void put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+static int cmd_get_version(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)ops;
+    (void)args;
+    out[0] = CONFIG_PROTO_VERSION;
+    *out_len = 1;
+    return CONFIG_STATUS_OK;
+}
+
+static int cmd_get_dpi(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)args;
+    uint16_t dpi;
+
+    if (!ops->get_dpi)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->get_dpi(&dpi);
+    if (st == CONFIG_STATUS_OK)
+    {
+        put_u16(out, dpi);
+        *out_len = 2;
+    }
+    return st;
+}
+
+static int cmd_set_dpi(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    if (!ops->set_dpi)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->set_dpi(get_u16(args));
+    // echo back what was actually applied (after clamping)
+    return st == CONFIG_STATUS_OK ? cmd_get_dpi(ops, args, out, out_len) : st;
+}
+
+static int cmd_get_rate(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)args;
+    uint16_t hz;
+
+    if (!ops->get_rate)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->get_rate(&hz);
+    if (st == CONFIG_STATUS_OK)
+    {
+        put_u16(out, hz);
+        *out_len = 2;
+    }
+    return st;
+}
+
+static int cmd_set_rate(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    uint16_t hz = get_u16(args);
+
+    if (!ops->set_rate)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if (hz == 0)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    int st = ops->set_rate(hz);
+    return st == CONFIG_STATUS_OK ? cmd_get_rate(ops, args, out, out_len) : st;
+}
+
+static int cmd_get_debounce(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)args;
+    uint16_t click_us, scroll_us;
+
+    if (!ops->get_debounce)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->get_debounce(&click_us, &scroll_us);
+    if (st == CONFIG_STATUS_OK)
+    {
+        put_u16(out, click_us);
+        put_u16(out + 2, scroll_us);
+        *out_len = 4;
+    }
+    return st;
+}
+
+static int cmd_set_debounce(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    if (!ops->set_debounce)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->set_debounce(get_u16(args), get_u16(args + 2));
+    return st == CONFIG_STATUS_OK ? cmd_get_debounce(ops, args, out, out_len) : st;
+}
+
+static int cmd_get_sensor_mode(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)args;
+
+    if (!ops->get_sensor_mode)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->get_sensor_mode(&out[0]);
+    if (st == CONFIG_STATUS_OK)
+    {
+        *out_len = 1;
+    }
+    return st;
+}
+
+static int cmd_set_sensor_mode(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    if (!ops->set_sensor_mode)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->set_sensor_mode(args[0]);
+    return st == CONFIG_STATUS_OK ? cmd_get_sensor_mode(ops, args, out, out_len) : st;
+}
+
+static int cmd_get_accel(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)args;
+    accel_params_t p;
+
+    if (!ops->get_accel)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->get_accel(&p);
+    if (st == CONFIG_STATUS_OK)
+    {
+        out[0] = p.curve;
+        put_u16(out + 1, p.offset);
+        put_u16(out + 3, p.accel);
+        put_u16(out + 5, p.exponent);
+        put_u16(out + 7, p.cap);
+        put_u16(out + 9, p.midpoint);
+        put_u16(out + 11, p.max_speed);
+        *out_len = 13;
+    }
+    return st;
+}
+
+static int cmd_set_accel(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    accel_params_t p;
+
+    if (!ops->get_accel || !ops->set_accel)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    // keep the custom points, they are set separately
+    int st = ops->get_accel(&p);
+    if (st != CONFIG_STATUS_OK)
+    {
+        return st;
+    }
+    if (args[0] > ACCEL_CURVE_POINTS || get_u16(args + 11) == 0)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    p.curve = args[0];
+    p.offset = get_u16(args + 1);
+    p.accel = get_u16(args + 3);
+    p.exponent = get_u16(args + 5);
+    p.cap = get_u16(args + 7);
+    p.midpoint = get_u16(args + 9);
+    p.max_speed = get_u16(args + 11);
+
+    st = ops->set_accel(&p);
+    return st == CONFIG_STATUS_OK ? cmd_get_accel(ops, args, out, out_len) : st;
+}
+
+static int cmd_set_accel_point(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)out;
+    (void)out_len;
+    accel_params_t p;
+
+    if (!ops->get_accel || !ops->set_accel)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if (args[0] >= ACCEL_POINTS_MAX || args[5] > ACCEL_POINTS_MAX)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    int st = ops->get_accel(&p);
+    if (st != CONFIG_STATUS_OK)
+    {
+        return st;
+    }
+    p.points[args[0]].speed = get_u16(args + 1);
+    p.points[args[0]].gain = get_u16(args + 3);
+    p.n_points = args[5];
+
+    return ops->set_accel(&p);
+}
+
+static int cmd_get_xform(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)args;
+    motion_xform_params_t p;
+
+    if (!ops->get_xform)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->get_xform(&p);
+    if (st == CONFIG_STATUS_OK)
+    {
+        put_u16(out, (uint16_t)p.rotation);
+        out[2] = p.axes;
+        out[3] = p.snap_deg;
+        out[4] = p.hyst_deg;
+        *out_len = 5;
+    }
+    return st;
+}
+
+static int cmd_set_xform(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    motion_xform_params_t p = {0};
+    int16_t rotation = (int16_t)get_u16(args);
+
+    if (!ops->set_xform)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if (rotation < -1800 || rotation > 1800 || args[3] > 45 ||
+        (args[2] & ~(MOTION_XFORM_INVERT_X | MOTION_XFORM_INVERT_Y | MOTION_XFORM_SWAP_XY)))
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    p.rotation = rotation;
+    p.axes = args[2];
+    p.snap_deg = args[3];
+    p.hyst_deg = args[4];
+
+    int st = ops->set_xform(&p);
+    return st == CONFIG_STATUS_OK ? cmd_get_xform(ops, args, out, out_len) : st;
+}
+
+static int cmd_get_surface(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)args;
+    surface_params_t p;
+
+    if (!ops->get_surface)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->get_surface(&p);
+    if (st == CONFIG_STATUS_OK)
+    {
+        out[0] = p.squal_min;
+        out[1] = p.settle;
+        *out_len = 2;
+    }
+    return st;
+}
+
+static int cmd_set_surface(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    surface_params_t p = {
+        .squal_min = args[0],
+        .settle = args[1],
+    };
+
+    if (!ops->set_surface)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+
+    int st = ops->set_surface(&p);
+    return st == CONFIG_STATUS_OK ? cmd_get_surface(ops, args, out, out_len) : st;
+}
+
+static int cmd_get_filter(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)args;
+    motion_filter_params_t p;
+
+    if (!ops->get_filter)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->get_filter(&p);
+    if (st == CONFIG_STATUS_OK)
+    {
+        out[0] = p.stages;
+        out[1] = p.ma_len;
+        put_u16(out + 2, p.min_cutoff);
+        put_u16(out + 4, p.beta);
+        put_u16(out + 6, p.d_cutoff);
+        out[8] = p.dz_enter;
+        out[9] = p.dz_exit;
+        out[10] = p.dz_quiet;
+        *out_len = 11;
+    }
+    return st;
+}
+
+static int cmd_set_filter(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    motion_filter_params_t p = {
+        .stages = args[0],
+        .ma_len = args[1],
+        .min_cutoff = get_u16(args + 2),
+        .beta = get_u16(args + 4),
+        .d_cutoff = get_u16(args + 6),
+        .dz_enter = args[8],
+        .dz_exit = args[9],
+        .dz_quiet = args[10],
+    };
+
+    if (!ops->set_filter)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if ((p.stages & ~(MOTION_FILTER_DEADZONE | MOTION_FILTER_AVERAGE | MOTION_FILTER_ONE_EURO)) || p.ma_len == 0 ||
+        p.ma_len > CONFIG_MOTION_FILTER_WINDOW || p.dz_exit > p.dz_enter || p.dz_quiet == 0)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+
+    int st = ops->set_filter(&p);
+    return st == CONFIG_STATUS_OK ? cmd_get_filter(ops, args, out, out_len) : st;
+}
+
+static int cmd_get_cpi_stage(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    cpi_stages_t s;
+
+    if (!ops->get_cpi_stages)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if (args[0] >= CPI_STAGES_MAX)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    int st = ops->get_cpi_stages(&s);
+    if (st == CONFIG_STATUS_OK)
+    {
+        out[0] = args[0];
+        out[1] = s.count;
+        out[2] = s.current;
+        put_u16(out + 3, s.stage[args[0]].x);
+        put_u16(out + 5, s.stage[args[0]].y);
+        *out_len = 7;
+    }
+    return st;
+}
+
+static int cmd_set_cpi_stage(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    if (!ops->set_cpi_stage)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->set_cpi_stage(args[0], get_u16(args + 1), get_u16(args + 3), args[5]);
+    return st == CONFIG_STATUS_OK ? cmd_get_cpi_stage(ops, args, out, out_len) : st;
+}
+
+static int cmd_select_cpi_stage(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    if (!ops->select_cpi_stage)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->select_cpi_stage(args[0]);
+    return st == CONFIG_STATUS_OK ? cmd_get_cpi_stage(ops, args, out, out_len) : st;
+}
+
+static int cmd_get_stats(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    if (!ops->get_stats)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    // first payload byte echoes the page so replies can be told apart
+    out[0] = args[0];
+    size_t len = 0;
+    int st = ops->get_stats(args[0], out + 1, CONFIG_RSP_PAYLOAD - 1, &len);
+    if (st == CONFIG_STATUS_OK)
+    {
+        *out_len = 1 + (len < CONFIG_RSP_PAYLOAD - 1 ? len : CONFIG_RSP_PAYLOAD - 1);
+    }
+    return st;
+}
+
+static int cmd_get_capture(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)args;
+
+    if (!ops->get_capture)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    int st = ops->get_capture(&out[0]);
+    if (st == CONFIG_STATUS_OK)
+    {
+        *out_len = 1;
+    }
+    return st;
+}
+
+static int cmd_set_capture(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    if (!ops->set_capture)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if (args[0] > 1)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    int st = ops->set_capture(args[0]);
+    return st == CONFIG_STATUS_OK ? cmd_get_capture(ops, args, out, out_len) : st;
+}
+
+// a program is longer than one report, it is staged in pieces and then stored
+#define MACRO_CHUNK (CONFIG_REPORT_LEN - 4)
+#define MACRO_GET_CHUNK (CONFIG_RSP_PAYLOAD - 3)
+
+static int cmd_write_macro(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)out;
+    (void)out_len;
+
+    if (!ops->write_macro)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if (args[1] > MACRO_CHUNK || args[0] + args[1] > MACRO_CODE_MAX)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    return ops->write_macro(args[0], args + 2, args[1]);
+}
+
+static int cmd_get_macro(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    macro_slot_t m;
+
+    if (!ops->get_macro)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if (args[0] >= MACRO_SLOTS)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    int st = ops->get_macro(args[0], &m);
+    if (st == CONFIG_STATUS_OK)
+    {
+        size_t n = args[1] < m.len ? m.len - args[1] : 0;
+        if (n > MACRO_GET_CHUNK)
+        {
+            n = MACRO_GET_CHUNK;
+        }
+        out[0] = args[0];
+        out[1] = m.chord;
+        out[2] = m.len;
+        if (n)
+        {
+            memcpy(out + 3, m.code + args[1], n);
+        }
+        *out_len = 3 + n;
+    }
+    return st;
+}
+
+static int cmd_store_macro(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    if (!ops->store_macro)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if (args[0] >= MACRO_SLOTS || args[2] > MACRO_CODE_MAX)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    int st = ops->store_macro(args[0], args[1], args[2]);
+    if (st != CONFIG_STATUS_OK || !ops->get_macro)
+    {
+        return st;
+    }
+    uint8_t get[2] = {args[0], 0};
+    return cmd_get_macro(ops, get, out, out_len);
+}
+
+static int cmd_clear_macro(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)out;
+    (void)out_len;
+
+    if (!ops->clear_macro)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if (args[0] >= MACRO_SLOTS)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    return ops->clear_macro(args[0]);
+}
+
+static int cmd_play_macro(const config_ops_t *ops, const uint8_t *args, uint8_t *out, size_t *out_len)
+{
+    (void)out;
+    (void)out_len;
+
+    if (!ops->play_macro)
+    {
+        return CONFIG_STATUS_UNSUPPORTED;
+    }
+    if (args[0] >= MACRO_SLOTS)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    return ops->play_macro(args[0]);
+}
+
+static const config_entry_t config_table[] = {
+    {CONFIG_CMD_GET_VERSION, 0, cmd_get_version},
+    {CONFIG_CMD_GET_DPI, 0, cmd_get_dpi},
+    {CONFIG_CMD_SET_DPI, 2, cmd_set_dpi},
+    {CONFIG_CMD_GET_RATE, 0, cmd_get_rate},
+    {CONFIG_CMD_SET_RATE, 2, cmd_set_rate},
+    {CONFIG_CMD_GET_DEBOUNCE, 0, cmd_get_debounce},
+    {CONFIG_CMD_SET_DEBOUNCE, 4, cmd_set_debounce},
+    {CONFIG_CMD_GET_SENSOR_MODE, 0, cmd_get_sensor_mode},
+    {CONFIG_CMD_SET_SENSOR_MODE, 1, cmd_set_sensor_mode},
+    {CONFIG_CMD_GET_ACCEL, 0, cmd_get_accel},
+    {CONFIG_CMD_SET_ACCEL, 13, cmd_set_accel},
+    {CONFIG_CMD_SET_ACCEL_POINT, 6, cmd_set_accel_point},
+    {CONFIG_CMD_GET_XFORM, 0, cmd_get_xform},
+    {CONFIG_CMD_SET_XFORM, 5, cmd_set_xform},
+    {CONFIG_CMD_GET_CPI_STAGE, 1, cmd_get_cpi_stage},
+    {CONFIG_CMD_SET_CPI_STAGE, 6, cmd_set_cpi_stage},
+    {CONFIG_CMD_SELECT_CPI_STAGE, 1, cmd_select_cpi_stage},
+    {CONFIG_CMD_GET_STATS, 1, cmd_get_stats},
+    {CONFIG_CMD_GET_SURFACE, 0, cmd_get_surface},
+    {CONFIG_CMD_SET_SURFACE, 2, cmd_set_surface},
+    {CONFIG_CMD_GET_FILTER, 0, cmd_get_filter},
+    {CONFIG_CMD_SET_FILTER, 11, cmd_set_filter},
+    {CONFIG_CMD_GET_CAPTURE, 0, cmd_get_capture},
+    {CONFIG_CMD_SET_CAPTURE, 1, cmd_set_capture},
+    {CONFIG_CMD_WRITE_MACRO, 2, cmd_write_macro},
+    {CONFIG_CMD_STORE_MACRO, 3, cmd_store_macro},
+    {CONFIG_CMD_CLEAR_MACRO, 1, cmd_clear_macro},
+    {CONFIG_CMD_PLAY_MACRO, 1, cmd_play_macro},
+    {CONFIG_CMD_GET_MACRO, 2, cmd_get_macro},
+};
+
+size_t config_proto_handle(const config_ops_t *ops, const uint8_t *req, size_t req_len,
+                           uint8_t *rsp, size_t rsp_cap)
+{
+    if (req_len < 2 || rsp_cap < CONFIG_REPORT_LEN)
+    {
+        return 0;
+    }
+
+    // copy so handlers can read a fixed argument window without checking req_len
+    uint8_t args[CONFIG_REPORT_LEN - 2] = {0};
+    size_t args_len = req_len - 2;
+    if (args_len > sizeof(args))
+    {
+        args_len = sizeof(args);
+    }
+    memcpy(args, req + 2, args_len);
+
+    memset(rsp, 0, CONFIG_REPORT_LEN);
+    rsp[0] = req[0] | CONFIG_RSP_FLAG;
+    rsp[1] = req[1];
+
+    int status = CONFIG_STATUS_UNKNOWN_CMD;
+    size_t out_len = 0;
+
+    for (size_t i = 0; i < sizeof(config_table) / sizeof(config_table[0]); i++)
+    {
+        const config_entry_t *e = &config_table[i];
+        if (e->cmd != req[0])
+        {
+            continue;
+        }
+
+        if (args_len < e->args_len)
+        {
+            status = CONFIG_STATUS_BAD_LENGTH;
+        }
+        else
+        {
+            status = e->handler(ops, args, rsp + CONFIG_RSP_HDR, &out_len);
+        }
+        break;
+    }
+
+    rsp[2] = (uint8_t)status;
+    if (status != CONFIG_STATUS_OK)
+    {
+        memset(rsp + CONFIG_RSP_HDR, 0, CONFIG_RSP_PAYLOAD);
+    }
+
+    return CONFIG_REPORT_LEN;
+}
@@ -0,0 +1,119 @@
+#ifndef CONFIG_PROTO_H
+#define CONFIG_PROTO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "accel.h"
+#include "motion_xform.h"
+#include "cpi.h"
+#include "surface.h"
+#include "motion_filter.h"
+#include "macro.h"
+
+/*
+ * Configuration protocol carried in the vendor HID report (CONFIG_REPORT_ID).
+ * Pure C so it can be fed arbitrary bytes on the host.
+ *
+ * Request : [0] cmd  [1] seq  [2..] args (little endian)
+ * Response: [0] cmd | 0x80  [1] seq  [2] status  [3..] payload
+ *
+ * The host writes a request as an output or feature report and reads the
+ * response back with a feature get.
+ */
+
+#define CONFIG_REPORT_ID 2
+#define CONFIG_REPORT_LEN 16
+#define CONFIG_PROTO_VERSION 1
+
+#define CONFIG_RSP_FLAG 0x80
+#define CONFIG_RSP_HDR 3
+#define CONFIG_RSP_PAYLOAD (CONFIG_REPORT_LEN - CONFIG_RSP_HDR)
+
+typedef enum
+{
+    CONFIG_CMD_GET_VERSION = 0x01,
+    CONFIG_CMD_GET_DPI = 0x10,
+    CONFIG_CMD_SET_DPI = 0x11,
+    CONFIG_CMD_GET_RATE = 0x12,
+    CONFIG_CMD_SET_RATE = 0x13,
+    CONFIG_CMD_GET_DEBOUNCE = 0x14,
+    CONFIG_CMD_SET_DEBOUNCE = 0x15,
+    CONFIG_CMD_GET_SENSOR_MODE = 0x16,
+    CONFIG_CMD_SET_SENSOR_MODE = 0x17,
+    CONFIG_CMD_GET_ACCEL = 0x18,
+    CONFIG_CMD_SET_ACCEL = 0x19,       // curve u8, offset, accel, exponent, cap, midpoint, max_speed u16
+    CONFIG_CMD_SET_ACCEL_POINT = 0x1A, // index u8, speed u16, gain u16, point count u8
+    CONFIG_CMD_GET_XFORM = 0x1B,
+    CONFIG_CMD_SET_XFORM = 0x1C,       // rotation i16 (0.1 deg), axes u8, snap deg u8, hysteresis deg u8
+    CONFIG_CMD_GET_CPI_STAGE = 0x1D,    // index u8 -> index, count, current u8, x u16, y u16
+    CONFIG_CMD_SET_CPI_STAGE = 0x1E,    // index u8, x u16, y u16, stage count u8
+    CONFIG_CMD_SELECT_CPI_STAGE = 0x1F, // index u8
+    CONFIG_CMD_GET_STATS = 0x20,        // page u8
+    CONFIG_CMD_GET_SURFACE = 0x21,
+    CONFIG_CMD_SET_SURFACE = 0x22,      // SQUAL threshold u8, settle samples u8
+    CONFIG_CMD_GET_FILTER = 0x23,
+    CONFIG_CMD_SET_FILTER = 0x24,       // stages u8, average len u8, min cutoff, beta, d cutoff u16, deadzone enter, exit, quiet u8
+    CONFIG_CMD_GET_CAPTURE = 0x25,
+    CONFIG_CMD_SET_CAPTURE = 0x26,      // raw frame streaming on u8, not persisted
+    CONFIG_CMD_WRITE_MACRO = 0x27,      // offset u8, n u8, n program bytes into the staging buffer
+    CONFIG_CMD_STORE_MACRO = 0x28,      // slot u8, chord u8, len u8: store the first len staged bytes
+    CONFIG_CMD_CLEAR_MACRO = 0x29,      // slot u8
+    CONFIG_CMD_PLAY_MACRO = 0x2A,       // slot u8
+    CONFIG_CMD_GET_MACRO = 0x2B,        // slot u8, offset u8 -> slot, chord, len u8, program bytes from offset
+} config_cmd_t;
+
+typedef enum
+{
+    CONFIG_STATUS_OK = 0,
+    CONFIG_STATUS_UNKNOWN_CMD = 1,
+    CONFIG_STATUS_BAD_LENGTH = 2,
+    CONFIG_STATUS_BAD_VALUE = 3,
+    CONFIG_STATUS_UNSUPPORTED = 4,
+    CONFIG_STATUS_FAILED = 5,
+} config_status_t;
+
+/*
+ * Device side of the protocol. Any op may be NULL, the command then answers
+ * CONFIG_STATUS_UNSUPPORTED. Ops return a config_status_t.
+ */
+typedef struct
+{
+    int (*get_dpi)(uint16_t *dpi);
+    int (*set_dpi)(uint16_t dpi);
+    int (*get_rate)(uint16_t *hz);
+    int (*set_rate)(uint16_t hz);
+    int (*get_debounce)(uint16_t *click_us, uint16_t *scroll_us);
+    int (*set_debounce)(uint16_t click_us, uint16_t scroll_us);
+    int (*get_sensor_mode)(uint8_t *mode);
+    int (*set_sensor_mode)(uint8_t mode);
+    int (*get_accel)(accel_params_t *params);
+    int (*set_accel)(const accel_params_t *params);
+    int (*get_xform)(motion_xform_params_t *params);
+    int (*set_xform)(const motion_xform_params_t *params);
+    int (*get_cpi_stages)(cpi_stages_t *stages);
+    int (*set_cpi_stage)(uint8_t index, uint16_t x, uint16_t y, uint8_t count);
+    int (*select_cpi_stage)(uint8_t index);
+    int (*get_surface)(surface_params_t *params);
+    int (*set_surface)(const surface_params_t *params);
+    int (*get_filter)(motion_filter_params_t *params);
+    int (*set_filter)(const motion_filter_params_t *params);
+    int (*get_capture)(uint8_t *on);
+    int (*set_capture)(uint8_t on);
+    int (*write_macro)(uint8_t offset, const uint8_t *data, uint8_t n);
+    int (*store_macro)(uint8_t slot, uint8_t chord, uint8_t len);
+    int (*clear_macro)(uint8_t slot);
+    int (*play_macro)(uint8_t slot);
+    int (*get_macro)(uint8_t slot, macro_slot_t *macro);
+    // fill at most cap bytes of stats page `page`, set *len
+    int (*get_stats)(uint8_t page, uint8_t *out, size_t cap, size_t *len);
+} config_ops_t;
+
+/**
+ * @brief Handle one request, write the response.
+ * @return response length, 0 if the request is too short to answer
+ */
+size_t config_proto_handle(const config_ops_t *ops, const uint8_t *req, size_t req_len,
+                           uint8_t *rsp, size_t rsp_cap);
+
+#endif
@@ -0,0 +1,138 @@
+#include <string.h>
+
+#include "cpi.h"
+
+uint16_t cpi_clamp(uint16_t cpi)
+{
+    if (cpi <= CPI_MIN)
+    {
+        return CPI_MIN;
+    }
+    if (cpi >= CPI_MAX)
+    {
+        return CPI_MAX;
+    }
+
+    return (uint16_t)((cpi + CPI_STEP / 2) / CPI_STEP * CPI_STEP);
+}
+
+void cpi_encode(uint16_t cpi, uint8_t *low, uint8_t *high)
+{
+    uint16_t reg = cpi_clamp(cpi) / CPI_STEP - 1;
+
+    *low = reg & 0xFF;
+    *high = (reg >> 8) & 0x0F;
+}
+
+uint16_t cpi_decode(uint8_t low, uint8_t high)
+{
+    return (uint16_t)(((((high & 0x0F) << 8) | low) + 1) * CPI_STEP);
+}
+
+int cpi_program(const spi_transport_t *spi, uint16_t x, uint16_t y, void (*gap)(void))
+{
+    uint8_t x_low, x_high, y_low, y_high;
+
+    x = cpi_clamp(x);
+    y = cpi_clamp(y);
+    cpi_encode(x, &x_low, &x_high);
+    cpi_encode(y, &y_low, &y_high);
+
+    // RES_XY_SEL: 0 = both axes from RESOLUTION_X, 1 = Y from RESOLUTION_Y
+    const uint8_t seq[][2] = {
+        {0x7F, 0x00},
+        {MOTION_CTRL, x == y ? 0x00 : MOTION_CTRL_RES_XY_SEL},
+        {RESOLUTION_X_LOW, x_low},
+        {RESOLUTION_X_HIGH, x_high},
+        {RESOLUTION_Y_LOW, y_low},
+        {RESOLUTION_Y_HIGH, y_high},
+        {SET_RESOLUTION, 0x01}, // latch both axes at once
+    };
+
+    for (size_t i = 0; i < sizeof(seq) / sizeof(seq[0]); i++)
+    {
+        int err = spi->write(spi->ctx, seq[i][0], seq[i][1]);
+        if (err != SPI_TRANSPORT_OK)
+        {
+            return err;
+        }
+        if (gap)
+        {
+            gap();
+        }
+    }
+
+    return SPI_TRANSPORT_OK;
+}
+
+// every stage has a value, so raising count never selects an unset one
+static const uint16_t stage_defaults[CPI_STAGES_MAX] = {400, 800, 1600, 3200, 6400};
+
+void cpi_stages_default(cpi_stages_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->count = 4;
+    s->current = 2;
+    for (uint8_t i = 0; i < CPI_STAGES_MAX; i++)
+    {
+        s->stage[i].x = stage_defaults[i];
+        s->stage[i].y = stage_defaults[i];
+    }
+}
+
+void cpi_stages_sanitize(cpi_stages_t *s)
+{
+    if (s->count == 0 || s->count > CPI_STAGES_MAX)
+    {
+        cpi_stages_default(s);
+        return;
+    }
+    if (s->current >= s->count)
+    {
+        s->current = 0;
+    }
+    for (uint8_t i = 0; i < CPI_STAGES_MAX; i++)
+    {
+        // tables from before every stage had a default left the unused ones at 0
+        if (s->stage[i].x == 0 || s->stage[i].y == 0)
+        {
+            s->stage[i].x = stage_defaults[i];
+            s->stage[i].y = stage_defaults[i];
+        }
+        s->stage[i].x = cpi_clamp(s->stage[i].x);
+        s->stage[i].y = cpi_clamp(s->stage[i].y);
+    }
+}
+
+cpi_xy_t cpi_stages_next(cpi_stages_t *s)
+{
+    s->current = (uint8_t)((s->current + 1) % s->count);
+    return s->stage[s->current];
+}
+
+bool cpi_stages_select(cpi_stages_t *s, uint8_t index)
+{
+    if (index >= s->count)
+    {
+        return false;
+    }
+    s->current = index;
+    return true;
+}
+
+bool cpi_stages_set(cpi_stages_t *s, uint8_t index, uint16_t x, uint16_t y, uint8_t count)
+{
+    if (index >= CPI_STAGES_MAX || count == 0 || count > CPI_STAGES_MAX || index >= count)
+    {
+        return false;
+    }
+
+    s->stage[index].x = cpi_clamp(x);
+    s->stage[index].y = cpi_clamp(y);
+    s->count = count;
+    if (s->current >= count)
+    {
+        s->current = count - 1;
+    }
+    return true;
+}
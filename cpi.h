@@ -0,0 +1,92 @@
+#ifndef CPI_H
+#define CPI_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "spi_transport.h"
+
+/*
+ * CPI values, PAW3395 resolution register encoding and the stage table cycled
+ * by DPI_SWITCH_GPIO. No IDF dependency.
+ *
+ * The sensor resolution is programmed in CPI_STEP units:
+ *   CPI = (RESOLUTION + 1) * CPI_STEP, RESOLUTION is 12 bits split over LOW/HIGH.
+ */
+
+#define MOTION_CTRL 0x5C
+#define MOTION_CTRL_RES_XY_SEL 0x08
+
+#define SET_RESOLUTION 0x47
+#define RESOLUTION_X_LOW 0x48
+#define RESOLUTION_X_HIGH 0x49
+#define RESOLUTION_Y_LOW 0x4A
+#define RESOLUTION_Y_HIGH 0x4B
+
+#define CPI_MIN 50
+#define CPI_MAX 26000
+#define CPI_STEP 50
+
+#define CPI_STAGES_MAX 5
+
+typedef struct
+{
+    uint16_t x;
+    uint16_t y;
+} cpi_xy_t;
+
+typedef struct
+{
+    uint8_t count;   // stages in use, 1..CPI_STAGES_MAX
+    uint8_t current;
+    cpi_xy_t stage[CPI_STAGES_MAX];
+} cpi_stages_t;
+
+/**
+ * @brief Clamp to CPI_MIN..CPI_MAX and round to the nearest CPI_STEP.
+ */
+uint16_t cpi_clamp(uint16_t cpi);
+
+/**
+ * @brief Resolution register bytes for a (clamped) CPI value.
+ */
+void cpi_encode(uint16_t cpi, uint8_t *low, uint8_t *high);
+
+/**
+ * @brief CPI programmed by a pair of register bytes.
+ */
+uint16_t cpi_decode(uint8_t low, uint8_t high);
+
+/**
+ * @brief Program X/Y resolution through spi: bank 0, MOTION_CTRL RES_XY_SEL for
+ *        per-axis CPI, the four resolution bytes, then SET_RESOLUTION latches
+ *        both axes. gap (may be NULL) runs after every write, for tSWW.
+ * @return SPI_TRANSPORT_OK or the first transport error, the rest is not written
+ */
+int cpi_program(const spi_transport_t *spi, uint16_t x, uint16_t y, void (*gap)(void));
+
+void cpi_stages_default(cpi_stages_t *s);
+
+/**
+ * @brief Bring a stage table loaded from storage back into range.
+ */
+void cpi_stages_sanitize(cpi_stages_t *s);
+
+static inline cpi_xy_t cpi_stages_current(const cpi_stages_t *s)
+{
+    return s->stage[s->current];
+}
+
+/**
+ * @brief Advance to the next stage, wrapping around.
+ */
+cpi_xy_t cpi_stages_next(cpi_stages_t *s);
+
+bool cpi_stages_select(cpi_stages_t *s, uint8_t index);
+
+/**
+ * @brief Set stage index (clamping both axes) and the number of stages in use.
+ */
+bool cpi_stages_set(cpi_stages_t *s, uint8_t index, uint16_t x, uint16_t y, uint8_t count);
+
+#endif
@@ -13,6 +13,7 @@
 #include "freertos/semphr.h"
 
 #include "esp_hid_gap.h"
+#include "blog_log.h"
 
 #if CONFIG_BT_NIMBLE_ENABLED
 #include "host/ble_hs.h"
@@ -844,6 +845,10 @@ esp_err_t esp_hid_ble_gap_adv_start(void)
 extern void ble_hid_task_start_up(void);
 static struct ble_hs_adv_fields fields;
 
+/* the HID central, for connection parameter requests */
+static uint16_t hid_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+static uint16_t hid_conn_itvl;
+
 esp_err_t esp_hid_ble_gap_adv_init(uint16_t appearance, const char *device_name)
 {
     ble_uuid16_t *uuid16, *uuid16_1;
@@ -907,48 +912,50 @@ nimble_hid_gap_event(struct ble_gap_event *event, void *arg)
     {
     case BLE_GAP_EVENT_CONNECT:
         /* A new connection was established or a connection attempt failed. */
-        ESP_LOGI(TAG, "connection %s; status=%d",
-                 event->connect.status == 0 ? "established" : "failed",
-                 event->connect.status);
+        BLOG(GAP_CONNECT, event->connect.status, event->connect.conn_handle);
+        if (event->connect.status == 0)
+        {
+            hid_conn_handle = event->connect.conn_handle;
+            if (ble_gap_conn_find(hid_conn_handle, &desc) == 0)
+            {
+                hid_conn_itvl = desc.conn_itvl;
+            }
+        }
         return 0;
         break;
     case BLE_GAP_EVENT_DISCONNECT:
-        ESP_LOGI(TAG, "disconnect; reason=%d", event->disconnect.reason);
+        BLOG(GAP_DISCONNECT, event->disconnect.reason);
+        hid_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+        hid_conn_itvl = 0;
         return 0;
     case BLE_GAP_EVENT_CONN_UPDATE:
         /* The central has updated the connection parameters. */
-        ESP_LOGI(TAG, "connection updated; status=%d",
-                 event->conn_update.status);
+        BLOG(GAP_CONN_UPDATE, event->conn_update.status);
+        if (ble_gap_conn_find(event->conn_update.conn_handle, &desc) == 0)
+        {
+            hid_conn_itvl = desc.conn_itvl;
+            BLOG(GAP_CONN_PARAMS, desc.conn_itvl, desc.conn_latency, desc.supervision_timeout);
+        }
         return 0;
 
     case BLE_GAP_EVENT_ADV_COMPLETE:
-        ESP_LOGI(TAG, "advertise complete; reason=%d",
-                 event->adv_complete.reason);
+        BLOG(GAP_ADV_COMPLETE, event->adv_complete.reason);
         return 0;
 
     case BLE_GAP_EVENT_SUBSCRIBE:
-        ESP_LOGI(TAG, "subscribe event; conn_handle=%d attr_handle=%d "
-                      "reason=%d prevn=%d curn=%d previ=%d curi=%d\n",
-                 event->subscribe.conn_handle,
-                 event->subscribe.attr_handle,
-                 event->subscribe.reason,
-                 event->subscribe.prev_notify,
-                 event->subscribe.cur_notify,
-                 event->subscribe.prev_indicate,
-                 event->subscribe.cur_indicate);
+        // previous and current state as one hex digit each: 0x01 = turned on
+        BLOG(GAP_SUBSCRIBE, event->subscribe.conn_handle, event->subscribe.attr_handle,
+             event->subscribe.prev_notify << 4 | event->subscribe.cur_notify,
+             event->subscribe.prev_indicate << 4 | event->subscribe.cur_indicate);
         return 0;
 
     case BLE_GAP_EVENT_MTU:
-        ESP_LOGI(TAG, "mtu update event; conn_handle=%d cid=%d mtu=%d",
-                 event->mtu.conn_handle,
-                 event->mtu.channel_id,
-                 event->mtu.value);
+        BLOG(GAP_MTU, event->mtu.conn_handle, event->mtu.channel_id, event->mtu.value);
         return 0;
 
     case BLE_GAP_EVENT_ENC_CHANGE:
         /* Encryption has been enabled or disabled for this connection. */
-        MODLOG_DFLT(INFO, "encryption change event; status=%d ",
-                    event->enc_change.status);
+        BLOG(GAP_ENC_CHANGE, event->enc_change.status);
         rc = ble_gap_conn_find(event->enc_change.conn_handle, &desc);
         assert(rc == 0);
         ble_hid_task_start_up();
@@ -980,7 +987,6 @@ nimble_hid_gap_event(struct ble_gap_event *event, void *arg)
         return BLE_GAP_REPEAT_PAIRING_RETRY;
 
     case BLE_GAP_EVENT_PASSKEY_ACTION:
-        ESP_LOGI(TAG, "PASSKEY_ACTION_EVENT started");
         struct ble_sm_io pkey = {0};
         int key = 0;
 
@@ -990,15 +996,14 @@ nimble_hid_gap_event(struct ble_gap_event *event, void *arg)
             pkey.passkey = 123456; // This is the passkey to be entered on peer
             ESP_LOGI(TAG, "Enter passkey %" PRIu32 "on the peer side", pkey.passkey);
             rc = ble_sm_inject_io(event->passkey.conn_handle, &pkey);
-            ESP_LOGI(TAG, "ble_sm_inject_io result: %d", rc);
+            BLOG(GAP_PASSKEY, pkey.action, rc);
         }
         else if (event->passkey.params.action == BLE_SM_IOACT_NUMCMP)
         {
-            ESP_LOGI(TAG, "Accepting passkey..");
-            pkey.action = event->passkey.params.action;
+                pkey.action = event->passkey.params.action;
             pkey.numcmp_accept = key;
             rc = ble_sm_inject_io(event->passkey.conn_handle, &pkey);
-            ESP_LOGI(TAG, "ble_sm_inject_io result: %d", rc);
+            BLOG(GAP_PASSKEY, pkey.action, rc);
         }
         else if (event->passkey.params.action == BLE_SM_IOACT_OOB)
         {
@@ -1009,20 +1014,48 @@ nimble_hid_gap_event(struct ble_gap_event *event, void *arg)
                 pkey.oob[i] = tem_oob[i];
             }
             rc = ble_sm_inject_io(event->passkey.conn_handle, &pkey);
-            ESP_LOGI(TAG, "ble_sm_inject_io result: %d", rc);
+            BLOG(GAP_PASSKEY, pkey.action, rc);
         }
         else if (event->passkey.params.action == BLE_SM_IOACT_INPUT)
         {
-            ESP_LOGI(TAG, "Input not supported passing -> 123456");
-            pkey.action = event->passkey.params.action;
+                pkey.action = event->passkey.params.action;
             pkey.passkey = 123456;
             rc = ble_sm_inject_io(event->passkey.conn_handle, &pkey);
-            ESP_LOGI(TAG, "ble_sm_inject_io result: %d", rc);
+            BLOG(GAP_PASSKEY, pkey.action, rc);
         }
         return 0;
     }
     return 0;
 }
+esp_err_t esp_hid_ble_gap_conn_update(uint16_t itvl_min, uint16_t itvl_max, uint16_t latency, uint16_t timeout)
+{
+    struct ble_gap_upd_params params = {
+        .itvl_min = itvl_min,
+        .itvl_max = itvl_max,
+        .latency = latency,
+        .supervision_timeout = timeout,
+    };
+    int rc;
+
+    if (hid_conn_handle == BLE_HS_CONN_HANDLE_NONE)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    rc = ble_gap_update_params(hid_conn_handle, &params);
+    if (rc != 0)
+    {
+        ESP_LOGW(TAG, "connection update request failed; rc=%d", rc);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+uint16_t esp_hid_ble_gap_conn_itvl(void)
+{
+    return hid_conn_itvl;
+}
+
 esp_err_t esp_hid_ble_gap_adv_start(void)
 {
     int rc;
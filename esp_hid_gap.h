@@ -78,6 +78,19 @@ esp_err_t esp_hid_gap_init(uint8_t mode);
 esp_err_t esp_hid_ble_gap_adv_init(uint16_t appearance, const char *device_name);
 esp_err_t esp_hid_ble_gap_adv_start(void);
 
+#if CONFIG_BT_NIMBLE_ENABLED
+/**
+ * @brief Ask the connected central for new connection parameters (controller units).
+ * @return ESP_ERR_INVALID_STATE when not connected
+ */
+esp_err_t esp_hid_ble_gap_conn_update(uint16_t itvl_min, uint16_t itvl_max, uint16_t latency, uint16_t timeout);
+
+/**
+ * @brief Current connection interval in 1.25 ms units, 0 when not connected.
+ */
+uint16_t esp_hid_ble_gap_conn_itvl(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,428 @@
+#include <string.h>
+
+#include "hid_desc.h"
+
+#define HID_ITEM_MAIN 0
+#define HID_ITEM_GLOBAL 1
+#define HID_ITEM_LOCAL 2
+#define HID_ITEM_LONG 0xFE
+
+#define HID_USAGES_MAX 8
+
+typedef struct
+{
+    uint16_t usage_page;
+    int32_t logical_min;
+    int32_t logical_max;
+    uint32_t logical_max_u; // for a maximum written without its sign bit cleared
+    uint8_t report_size;
+    uint16_t report_count;
+    uint8_t report_id;
+} hid_global_t;
+
+typedef struct
+{
+    uint32_t usages[HID_USAGES_MAX]; // page << 16 | usage when the page was given
+    size_t n_usages;
+    uint32_t usage_min;
+    uint32_t usage_max;
+    bool has_min;
+    bool has_max;
+} hid_local_t;
+
+typedef struct
+{
+    hid_layout_t *out;
+    hid_global_t g;
+    hid_global_t stack[HID_DESC_STACK_MAX];
+    size_t sp;
+    hid_local_t l;
+    int depth;
+    bool ids;    // some main item had a report ID
+    bool no_ids; // some main item had none
+} hid_parser_t;
+
+static const char *const err_str[] = {
+    [HID_DESC_OK] = "ok",
+    [HID_DESC_TRUNCATED] = "truncated item",
+    [HID_DESC_BAD_ITEM] = "reserved item",
+    [HID_DESC_COLLECTION] = "unbalanced collection",
+    [HID_DESC_STACK] = "push/pop mismatch",
+    [HID_DESC_NO_SIZE] = "missing report size or count",
+    [HID_DESC_BAD_REPORT_ID] = "bad report ID",
+    [HID_DESC_BAD_RANGE] = "logical minimum above maximum",
+    [HID_DESC_UNALIGNED] = "report not byte aligned",
+    [HID_DESC_TOO_MANY] = "too many fields or reports",
+};
+
+const char *hid_desc_err_str(hid_desc_err_t err)
+{
+    return (unsigned)err < sizeof(err_str) / sizeof(err_str[0]) ? err_str[err] : "?";
+}
+
+static hid_report_info_t *report_get(hid_layout_t *l, uint8_t id, uint8_t type)
+{
+    for (size_t i = 0; i < l->n_reports; i++)
+    {
+        if (l->reports[i].id == id && l->reports[i].type == type)
+        {
+            return &l->reports[i];
+        }
+    }
+    if (l->n_reports == HID_DESC_REPORTS_MAX)
+    {
+        return NULL;
+    }
+
+    hid_report_info_t *r = &l->reports[l->n_reports++];
+    r->id = id;
+    r->type = type;
+    r->bits = 0;
+    return r;
+}
+
+static uint16_t usage_page_of(const hid_parser_t *p, uint32_t usage)
+{
+    return usage > 0xFFFF ? (uint16_t)(usage >> 16) : p->g.usage_page;
+}
+
+static hid_desc_err_t add_field(hid_parser_t *p, hid_report_info_t *r, uint8_t type, uint8_t flags,
+                                uint32_t usage, uint32_t usage_max, uint16_t count)
+{
+    if (p->out->n_fields == HID_DESC_FIELDS_MAX)
+    {
+        return HID_DESC_TOO_MANY;
+    }
+
+    hid_field_t *f = &p->out->fields[p->out->n_fields++];
+    f->report_id = p->g.report_id;
+    f->type = type;
+    f->flags = flags;
+    f->size = p->g.report_size;
+    f->count = count;
+    f->bit_offset = r->bits;
+    f->usage_page = usage_page_of(p, usage);
+    f->usage = (uint16_t)usage;
+    f->usage_max = (uint16_t)usage_max;
+    f->logical_min = p->g.logical_min;
+    f->logical_max = p->g.logical_max;
+    if (p->g.logical_min >= 0 && p->g.logical_max < 0)
+    {
+        f->logical_max = (int32_t)p->g.logical_max_u;
+    }
+
+    r->bits += f->size * count;
+    return HID_DESC_OK;
+}
+
+static hid_desc_err_t main_data(hid_parser_t *p, uint8_t type, uint32_t data)
+{
+    const hid_global_t *g = &p->g;
+    uint8_t flags = data & (HID_FIELD_CONST | HID_FIELD_VARIABLE | HID_FIELD_RELATIVE);
+
+    if (g->report_size == 0 || g->report_size > 32 || g->report_count == 0)
+    {
+        return HID_DESC_NO_SIZE;
+    }
+    if (g->report_id)
+    {
+        p->ids = true;
+    }
+    else
+    {
+        p->no_ids = true;
+    }
+    if (p->ids && p->no_ids)
+    {
+        return HID_DESC_BAD_REPORT_ID;
+    }
+
+    hid_report_info_t *r = report_get(p->out, g->report_id, type);
+    if (r == NULL)
+    {
+        return HID_DESC_TOO_MANY;
+    }
+    if ((uint32_t)r->bits + (uint32_t)g->report_size * g->report_count > UINT16_MAX)
+    {
+        return HID_DESC_TOO_MANY;
+    }
+
+    if (flags & HID_FIELD_CONST)
+    {
+        r->bits += g->report_size * g->report_count;
+        return HID_DESC_OK;
+    }
+
+    int32_t lmax = g->logical_min >= 0 && g->logical_max < 0 ? (int32_t)g->logical_max_u : g->logical_max;
+    if (g->logical_min > lmax)
+    {
+        return HID_DESC_BAD_RANGE;
+    }
+
+    const hid_local_t *l = &p->l;
+    if (l->n_usages > 1)
+    {
+        // one field per listed usage, the last usage repeats for the rest
+        uint16_t left = g->report_count;
+        for (size_t i = 0; i < l->n_usages && left; i++)
+        {
+            uint16_t count = i + 1 == l->n_usages ? left : 1;
+            hid_desc_err_t err = add_field(p, r, type, flags, l->usages[i], l->usages[i], count);
+            if (err != HID_DESC_OK)
+            {
+                return err;
+            }
+            left -= count;
+        }
+        return HID_DESC_OK;
+    }
+
+    uint32_t usage = l->n_usages ? l->usages[0] : l->usage_min;
+    uint32_t usage_max = l->n_usages ? usage : l->has_max ? l->usage_max : usage;
+    return add_field(p, r, type, flags, usage, usage_max, g->report_count);
+}
+
+static hid_desc_err_t item_main(hid_parser_t *p, uint8_t tag, uint32_t data)
+{
+    hid_desc_err_t err = HID_DESC_OK;
+
+    switch (tag)
+    {
+    case 0x8:
+        err = main_data(p, HID_REPORT_INPUT, data);
+        break;
+    case 0x9:
+        err = main_data(p, HID_REPORT_OUTPUT, data);
+        break;
+    case 0xB:
+        err = main_data(p, HID_REPORT_FEATURE, data);
+        break;
+    case 0xA:
+        p->depth++;
+        break;
+    case 0xC:
+        if (--p->depth < 0)
+        {
+            return HID_DESC_COLLECTION;
+        }
+        break;
+    default:
+        return HID_DESC_BAD_ITEM;
+    }
+
+    // local items only last until the next main item
+    memset(&p->l, 0, sizeof(p->l));
+    return err;
+}
+
+static hid_desc_err_t item_global(hid_parser_t *p, uint8_t tag, uint32_t u, int32_t s)
+{
+    hid_global_t *g = &p->g;
+
+    switch (tag)
+    {
+    case 0x0:
+        g->usage_page = (uint16_t)u;
+        break;
+    case 0x1:
+        g->logical_min = s;
+        break;
+    case 0x2:
+        g->logical_max = s;
+        g->logical_max_u = u;
+        break;
+    case 0x3: // physical range, unit exponent, unit: not needed for the layout
+    case 0x4:
+    case 0x5:
+    case 0x6:
+        break;
+    case 0x7:
+        g->report_size = u > 0xFF ? 0 : (uint8_t)u;
+        break;
+    case 0x8:
+        if (u == 0 || u > 0xFF)
+        {
+            return HID_DESC_BAD_REPORT_ID;
+        }
+        g->report_id = (uint8_t)u;
+        break;
+    case 0x9:
+        g->report_count = u > 0xFFFF ? 0 : (uint16_t)u;
+        break;
+    case 0xA:
+        if (p->sp == HID_DESC_STACK_MAX)
+        {
+            return HID_DESC_STACK;
+        }
+        p->stack[p->sp++] = *g;
+        break;
+    case 0xB:
+        if (p->sp == 0)
+        {
+            return HID_DESC_STACK;
+        }
+        *g = p->stack[--p->sp];
+        break;
+    default:
+        return HID_DESC_BAD_ITEM;
+    }
+
+    return HID_DESC_OK;
+}
+
+static hid_desc_err_t item_local(hid_parser_t *p, uint8_t tag, uint32_t u, uint8_t size)
+{
+    hid_local_t *l = &p->l;
+
+    // a 4-byte usage carries its own page in the upper half
+    if (size < 4)
+    {
+        u &= 0xFFFF;
+    }
+
+    switch (tag)
+    {
+    case 0x0:
+        if (l->n_usages == HID_USAGES_MAX)
+        {
+            return HID_DESC_TOO_MANY;
+        }
+        l->usages[l->n_usages++] = u;
+        break;
+    case 0x1:
+        l->usage_min = u;
+        l->has_min = true;
+        break;
+    case 0x2:
+        l->usage_max = u;
+        l->has_max = true;
+        break;
+    default: // designators, strings, delimiters
+        break;
+    }
+
+    return HID_DESC_OK;
+}
+
+hid_desc_err_t hid_desc_parse(const uint8_t *desc, size_t len, hid_layout_t *out)
+{
+    hid_parser_t p;
+    size_t i = 0;
+
+    memset(out, 0, sizeof(*out));
+    memset(&p, 0, sizeof(p));
+    p.out = out;
+
+    while (i < len)
+    {
+        uint8_t prefix = desc[i];
+        hid_desc_err_t err = HID_DESC_OK;
+
+        out->err_offset = i;
+
+        if (prefix == HID_ITEM_LONG)
+        {
+            if (i + 3 > len || i + 3 + desc[i + 1] > len)
+            {
+                return HID_DESC_TRUNCATED;
+            }
+            i += 3 + desc[i + 1]; // no long items are defined, skip
+            continue;
+        }
+
+        uint8_t size = prefix & 3;
+        uint8_t type = (prefix >> 2) & 3;
+        uint8_t tag = prefix >> 4;
+        if (size == 3)
+        {
+            size = 4;
+        }
+        if (i + 1 + size > len)
+        {
+            return HID_DESC_TRUNCATED;
+        }
+
+        uint32_t u = 0;
+        for (uint8_t k = 0; k < size; k++)
+        {
+            u |= (uint32_t)desc[i + 1 + k] << (8 * k);
+        }
+        int32_t s = (int32_t)u;
+        if (size && size < 4 && (u >> (8 * size - 1)) & 1)
+        {
+            s = (int32_t)(u | (~0u << (8 * size)));
+        }
+
+        switch (type)
+        {
+        case HID_ITEM_MAIN:
+            err = item_main(&p, tag, u);
+            break;
+        case HID_ITEM_GLOBAL:
+            err = item_global(&p, tag, u, s);
+            break;
+        case HID_ITEM_LOCAL:
+            err = item_local(&p, tag, u, size);
+            break;
+        default:
+            err = HID_DESC_BAD_ITEM;
+            break;
+        }
+        if (err != HID_DESC_OK)
+        {
+            return err;
+        }
+
+        i += 1 + size;
+    }
+
+    out->err_offset = len;
+    if (p.depth != 0)
+    {
+        return HID_DESC_COLLECTION;
+    }
+    for (size_t k = 0; k < out->n_reports; k++)
+    {
+        if (out->reports[k].bits % 8)
+        {
+            return HID_DESC_UNALIGNED;
+        }
+    }
+
+    return HID_DESC_OK;
+}
+
+size_t hid_layout_report_len(const hid_layout_t *l, uint8_t report_id, hid_report_type_t type)
+{
+    for (size_t i = 0; i < l->n_reports; i++)
+    {
+        if (l->reports[i].id == report_id && l->reports[i].type == type)
+        {
+            return l->reports[i].bits / 8;
+        }
+    }
+    return 0;
+}
+
+const hid_field_t *hid_layout_find(const hid_layout_t *l, uint8_t report_id, hid_report_type_t type,
+                                   uint16_t usage_page, uint16_t usage, unsigned *index)
+{
+    for (size_t i = 0; i < l->n_fields; i++)
+    {
+        const hid_field_t *f = &l->fields[i];
+        if (f->report_id != report_id || f->type != type || f->usage_page != usage_page)
+        {
+            continue;
+        }
+        if (usage < f->usage || usage > f->usage_max || usage - f->usage >= f->count)
+        {
+            continue;
+        }
+        if (index)
+        {
+            *index = usage - f->usage;
+        }
+        return f;
+    }
+    return NULL;
+}
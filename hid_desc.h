@@ -0,0 +1,124 @@
+#ifndef HID_DESC_H
+#define HID_DESC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * HID report descriptor parser and validator. No IDF dependency.
+ *
+ * Walks short and long items with the global state (including Push/Pop) and
+ * the local usages, and turns every Input/Output/Feature main item into a
+ * field with its bit offset inside its report. Offsets exclude the report ID
+ * byte, matching what the BLE HID layer passes around.
+ *
+ * A main item with a list of usages (X, Y) becomes one field per usage, the
+ * last one taking the remaining count; a usage range stays one field.
+ * Constant (padding) items only advance the offset.
+ */
+
+#define HID_DESC_FIELDS_MAX 32
+#define HID_DESC_REPORTS_MAX 8
+#define HID_DESC_STACK_MAX 4
+
+typedef enum
+{
+    HID_DESC_OK = 0,
+    HID_DESC_TRUNCATED,        // item runs past the end
+    HID_DESC_BAD_ITEM,         // reserved item type or tag
+    HID_DESC_COLLECTION,       // End Collection without Collection, or left open
+    HID_DESC_STACK,            // Push/Pop overflow or underflow
+    HID_DESC_NO_SIZE,          // main item before Report Size / Count
+    HID_DESC_BAD_REPORT_ID,    // ID 0, or fields both with and without IDs
+    HID_DESC_BAD_RANGE,        // Logical Minimum above Maximum
+    HID_DESC_UNALIGNED,        // report not a whole number of bytes
+    HID_DESC_TOO_MANY,         // more fields or reports than the layout holds
+} hid_desc_err_t;
+
+typedef enum
+{
+    HID_REPORT_INPUT = 0,
+    HID_REPORT_OUTPUT,
+    HID_REPORT_FEATURE,
+} hid_report_type_t;
+
+#define HID_FIELD_CONST 0x01
+#define HID_FIELD_VARIABLE 0x02
+#define HID_FIELD_RELATIVE 0x04
+
+typedef struct
+{
+    uint8_t report_id; // 0 when the descriptor uses no IDs
+    uint8_t type;      // hid_report_type_t
+    uint8_t flags;     // main item data bits 0..2
+    uint8_t size;      // bits per element
+    uint16_t count;
+    uint16_t bit_offset;
+    uint16_t usage_page;
+    uint16_t usage;     // first usage, or Usage Minimum
+    uint16_t usage_max; // last usage of a range, else usage
+    int32_t logical_min;
+    int32_t logical_max;
+} hid_field_t;
+
+typedef struct
+{
+    uint8_t id;
+    uint8_t type;
+    uint16_t bits;
+} hid_report_info_t;
+
+typedef struct
+{
+    hid_field_t fields[HID_DESC_FIELDS_MAX];
+    size_t n_fields;
+    hid_report_info_t reports[HID_DESC_REPORTS_MAX];
+    size_t n_reports;
+    size_t err_offset; // descriptor offset of the item that failed
+} hid_layout_t;
+
+/**
+ * @brief Parse and validate a report descriptor.
+ */
+hid_desc_err_t hid_desc_parse(const uint8_t *desc, size_t len, hid_layout_t *out);
+
+const char *hid_desc_err_str(hid_desc_err_t err);
+
+/**
+ * @brief Report length in bytes without the ID byte, 0 if the report does not exist.
+ */
+size_t hid_layout_report_len(const hid_layout_t *l, uint8_t report_id, hid_report_type_t type);
+
+/**
+ * @brief Field carrying usage (page, usage), covering usage ranges. NULL if none.
+ * @param index element of the field for that usage, may be NULL
+ */
+const hid_field_t *hid_layout_find(const hid_layout_t *l, uint8_t report_id, hid_report_type_t type,
+                                   uint16_t usage_page, uint16_t usage, unsigned *index);
+
+/**
+ * @brief Element `index` of a field from a report (without the ID byte),
+ *        sign-extended when the logical minimum is negative.
+ */
+static inline int32_t hid_field_get(const hid_field_t *f, const uint8_t *report, unsigned index)
+{
+    unsigned bit = f->bit_offset + index * f->size;
+    const uint8_t *p = report + (bit >> 3);
+    unsigned n = ((bit & 7) + f->size + 7) >> 3;
+    uint64_t v = 0;
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        v |= (uint64_t)p[i] << (8 * i);
+    }
+    v = (v >> (bit & 7)) & ((1ULL << f->size) - 1);
+
+    if (f->logical_min < 0 && f->size < 32 && (v >> (f->size - 1)) & 1)
+    {
+        v |= ~0ULL << f->size;
+    }
+    return (int32_t)v;
+}
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef HID_REPORT_H
+#define HID_REPORT_H
+
+#include <stdint.h>
+
+/*
+ * Building blocks for HID input reports declared once as a field list, from
+ * which both the report descriptor bytes and the packer are expanded at
+ * compile time. No IDF dependency.
+ *
+ * A field list is an X-macro of X(name, kind, bits, page, usage):
+ *   BUTTONS  `bits` buttons from Button 1, one bit each
+ *   PAD      `bits` constant bits
+ *   REL      signed relative value, clamped to +-(2^(bits-1) - 1)
+ *   VENDOR   unsigned absolute value, 0 .. 2^bits - 1
+ * Fields are packed LSB first in list order, as the host parses them.
+ * REL and VENDOR fields are at most 16 bits wide.
+ */
+
+#define HID_PAGE_DESKTOP 0x01
+#define HID_PAGE_BUTTON 0x09
+#define HID_PAGE_CONSUMER 0x0C
+#define HID_PAGE_VENDOR 0xFF00
+
+#define HID_USAGE_X 0x30
+#define HID_USAGE_Y 0x31
+#define HID_USAGE_WHEEL 0x38
+#define HID_USAGE_AC_PAN 0x0238
+
+#define HID_LMAX(bits) ((1L << ((bits) - 1)) - 1)
+#define HID_UMAX(bits) ((1UL << (bits)) - 1)
+
+#define HID_LE16(v) (((unsigned long)(v)) & 0xFF), ((((unsigned long)(v)) >> 8) & 0xFF)
+#define HID_LE32(v) HID_LE16(v), HID_LE16(((unsigned long)(v)) >> 16)
+
+// descriptor items per field kind, each ends with a comma
+#define HID_DESC_BUTTONS(bits, page, usage)                                                              \
+    0x05, HID_PAGE_BUTTON, 0x19, 0x01, 0x29, (bits), 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, (bits), \
+        0x81, 0x02, // Input (Data,Var,Abs)
+#define HID_DESC_PAD(bits, page, usage) 0x75, (bits), 0x95, 0x01, 0x81, 0x03, // Input (Const,Var,Abs)
+#define HID_DESC_REL(bits, page, usage)                                                                 \
+    0x06, HID_LE16(page), 0x0A, HID_LE16(usage), 0x16, HID_LE16(-HID_LMAX(bits)), 0x26,                 \
+        HID_LE16(HID_LMAX(bits)), 0x75, (bits), 0x95, 0x01, 0x81, 0x06, // Input (Data,Var,Rel)
+#define HID_DESC_VENDOR(bits, page, usage)                                                              \
+    0x06, HID_LE16(page), 0x0A, HID_LE16(usage), 0x15, 0x00, 0x27, HID_LE32(HID_UMAX(bits)), 0x75,      \
+        (bits), 0x95, 0x01, 0x81, 0x02, // Input (Data,Var,Abs)
+
+// report struct members per field kind
+#define HID_MEMBER_BUTTONS(name) uint32_t name;
+#define HID_MEMBER_PAD(name)
+#define HID_MEMBER_REL(name) int32_t name;
+#define HID_MEMBER_VENDOR(name) uint32_t name;
+
+// packing per field kind; value is not evaluated for PAD
+#define HID_PACK_BUTTONS(buf, value, bit, bits) hid_put_bits(buf, bit, bits, (uint32_t)(value));
+#define HID_PACK_PAD(buf, value, bit, bits)
+#define HID_PACK_REL(buf, value, bit, bits) hid_put_bits(buf, bit, bits, (uint32_t)hid_clamp(value, HID_LMAX(bits)));
+#define HID_PACK_VENDOR(buf, value, bit, bits) hid_put_bits(buf, bit, bits, (uint32_t)(value));
+
+static inline int32_t hid_clamp(int32_t v, int32_t max)
+{
+    return v > max ? max : v < -max ? -max : v;
+}
+
+/* OR `bits` bits of v into buf at bit offset `bit`; constant arguments fold to a few shifts */
+static inline void hid_put_bits(uint8_t *buf, unsigned bit, unsigned bits, uint32_t v)
+{
+    uint64_t m = ((uint64_t)v & ((1ULL << bits) - 1)) << (bit & 7);
+    uint8_t *p = buf + (bit >> 3);
+    unsigned n = ((bit & 7) + bits + 7) >> 3;
+
+    for (unsigned i = 0; i < n; i++)
+    {
+        p[i] |= (uint8_t)(m >> (8 * i));
+    }
+}
+
+#endif
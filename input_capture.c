@@ -0,0 +1,208 @@
+#include <string.h>
+
+#include "input_capture.h"
+
+size_t input_ring_pop(input_ring_t *r, input_snap_t *out, size_t max)
+{
+    uint32_t tail = r->tail;
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    size_t n = 0;
+
+    while (tail != head && n < max)
+    {
+        out[n++] = r->buf[tail & (INPUT_RING_LEN - 1)];
+        tail++;
+    }
+    __atomic_store_n(&r->tail, tail, __ATOMIC_RELEASE);
+
+    return n;
+}
+
+static bool window_open(input_window_t *w, uint32_t now, uint32_t len)
+{
+    if (!w->settled && now - w->at >= len)
+    {
+        w->settled = true;
+    }
+    return w->settled;
+}
+
+static void window_restart(input_window_t *w, uint32_t now, uint32_t len)
+{
+    w->at = now;
+    w->settled = len == 0;
+}
+
+static inline bool pin_low(uint64_t pins, uint8_t gpio)
+{
+    return !((pins >> gpio) & 1);
+}
+
+static uint8_t enc_state(const input_decoder_t *d, uint64_t pins)
+{
+    return (uint8_t)(((pins >> d->cfg.enc_a) & 1) << 1 | ((pins >> d->cfg.enc_b) & 1));
+}
+
+void input_decoder_init(input_decoder_t *d, const input_config_t *cfg, uint64_t pins)
+{
+    memset(d, 0, sizeof(*d));
+    d->cfg = *cfg;
+    d->pins = pins;
+
+    for (uint8_t i = 0; i < cfg->n_buttons; i++)
+    {
+        if (pin_low(pins, cfg->buttons[i].gpio))
+        {
+            d->buttons |= 1u << cfg->buttons[i].bit;
+        }
+        d->button_win[i].settled = true;
+    }
+    d->enc = enc_state(d, pins);
+    d->enc_win.settled = true;
+    d->dpi_down = cfg->dpi_gpio >= 0 && pin_low(pins, (uint8_t)cfg->dpi_gpio);
+    d->dpi_win.settled = true;
+}
+
+void input_decoder_set_debounce(input_decoder_t *d, uint32_t click_cycles, uint32_t scroll_cycles)
+{
+    d->cfg.click_cycles = click_cycles;
+    d->cfg.scroll_cycles = scroll_cycles;
+}
+
+static inline void count(uint8_t *c)
+{
+    if (*c < UINT8_MAX)
+    {
+        (*c)++;
+    }
+}
+
+static void decode_buttons(input_decoder_t *d, uint64_t pins, uint32_t now, input_events_t *ev)
+{
+    for (uint8_t i = 0; i < d->cfg.n_buttons; i++)
+    {
+        uint8_t mask = 1u << d->cfg.buttons[i].bit;
+        bool down = pin_low(pins, d->cfg.buttons[i].gpio);
+
+        if (down == ((d->buttons & mask) != 0))
+        {
+            continue;
+        }
+        // a change inside the window is contact bounce; counted on the edge, not on every tick re-checking it
+        if (!window_open(&d->button_win[i], now, d->cfg.click_cycles))
+        {
+            if (down != pin_low(d->pins, d->cfg.buttons[i].gpio))
+            {
+                count(&ev->bounces);
+            }
+            continue;
+        }
+        d->buttons ^= mask;
+        window_restart(&d->button_win[i], now, d->cfg.click_cycles);
+        ev->buttons = d->buttons;
+        ev->buttons_changed = true;
+    }
+}
+
+static void decode_wheel(input_decoder_t *d, uint64_t pins, uint32_t now, input_events_t *ev)
+{
+    uint8_t enc = enc_state(d, pins);
+    int8_t step;
+
+    if (enc == d->enc)
+    {
+        return;
+    }
+
+    switch ((d->enc << 2) | enc)
+    {
+    case 0x1: case 0x7: case 0xE: case 0x8:
+        step = -1;
+        break;
+    case 0x2: case 0xB: case 0xD: case 0x4:
+        step = 1;
+        break;
+    default:
+        step = 0; // both lines changed, an edge was missed: resync
+        count(&ev->enc_invalid);
+        break;
+    }
+    d->enc = enc;
+
+    if (step && !window_open(&d->enc_win, now, d->cfg.scroll_cycles))
+    {
+        count(&ev->bounces);
+    }
+    else if (step)
+    {
+        window_restart(&d->enc_win, now, d->cfg.scroll_cycles);
+        if ((step > 0 && ev->vertical < INT8_MAX) || (step < 0 && ev->vertical > INT8_MIN))
+        {
+            ev->vertical += step;
+        }
+    }
+}
+
+static void decode_dpi(input_decoder_t *d, uint64_t pins, uint32_t now, input_events_t *ev)
+{
+    bool down = pin_low(pins, (uint8_t)d->cfg.dpi_gpio);
+
+    if (down == d->dpi_down)
+    {
+        return;
+    }
+    d->dpi_down = down;
+
+    // press edge only
+    if (down && !window_open(&d->dpi_win, now, d->cfg.click_cycles))
+    {
+        count(&ev->bounces);
+    }
+    else if (down)
+    {
+        window_restart(&d->dpi_win, now, d->cfg.click_cycles);
+        if (ev->dpi_presses < UINT8_MAX)
+        {
+            ev->dpi_presses++;
+        }
+    }
+}
+
+bool input_decoder_pending(const input_decoder_t *d)
+{
+    for (uint8_t i = 0; i < d->cfg.n_buttons; i++)
+    {
+        bool down = pin_low(d->pins, d->cfg.buttons[i].gpio);
+        if (down != ((d->buttons >> d->cfg.buttons[i].bit) & 1))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void input_decode(input_decoder_t *d, const input_snap_t *snaps, size_t n, input_events_t *ev)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t pins = snaps[i].pins;
+        uint32_t now = snaps[i].cycles;
+
+        decode_buttons(d, pins, now, ev);
+        decode_wheel(d, pins, now, ev);
+        if (d->cfg.dpi_gpio >= 0)
+        {
+            decode_dpi(d, pins, now, ev);
+        }
+        d->pins = pins;
+    }
+}
+
+void input_decoder_tick(input_decoder_t *d, uint32_t cycles, input_events_t *ev)
+{
+    window_open(&d->enc_win, cycles, d->cfg.scroll_cycles);
+    window_open(&d->dpi_win, cycles, d->cfg.click_cycles);
+
+    // the last level seen is the real one once its window has passed
+    decode_buttons(d, d->pins, cycles, ev);
+}
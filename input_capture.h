@@ -0,0 +1,133 @@
+#ifndef INPUT_CAPTURE_H
+#define INPUT_CAPTURE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Button, wheel and DPI switch capture. No IDF dependency.
+ *
+ * The GPIO ISR does nothing but push a snapshot of the input registers and
+ * the cycle counter into a single-producer ring (input_ring_push()). A task
+ * pops the snapshots and runs them through the decoder in one batch:
+ * debouncing, quadrature decoding and button state all happen there, so a
+ * burst of encoder edges costs a few register reads per edge in the ISR.
+ *
+ * Pins are active low. Times are CPU cycles of the core taking the GPIO
+ * interrupt; they wrap after a few seconds, so the consumer has to call
+ * input_decoder_tick() at least once a second to age the debounce windows.
+ */
+
+#define INPUT_RING_LEN 64 // power of two
+#define INPUT_BUTTONS_MAX 5
+
+typedef struct
+{
+    uint64_t pins; // GPIO 0..63 levels
+    uint32_t cycles;
+} input_snap_t;
+
+typedef struct
+{
+    input_snap_t buf[INPUT_RING_LEN];
+    uint32_t head; // written by the ISR only
+    uint32_t tail; // written by the consumer only
+    uint32_t overruns;
+} input_ring_t;
+
+typedef struct
+{
+    uint8_t gpio;
+    uint8_t bit; // report button bit
+} input_button_t;
+
+typedef struct
+{
+    input_button_t buttons[INPUT_BUTTONS_MAX];
+    uint8_t n_buttons;
+    uint8_t enc_a;
+    uint8_t enc_b;
+    int8_t dpi_gpio;       // -1 = no DPI switch
+    uint32_t click_cycles; // buttons and DPI switch
+    uint32_t scroll_cycles;
+} input_config_t;
+
+typedef struct
+{
+    uint32_t at;  // cycles of the last accepted change
+    bool settled; // window expired, survives the counter wrapping
+} input_window_t;
+
+typedef struct
+{
+    input_config_t cfg;
+    uint64_t pins; // last snapshot
+    uint8_t buttons;
+    input_window_t button_win[INPUT_BUTTONS_MAX];
+    uint8_t enc;
+    input_window_t enc_win;
+    bool dpi_down;
+    input_window_t dpi_win;
+} input_decoder_t;
+
+typedef struct
+{
+    uint8_t buttons;
+    bool buttons_changed;
+    int8_t vertical;
+    uint8_t dpi_presses;
+    uint8_t bounces;     // edges dropped inside a debounce window
+    uint8_t enc_invalid; // wheel transitions with a missed edge
+} input_events_t;
+
+/**
+ * @brief ISR side. Drops the snapshot (and counts an overrun) when full.
+ * @return true if the ring was empty, i.e. the consumer has to be woken
+ */
+static inline bool input_ring_push(input_ring_t *r, uint64_t pins, uint32_t cycles)
+{
+    uint32_t head = r->head;
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+
+    if (head - tail >= INPUT_RING_LEN)
+    {
+        r->overruns++;
+        return false;
+    }
+    r->buf[head & (INPUT_RING_LEN - 1)] = (input_snap_t){.pins = pins, .cycles = cycles};
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+
+    return head == tail;
+}
+
+/**
+ * @brief Consumer side, call until it returns 0 before waiting for the next wake-up.
+ * @return snapshots copied to out
+ */
+size_t input_ring_pop(input_ring_t *r, input_snap_t *out, size_t max);
+
+/**
+ * @brief Start from the current pin levels, nothing is reported for them.
+ */
+void input_decoder_init(input_decoder_t *d, const input_config_t *cfg, uint64_t pins);
+
+void input_decoder_set_debounce(input_decoder_t *d, uint32_t click_cycles, uint32_t scroll_cycles);
+
+/**
+ * @brief A button level is waiting for its debounce window, tick again soon.
+ */
+bool input_decoder_pending(const input_decoder_t *d);
+
+/**
+ * @brief Decode snapshots in order, accumulating into ev (clear it first).
+ */
+void input_decode(input_decoder_t *d, const input_snap_t *snaps, size_t n, input_events_t *ev);
+
+/**
+ * @brief Age the debounce windows, and accept a button level that settled
+ *        inside a window without a later edge to report it.
+ */
+void input_decoder_tick(input_decoder_t *d, uint32_t cycles, input_events_t *ev);
+
+#endif
@@ -0,0 +1,155 @@
+#include <string.h>
+
+#include "macro.h"
+
+static size_t op_size(uint8_t op)
+{
+    switch (op)
+    {
+    case MACRO_OP_END:
+        return 1;
+    case MACRO_OP_PRESS:
+    case MACRO_OP_RELEASE:
+    case MACRO_OP_SCROLL:
+        return 2;
+    case MACRO_OP_WAIT:
+    case MACRO_OP_WAIT_US:
+        return 3;
+    case MACRO_OP_MOVE:
+        return 5;
+    default:
+        return 0;
+    }
+}
+
+static inline uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+bool macro_validate(const uint8_t *code, size_t len)
+{
+    size_t pc = 0;
+
+    while (pc < len)
+    {
+        size_t n = op_size(code[pc]);
+        if (n == 0 || pc + n > len)
+        {
+            return false;
+        }
+        if (code[pc] == MACRO_OP_END)
+        {
+            return true;
+        }
+        pc += n;
+    }
+
+    return false;
+}
+
+void macro_player_init(macro_player_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->deadline_us = MACRO_IDLE;
+}
+
+void macro_start(macro_player_t *p, const uint8_t *code, size_t len, uint64_t now_us)
+{
+    p->code = code;
+    p->len = len;
+    p->pc = 0;
+    p->deadline_us = now_us;
+    p->buttons = 0;
+}
+
+uint64_t macro_step(macro_player_t *p, uint64_t now_us, macro_output_t *out)
+{
+    while (p->deadline_us != MACRO_IDLE && now_us >= p->deadline_us)
+    {
+        // macro_validate() guarantees the op and its arguments are in range
+        const uint8_t *op = &p->code[p->pc];
+        p->pc += op_size(op[0]);
+
+        switch (op[0])
+        {
+        case MACRO_OP_PRESS:
+            p->buttons |= op[1];
+            break;
+        case MACRO_OP_RELEASE:
+            p->buttons &= ~op[1];
+            break;
+        case MACRO_OP_MOVE:
+            out->x += (int16_t)get_u16(&op[1]);
+            out->y += (int16_t)get_u16(&op[3]);
+            out->changed = true;
+            break;
+        case MACRO_OP_SCROLL:
+            out->vertical += (int8_t)op[1];
+            out->changed = true;
+            break;
+        case MACRO_OP_WAIT:
+            p->deadline_us += (uint64_t)get_u16(&op[1]) * 1000;
+            break;
+        case MACRO_OP_WAIT_US:
+            p->deadline_us += get_u16(&op[1]);
+            break;
+        case MACRO_OP_END:
+        default:
+            // never leave buttons held by a finished program
+            p->buttons = 0;
+            p->deadline_us = MACRO_IDLE;
+            break;
+        }
+    }
+
+    // ops due in the same step collapse to their final button state, programs put a WAIT
+    // between a press and its release
+    if (p->buttons != p->reported)
+    {
+        p->reported = p->buttons;
+        out->changed = true;
+    }
+    out->buttons = p->buttons;
+
+    return p->deadline_us;
+}
+
+bool macro_slot_set(macro_slot_t *slots, size_t index, uint8_t chord, const uint8_t *code, size_t len)
+{
+    if (index >= MACRO_SLOTS || len > MACRO_CODE_MAX)
+    {
+        return false;
+    }
+    if (len && !macro_validate(code, len))
+    {
+        return false;
+    }
+
+    // clear the tail too, slots are compared and stored whole
+    memset(&slots[index], 0, sizeof(slots[index]));
+    slots[index].chord = chord;
+    slots[index].len = (uint8_t)len;
+    memcpy(slots[index].code, code, len);
+
+    return true;
+}
+
+int macro_match_chord(const macro_slot_t *slots, uint8_t buttons)
+{
+    // at least two buttons
+    if ((buttons & (buttons - 1)) == 0)
+    {
+        return -1;
+    }
+
+    for (int i = 0; i < MACRO_SLOTS; i++)
+    {
+        if (slots[i].len && slots[i].chord == buttons)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
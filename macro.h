@@ -0,0 +1,98 @@
+#ifndef MACRO_H
+#define MACRO_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Macro bytecode and interpreter. Time is passed in by the caller (microseconds),
+ * so the same code runs from an esp_timer on the device and from a virtual clock
+ * on the host.
+ *
+ * Program = sequence of ops, little endian arguments:
+ *   END                      0x00
+ *   PRESS   mask:u8          0x01  buttons |= mask
+ *   RELEASE mask:u8          0x02  buttons &= ~mask
+ *   MOVE    dx:i16 dy:i16    0x03
+ *   SCROLL  v:i8             0x04
+ *   WAIT    ms:u16           0x05  waits are measured from the previous deadline, not from
+ *                                  when the step happened to run, so timing does not drift
+ *   WAIT_US us:u16           0x06
+ */
+
+#define MACRO_OP_END 0x00
+#define MACRO_OP_PRESS 0x01
+#define MACRO_OP_RELEASE 0x02
+#define MACRO_OP_MOVE 0x03
+#define MACRO_OP_SCROLL 0x04
+#define MACRO_OP_WAIT 0x05
+#define MACRO_OP_WAIT_US 0x06
+
+#define MACRO_SLOTS 4
+#define MACRO_CODE_MAX 64
+
+#define MACRO_IDLE UINT64_MAX
+
+typedef struct
+{
+    uint8_t buttons; // button state owned by the macro
+    int16_t x;
+    int16_t y;
+    int8_t vertical;
+    bool changed; // anything to report
+} macro_output_t;
+
+typedef struct
+{
+    const uint8_t *code;
+    size_t len;
+    size_t pc;
+    uint64_t deadline_us; // MACRO_IDLE when not running
+    uint8_t buttons;
+    uint8_t reported; // buttons as of the last step, to flag changes
+} macro_player_t;
+
+typedef struct
+{
+    uint8_t chord; // button mask that triggers the slot, 0 = manual only
+    uint8_t len;
+    uint8_t code[MACRO_CODE_MAX];
+} macro_slot_t;
+
+/**
+ * @brief Check that every op is known and complete and the program ends with END.
+ */
+bool macro_validate(const uint8_t *code, size_t len);
+
+void macro_player_init(macro_player_t *p);
+
+/**
+ * @brief Start code at now_us. A running program is replaced and its buttons released.
+ */
+void macro_start(macro_player_t *p, const uint8_t *code, size_t len, uint64_t now_us);
+
+/**
+ * @brief Execute every op due at now_us, merge their effect into out.
+ * @return next deadline, MACRO_IDLE once the program has ended
+ */
+uint64_t macro_step(macro_player_t *p, uint64_t now_us, macro_output_t *out);
+
+static inline bool macro_running(const macro_player_t *p)
+{
+    return p->deadline_us != MACRO_IDLE;
+}
+
+/**
+ * @brief Store a validated program in slots[index].
+ * @return false if index or program is invalid
+ */
+bool macro_slot_set(macro_slot_t *slots, size_t index, uint8_t chord, const uint8_t *code, size_t len);
+
+/**
+ * @brief Slot whose chord exactly equals buttons, -1 if none. Single-button
+ *        chords are ignored so ordinary clicks never trigger a macro.
+ */
+int macro_match_chord(const macro_slot_t *slots, uint8_t buttons);
+
+#endif
@@ -15,11 +15,36 @@
 
 #include "driver/gpio.h"
 #include "esp_timer.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "soc/soc.h"
+#include "soc/gpio_reg.h"
 #include "nvs_flash.h"
 
 #include "nimble.h"   /* your BLE wrapper: wake_ble(), ble_mounted(), ble_hid_mouse_report() */
+#include "spi.h"      /* sensor SPI transport: wake_spi() */
 #include "paw3395.h"  /* sensor driver: wake_paw3395(), read_move(), (optional set_dpi) */
 #include "pins.h"     /* board pin definitions (provide pin macros used below) */
+#include "battery.h"  /* battery sampling: wake_battery() */
+#include "settings_nvs.h" /* deferred settings store: wake_settings() */
+#include "settings.h"
+#include "mouse_api.h"
+#include "macro.h"        /* macro bytecode interpreter */
+#include "accel.h"        /* pointer acceleration tables */
+#include "motion_xform.h" /* rotation and angle snapping */
+#include "motion_filter.h" /* jitter and smoothing on raw deltas */
+#include "cpi.h"          /* CPI stage table */
+#include "boot.h"         /* boot orchestrator and metrics */
+#include "sched_plan.h"   /* task placement and priorities from latency budgets */
+#include "task_plan.h"    /* the tasks below with their budgets, shared with tools/sched_check.c */
+#include "sched_stats.h"
+#include "input_capture.h" /* button/wheel snapshot ring and deferred decoder */
+#include "mouse_hid.h"      /* input report layout: MOUSE_HID_XY_MAX */
+#include "rate_ctl.h"       /* adaptive report rate and BLE connection parameters */
+#include "predict.h"        /* motion prediction ahead of the BLE delay */
+#include "stats.h"          /* event counters */
+#include "telemetry.h"
+#include "blog_log.h"
 
 static const char *TAG = "main";
 
@@ -69,11 +94,14 @@ void set_dpi(uint16_t dpi)
 #ifndef CONFIG_ENCODER_DEBOUNCE
 #define CONFIG_ENCODER_DEBOUNCE (20000)  /* 20 ms in microseconds */
 #endif
-#ifndef CONFIG_STOP_INTERVAL_BLE
-#define CONFIG_STOP_INTERVAL_BLE 8       /* ms between BLE HID reports */
+#ifndef CONFIG_REPORT_RATE_ADAPTIVE
+#define CONFIG_REPORT_RATE_ADAPTIVE 1    /* pace reports by pointer speed, configured rate is the ceiling */
 #endif
-#ifndef CONFIG_PAW3395_READ_INTERVAL
-#define CONFIG_PAW3395_READ_INTERVAL 5   /* ms */
+#ifndef CONFIG_MOTION_PREDICT_US
+#define CONFIG_MOTION_PREDICT_US 0       /* lead reports by this much (report + radio delay), 0 = off */
+#endif
+#ifndef CONFIG_PAW3395_HEALTH_PERIOD_MS
+#define CONFIG_PAW3395_HEALTH_PERIOD_MS 2000 /* idle time between sensor health checks */
 #endif
 
 /* -------------------------------------------------------------------------
@@ -81,7 +109,7 @@ void set_dpi(uint16_t dpi)
    nimble.h should provide:
      esp_err_t wake_ble(void);
      bool ble_mounted(void);
-     void ble_hid_mouse_report(uint8_t buttons, char x, char y, char vertical);
+     void ble_hid_mouse_report(uint8_t buttons, int16_t x, int16_t y, int8_t vertical);
    paw3395.h should provide sensor init/read functions used below:
      void wake_paw3395(void);
      esp_err_t read_move(int16_t *dx, int16_t *dy);
@@ -90,37 +118,54 @@ void set_dpi(uint16_t dpi)
 /* -------------------------------------------------------------------------
    Helper utilities
    ------------------------------------------------------------------------- */
-static inline int8_t clamp_int8(int16_t v)
+/* largest X/Y step one report carries, from the descriptor field width */
+static inline int16_t clamp_xy(int32_t v)
 {
-    if (v > 127) return 127;
-    if (v < -128) return -128;
-    return (int8_t)v;
+    if (v > MOUSE_HID_XY_MAX) return MOUSE_HID_XY_MAX;
+    if (v < -MOUSE_HID_XY_MAX) return -MOUSE_HID_XY_MAX;
+    return (int16_t)v;
 }
 
-static inline uint8_t get_encoder_state(void)
+/* all input levels at once, GPIO 0..31 and 32..39 */
+static inline uint64_t IRAM_ATTR input_pins(void)
 {
-    return (gpio_get_level(CONFIG_ENCODER_A_NUM) << 1) | gpio_get_level(CONFIG_ENCODER_B_NUM);
+    uint64_t pins = REG_READ(GPIO_IN_REG);
+#ifdef GPIO_IN1_REG
+    pins |= (uint64_t)REG_READ(GPIO_IN1_REG) << 32;
+#endif
+    return pins;
 }
 
 /* -------------------------------------------------------------------------
    Types and state
    ------------------------------------------------------------------------- */
-typedef struct {
-    uint8_t bit;
-    gpio_num_t gpio;
-    uint64_t last_isr_tick;
-} button_info_t;
+#define ACCUM_MACRO_BUTTONS 0x01 /* item carries the macro player's button state */
+#define ACCUM_BUTTONS 0x02       /* item carries the debounced physical buttons */
 
 typedef struct {
     int16_t x;
     int16_t y;
     int8_t vertical;
+    uint8_t flags;
+    uint8_t buttons;   /* valid with ACCUM_MACRO_BUTTONS / ACCUM_BUTTONS */
+    uint32_t t_us;     /* when it was queued, 0 = not measured */
 } accum_item_t;
 
-/* Button mapping (bits) */
-static button_info_t btn_left    = { .bit = 0, .gpio = CONFIG_MICRO_PIN_L };
-static button_info_t btn_mid     = { .bit = 2, .gpio = CONFIG_MICRO_PIN_M };
-static button_info_t btn_right   = { .bit = 1, .gpio = CONFIG_MICRO_PIN_R };
+/* Buttons, wheel and DPI switch: the ISR only snapshots, input_loop_task decodes */
+static const input_config_t input_cfg = {
+    .buttons = {
+        { .gpio = CONFIG_MICRO_PIN_L, .bit = 0 },
+        { .gpio = CONFIG_MICRO_PIN_R, .bit = 1 },
+        { .gpio = CONFIG_MICRO_PIN_M, .bit = 2 },
+    },
+    .n_buttons = 3,
+    .enc_a = CONFIG_ENCODER_A_NUM,
+    .enc_b = CONFIG_ENCODER_B_NUM,
+    .dpi_gpio = DPI_SWITCH_GPIO,
+};
+static input_ring_t input_ring;
+static input_decoder_t input_decoder;
+static TaskHandle_t input_task_handle = NULL;
 
 /* Runtime accumulators and sync objects */
 static int16_t accum_x = 0;
@@ -129,14 +174,83 @@ static int8_t accum_vertical = 0;
 static SemaphoreHandle_t accum_mutex = NULL;
 static QueueHandle_t accum_queue = NULL;
 
-static uint8_t motion_level = 0;
+static uint8_t motion_level = 1;               /* MOTION is active low, idle until the pin says otherwise */
 static TaskHandle_t move_task_handle = NULL;
-static uint8_t encoder_state = 0;
-static uint64_t last_slide_tick = 0;
+static volatile uint32_t move_wake_us = 0;     /* last motion interrupt */
 
-static uint8_t buttons_temp = 0;
-static uint8_t buttons = 0;
+static uint8_t buttons = 0;                    /* debounced, under accum_mutex */
 static TaskHandle_t report_task_handle = NULL;
+static volatile uint32_t report_wake_us = 0;   /* last notify of report_loop_task, 0 = served */
+static rate_ctl_t rate_ctl;                    /* report_loop_task only */
+static predict_t predictor;                    /* report_loop_task only */
+
+/* Macro playback: player state is shared by the timer callback and the API, guarded by macro_lock */
+static macro_slot_t macro_slots[MACRO_SLOTS];
+static macro_player_t macro_player;
+static uint8_t macro_code[MACRO_CODE_MAX];   /* private copy of the program being played */
+static esp_timer_handle_t macro_timer = NULL;
+static portMUX_TYPE macro_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t macro_buttons = 0;            /* merged into reports, under accum_mutex */
+static uint8_t chord_mask = 0;               /* physical buttons swallowed by a chord trigger */
+
+/* Pointer acceleration: move_loop_task owns accel, api_set_accel() builds the
+   table in accel_build and hands a copy over in accel_next */
+static accel_t accel;
+static accel_t accel_build;                   /* config channel (BLE host task) only */
+static accel_t accel_next;
+static accel_params_t accel_params;           /* last set, for api_get_accel() */
+static volatile bool accel_pending = false;
+/* Rotation / angle snapping; inversion and swap are done by the sensor.
+   move_loop_task owns xform, api_set_xform() builds xform_next and hands it over */
+static motion_xform_t xform;
+static motion_xform_t xform_next;
+static motion_xform_params_t xform_params;    /* last set, for api_get_xform() */
+static volatile bool xform_pending = false;
+/* same handover for the filter stages */
+static motion_filter_t motion_filter;
+static motion_filter_t motion_filter_next;
+static motion_filter_params_t filter_params;  /* last set, clamped, for api_get_filter() */
+static volatile bool filter_pending = false;
+static portMUX_TYPE motion_cfg_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/* CPI stage table, cycled by DPI_SWITCH_GPIO; the sensor is written outside cpi_lock, see cpi_commit() */
+static cpi_stages_t cpi_stages;
+static portMUX_TYPE cpi_lock = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool dpi_switch_pending = false;
+
+/* Runtime tunables (config channel / settings), start at the build defaults */
+static volatile uint16_t report_rate_hz = MOUSE_REPORT_RATE_DEFAULT;   /* as set, the interval follows it */
+static volatile uint32_t report_interval_ms = (1000 + MOUSE_REPORT_RATE_DEFAULT / 2) / MOUSE_REPORT_RATE_DEFAULT;
+static volatile uint32_t click_debounce_us = CONFIG_MICRO_DEBOUNCE;
+static volatile uint32_t scroll_debounce_us = CONFIG_ENCODER_DEBOUNCE;
+
+/* every producer of the accumulator goes through here, a full queue is counted */
+static inline void accum_send(const accum_item_t *item)
+{
+    if (xQueueSend(accum_queue, item, 0) != pdPASS) stats_inc(STATS_QUEUE_FULL);
+}
+
+/* -------------------------------------------------------------------------
+   Task plan: the sensor path runs on its own core, the report task stays
+   with the NimBLE host it feeds. Priorities come from sched_plan_assign().
+   ------------------------------------------------------------------------- */
+#if portNUM_PROCESSORS > 1
+#define SENSOR_CORE 1 /* motion ISR, move and accum tasks */
+#define HOST_CORE 0   /* NimBLE host (CONFIG_BT_NIMBLE_PINNED_TO_CORE) and report task */
+#else
+#define SENSOR_CORE SCHED_ANY_CORE
+#define HOST_CORE SCHED_ANY_CORE
+#endif
+
+static sched_task_t task_plan[TASK_COUNT];   /* task_plan_init() in app_main */
+
+static sched_latency_t task_latency[TASK_COUNT];
+
+/* record since_us -> now for a task, single writer per entry */
+static inline void latency_done(int task, uint32_t since_us)
+{
+    if (since_us) sched_latency_record(&task_latency[task], (uint32_t)esp_timer_get_time() - since_us);
+}
 
 /* -------------------------------------------------------------------------
    ISR handlers
@@ -145,61 +259,22 @@ static void IRAM_ATTR on_move(void *args)
 {
     (void)args;
     motion_level = gpio_get_level(CONFIG_PAW3395D_MOTION_NUM);
+    move_wake_us = (uint32_t)esp_timer_get_time();
     BaseType_t xHigherPriorityTaskWoken = pdFALSE;
     vTaskNotifyGiveFromISR(move_task_handle, &xHigherPriorityTaskWoken);
     portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
-static void IRAM_ATTR on_click(void *args)
-{
-    uint64_t now = esp_timer_get_time();
-    button_info_t *btn = (button_info_t *)args;
-
-    int level = gpio_get_level(btn->gpio);
-
-    if (!level) buttons_temp |= (1 << btn->bit);
-    else buttons_temp &= ~(1 << btn->bit);
-
-    if (buttons_temp == buttons) return;
-
-    if ((now - btn->last_isr_tick) >= CONFIG_MICRO_DEBOUNCE) {
-        btn->last_isr_tick = now;
-        buttons = buttons_temp;
-        accum_item_t item = {0};
-        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        xQueueSendFromISR(accum_queue, &item, &xHigherPriorityTaskWoken);
-        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
-    }
-}
-
-static void IRAM_ATTR on_scroll(void *args)
+/* buttons, wheel and DPI switch: a few register reads, decoding is deferred */
+static void IRAM_ATTR on_input(void *args)
 {
     (void)args;
-    uint64_t now = esp_timer_get_time();
+    if (!input_ring_push(&input_ring, input_pins(), esp_cpu_get_cycle_count())) return;
 
-    uint8_t encoder_state_temp = get_encoder_state();
-    if (encoder_state_temp == encoder_state) return;
-
-    int8_t state_transition = (encoder_state << 2) | encoder_state_temp;
-    int8_t vertical;
-    switch (state_transition) {
-    case 0b0001: case 0b0111: case 0b1110: case 0b1000:
-        vertical = -1; break;
-    case 0b0010: case 0b1011: case 0b1101: case 0b0100:
-        vertical = 1; break;
-    default:
-        return;
-    }
-
-    if ((now - last_slide_tick) >= CONFIG_ENCODER_DEBOUNCE) {
-        last_slide_tick = now;
-        accum_item_t item = { .x = 0, .y = 0, .vertical = vertical };
-        BaseType_t xHigherPriorityTaskWoken = pdFALSE;
-        xQueueSendFromISR(accum_queue, &item, &xHigherPriorityTaskWoken);
-        portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
-    }
-
-    encoder_state = encoder_state_temp;
+    /* the ring was empty: the task may be waiting */
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    vTaskNotifyGiveFromISR(input_task_handle, &xHigherPriorityTaskWoken);
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 
 /* -------------------------------------------------------------------------
@@ -215,6 +290,9 @@ static void reg_isr_handler(void)
         .intr_type = GPIO_INTR_ANYEDGE,
     };
     gpio_config(&motion_conf);
+    /* a DPI press or config write wakes the move task before the first edge,
+       it must see the pin as it is or it would poll an idle sensor */
+    motion_level = gpio_get_level(CONFIG_PAW3395D_MOTION_NUM);
     gpio_isr_handler_add(CONFIG_PAW3395D_MOTION_NUM, on_move, NULL);
 
     gpio_config_t switch_conf = {
@@ -225,9 +303,15 @@ static void reg_isr_handler(void)
         .intr_type = GPIO_INTR_ANYEDGE,
     };
     gpio_config(&switch_conf);
-    gpio_isr_handler_add(CONFIG_MICRO_PIN_L, on_click, &btn_left);
-    gpio_isr_handler_add(CONFIG_MICRO_PIN_R, on_click, &btn_right);
-    gpio_isr_handler_add(CONFIG_MICRO_PIN_M, on_click, &btn_mid);
+
+    gpio_config_t dpi_conf = {
+        .pin_bit_mask = BIT64(DPI_SWITCH_GPIO),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE, /* the decoder needs the release to see the next press */
+    };
+    gpio_config(&dpi_conf);
 
     gpio_config_t enc_conf = {
         .pin_bit_mask = BIT64(CONFIG_ENCODER_B_NUM) | BIT64(CONFIG_ENCODER_A_NUM),
@@ -237,45 +321,204 @@ static void reg_isr_handler(void)
         .intr_type = GPIO_INTR_ANYEDGE,
     };
     gpio_config(&enc_conf);
-    gpio_isr_handler_add(CONFIG_ENCODER_B_NUM, on_scroll, NULL);
-    gpio_isr_handler_add(CONFIG_ENCODER_A_NUM, on_scroll, NULL);
 
-    encoder_state = get_encoder_state();
+    /* decoder starts from the levels now, before any snapshot can arrive */
+    input_decoder_init(&input_decoder, &input_cfg, input_pins());
+
+    gpio_isr_handler_add(CONFIG_MICRO_PIN_L, on_input, NULL);
+    gpio_isr_handler_add(CONFIG_MICRO_PIN_R, on_input, NULL);
+    gpio_isr_handler_add(CONFIG_MICRO_PIN_M, on_input, NULL);
+    gpio_isr_handler_add(DPI_SWITCH_GPIO, on_input, NULL);
+    gpio_isr_handler_add(CONFIG_ENCODER_A_NUM, on_input, NULL);
+    gpio_isr_handler_add(CONFIG_ENCODER_B_NUM, on_input, NULL);
+
+    xTaskNotifyGive(input_task_handle);
+}
+
+/* -------------------------------------------------------------------------
+   Macro scheduler: one-shot esp_timer re-armed at each program deadline,
+   output goes through accum_queue like any other input
+   ------------------------------------------------------------------------- */
+static void on_macro_timer(void *args)
+{
+    (void)args;
+    macro_output_t out = {0};
+    uint64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&macro_lock);
+    uint64_t next = macro_step(&macro_player, now, &out);
+    portEXIT_CRITICAL(&macro_lock);
+
+    if (out.changed) {
+        accum_item_t item = { .x = out.x, .y = out.y, .vertical = out.vertical,
+                              .flags = ACCUM_MACRO_BUTTONS, .buttons = out.buttons };
+        accum_send(&item);
+    }
+
+    if (next != MACRO_IDLE) {
+        esp_timer_start_once(macro_timer, next > now ? next - now : 0);
+    }
+}
+
+/* start code now, replacing whatever is playing */
+static void macro_play(const uint8_t *code, size_t len)
+{
+    if (!macro_timer || len > MACRO_CODE_MAX) return;
+
+    esp_timer_stop(macro_timer);
+
+    portENTER_CRITICAL(&macro_lock);
+    memcpy(macro_code, code, len);
+    macro_start(&macro_player, macro_code, len, esp_timer_get_time());
+    portEXIT_CRITICAL(&macro_lock);
+
+    /* fails only if the callback re-armed meanwhile, which then runs the new program */
+    esp_timer_start_once(macro_timer, 0);
+}
+
+/* called from accum_loop_task with accum_mutex held, whenever input arrives */
+static void chord_check(void)
+{
+    static uint8_t last_held = 0;
+    uint8_t held = buttons;
+
+    if (held == last_held) return;
+    last_held = held;
+
+    /* keep swallowing chord buttons until each one is released */
+    chord_mask &= held;
+
+    portENTER_CRITICAL(&macro_lock);
+    int slot = macro_match_chord(macro_slots, held);
+    portEXIT_CRITICAL(&macro_lock);
+
+    if (slot >= 0) {
+        chord_mask = held;
+        macro_play(macro_slots[slot].code, macro_slots[slot].len);
+    }
 }
 
 /* -------------------------------------------------------------------------
    Reporting
    ------------------------------------------------------------------------- */
-static void report_send(uint8_t accum_buttons_temp, int16_t accum_x_temp, int16_t accum_y_temp, int8_t accum_vertical_temp)
+#if CONFIG_REPORT_RATE_ADAPTIVE
+#define RATE_POLL_MS 500 /* idle check while no reports are due */
+
+/* follow the configured rate, which is the ceiling of the adaptive range; the
+   stored Hz, not the rounded interval, or it could never reach MOUSE_REPORT_RATE_MAX */
+static void rate_sync(uint32_t now_us)
+{
+    uint16_t max_hz = report_rate_hz;
+
+    if (rate_ctl.p.max_hz != max_hz) {
+        rate_params_t p;
+        rate_default_params(&p);
+        p.min_hz = MOUSE_REPORT_RATE_MIN < max_hz ? MOUSE_REPORT_RATE_MIN : max_hz;
+        p.max_hz = max_hz;
+        rate_ctl_init(&rate_ctl, &p, now_us);
+    }
+}
+
+static void rate_link(uint32_t now_us)
+{
+    rate_conn_t c;
+
+    if (!ble_mounted()) {
+        rate_ctl_conn_reset(&rate_ctl);
+        return;
+    }
+    if (rate_ctl_conn_due(&rate_ctl, now_us, &c)) {
+        ble_conn_params(c.itvl_min, c.itvl_max, c.latency, c.timeout);
+    }
+}
+#endif
+
+/* ms until the next report may go out */
+static uint32_t report_pace(uint8_t btns, int16_t x, int16_t y, int8_t vertical)
+{
+#if CONFIG_REPORT_RATE_ADAPTIVE
+    static uint8_t last_btns;
+    uint32_t now = (uint32_t)esp_timer_get_time();
+    bool event = btns != last_btns || vertical != 0;
+
+    last_btns = btns;
+    rate_sync(now);
+    rate_ctl_set_link(&rate_ctl, ble_conn_itvl());
+    uint32_t us = rate_ctl_update(&rate_ctl, x, y, event, now);
+    rate_link(now);
+    return (us + 500) / 1000;
+#else
+    (void)btns; (void)x; (void)y; (void)vertical;
+    return report_interval_ms;
+#endif
+}
+
+static void report_send(uint8_t accum_buttons_temp, int32_t accum_x_temp, int32_t accum_y_temp, int8_t accum_vertical_temp)
 {
+#if CONFIG_MOTION_PREDICT_US
+    predict_apply(&predictor, &accum_x_temp, &accum_y_temp, (uint32_t)esp_timer_get_time(), CONFIG_MOTION_PREDICT_US);
+#endif
     do {
-        int8_t x_send = clamp_int8(accum_x_temp);
-        int8_t y_send = clamp_int8(accum_y_temp);
+        int16_t x_send = clamp_xy(accum_x_temp);
+        int16_t y_send = clamp_xy(accum_y_temp);
 
         if (ble_mounted()) {
-            /* nimble.h uses char for x/y/vertical — cast safely */
-            ble_hid_mouse_report(accum_buttons_temp, (char)x_send, (char)y_send, (char)accum_vertical_temp);
-            vTaskDelay(pdMS_TO_TICKS(CONFIG_STOP_INTERVAL_BLE));
+            ble_hid_mouse_report(accum_buttons_temp, x_send, y_send, accum_vertical_temp);
+            boot_mark(BOOT_MARK_FIRST_REPORT);
+            latency_done(TASK_REPORT, report_wake_us);
+            report_wake_us = 0;
+            vTaskDelay(pdMS_TO_TICKS(report_pace(accum_buttons_temp, x_send, y_send, accum_vertical_temp)));
         } else {
             /* Not connected: short delay (alternatively buffer) */
+            stats_inc(STATS_REPORTS_DROPPED);
             vTaskDelay(pdMS_TO_TICKS(20));
         }
 
         accum_x_temp -= x_send;
         accum_y_temp -= y_send;
         accum_vertical_temp = 0;
+        if (accum_x_temp != 0 || accum_y_temp != 0) stats_inc(STATS_REPORT_SPLITS);
     } while (accum_x_temp != 0 || accum_y_temp != 0 || accum_vertical_temp != 0);
 }
 
+/* the predicted lead is taken back by a report of its own once motion stops */
+static bool report_correction_due(void)
+{
+#if CONFIG_MOTION_PREDICT_US
+    return predict_pending(&predictor);
+#else
+    return false;
+#endif
+}
+
+static TickType_t report_wait(void)
+{
+    if (report_correction_due()) return 0;
+#if CONFIG_REPORT_RATE_ADAPTIVE
+    return pdMS_TO_TICKS(RATE_POLL_MS);
+#else
+    return portMAX_DELAY;
+#endif
+}
+
 /* report loop task */
 static void report_loop_task(void *pv)
 {
     (void)pv;
     for (;;) {
-        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (ulTaskNotifyTake(pdTRUE, report_wait()) == 0 && !report_correction_due()) {
+#if CONFIG_REPORT_RATE_ADAPTIVE
+            /* nothing to send: drop to the idle tier and relax the link */
+            uint32_t now = (uint32_t)esp_timer_get_time();
+            rate_sync(now);
+            rate_ctl_poll(&rate_ctl, now);
+            rate_link(now);
+#endif
+            continue;
+        }
 
         if (xSemaphoreTake(accum_mutex, portMAX_DELAY) == pdTRUE) {
-            uint8_t accum_buttons_temp = buttons;
+            uint8_t accum_buttons_temp = (buttons & ~chord_mask) | macro_buttons;
             int16_t accum_x_temp = accum_x;
             int16_t accum_y_temp = accum_y;
             int8_t accum_vertical_temp = accum_vertical;
@@ -302,31 +545,170 @@ static void accum_loop_task(void *pv)
                 accum_x += item.x;
                 accum_y += item.y;
                 accum_vertical += item.vertical;
+                if (item.flags & ACCUM_MACRO_BUTTONS) macro_buttons = item.buttons;
+                if (item.flags & ACCUM_BUTTONS) buttons = item.buttons;
+                chord_check();
                 xSemaphoreGive(accum_mutex);
 
+                if (!report_wake_us) report_wake_us = (uint32_t)esp_timer_get_time();
                 xTaskNotifyGive(report_task_handle);
+                latency_done(TASK_ACCUM, item.t_us);
             }
         }
     }
 }
 
+/* input loop task: decodes the snapshots taken by on_input */
+#define INPUT_BATCH 16
+#define INPUT_IDLE_MS 1000    /* ages the debounce windows, the cycle counter wraps in seconds */
+#define INPUT_PENDING_MS 5    /* a release inside the click window is accepted this late */
+
+static void input_emit(const input_events_t *ev)
+{
+    if (ev->bounces) stats_add(STATS_DEBOUNCE_REJECTS, ev->bounces);
+    if (ev->enc_invalid) stats_add(STATS_ENCODER_INVALID, ev->enc_invalid);
+
+    if (ev->buttons_changed || ev->vertical) {
+        accum_item_t item = { .vertical = ev->vertical, .t_us = (uint32_t)esp_timer_get_time() };
+        if (ev->buttons_changed) {
+            item.flags = ACCUM_BUTTONS;
+            item.buttons = ev->buttons;
+        }
+        accum_send(&item);
+    }
+
+    if (ev->dpi_presses) {
+        /* the SPI writes happen in move_loop_task */
+        dpi_switch_pending = true;
+        xTaskNotifyGive(move_task_handle);
+    }
+}
+
+static void input_loop_task(void *pv)
+{
+    (void)pv;
+    input_snap_t snaps[INPUT_BATCH];
+    uint32_t overruns_seen = 0;
+    TickType_t wait;
+
+    /* first wake-up comes from reg_isr_handler() once the decoder is set up */
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    for (;;) {
+        uint32_t per_us = esp_rom_get_cpu_ticks_per_us();
+        input_events_t ev = {0};
+        uint32_t first = 0;
+        bool any = false;
+        size_t n;
+
+        input_decoder_set_debounce(&input_decoder, click_debounce_us * per_us, scroll_debounce_us * per_us);
+
+        /* drain until empty, the ISR only wakes us on an empty ring */
+        while ((n = input_ring_pop(&input_ring, snaps, INPUT_BATCH)) > 0) {
+            if (!any) first = snaps[0].cycles;
+            any = true;
+            input_decode(&input_decoder, snaps, n, &ev);
+        }
+        /* same core as the ISR, so the cycle counts compare */
+        uint32_t now = esp_cpu_get_cycle_count();
+        /* the ring overflowed: the edges it dropped may include the last one,
+           so the live levels stand in for them or a button could stay held */
+        uint32_t overruns = __atomic_load_n(&input_ring.overruns, __ATOMIC_RELAXED);
+        if (overruns != overruns_seen) {
+            input_snap_t live = { .pins = input_pins(), .cycles = now };
+            overruns_seen = overruns;
+            input_decode(&input_decoder, &live, 1, &ev);
+        }
+        input_decoder_tick(&input_decoder, now, &ev);
+        input_emit(&ev);
+        if (any) sched_latency_record(&task_latency[TASK_INPUT], (now - first) / per_us);
+
+        wait = input_decoder_pending(&input_decoder) ? pdMS_TO_TICKS(INPUT_PENDING_MS) : pdMS_TO_TICKS(INPUT_IDLE_MS);
+        ulTaskNotifyTake(pdTRUE, wait ? wait : 1);
+    }
+}
+
+/* motion stages after the filter, dt_us = time since previous read */
+static void motion_emit(int16_t x, int16_t y, uint32_t dt_us)
+{
+    motion_xform_apply(&xform, &x, &y);
+    accel_apply(&accel, &x, &y, dt_us);
+
+    if (x != 0 || y != 0) {
+        accum_item_t it = { .x = x, .y = y, .vertical = 0, .t_us = (uint32_t)esp_timer_get_time() };
+        accum_send(&it);
+    }
+}
+
+/* motion stages between the sensor read and the accumulator */
+static void motion_push(int16_t x, int16_t y, uint32_t dt_us)
+{
+    motion_filter_apply(&motion_filter, &x, &y, dt_us);
+    motion_emit(x, y, dt_us);
+}
+
+/* move_loop_task only: swap in what the setters prepared, between bursts */
+static void motion_config_take(void)
+{
+    if (!xform_pending && !filter_pending && !accel_pending) return;
+
+    portENTER_CRITICAL(&motion_cfg_lock);
+    /* table, shift and enable change together; remainders were reset after the last burst */
+    if (accel_pending) {
+        accel = accel_next;
+        accel_pending = false;
+    }
+    if (xform_pending) {
+        xform = xform_next;
+        xform_pending = false;
+    }
+    /* the last burst flushed the old filter, nothing it held is lost */
+    if (filter_pending) {
+        motion_filter = motion_filter_next;
+        filter_pending = false;
+    }
+    portEXIT_CRITICAL(&motion_cfg_lock);
+}
+
 /* move loop task: poll sensor while motion pin indicates motion */
 static void move_loop_task(void *pv)
 {
     (void)pv;
     int16_t x = 0, y = 0;
+    uint64_t last_read_us, now_us;
 
     for (;;) {
-        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        /* no motion for a while: use the idle time to check on the sensor */
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CONFIG_PAW3395_HEALTH_PERIOD_MS)) == 0) {
+            paw3395_health_check();
+            continue;
+        }
+
+        /* stage switches are applied between bursts, from the only task that reads them */
+        if (dpi_switch_pending) {
+            dpi_switch_pending = false;
+            api_cpi_stage_next();
+        }
+        motion_config_take();
+
+        /* first read of a burst: assume one nominal interval */
+        last_read_us = esp_timer_get_time() - CONFIG_PAW3395_READ_INTERVAL * 1000;
+        uint32_t wake_us = move_wake_us;
 
         while (motion_level == 0) {
-            if (read_move(&x, &y) == ESP_OK) {
+            esp_err_t err = read_move(&x, &y);
+            /* a sample the surface gate dropped (lift, low SQUAL, settling) is a read without motion */
+            if (err == ESP_OK || err == ESP_ERR_INVALID_STATE) {
+                now_us = esp_timer_get_time();
+                latency_done(TASK_MOVE, wake_us);
+                wake_us = 0;
                 if (x != 0 || y != 0) {
-                    accum_item_t it = { .x = x, .y = y, .vertical = 0 };
-                    xQueueSend(accum_queue, &it, 0);
+                    motion_push(x, y, (uint32_t)(now_us - last_read_us));
                     x = y = 0;
                 }
+                last_read_us = now_us;
             } else {
+                /* SPI error: back off before trying the bus again */
                 vTaskDelay(pdMS_TO_TICKS(10));
             }
             vTaskDelay(pdMS_TO_TICKS(CONFIG_PAW3395_READ_INTERVAL));
@@ -335,60 +717,370 @@ static void move_loop_task(void *pv)
         /* drain */
         if (read_move(&x, &y) == ESP_OK) {
             if (x != 0 || y != 0) {
-                accum_item_t it = { .x = x, .y = y, .vertical = 0 };
-                xQueueSend(accum_queue, &it, 0);
+                motion_push(x, y, (uint32_t)(esp_timer_get_time() - last_read_us));
             }
         }
 
+        /* what the smoothing stages still hold goes out before the stages reset */
+        if (motion_filter_flush(&motion_filter, &x, &y)) {
+            motion_emit(x, y, CONFIG_PAW3395_READ_INTERVAL * 1000);
+        }
+
         x = y = 0;
+        motion_xform_reset(&xform);
+        accel_reset(&accel);
     }
 }
 
 /* API helpers */
-void api_set_dpi(uint16_t dpi) { set_dpi(dpi); }
+static void cpi_commit(void)
+{
+    cpi_stages_t s;
+    cpi_xy_t c, now;
+
+    /* the move task (DPI switch) and the BLE host both get here: whoever programs
+       the sensor last re-checks the table, so the sensor ends on its current stage */
+    portENTER_CRITICAL(&cpi_lock);
+    s = cpi_stages;
+    portEXIT_CRITICAL(&cpi_lock);
+    for (;;) {
+        c = cpi_stages_current(&s);
+        paw3395_set_cpi(c.x, c.y);
+
+        portENTER_CRITICAL(&cpi_lock);
+        s = cpi_stages;
+        portEXIT_CRITICAL(&cpi_lock);
+        now = cpi_stages_current(&s);
+        if (now.x == c.x && now.y == c.y) break;
+    }
+    settings_set_cpi(&s);
+}
+
+/* sets both axes of the current stage */
+void api_set_dpi(uint16_t dpi)
+{
+    portENTER_CRITICAL(&cpi_lock);
+    cpi_stages_set(&cpi_stages, cpi_stages.current, dpi, dpi, cpi_stages.count);
+    portEXIT_CRITICAL(&cpi_lock);
+    cpi_commit();
+}
+
+uint16_t api_get_dpi(void) { return get_dpi(); }
+
+void api_cpi_stage_next(void)
+{
+    portENTER_CRITICAL(&cpi_lock);
+    cpi_stages_next(&cpi_stages);
+    portEXIT_CRITICAL(&cpi_lock);
+    cpi_commit();
+}
+
+bool api_cpi_select(uint8_t index)
+{
+    portENTER_CRITICAL(&cpi_lock);
+    bool ok = cpi_stages_select(&cpi_stages, index);
+    portEXIT_CRITICAL(&cpi_lock);
+    if (ok) cpi_commit();
+    return ok;
+}
+
+bool api_cpi_set_stage(uint8_t index, uint16_t x, uint16_t y, uint8_t count)
+{
+    portENTER_CRITICAL(&cpi_lock);
+    bool ok = cpi_stages_set(&cpi_stages, index, x, y, count);
+    portEXIT_CRITICAL(&cpi_lock);
+    if (ok) cpi_commit();
+    return ok;
+}
+
+void api_cpi_get_stages(cpi_stages_t *stages)
+{
+    portENTER_CRITICAL(&cpi_lock);
+    *stages = cpi_stages;
+    portEXIT_CRITICAL(&cpi_lock);
+}
+
+/* the rate is kept in Hz, whole milliseconds only pace the fixed-rate path */
+static void report_rate_apply(uint16_t hz)
+{
+    report_rate_hz = hz;
+    report_interval_ms = (1000 + hz / 2) / hz;
+}
+
+uint16_t api_set_report_rate(uint16_t hz)
+{
+    if (hz < MOUSE_REPORT_RATE_MIN) hz = MOUSE_REPORT_RATE_MIN;
+    if (hz > MOUSE_REPORT_RATE_MAX) hz = MOUSE_REPORT_RATE_MAX;
+
+    report_rate_apply(hz);
+    settings_set_report_rate(hz);
+    return hz;
+}
+
+uint16_t api_get_report_rate(void) { return report_rate_hz; }
+
+void api_set_debounce(uint16_t click_us, uint16_t scroll_us)
+{
+    /* 0 restores the build default */
+    click_debounce_us = click_us ? click_us : CONFIG_MICRO_DEBOUNCE;
+    scroll_debounce_us = scroll_us ? scroll_us : CONFIG_ENCODER_DEBOUNCE;
+    settings_set_debounce(click_us, scroll_us);
+}
+
+void api_get_debounce(uint16_t *click_us, uint16_t *scroll_us)
+{
+    *click_us = click_debounce_us;
+    *scroll_us = scroll_debounce_us;
+}
+
+/* the move task is scaling with accel: the table is built aside, it is swapped in between bursts */
+void api_set_accel(const accel_params_t *params)
+{
+    if (accel_configure(&accel_build, params)) {
+        portENTER_CRITICAL(&motion_cfg_lock);
+        accel_next = accel_build;
+        accel_params = *params;
+        accel_pending = true;
+        portEXIT_CRITICAL(&motion_cfg_lock);
+
+        if (move_task_handle) xTaskNotifyGive(move_task_handle);
+        BLOG(ACCEL_CURVE, params->curve);
+    }
+    settings_set_accel(params);
+}
+
+void api_get_accel(accel_params_t *params)
+{
+    portENTER_CRITICAL(&motion_cfg_lock);
+    *params = accel_params;
+    portEXIT_CRITICAL(&motion_cfg_lock);
+}
+
+/* the move task is using xform: build the new one aside, it is swapped in between bursts */
+void api_set_xform(const motion_xform_params_t *params)
+{
+    motion_xform_t next;
+    motion_xform_configure(&next, params, false);
+    paw3395_set_axes(motion_xform_axis_reg(params->axes));
+
+    portENTER_CRITICAL(&motion_cfg_lock);
+    xform_next = next;
+    xform_params = *params;
+    xform_pending = true;
+    portEXIT_CRITICAL(&motion_cfg_lock);
+
+    if (move_task_handle) xTaskNotifyGive(move_task_handle);
+    settings_set_xform(params);
+}
+
+void api_get_xform(motion_xform_params_t *params)
+{
+    portENTER_CRITICAL(&motion_cfg_lock);
+    *params = xform_params;
+    portEXIT_CRITICAL(&motion_cfg_lock);
+}
+
+void api_set_surface(const surface_params_t *params)
+{
+    paw3395_set_surface(params);
+    settings_set_surface(params);
+}
+
+void api_get_surface(surface_params_t *params) { paw3395_get_surface(params, NULL); }
+
+/* the move task is filtering: configure a copy, it is swapped in between bursts */
+void api_set_filter(const motion_filter_params_t *params)
+{
+    motion_filter_t next;
+    motion_filter_configure(&next, params);
+
+    portENTER_CRITICAL(&motion_cfg_lock);
+    motion_filter_next = next;
+    filter_params = next.params;
+    filter_pending = true;
+    portEXIT_CRITICAL(&motion_cfg_lock);
+
+    if (move_task_handle) xTaskNotifyGive(move_task_handle);
+    settings_set_filter(params);
+}
+
+void api_get_filter(motion_filter_params_t *params)
+{
+    portENTER_CRITICAL(&motion_cfg_lock);
+    *params = filter_params;
+    portEXIT_CRITICAL(&motion_cfg_lock);
+}
+
+/* apply stored tunables without marking the settings dirty */
+static void resume_settings(void)
+{
+    settings_t s = settings_get();
+
+    /* the sensor already runs the current stage, see resume_dpi() */
+    cpi_stages = s.cpi;
+
+    if (s.report_rate_hz >= MOUSE_REPORT_RATE_MIN && s.report_rate_hz <= MOUSE_REPORT_RATE_MAX) {
+        report_rate_apply(s.report_rate_hz);
+    }
+    if (s.click_debounce_us) click_debounce_us = s.click_debounce_us;
+    if (s.scroll_debounce_us) scroll_debounce_us = s.scroll_debounce_us;
+    if (s.sensor_mode != PAW3395_MODE_HIGH_PERFORMANCE) paw3395_set_mode(s.sensor_mode);
+    /* before the move task exists, the live table can be built directly */
+    accel_configure(&accel, &s.accel);
+    accel_build = accel;
+    accel_params = accel.params;
+    paw3395_set_axes(motion_xform_axis_reg(s.xform.axes));
+    /* before the move task exists, the live transform can be set directly */
+    motion_xform_configure(&xform, &s.xform, false);
+    xform_params = s.xform;
+    paw3395_set_surface(&s.surface);
+    motion_filter_configure(&motion_filter, &s.filter);
+    filter_params = motion_filter.params;
+
+    portENTER_CRITICAL(&macro_lock);
+    memcpy(macro_slots, s.macros, sizeof(macro_slots));
+    portEXIT_CRITICAL(&macro_lock);
+}
 
 void api_macro(int16_t x, int16_t y, uint8_t btns)
 {
-    accum_item_t item = { .x = x, .y = y, .vertical = 0 };
-    buttons = btns; /* preserve original (thread-unsafe) behavior */
-    xQueueSend(accum_queue, &item, 0);
+    /* press, move, hold for one report interval, release */
+    uint16_t hold_ms = report_interval_ms;
+    const uint8_t code[] = {
+        MACRO_OP_PRESS, btns,
+        MACRO_OP_MOVE, x & 0xFF, (uint16_t)x >> 8, y & 0xFF, (uint16_t)y >> 8,
+        MACRO_OP_WAIT, hold_ms & 0xFF, hold_ms >> 8,
+        MACRO_OP_RELEASE, btns,
+        MACRO_OP_END,
+    };
+    macro_play(code, sizeof(code));
+}
+
+bool api_macro_store(uint8_t slot, uint8_t chord, const uint8_t *code, size_t len)
+{
+    /* validate outside the lock, the copy itself is short */
+    if (len && !macro_validate(code, len)) return false;
+
+    macro_slot_t stored;
+    portENTER_CRITICAL(&macro_lock);
+    bool ok = macro_slot_set(macro_slots, slot, chord, code, len);
+    if (ok) stored = macro_slots[slot];
+    portEXIT_CRITICAL(&macro_lock);
+
+    if (ok) settings_set_macro(slot, &stored);
+    return ok;
+}
+
+bool api_macro_get(uint8_t slot, macro_slot_t *macro)
+{
+    if (slot >= MACRO_SLOTS) return false;
+
+    portENTER_CRITICAL(&macro_lock);
+    *macro = macro_slots[slot];
+    portEXIT_CRITICAL(&macro_lock);
+    return true;
+}
+
+bool api_macro_play(uint8_t slot)
+{
+    uint8_t code[MACRO_CODE_MAX];
+    size_t len;
+
+    if (slot >= MACRO_SLOTS) return false;
+
+    portENTER_CRITICAL(&macro_lock);
+    len = macro_slots[slot].len;
+    memcpy(code, macro_slots[slot].code, len);
+    portEXIT_CRITICAL(&macro_lock);
+
+    if (!len) return false;
+    macro_play(code, len);
+    return true;
 }
 
 /* -------------------------------------------------------------------------
-   app_main
+   Boot steps, run by boot_run() as their dependencies complete
    ------------------------------------------------------------------------- */
-void app_main(void)
-{
-    esp_err_t ret;
+#if portNUM_PROCESSORS > 1
+#define BOOT_SENSOR_CORE SENSOR_CORE /* away from the NimBLE host */
+#else
+#define BOOT_SENSOR_CORE tskNO_AFFINITY
+#endif
 
-    /* NVS for BLE bonding storage */
-    ret = nvs_flash_init();
+/* NVS for BLE bonding storage and settings */
+static esp_err_t boot_nvs(void)
+{
+    esp_err_t ret = nvs_flash_init();
     if (ret == ESP_ERR_NVS_NO_FREE_PAGES || ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
         ESP_ERROR_CHECK(nvs_flash_erase());
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    return ret;
+}
 
-    /* Start BLE */
-    ret = wake_ble();
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "wake_ble failed: %s", esp_err_to_name(ret));
-        /* continue: input tasks still useful but BLE won't send */
+/* SPI, power-up sequence, SROM upload and clock calibration */
+static esp_err_t boot_sensor(void)
+{
+    /* the sensor lock has to exist even if this step fails, the tasks start anyway */
+    paw3395_init();
+
+    /* GPIO interrupts are allocated on the calling core, this step runs on the sensor core */
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+        ESP_LOGE(TAG, "gpio_install_isr_service failed: %s", esp_err_to_name(ret));
+        return ret;
     }
 
-    /* Initialize sensor */
+    ret = wake_spi();
+    if (ret != ESP_OK) return ret;
+
     wake_paw3395();
 
-    /* Install GPIO ISR service */
-    ret = gpio_install_isr_service(0);
-    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
-        ESP_LOGE(TAG, "gpio_install_isr_service failed: %s", esp_err_to_name(ret));
-    } else {
-        ESP_LOGI(TAG, "GPIO ISR service installed");
+    /* fastest reliable SPI clock, cached after the first boot */
+    uint32_t spi_hz = paw3395_calibrate_spi(settings_get().spi_clock_hz);
+    settings_set_spi_clock(spi_hz);
+
+    boot_mark(BOOT_MARK_SENSOR_READY);
+    return ESP_OK;
+}
+
+enum { STEP_NVS, STEP_SETTINGS, STEP_BLE, STEP_BATTERY, STEP_SENSOR };
+
+static const boot_step_t boot_steps[] = {
+    [STEP_NVS] = {"nvs", boot_nvs, 0, tskNO_AFFINITY, 3072, 5},
+    /* settings are read by the sensor init (DPI) */
+    [STEP_SETTINGS] = {"settings", wake_settings, BOOT_DEP(STEP_NVS), tskNO_AFFINITY, 3072, 5},
+    /* stack enable, GATT/HID setup; advertising starts from the HID START event */
+    [STEP_BLE] = {"ble", wake_ble, BOOT_DEP(STEP_NVS), 0, 4096, 5},
+    /* battery sampling reports through BAS */
+    [STEP_BATTERY] = {"battery", wake_battery, BOOT_DEP(STEP_BLE), tskNO_AFFINITY, 3072, 4},
+    [STEP_SENSOR] = {"sensor", boot_sensor, BOOT_DEP(STEP_SETTINGS), BOOT_SENSOR_CORE, 4096, 5},
+};
+
+/* -------------------------------------------------------------------------
+   app_main
+   ------------------------------------------------------------------------- */
+void app_main(void)
+{
+    esp_err_t ret;
+
+    /* BLE and sensor bring-up overlap; a failed step is logged and the
+       input tasks still start (without BLE nothing is sent) */
+    ret = boot_run(boot_steps, sizeof(boot_steps) / sizeof(boot_steps[0]));
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "boot_run failed: %s", esp_err_to_name(ret));
+        return;
     }
 
-    reg_isr_handler();
-    ESP_LOGI(TAG, "ISR handlers ready");
+    accel_init(&accel);
+#if CONFIG_MOTION_PREDICT_US
+    predict_params_t predict_params;
+    predict_default_params(&predict_params);
+    predict_init(&predictor, &predict_params);
+#endif
+
+    resume_settings();
 
     /* Create queue and mutex */
     accum_queue = xQueueCreate(32, sizeof(accum_item_t));
@@ -402,19 +1094,58 @@ void app_main(void)
         return;
     }
 
-    /* Create tasks */
-    if (xTaskCreate(report_loop_task, "report_loop_task", 4096, NULL, 1, &report_task_handle) != pdPASS) {
-        ESP_LOGE(TAG, "xTaskCreate report_loop_task failed");
+    macro_player_init(&macro_player);
+    const esp_timer_create_args_t macro_timer_args = {
+        .callback = on_macro_timer,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "macro",
+    };
+    if (esp_timer_create(&macro_timer_args, &macro_timer) != ESP_OK) {
+        ESP_LOGE(TAG, "esp_timer_create macro failed");
         return;
     }
-    if (xTaskCreate(accum_loop_task, "accum_loop_task", 4096, NULL, 2, NULL) != pdPASS) {
-        ESP_LOGE(TAG, "xTaskCreate accum_loop_task failed");
+
+    /* Priorities from the latency budgets, checked against the BLE host */
+    task_plan_init(task_plan, SENSOR_CORE, HOST_CORE, configMAX_PRIORITIES - 4);
+    sched_plan_assign(task_plan, TASK_COUNT, CONFIG_TASK_BASE_PRIORITY);
+    bool plan_ok = sched_plan_analyse(task_plan, TASK_COUNT);
+    for (int i = 0; i < TASK_COUNT; i++) {
+        const sched_task_t *t = &task_plan[i];
+        if (t->ok) {
+            ESP_LOGI(TAG, "%s: core %d prio %u, response %lu of %lu us", t->name, t->core, t->priority,
+                     (unsigned long)t->response_us, (unsigned long)t->deadline_us);
+        } else {
+            ESP_LOGW(TAG, "%s: core %d prio %u misses its %lu us budget", t->name, t->core, t->priority,
+                     (unsigned long)t->deadline_us);
+        }
+    }
+    if (!plan_ok) ESP_LOGW(TAG, "task plan over budget, check CONFIG_*_BUDGET_US / _WCET_US");
+
+    /* Create tasks before the ISRs that notify them */
+    if (sched_task_create(report_loop_task, &task_plan[TASK_REPORT], NULL, &report_task_handle) != ESP_OK) {
+        ESP_LOGE(TAG, "create report_loop_task failed");
         return;
     }
-    if (xTaskCreate(move_loop_task, "move_loop_task", 4096, NULL, 1, &move_task_handle) != pdPASS) {
-        ESP_LOGE(TAG, "xTaskCreate move_loop_task failed");
+    if (sched_task_create(accum_loop_task, &task_plan[TASK_ACCUM], NULL, NULL) != ESP_OK) {
+        ESP_LOGE(TAG, "create accum_loop_task failed");
         return;
     }
+    if (sched_task_create(move_loop_task, &task_plan[TASK_MOVE], NULL, &move_task_handle) != ESP_OK) {
+        ESP_LOGE(TAG, "create move_loop_task failed");
+        return;
+    }
+    if (sched_task_create(input_loop_task, &task_plan[TASK_INPUT], NULL, &input_task_handle) != ESP_OK) {
+        ESP_LOGE(TAG, "create input_loop_task failed");
+        return;
+    }
+
+    /* the GPIO ISR service was installed by boot_sensor on the sensor core */
+    reg_isr_handler();
+    ESP_LOGI(TAG, "ISR handlers ready");
+
+    wake_sched_stats(task_plan, task_latency, TASK_COUNT);
+    wake_telemetry();
+    wake_blog();
 
     ESP_LOGI(TAG, "app_main finished, tasks running");
 }
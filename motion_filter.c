@@ -0,0 +1,212 @@
+#include <string.h>
+
+#include "motion_filter.h"
+
+#define Q8 8
+#define DT_MIN_US 100
+#define DT_MAX_US 100000
+#define TWO_PI_Q16_PER_MHZ 25736 // 2 pi * 65536 / 16 (Q4) in units of 1e-6, cutoff * dt -> Q16 angle
+
+void motion_filter_default_params(motion_filter_params_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->stages = 0;
+    p->ma_len = 4;
+    p->min_cutoff = 20 * 16; // 20 Hz
+    p->beta = 8 * 16;        // +8 Hz per count/ms
+    p->d_cutoff = 10 * 16;   // 10 Hz
+    p->dz_enter = 2;
+    p->dz_exit = 1;
+    p->dz_quiet = 4;
+}
+
+static void reset(motion_filter_t *f)
+{
+    motion_filter_params_t p = f->params;
+
+    memset(f, 0, sizeof(*f));
+    f->params = p;
+}
+
+void motion_filter_configure(motion_filter_t *f, const motion_filter_params_t *p)
+{
+    f->params = *p;
+    if (f->params.ma_len == 0)
+    {
+        f->params.ma_len = 1;
+    }
+    if (f->params.ma_len > CONFIG_MOTION_FILTER_WINDOW)
+    {
+        f->params.ma_len = CONFIG_MOTION_FILTER_WINDOW;
+    }
+    if (f->params.dz_exit > f->params.dz_enter)
+    {
+        f->params.dz_exit = f->params.dz_enter;
+    }
+    if (f->params.dz_quiet == 0)
+    {
+        f->params.dz_quiet = 1;
+    }
+    reset(f);
+}
+
+static inline int32_t abs32(int32_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+// max + min / 2, within 12% of the Euclidean length
+static inline int32_t mag(int32_t x, int32_t y)
+{
+    int32_t ax = abs32(x);
+    int32_t ay = abs32(y);
+
+    return ax > ay ? ax + ay / 2 : ay + ax / 2;
+}
+
+static void deadzone(motion_filter_t *f, int32_t v[2])
+{
+    const motion_filter_params_t *p = &f->params;
+
+    if (!f->dz_moving)
+    {
+        f->dz_pend[0] += v[0];
+        f->dz_pend[1] += v[1];
+        if (mag(f->dz_pend[0], f->dz_pend[1]) < ((int32_t)p->dz_enter << Q8))
+        {
+            v[0] = v[1] = 0;
+            return;
+        }
+        // broke out of the dead zone: let everything collected through
+        v[0] = f->dz_pend[0];
+        v[1] = f->dz_pend[1];
+        f->dz_pend[0] = f->dz_pend[1] = 0;
+        f->dz_moving = true;
+        f->dz_still = 0;
+        return;
+    }
+
+    // while moving nothing is held back, small samples only count towards stopping
+    if (mag(v[0], v[1]) <= ((int32_t)p->dz_exit << Q8))
+    {
+        if (++f->dz_still >= p->dz_quiet)
+        {
+            f->dz_moving = false;
+        }
+    }
+    else
+    {
+        f->dz_still = 0;
+    }
+}
+
+static void average(motion_filter_t *f, int32_t v[2])
+{
+    uint8_t len = f->params.ma_len;
+    // written len samples ago, leaves the window now
+    uint8_t old = (uint8_t)((f->ma_pos + CONFIG_MOTION_FILTER_WINDOW - len) % CONFIG_MOTION_FILTER_WINDOW);
+
+    for (int i = 0; i < 2; i++)
+    {
+        f->ma_sum[i] += v[i] - f->ma_buf[i][old];
+        f->ma_buf[i][f->ma_pos] = v[i];
+        int32_t out = f->ma_sum[i] / len;
+        f->ma_held[i] += v[i] - out;
+        v[i] = out;
+    }
+    f->ma_pos = (uint8_t)((f->ma_pos + 1) % CONFIG_MOTION_FILTER_WINDOW);
+}
+
+// smoothing factor Q16 of a first order low pass at cutoff_q4 sampled every dt_us: w / (w + 1), w = 2 pi fc dt
+static uint32_t lowpass_alpha(uint32_t cutoff_q4, uint32_t dt_us)
+{
+    uint64_t w = (uint64_t)cutoff_q4 * dt_us * TWO_PI_Q16_PER_MHZ / 1000000u;
+
+    return (uint32_t)((w << 16) / (w + 65536u));
+}
+
+static void one_euro(motion_filter_t *f, int32_t v[2], uint32_t dt_us)
+{
+    const motion_filter_params_t *p = &f->params;
+
+    // speed of this sample in counts/ms Q4, low passed so one outlier does not open the filter
+    uint32_t speed = (uint32_t)(((uint64_t)mag(v[0], v[1]) * 1000u * 16u >> Q8) / dt_us);
+    uint32_t a_d = lowpass_alpha(p->d_cutoff, dt_us);
+    f->euro_speed += (int32_t)(((int64_t)((int32_t)speed - (int32_t)f->euro_speed) * a_d) >> 16);
+
+    uint32_t cutoff = p->min_cutoff + (uint32_t)(((uint64_t)p->beta * f->euro_speed) >> 4);
+    uint32_t a = lowpass_alpha(cutoff, dt_us);
+
+    for (int i = 0; i < 2; i++)
+    {
+        // the output closes the fraction a of the distance to the input
+        int32_t lag = f->euro_lag[i] + v[i];
+        int32_t out = (int32_t)(((int64_t)lag * a) >> 16);
+        f->euro_lag[i] = lag - out;
+        v[i] = out;
+    }
+}
+
+static int16_t round_out(int32_t *rem, int32_t v)
+{
+    int32_t out;
+
+    *rem += v;
+    out = (*rem + (1 << (Q8 - 1))) >> Q8;
+    if (out > INT16_MAX)
+    {
+        out = INT16_MAX;
+    }
+    else if (out < INT16_MIN)
+    {
+        out = INT16_MIN;
+    }
+    *rem -= out << Q8;
+    return (int16_t)out;
+}
+
+void motion_filter_apply(motion_filter_t *f, int16_t *dx, int16_t *dy, uint32_t dt_us)
+{
+    uint8_t stages = f->params.stages;
+    int32_t v[2] = {(int32_t)*dx << Q8, (int32_t)*dy << Q8};
+
+    if (stages == 0)
+    {
+        return;
+    }
+    if (dt_us < DT_MIN_US)
+    {
+        dt_us = DT_MIN_US;
+    }
+    else if (dt_us > DT_MAX_US)
+    {
+        dt_us = DT_MAX_US;
+    }
+
+    if (stages & MOTION_FILTER_DEADZONE)
+    {
+        deadzone(f, v);
+    }
+    if (stages & MOTION_FILTER_AVERAGE)
+    {
+        average(f, v);
+    }
+    if (stages & MOTION_FILTER_ONE_EURO)
+    {
+        one_euro(f, v, dt_us);
+    }
+
+    *dx = round_out(&f->rem[0], v[0]);
+    *dy = round_out(&f->rem[1], v[1]);
+}
+
+bool motion_filter_flush(motion_filter_t *f, int16_t *dx, int16_t *dy)
+{
+    int32_t x = f->ma_held[0] + f->euro_lag[0];
+    int32_t y = f->ma_held[1] + f->euro_lag[1];
+
+    *dx = round_out(&f->rem[0], x);
+    *dy = round_out(&f->rem[1], y);
+    reset(f);
+    return *dx != 0 || *dy != 0;
+}
@@ -0,0 +1,89 @@
+#ifndef MOTION_FILTER_H
+#define MOTION_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+
+/*
+ * Jitter and smoothing filters on the raw sensor deltas. No IDF dependency.
+ *
+ * Stages run in a fixed order, each one enabled by a bit in stages:
+ *   deadzone       motion from rest must add up to dz_enter counts before it
+ *                  passes; once moving, dz_quiet samples of at most dz_exit
+ *                  counts return to rest and what is pending is dropped
+ *   moving average mean of the last ma_len deltas, running sum, no loop
+ *   1 euro         first order low pass whose cutoff rises with speed:
+ *                  min_cutoff + beta * speed, speed itself low passed at
+ *                  d_cutoff (Casiez et al., CHI 2012)
+ *
+ * All state is static, Q8 fixed point, and every stage is constant work per
+ * sample. The smoothing stages hold back part of the motion while it runs;
+ * motion_filter_flush() releases it when the burst ends, so no counts are
+ * lost. Only the deadzone discards motion, by design.
+ *
+ * Units: cutoffs in Hz Q4 (16 = 1 Hz), beta in Hz Q4 per count/ms.
+ */
+
+#ifndef CONFIG_MOTION_FILTER_WINDOW
+#define CONFIG_MOTION_FILTER_WINDOW 8 /* longest moving average, samples */
+#endif
+
+#define MOTION_FILTER_DEADZONE 0x01
+#define MOTION_FILTER_AVERAGE 0x02
+#define MOTION_FILTER_ONE_EURO 0x04
+
+typedef struct
+{
+    uint8_t stages;      // MOTION_FILTER_* flags, 0 = pass through
+    uint8_t ma_len;      // 1..CONFIG_MOTION_FILTER_WINDOW
+    uint16_t min_cutoff; // Hz Q4
+    uint16_t beta;       // Hz Q4 per count/ms
+    uint16_t d_cutoff;   // Hz Q4
+    uint8_t dz_enter;    // counts
+    uint8_t dz_exit;     // counts
+    uint8_t dz_quiet;    // samples
+    uint8_t reserved0;
+} motion_filter_params_t;
+
+typedef struct
+{
+    motion_filter_params_t params;
+    // deadzone
+    int32_t dz_pend[2]; // Q8, motion collected at rest
+    uint8_t dz_still;
+    bool dz_moving;
+    // moving average
+    uint8_t ma_pos;
+    int32_t ma_buf[2][CONFIG_MOTION_FILTER_WINDOW]; // Q8
+    int32_t ma_sum[2];
+    int32_t ma_held[2]; // in - out so far, Q8
+    // 1 euro
+    int32_t euro_lag[2]; // input - output position, Q8
+    uint32_t euro_speed; // counts/ms Q4
+    // output rounding
+    int32_t rem[2]; // Q8
+} motion_filter_t;
+
+void motion_filter_default_params(motion_filter_params_t *p);
+
+/**
+ * @brief Clamp the parameters into range and start from rest.
+ */
+void motion_filter_configure(motion_filter_t *f, const motion_filter_params_t *p);
+
+/**
+ * @brief Filter one sample in place, dt_us = time since the previous one.
+ */
+void motion_filter_apply(motion_filter_t *f, int16_t *dx, int16_t *dy, uint32_t dt_us);
+
+/**
+ * @brief Release what the smoothing stages hold and start from rest; call when motion stops.
+ * @return true if there is motion left to send
+ */
+bool motion_filter_flush(motion_filter_t *f, int16_t *dx, int16_t *dy);
+
+#endif
@@ -0,0 +1,183 @@
+#include <math.h>
+#include <string.h>
+
+#include "motion_xform.h"
+
+#define Q14 14
+
+// PAW3395 AXIS_CTRL bits
+#define AXIS_CTRL_INV_X 0x20
+#define AXIS_CTRL_INV_Y 0x40
+#define AXIS_CTRL_SWAP_XY 0x80
+
+void motion_xform_default_params(motion_xform_params_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    // the sensor is mounted mirrored on this board
+    p->axes = MOTION_XFORM_INVERT_X;
+    p->hyst_deg = 5;
+}
+
+uint8_t motion_xform_axis_reg(uint8_t axes)
+{
+    uint8_t reg = 0;
+
+    if (axes & MOTION_XFORM_INVERT_X)
+    {
+        reg |= AXIS_CTRL_INV_X;
+    }
+    if (axes & MOTION_XFORM_INVERT_Y)
+    {
+        reg |= AXIS_CTRL_INV_Y;
+    }
+    if (axes & MOTION_XFORM_SWAP_XY)
+    {
+        reg |= AXIS_CTRL_SWAP_XY;
+    }
+
+    return reg;
+}
+
+static uint16_t tan_q8(unsigned deg)
+{
+    if (deg >= 45)
+    {
+        deg = 45; // past 45 degrees both axes would qualify
+    }
+    return (uint16_t)(tanf(deg * (float)M_PI / 180.0f) * 256.0f + 0.5f);
+}
+
+void motion_xform_configure(motion_xform_t *t, const motion_xform_params_t *p, bool soft_axes)
+{
+    memset(t, 0, sizeof(*t));
+    t->params = *p;
+    t->soft_axes = soft_axes;
+
+    t->rotate = p->rotation % 3600 != 0;
+    if (t->rotate)
+    {
+        float rad = p->rotation * (float)M_PI / 1800.0f;
+        float c = cosf(rad);
+        float s = sinf(rad);
+        t->m[0] = lroundf(c * (1 << Q14));
+        t->m[1] = lroundf(-s * (1 << Q14));
+        t->m[2] = lroundf(s * (1 << Q14));
+        t->m[3] = lroundf(c * (1 << Q14));
+    }
+
+    if (p->snap_deg)
+    {
+        t->tan_enter = tan_q8(p->snap_deg);
+        t->tan_exit = tan_q8(p->snap_deg + p->hyst_deg);
+    }
+}
+
+static inline int16_t sat16(int32_t v)
+{
+    return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : (int16_t)v;
+}
+
+static void snap_update(motion_xform_t *t, int16_t dx, int16_t dy)
+{
+    uint32_t ax = (uint32_t)(dx < 0 ? -dx : dx) << 4;
+    uint32_t ay = (uint32_t)(dy < 0 ? -dy : dy) << 4;
+
+    // average over ~4 samples so one noisy sample does not flip the decision
+    t->avg_x += ((int32_t)ax - (int32_t)t->avg_x) >> 2;
+    t->avg_y += ((int32_t)ay - (int32_t)t->avg_y) >> 2;
+
+    uint32_t x = t->avg_x;
+    uint32_t y = t->avg_y;
+
+    switch (t->snap)
+    {
+    case MOTION_SNAP_X:
+        if ((y << 8) > t->tan_exit * x)
+        {
+            t->snap = MOTION_SNAP_NONE;
+        }
+        break;
+    case MOTION_SNAP_Y:
+        if ((x << 8) > t->tan_exit * y)
+        {
+            t->snap = MOTION_SNAP_NONE;
+        }
+        break;
+    default:
+        break;
+    }
+
+    if (t->snap == MOTION_SNAP_NONE && (x | y))
+    {
+        if ((y << 8) <= t->tan_enter * x)
+        {
+            t->snap = MOTION_SNAP_X;
+        }
+        else if ((x << 8) <= t->tan_enter * y)
+        {
+            t->snap = MOTION_SNAP_Y;
+        }
+    }
+}
+
+void motion_xform_apply(motion_xform_t *t, int16_t *dx, int16_t *dy)
+{
+    int32_t x = *dx;
+    int32_t y = *dy;
+
+    if (t->soft_axes)
+    {
+        uint8_t axes = t->params.axes;
+        if (axes & MOTION_XFORM_INVERT_X)
+        {
+            x = -x;
+        }
+        if (axes & MOTION_XFORM_INVERT_Y)
+        {
+            y = -y;
+        }
+        if (axes & MOTION_XFORM_SWAP_XY)
+        {
+            int32_t tmp = x;
+            x = y;
+            y = tmp;
+        }
+    }
+
+    if (t->rotate)
+    {
+        int32_t rx = t->m[0] * x + t->m[1] * y + t->rem_x;
+        int32_t ry = t->m[2] * x + t->m[3] * y + t->rem_y;
+        // round to nearest: the remainder dropped by motion_xform_reset() is then
+        // +-0.5 count with no bias, a floor would lose up to a count per stroke down-left
+        x = (rx + (1 << (Q14 - 1))) >> Q14;
+        y = (ry + (1 << (Q14 - 1))) >> Q14;
+        t->rem_x = rx - (x << Q14);
+        t->rem_y = ry - (y << Q14);
+    }
+
+    if (t->params.snap_deg)
+    {
+        snap_update(t, sat16(x), sat16(y));
+        if (t->snap == MOTION_SNAP_X)
+        {
+            y = 0;
+        }
+        else if (t->snap == MOTION_SNAP_Y)
+        {
+            x = 0;
+        }
+    }
+
+    *dx = sat16(x);
+    *dy = sat16(y);
+}
+
+void motion_xform_reset(motion_xform_t *t)
+{
+    t->rem_x = 0;
+    t->rem_y = 0;
+    t->avg_x = 0;
+    t->avg_y = 0;
+    t->snap = MOTION_SNAP_NONE;
+}
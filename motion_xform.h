@@ -0,0 +1,74 @@
+#ifndef MOTION_XFORM_H
+#define MOTION_XFORM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Motion transform: axis inversion/swap, rotation and angle snapping.
+ *
+ * Inversion and swap are pure register settings on the PAW3395 (AXIS_CTRL),
+ * so they are done by the sensor and cost nothing here; motion_xform_axis_reg()
+ * gives the value to write. Rotation uses a Q14 2x2 matrix with the rounding
+ * remainder carried between samples, so no counts are lost. Snapping locks
+ * the off axis to zero while motion stays within snap_deg of an axis and only
+ * unlocks beyond snap_deg + hyst_deg, so it does not chatter at the boundary.
+ */
+
+#define MOTION_XFORM_INVERT_X 0x01
+#define MOTION_XFORM_INVERT_Y 0x02
+#define MOTION_XFORM_SWAP_XY 0x04
+
+typedef struct
+{
+    int16_t rotation; // tenths of a degree, counter-clockwise
+    uint8_t axes;     // MOTION_XFORM_* flags
+    uint8_t snap_deg; // 0 = snapping off
+    uint8_t hyst_deg;
+    uint8_t reserved0;
+} motion_xform_params_t;
+
+typedef enum
+{
+    MOTION_SNAP_NONE = 0,
+    MOTION_SNAP_X, // locked to horizontal
+    MOTION_SNAP_Y, // locked to vertical
+} motion_snap_t;
+
+typedef struct
+{
+    motion_xform_params_t params;
+    bool rotate;
+    bool soft_axes;        // apply axes in software (sensor cannot)
+    int32_t m[4];          // Q14 row-major rotation
+    int32_t rem_x, rem_y;  // Q14 remainders
+    uint16_t tan_enter;    // Q8 tan(snap_deg)
+    uint16_t tan_exit;     // Q8 tan(snap_deg + hyst_deg)
+    uint32_t avg_x, avg_y; // Q4 moving averages of |dx|, |dy|
+    motion_snap_t snap;
+} motion_xform_t;
+
+void motion_xform_default_params(motion_xform_params_t *p);
+
+/**
+ * @brief Precompute matrix and snap thresholds. soft_axes = true applies inversion
+ *        and swap in software too, for targets without AXIS_CTRL (and the host).
+ */
+void motion_xform_configure(motion_xform_t *t, const motion_xform_params_t *p, bool soft_axes);
+
+/**
+ * @brief PAW3395 AXIS_CTRL value for the axis flags.
+ */
+uint8_t motion_xform_axis_reg(uint8_t axes);
+
+/**
+ * @brief Transform one sample in place.
+ */
+void motion_xform_apply(motion_xform_t *t, int16_t *dx, int16_t *dy);
+
+/**
+ * @brief Forget snap state and remainders, call when motion stops.
+ */
+void motion_xform_reset(motion_xform_t *t);
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef MOUSE_API_H
+#define MOUSE_API_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "accel.h"
+#include "motion_xform.h"
+#include "cpi.h"
+#include "surface.h"
+#include "motion_filter.h"
+#include "macro.h"
+
+/*
+ * Runtime control of the input pipeline, implemented in main.c.
+ * Setters apply immediately and update the settings store.
+ */
+
+/**
+ * @brief Set both axes of the current CPI stage.
+ */
+void api_set_dpi(uint16_t dpi);
+
+uint16_t api_get_dpi(void);
+
+/**
+ * @brief Cycle to the next CPI stage (what DPI_SWITCH_GPIO does).
+ */
+void api_cpi_stage_next(void);
+
+bool api_cpi_select(uint8_t index);
+
+/**
+ * @brief Set one stage and the number of stages in use; applied at once if it is the current one.
+ */
+bool api_cpi_set_stage(uint8_t index, uint16_t x, uint16_t y, uint8_t count);
+
+void api_cpi_get_stages(cpi_stages_t *stages);
+
+/**
+ * @brief Set the report rate, clamped to MOUSE_REPORT_RATE_MIN..MAX.
+ * @return the rate actually applied
+ */
+uint16_t api_set_report_rate(uint16_t hz);
+
+uint16_t api_get_report_rate(void);
+
+/**
+ * @brief Set the button and wheel debounce windows in microseconds, 0 restores the default.
+ */
+void api_set_debounce(uint16_t click_us, uint16_t scroll_us);
+
+void api_get_debounce(uint16_t *click_us, uint16_t *scroll_us);
+
+/**
+ * @brief Replace the acceleration curve; the gain table is rebuilt only if the parameters changed.
+ */
+void api_set_accel(const accel_params_t *params);
+
+void api_get_accel(accel_params_t *params);
+
+/**
+ * @brief Set rotation, axis flags and snapping; axis flags go to the sensor's AXIS_CTRL.
+ */
+void api_set_xform(const motion_xform_params_t *params);
+
+void api_get_xform(motion_xform_params_t *params);
+
+/**
+ * @brief Lift-off and SQUAL gating of sensor motion.
+ */
+void api_set_surface(const surface_params_t *params);
+
+void api_get_surface(surface_params_t *params);
+
+/**
+ * @brief Jitter and smoothing stages on the raw sensor deltas.
+ */
+void api_set_filter(const motion_filter_params_t *params);
+
+void api_get_filter(motion_filter_params_t *params);
+
+/**
+ * @brief One-shot macro: press btns, move by x/y, release after one report interval.
+ */
+void api_macro(int16_t x, int16_t y, uint8_t btns);
+
+/**
+ * @brief Store a macro program (see macro.h) in a slot, triggered by the button chord
+ *        (two or more buttons, 0 for manual only). len 0 clears the slot.
+ */
+bool api_macro_store(uint8_t slot, uint8_t chord, const uint8_t *code, size_t len);
+
+bool api_macro_get(uint8_t slot, macro_slot_t *macro);
+
+bool api_macro_play(uint8_t slot);
+
+#endif
@@ -0,0 +1,41 @@
+#include "config_proto.h"
+#include "mouse_hid.h"
+
+const uint8_t mouse_hid_report_map[] = {
+    // Application Collection: Mouse, report ID 1, fields from MOUSE_HID_FIELDS
+    MOUSE_HID_DESCRIPTOR
+
+    // Application Collection: Vendor configuration channel
+    0x06,
+    0x00,
+    0xFF, // Usage Page (Vendor Defined 0xFF00)
+    0x09,
+    0x01, // Usage (Vendor Usage 1)
+    0xA1,
+    0x01, // Collection (Application)
+
+    // Report ID 2: config request (Output/Feature) and response (Feature)
+    0x85,
+    CONFIG_REPORT_ID, //   Report ID (2)
+    0x15,
+    0x00, //   Logical Minimum (0)
+    0x26,
+    0xFF,
+    0x00, //   Logical Maximum (255)
+    0x75,
+    0x08, //   Report Size (8)
+    0x95,
+    CONFIG_REPORT_LEN, //   Report Count (16)
+    0x09,
+    0x02, //   Usage (Vendor Usage 2)
+    0xB1,
+    0x02, //   Feature (Data,Var,Abs)
+    0x09,
+    0x03, //   Usage (Vendor Usage 3)
+    0x91,
+    0x02, //   Output (Data,Var,Abs)
+
+    0xC0, // End Collection (Application)
+};
+
+const size_t mouse_hid_report_map_len = sizeof(mouse_hid_report_map);
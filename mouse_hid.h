@@ -0,0 +1,85 @@
+#ifndef MOUSE_HID_H
+#define MOUSE_HID_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if __has_include("sdkconfig.h")
+#include "sdkconfig.h"
+#endif
+#include "hid_report.h"
+
+/*
+ * The mouse input report, declared once. MOUSE_HID_DESCRIPTOR and
+ * mouse_hid_pack() are both expanded from MOUSE_HID_FIELDS, so the bytes
+ * the host is told about and the bytes sent cannot drift apart.
+ */
+
+#ifndef CONFIG_MOUSE_HID_XY_BITS
+#define CONFIG_MOUSE_HID_XY_BITS 8 /* 12 or 16 for high CPI without splitting reports */
+#endif
+#ifndef CONFIG_MOUSE_HID_PAN
+#define CONFIG_MOUSE_HID_PAN 0 /* horizontal wheel field (AC Pan) */
+#endif
+
+#define MOUSE_HID_REPORT_ID 1
+
+#if CONFIG_MOUSE_HID_PAN
+#define MOUSE_HID_PAN_FIELD(X) X(pan, REL, 8, HID_PAGE_CONSUMER, HID_USAGE_AC_PAN)
+#else
+#define MOUSE_HID_PAN_FIELD(X)
+#endif
+
+#define MOUSE_HID_FIELDS(X)                                                     \
+    X(buttons, BUTTONS, 5, HID_PAGE_BUTTON, 0)                                  \
+    X(pad0, PAD, 3, 0, 0)                                                       \
+    X(x, REL, CONFIG_MOUSE_HID_XY_BITS, HID_PAGE_DESKTOP, HID_USAGE_X)          \
+    X(y, REL, CONFIG_MOUSE_HID_XY_BITS, HID_PAGE_DESKTOP, HID_USAGE_Y)          \
+    X(wheel, REL, 8, HID_PAGE_DESKTOP, HID_USAGE_WHEEL)                         \
+    MOUSE_HID_PAN_FIELD(X)
+
+#define MOUSE_HID_X_MEMBER(name, kind, bits, page, usage) HID_MEMBER_##kind(name)
+#define MOUSE_HID_X_DESC(name, kind, bits, page, usage) HID_DESC_##kind(bits, page, usage)
+#define MOUSE_HID_X_BIT(name, kind, bits, page, usage) \
+    MOUSE_HID_BIT_##name, MOUSE_HID_LAST_##name = MOUSE_HID_BIT_##name + (bits) - 1,
+#define MOUSE_HID_X_PACK(name, kind, bits, page, usage) HID_PACK_##kind(out, r->name, MOUSE_HID_BIT_##name, bits)
+
+// bit offset of every field, in list order
+enum
+{
+    MOUSE_HID_FIELDS(MOUSE_HID_X_BIT) MOUSE_HID_REPORT_BITS
+};
+
+#define MOUSE_HID_REPORT_LEN (MOUSE_HID_REPORT_BITS / 8)
+#define MOUSE_HID_XY_MAX HID_LMAX(CONFIG_MOUSE_HID_XY_BITS)
+
+_Static_assert(MOUSE_HID_REPORT_BITS % 8 == 0, "pad MOUSE_HID_FIELDS to a whole byte");
+_Static_assert(CONFIG_MOUSE_HID_XY_BITS >= 8 && CONFIG_MOUSE_HID_XY_BITS <= 16, "X/Y are 8 to 16 bits");
+
+typedef struct
+{
+    MOUSE_HID_FIELDS(MOUSE_HID_X_MEMBER)
+} mouse_hid_report_t;
+
+// Pointer collection with the input report, for the application collection
+#define MOUSE_HID_DESCRIPTOR                                                                   \
+    0x05, HID_PAGE_DESKTOP, 0x09, 0x02, 0xA1, 0x01, /* Usage (Mouse), Collection (Application) */ \
+        0x85, MOUSE_HID_REPORT_ID, 0x09, 0x01, 0xA1, 0x00, /* Usage (Pointer), Collection (Physical) */ \
+        MOUSE_HID_FIELDS(MOUSE_HID_X_DESC) 0xC0, /* End Collection (Physical) */                \
+        0xC0,                                     /* End Collection (Application) */
+
+/**
+ * @brief Report map of the device: the mouse collection above plus the
+ *        vendor configuration channel. tools/hid_check.c validates it.
+ */
+extern const uint8_t mouse_hid_report_map[];
+extern const size_t mouse_hid_report_map_len;
+
+static inline void mouse_hid_pack(const mouse_hid_report_t *r, uint8_t out[MOUSE_HID_REPORT_LEN])
+{
+    memset(out, 0, MOUSE_HID_REPORT_LEN);
+    MOUSE_HID_FIELDS(MOUSE_HID_X_PACK)
+}
+
+#endif
@@ -10,94 +10,21 @@
 #include "esp_log.h"
 
 #include "esp_hid_gap.h"
+#include "battery.h"
+#include "settings.h"
+#include "config_channel.h"
+#include "boot.h"
+#include "mouse_hid.h"
+#include "print_report_map.h"
+#include "stats.h"
+#include "blog_log.h"
 #include "nimble.h"
 
 static const char *TAG = "nimble";
 
-static const uint8_t mouse_report_map[] = {
-    // Application Collection: Mouse
-    0x05,
-    0x01, // Usage Page (Generic Desktop)
-    0x09,
-    0x02, // Usage (Mouse)
-    0xA1,
-    0x01, // Collection (Application)
-
-    // Report ID 1: Mouse Input (Device -> Host)
-    0x85,
-    0x01, //   Report ID (1)
-    0x09,
-    0x01, //   Usage (Pointer)
-    0xA1,
-    0x00, //   Collection (Physical)
-
-    // Button bits (5 buttons)
-    0x05,
-    0x09, //     Usage Page (Button)
-    0x19,
-    0x01, //     Usage Minimum (Button 1)
-    0x29,
-    0x05, //     Usage Maximum (Button 5)
-    0x15,
-    0x00, //     Logical Minimum (0)
-    0x25,
-    0x01, //     Logical Maximum (1)
-    0x75,
-    0x01, //     Report Size (1)
-    0x95,
-    0x05, //     Report Count (5)
-    0x81,
-    0x02, //     Input (Data,Var,Abs) - Button states
-
-    // Padding to fill 1 byte
-    0x75,
-    0x03, //     Report Size (3)
-    0x95,
-    0x01, //     Report Count (1)
-    0x81,
-    0x03, //     Input (Const,Var,Abs) - Padding
-
-    // X and Y movement (relative)
-    0x05,
-    0x01, //     Usage Page (Generic Desktop)
-    0x09,
-    0x30, //     Usage (X)
-    0x09,
-    0x31, //     Usage (Y)
-    0x15,
-    0x81, //     Logical Minimum (-127)
-    0x25,
-    0x7F, //     Logical Maximum (127)
-    0x75,
-    0x08, //     Report Size (8)
-    0x95,
-    0x02, //     Report Count (2)
-    0x81,
-    0x06, //     Input (Data,Var,Rel) - X,Y relative movement
-
-    // Vertical wheel
-    0x09,
-    0x38, //     Usage (Wheel)
-    0x15,
-    0x81, //     Logical Minimum (-127)
-    0x25,
-    0x7F, //     Logical Maximum (127)
-    0x75,
-    0x08, //     Report Size (8)
-    0x95,
-    0x01, //     Report Count (1)
-    0x81,
-    0x06, //     Input (Data,Var,Rel) - Vertical wheel
-
-    0xC0, //   End Collection (Physical)
-
-    0xC0, // End Collection (Application)
-};
-
 static esp_hid_raw_report_map_t ble_report_maps[] = {
     {
-        .data = mouse_report_map,
-        .len = sizeof(mouse_report_map),
+        .data = mouse_hid_report_map, // .len set in wake_ble()
     },
 };
 
@@ -116,17 +43,50 @@ static uint8_t ble_hid_task_state;
 
 static esp_hidd_dev_t *hid_dev;
 
+/**
+ * Run a config request and publish the response as the feature value,
+ * so the host reads it back with a feature get.
+ */
+static void ble_hid_config_request(uint16_t report_id, const uint8_t *data, uint16_t length)
+{
+    uint8_t rsp[CONFIG_REPORT_LEN];
+
+    if (report_id != CONFIG_REPORT_ID)
+    {
+        return;
+    }
+
+    size_t n = config_channel_handle(data, length, rsp, sizeof(rsp));
+    if (n)
+    {
+        esp_hidd_dev_feature_set(hid_dev, 0, CONFIG_REPORT_ID, rsp, n);
+    }
+}
+
 void ble_hid_task_start_up(void)
 {
     ble_hid_task_state = 1;
-    // esp_hidd_dev_battery_set(hid_dev, 100); // we can not get real bat. there always set 100
-    ESP_LOGI(TAG, "hid start up");
+    // the BAS value may have moved while disconnected, publish the current one
+    esp_hidd_dev_battery_set(hid_dev, battery_level());
+    BLOG(HID_UP);
 }
 
 void ble_hid_task_shut_down(void)
 {
     ble_hid_task_state = 0;
-    ESP_LOGI(TAG, "hid shut down");
+    BLOG(HID_DOWN);
+}
+
+// the first 16 bytes of a host write, in order when printed as %08x words
+static void blog_data(const uint8_t *data, uint16_t len)
+{
+    uint32_t w[BLOG_ARGS_MAX] = {0};
+
+    for (uint16_t i = 0; i < len && i < sizeof(w); i++)
+    {
+        w[i / 4] |= (uint32_t)data[i] << (24 - 8 * (i % 4));
+    }
+    blog_log(BLOG_HID_DATA, w, BLOG_ARGS_MAX);
 }
 
 static void ble_hidd_event_callback(void *handler_args, esp_event_base_t base, int32_t id, void *event_data)
@@ -138,23 +98,25 @@ static void ble_hidd_event_callback(void *handler_args, esp_event_base_t base, i
     {
     case ESP_HIDD_START_EVENT:
     {
-        ESP_LOGI(TAG, "START");
+        BLOG(HID_START);
         esp_hid_ble_gap_adv_start();
+        boot_mark(BOOT_MARK_ADVERTISING);
         break;
     }
     case ESP_HIDD_CONNECT_EVENT:
     {
-        ESP_LOGI(TAG, "CONNECT");
+        BLOG(HID_CONNECT);
+        stats_inc(STATS_RECONNECTS);
         break;
     }
     case ESP_HIDD_PROTOCOL_MODE_EVENT:
     {
-        ESP_LOGI(TAG, "PROTOCOL MODE[%u]: %s", param->protocol_mode.map_index, param->protocol_mode.protocol_mode ? "REPORT" : "BOOT");
+        BLOG(HID_PROTOCOL, param->protocol_mode.map_index, param->protocol_mode.protocol_mode);
         break;
     }
     case ESP_HIDD_CONTROL_EVENT:
     {
-        ESP_LOGI(TAG, "CONTROL[%u]: %sSUSPEND", param->control.map_index, param->control.control ? "EXIT_" : "");
+        BLOG(HID_CONTROL, param->control.map_index, param->control.control);
         if (param->control.control)
         {
             // exit suspend
@@ -169,27 +131,28 @@ static void ble_hidd_event_callback(void *handler_args, esp_event_base_t base, i
     }
     case ESP_HIDD_OUTPUT_EVENT:
     {
-        ESP_LOGI(TAG, "OUTPUT[%u]: %8s ID: %2u, Len: %d, Data:", param->output.map_index, esp_hid_usage_str(param->output.usage), param->output.report_id, param->output.length);
-        ESP_LOG_BUFFER_HEX(TAG, param->output.data, param->output.length);
-
+        BLOG(HID_OUTPUT, param->output.map_index, param->output.report_id, param->output.length);
+        blog_data(param->output.data, param->output.length);
+        ble_hid_config_request(param->output.report_id, param->output.data, param->output.length);
         break;
     }
     case ESP_HIDD_FEATURE_EVENT:
     {
-        ESP_LOGI(TAG, "FEATURE[%u]: %8s ID: %2u, Len: %d, Data:", param->feature.map_index, esp_hid_usage_str(param->feature.usage), param->feature.report_id, param->feature.length);
-        ESP_LOG_BUFFER_HEX(TAG, param->feature.data, param->feature.length);
+        BLOG(HID_FEATURE, param->feature.map_index, param->feature.report_id, param->feature.length);
+        blog_data(param->feature.data, param->feature.length);
+        ble_hid_config_request(param->feature.report_id, param->feature.data, param->feature.length);
         break;
     }
     case ESP_HIDD_DISCONNECT_EVENT:
     {
-        ESP_LOGI(TAG, "DISCONNECT: %s", esp_hid_disconnect_reason_str(esp_hidd_dev_transport_get(param->disconnect.dev), param->disconnect.reason));
+        BLOG(HID_DISCONNECT, param->disconnect.reason);
         ble_hid_task_shut_down();
         esp_hid_ble_gap_adv_start();
         break;
     }
     case ESP_HIDD_STOP_EVENT:
     {
-        ESP_LOGI(TAG, "STOP");
+        BLOG(HID_STOP);
         break;
     }
     default:
@@ -218,16 +181,6 @@ void ble_hid_device_host_task(void *param)
 
 void ble_store_config_init(void);
 
-// close bat service
-void ble_svc_bas_init(void)
-{
-}
-
-esp_err_t ble_svc_bas_battery_level_set(uint8_t level)
-{
-    return ESP_OK;
-}
-
 esp_err_t wake_ble(void)
 {
     esp_err_t ret;
@@ -238,6 +191,12 @@ esp_err_t wake_ble(void)
     ret = esp_hid_ble_gap_adv_init(ESP_HID_APPEARANCE_MOUSE, ble_hid_config.device_name);
     ESP_ERROR_CHECK(ret);
 
+    ble_report_maps[0].len = mouse_hid_report_map_len;
+    if (!print_report_map_info(&ble_report_maps[0]))
+    {
+        ESP_LOGE(TAG, "HID report map rejected, hosts may refuse the device");
+    }
+
     ESP_LOGI(TAG, "setting ble device");
     ESP_ERROR_CHECK(
         esp_hidd_dev_init(&ble_hid_config, ESP_HID_TRANSPORT_BLE, ble_hidd_event_callback, &hid_dev));
@@ -261,6 +220,9 @@ esp_err_t sleep_ble(void)
 {
     esp_err_t ret;
 
+    // last chance to persist pending settings before power goes down
+    settings_flush();
+
     if (hid_dev != NULL)
     {
         ret = esp_hidd_dev_deinit(hid_dev);
@@ -273,12 +235,50 @@ esp_err_t sleep_ble(void)
     return ret;
 }
 
-void ble_hid_mouse_report(uint8_t buttons, char x, char y, char vertical)
+void ble_hid_mouse_report(uint8_t buttons, int16_t x, int16_t y, int8_t vertical)
 {
-    static uint8_t buffer[4] = {0};
-    buffer[0] = buttons;
-    buffer[1] = x;
-    buffer[2] = y;
-    buffer[3] = vertical;
-    esp_hidd_dev_input_set(hid_dev, 0, 1, buffer, 4);
+    static uint8_t buffer[MOUSE_HID_REPORT_LEN];
+    mouse_hid_report_t report = {
+        .buttons = buttons,
+        .x = x,
+        .y = y,
+        .wheel = vertical,
+    };
+
+    mouse_hid_pack(&report, buffer);
+    if (esp_hidd_dev_input_set(hid_dev, 0, MOUSE_HID_REPORT_ID, buffer, sizeof(buffer)) == ESP_OK)
+    {
+        stats_inc(STATS_REPORTS_SENT);
+    }
+    else
+    {
+        stats_inc(STATS_REPORTS_DROPPED);
+    }
+}
+
+esp_err_t ble_conn_params(uint16_t itvl_min, uint16_t itvl_max, uint16_t latency, uint16_t timeout)
+{
+    if (!ble_mounted())
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    BLOG(GAP_CONN_REQUEST, itvl_min, itvl_max, latency);
+    return esp_hid_ble_gap_conn_update(itvl_min, itvl_max, latency, timeout);
+}
+
+uint16_t ble_conn_itvl(void)
+{
+    return ble_mounted() ? esp_hid_ble_gap_conn_itvl() : 0;
+}
+
+void ble_hid_battery_report(uint8_t level)
+{
+    if (hid_dev == NULL)
+    {
+        return;
+    }
+
+    // BAS notifies subscribed centrals from here, callers only report on change
+    esp_hidd_dev_battery_set(hid_dev, level);
 }
@@ -1,6 +1,7 @@
 #ifndef NIMBLE_H
 #define NIMBLE_H
 
+#include <stdint.h>
 #include <stdlib.h>
 
 esp_err_t wake_ble(void);
@@ -9,7 +10,22 @@ esp_err_t sleep_ble(void);
 
 bool ble_mounted(void);
 
-void ble_hid_mouse_report(uint8_t buttons, char x, char y, char vertical);
+/**
+ * @brief Send the mouse input report, x/y are clamped to MOUSE_HID_XY_MAX.
+ */
+void ble_hid_mouse_report(uint8_t buttons, int16_t x, int16_t y, int8_t vertical);
+
+void ble_hid_battery_report(uint8_t level);
+
+/**
+ * @brief Request connection parameters from the central (1.25 ms, events, 10 ms units).
+ */
+esp_err_t ble_conn_params(uint16_t itvl_min, uint16_t itvl_max, uint16_t latency, uint16_t timeout);
+
+/**
+ * @brief Connection interval in use (1.25 ms units), 0 when not connected.
+ */
+uint16_t ble_conn_itvl(void);
 
 void ble_power_save();
 
@@ -1,79 +1,124 @@
 
 #include <stdlib.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include "driver/gpio.h"
 #include "driver/spi_master.h"
+#include "esp_cpu.h"
 #include "esp_log.h"
-#include "nvs_flash.h"
-#include "nvs.h"
+#include "esp_partition.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
 #include "pins.h"
+#include "settings.h"
+#include "cpi.h"
+#include "sensor_health.h"
+#include "srom.h"
+#include "stats.h"
+#include "blog_log.h"
+#include "capture_uart.h"
 #include "spi.h"
 #include "paw3395.h"
 
 static const char *TAG = "paw3395";
 
-static uint16_t dpi; // actually its cpi
+#ifndef CONFIG_PAW3395_SPI_CAL_ROUNDS
+#define CONFIG_PAW3395_SPI_CAL_ROUNDS 32 /* ID + readback checks per calibration step */
+#endif
+#ifndef CONFIG_PAW3395_SPI_CAL_MARGIN
+#define CONFIG_PAW3395_SPI_CAL_MARGIN 1 /* steps below the fastest passing clock */
+#endif
+
+// SPI clock steps up to the sensor maximum (10 MHz), 80 MHz APB divided by 20, 16, 10, 8
+static const uint32_t spi_clock_steps[] = {4000000, 5000000, 8000000, 10000000};
+
+// gaps between frames, converted to CPU cycles in wake_paw3395()
+#define T_SWW_NS 5000  // tSWW / tSWR, after a write
+#define T_SRR_NS 2000  // tSRW / tSRR, after a read
+#define T_BEXIT_NS 500 // after a motion burst
+
+#ifndef CONFIG_PAW3395_SROM_ENABLE
+#define CONFIG_PAW3395_SROM_ENABLE 0 /* the PAW3395 boots from ROM, only needed for patched firmware */
+#endif
+#define SROM_PARTITION_LABEL "srom"
+
+#ifndef CONFIG_PAW3395_HEALTH_STRIKES
+#define CONFIG_PAW3395_HEALTH_STRIKES 1 /* failed checks tolerated before a re-init */
+#endif
+
+// PERFORMANCE[1:0] selects the run mode, corded gaming additionally sets bit 7
+static const uint8_t mode_reg[] = {
+    [PAW3395_MODE_HIGH_PERFORMANCE] = 0x00,
+    [PAW3395_MODE_LOW_POWER] = 0x01,
+    [PAW3395_MODE_OFFICE] = 0x02,
+    [PAW3395_MODE_CORDED_GAMING] = 0x83,
+};
+
+static uint16_t cpi_x; // resolution currently programmed, 0 = unknown
+static uint16_t cpi_y;
+static uint8_t mode = PAW3395_MODE_HIGH_PERFORMANCE;
+static uint8_t axis_ctrl = AXIS_CTRL_DEFAULT;
+
+/*
+ * Serializes register sequences against burst reads, so a CPI stage switch or
+ * mode change from another task never splits an in-flight burst.
+ */
+static SemaphoreHandle_t sensor_mutex;
 
-static inline void delay_ms(uint8_t nms)
+static inline void sensor_lock(void)
 {
-    vTaskDelay(pdMS_TO_TICKS(nms));
+    xSemaphoreTake(sensor_mutex, portMAX_DELAY);
 }
 
-static inline void delay_us(uint32_t nus)
+static inline void sensor_unlock(void)
 {
-    esp_rom_delay_us(nus);
+    xSemaphoreGive(sensor_mutex);
 }
 
-static inline void delay_120ns()
+static inline void delay_ms(uint8_t nms)
 {
-    // Minimum delay set to 1 microsecond.
-    // The target of 120 nanoseconds cannot be reliably achieved due to hardware constraints (Xtensa architecture & CPU clock cycle limits).
-    delay_us(1);
+    vTaskDelay(pdMS_TO_TICKS(nms));
 }
 
-static inline void delay_500ns()
-{
-    // Same to delay_120ns()
-    delay_us(1);
-}
+static uint32_t t_sww_cycles;
+static uint32_t t_srr_cycles;
+static uint32_t t_bexit_cycles;
 
-static inline void cs_high(void)
+static uint32_t ns_to_cycles(uint32_t ns)
 {
-    delay_120ns();
-    gpio_set_level(PAW3395_SPI_CS, 1);
+    return (ns * esp_rom_get_cpu_ticks_per_us() + 999) / 1000;
 }
 
-static inline void cs_low(void)
+// busy wait on the CPU cycle counter, sub-microsecond where esp_rom_delay_us() is not
+static inline void delay_cycles(uint32_t cycles)
 {
-    gpio_set_level(PAW3395_SPI_CS, 0);
-    delay_120ns();
+    uint32_t start = esp_cpu_get_cycle_count();
+
+    while (esp_cpu_get_cycle_count() - start < cycles)
+    {
+    }
 }
 
+/*
+ * Register access goes through the SPI transport (spi.h), which owns CS and
+ * the address-to-data delay. Only the gaps between frames are timed here.
+ */
+static const spi_transport_t *bus;
+
 static inline void paw3395_write(uint8_t reg_addr, uint8_t reg_data)
 {
-    cs_low();
-
-    spi_write_data(reg_addr, reg_data);
-
-    cs_high();
+    bus->write(bus->ctx, reg_addr, reg_data);
 
-    delay_us(5);
+    delay_cycles(t_sww_cycles);
 }
 
 static inline uint8_t paw3395_read(uint8_t reg_addr)
 {
     uint8_t data = 0;
-    cs_low();
-
-    spi_send_read(reg_addr);
-
-    delay_us(2);
-
-    // Read data
-    data = spi_read_data();
 
-    cs_high();
+    bus->read(bus->ctx, reg_addr, &data, 1);
 
-    delay_us(2);
+    delay_cycles(t_srr_cycles);
 
     return data;
 }
@@ -252,36 +297,133 @@ static void load_powerup_reg_setting()
     paw3395_write(0x7F, 0x00);
 }
 
-static uint8_t motion_burst_buffer[12] = {0};
+static uint8_t motion_burst_buffer[SURFACE_BURST_LEN] = {0};
+static surface_gate_t surface;
+
+static sensor_health_t health = {.strikes_max = CONFIG_PAW3395_HEALTH_STRIKES};
+static bool burst_fresh;         // a burst was read since the last health check
+static uint32_t spi_errors_seen; // spi_error_count() at the last health check
+
+static int read_motion()
+{
+    // one frame for the whole burst instead of a transaction per byte
+    int ret = bus->read(bus->ctx, MOTION_BURST_ADR, motion_burst_buffer, SURFACE_BURST_LEN);
+
+    delay_cycles(t_bexit_cycles);
+
+    burst_fresh = true;
+
+    return ret;
+}
+
+#if CONFIG_PAW3395_SROM_ENABLE
+static srom_image_t srom;
+static esp_partition_mmap_handle_t srom_map_handle;
 
-static void read_motion()
+// map the partition once, the image stays mapped for re-inits
+static esp_err_t srom_map(void)
 {
-    cs_low();
+    const void *blob;
 
-    spi_send_read(MOTION_BURST_ADR);
+    if (srom.data)
+    {
+        return ESP_OK;
+    }
 
-    delay_us(2);
+    const esp_partition_t *part =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, SROM_PARTITION_LABEL);
+    if (part == NULL)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t ret = esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &blob, &srom_map_handle);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
 
-    for (uint8_t i = 0; i < 12; i++)
+    int st = srom_image_parse(blob, part->size, &srom);
+    if (st != SROM_OK)
     {
-        motion_burst_buffer[i] = spi_read_data();
+        ESP_LOGE(TAG, "SROM image invalid (%d)", st);
+        esp_partition_munmap(srom_map_handle);
+        return ESP_ERR_INVALID_CRC;
     }
 
-    cs_high();
-    delay_500ns();
+    return ESP_OK;
 }
 
+// call with the sensor locked, after the power-up register setting
+static esp_err_t srom_upload(void)
+{
+    esp_err_t ret = srom_map();
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "no SROM upload: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
+    int64_t start = esp_timer_get_time();
+
+    paw3395_write(SROM_ENABLE, SROM_ENABLE_INIT);
+    delay_ms(10);
+    paw3395_write(SROM_ENABLE, SROM_ENABLE_LOAD);
+
+    // streamed straight from the flash mapping
+    if (bus->write_stream(bus->ctx, SROM_LOAD_BURST, srom.data, srom.length, SROM_BYTE_GAP_NS) != SPI_TRANSPORT_OK)
+    {
+        return ESP_FAIL;
+    }
+    delay_cycles(ns_to_cycles(200000)); // 200 us before the first register access
+
+    uint8_t id = paw3395_read(SROM_ID);
+
+    paw3395_write(SROM_ENABLE, SROM_ENABLE_CRC);
+    delay_ms(10);
+    uint16_t crc = paw3395_read(SROM_DATA_OUT_LOWER) | (paw3395_read(SROM_DATA_OUT_UPPER) << 8);
+
+    int64_t took = esp_timer_get_time() - start;
+
+    if (id != srom.id || crc != SROM_SELF_TEST_OK)
+    {
+        ESP_LOGE(TAG, "SROM upload failed: id 0x%02x (want 0x%02x), crc 0x%04x", id, srom.id, crc);
+        return ESP_ERR_INVALID_CRC;
+    }
+
+    ESP_LOGI(TAG, "SROM 0x%02x uploaded, %lu bytes in %lld us", id, (unsigned long)srom.length, took);
+
+    return ESP_OK;
+}
+#endif
+
 void resume_dpi(void);
 
+void paw3395_init(void)
+{
+    if (sensor_mutex == NULL)
+    {
+        sensor_mutex = xSemaphoreCreateMutex();
+    }
+}
+
 void wake_paw3395()
 {
     ESP_LOGI(TAG, "Wake paw3395 begin.");
 
+    paw3395_init();
+    t_sww_cycles = ns_to_cycles(T_SWW_NS);
+    t_srr_cycles = ns_to_cycles(T_SRR_NS);
+    t_bexit_cycles = ns_to_cycles(T_BEXIT_NS);
+    sensor_lock();
+
+    // set under the lock: NULL tells everyone else the sensor never woke
+    bus = spi_transport();
+
     delay_ms(50); // wait 50 ms
 
     // reset SPI
-    cs_high();
-    cs_low();
+    bus->reset_port(bus->ctx);
 
     // write 0x5A to POWER_UP_RESET
     paw3395_write(0x3A, 0x5A);
@@ -297,70 +439,147 @@ void wake_paw3395()
     paw3395_read(0x05);
     paw3395_read(0x06);
 
-    ESP_LOGI(TAG, "PRODUCT_ID:0x%02x", paw3395_read(0x00));
+#if CONFIG_PAW3395_SROM_ENABLE
+    srom_upload();
+#endif
 
-    // our paw3395 install reverse.so we need reverse axis_x
-    paw3395_write(0x5B, 0x20);
+    uint8_t product_id = paw3395_read(PAW3395_PRODUCT_ID_REG);
+    if (product_id != PAW3395_PRODUCT_ID)
+    {
+        ESP_LOGW(TAG, "PRODUCT_ID:0x%02x, expected 0x%02x", product_id, PAW3395_PRODUCT_ID);
+    }
+    else
+    {
+        ESP_LOGI(TAG, "PRODUCT_ID:0x%02x", product_id);
+    }
+
+    // mounting correction, see motion_xform.h
+    paw3395_write(AXIS_CTRL, axis_ctrl);
+
+    // power-up reset also dropped the run mode
+    if (mode != PAW3395_MODE_HIGH_PERFORMANCE)
+    {
+        paw3395_write(0x7F, 0x00);
+        paw3395_write(PERFORMANCE, mode_reg[mode]);
+    }
+
+    burst_fresh = false;
+    spi_errors_seen = spi_error_count();
+
+    // power-up reset cleared the resolution registers
+    cpi_x = cpi_y = 0;
+
+    sensor_unlock();
 
     ESP_LOGI(TAG, "Wake paw3395 end.");
 
     resume_dpi();
 }
 
-void read_move(int16_t *x, int16_t *y)
+esp_err_t read_move(int16_t *x, int16_t *y)
 {
-    read_motion();
+    surface_burst_t burst;
+    bool pass;
 
-    *x += (int16_t)(motion_burst_buffer[2] + (motion_burst_buffer[3] << 8));
-    *y += (int16_t)(motion_burst_buffer[4] + (motion_burst_buffer[5] << 8));
-}
-
-void set_dpi(uint16_t new_dpi)
-{
-    if (new_dpi < CPI_MIN)
+    sensor_lock();
+    if (bus == NULL)
     {
-        new_dpi = CPI_MIN;
+        sensor_unlock();
+        return ESP_FAIL;
     }
-
-    if (new_dpi > CPI_MAX)
+    if (read_motion() != SPI_TRANSPORT_OK)
     {
-        new_dpi = CPI_MIN;
+        sensor_unlock();
+        stats_inc(STATS_SPI_ERRORS);
+        return ESP_FAIL;
     }
+    surface_parse_burst(motion_burst_buffer, &burst);
+    pass = surface_gate(&surface, &burst);
+    if (capture_enabled())
+    {
+        capture_burst((uint32_t)esp_timer_get_time(), motion_burst_buffer, pass ? burst.dx : 0, pass ? burst.dy : 0,
+                      pass ? CAPTURE_FLAG_PASS : 0);
+    }
+    sensor_unlock();
 
-    if (new_dpi == dpi)
+    if (!pass)
     {
-        return;
+        return ESP_ERR_INVALID_STATE;
     }
 
-    uint16_t reg_value = (new_dpi / CPI_MIN) - 1;
+    *x += burst.dx;
+    *y += burst.dy;
 
-    uint8_t high_byte = (reg_value >> 8) & 0x0F;
-    uint8_t low_byte = reg_value & 0xFF;
+    return ESP_OK;
+}
 
-    // both x y resolution set by RESOLUTION_X_L,RESOLUTION_X_h
-    paw3395_write(MOTION_CTRL, 0x00);
+void paw3395_set_surface(const surface_params_t *params)
+{
+    sensor_lock();
+    surface_configure(&surface, params);
+    sensor_unlock();
+}
 
-    paw3395_write(RESOLUTION_X_LOW, low_byte);
-    paw3395_write(RESOLUTION_X_HIGH, high_byte);
+void paw3395_get_surface(surface_params_t *params, surface_stats_t *stats)
+{
+    sensor_lock();
+    if (params)
+    {
+        *params = surface.params;
+    }
+    if (stats)
+    {
+        *stats = surface.stats;
+    }
+    sensor_unlock();
+}
 
-    // refresh
-    paw3395_write(SET_RESOLUTION, 0x01);
+static void write_gap(void)
+{
+    delay_cycles(t_sww_cycles);
+}
 
-    delay_500ns();
+void paw3395_set_cpi(uint16_t x, uint16_t y)
+{
+    x = cpi_clamp(x);
+    y = cpi_clamp(y);
 
-    dpi = new_dpi;
+    // compare, program and cache under one lock: with two setters interleaving
+    // the cache could otherwise name a resolution the sensor is not running
+    sensor_lock();
+    if (bus == NULL || (x == cpi_x && y == cpi_y))
+    {
+        sensor_unlock();
+        return;
+    }
 
-    ESP_LOGI(TAG, "current DPI(CPI):%d", dpi);
+    bool ok = cpi_program(bus, x, y, write_gap) == SPI_TRANSPORT_OK;
 
-    nvs_handle_t nvs_handle;
-    esp_err_t ret = nvs_open("storage", NVS_READWRITE, &nvs_handle);
-    if (ret != ESP_OK)
+    delay_cycles(t_bexit_cycles);
+
+    // a sequence cut short leaves the registers unknown, the next set retries
+    cpi_x = ok ? x : 0;
+    cpi_y = ok ? y : 0;
+
+    sensor_unlock();
+
+    if (ok)
     {
-        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(ret));
+        BLOG(CPI, x, y);
     }
+}
 
-    ret = nvs_set_u16(nvs_handle, "dpi", dpi);
-    nvs_close(nvs_handle);
+void paw3395_get_cpi(uint16_t *x, uint16_t *y)
+{
+    sensor_lock();
+    *x = cpi_x;
+    *y = cpi_y;
+    sensor_unlock();
+}
+
+void set_dpi(uint16_t new_dpi)
+{
+    paw3395_set_cpi(new_dpi, new_dpi);
 }
 
 /**
@@ -368,24 +587,161 @@ void set_dpi(uint16_t new_dpi)
  */
 void resume_dpi(void)
 {
-    nvs_handle_t nvs_handle;
-    esp_err_t ret = nvs_open("storage", NVS_READWRITE, &nvs_handle);
-    if (ret != ESP_OK)
+    // restoring must not mark the settings dirty, so only the sensor is touched
+    settings_t s = settings_get();
+    cpi_xy_t cpi = cpi_stages_current(&s.cpi);
+
+    paw3395_set_cpi(cpi.x, cpi.y);
+}
+
+uint16_t get_dpi(void)
+{
+    return cpi_x;
+}
+
+esp_err_t paw3395_set_mode(uint8_t new_mode)
+{
+    if (new_mode >= sizeof(mode_reg))
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sensor_lock();
+    if (bus == NULL)
+    {
+        sensor_unlock();
+        return ESP_ERR_INVALID_STATE;
+    }
+    paw3395_write(0x7F, 0x00);
+    paw3395_write(PERFORMANCE, mode_reg[new_mode]);
+    sensor_unlock();
+
+    mode = new_mode;
+
+    BLOG(SENSOR_MODE, mode);
+
+    return ESP_OK;
+}
+
+uint8_t paw3395_get_mode(void)
+{
+    return mode;
+}
+
+void paw3395_set_axes(uint8_t new_axis_ctrl)
+{
+    if (new_axis_ctrl == axis_ctrl)
+    {
+        return;
+    }
+
+    // written by wake_paw3395() if the sensor is not up yet
+    sensor_lock();
+    if (bus != NULL)
     {
-        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(ret));
+        paw3395_write(0x7F, 0x00);
+        paw3395_write(AXIS_CTRL, new_axis_ctrl);
+    }
+    axis_ctrl = new_axis_ctrl;
+    sensor_unlock();
+}
+
+void paw3395_health_check(void)
+{
+    sensor_lock();
+    if (bus == NULL)
+    {
+        // SPI never came up, there is nothing to check or re-init
+        sensor_unlock();
         return;
     }
 
-    uint16_t dpi;
-    ret = nvs_get_u16(nvs_handle, "dpi", &dpi);
-    nvs_close(nvs_handle);
+    uint8_t product_id = paw3395_read(PAW3395_PRODUCT_ID_REG);
+    uint8_t inv_product_id = paw3395_read(PAW3395_INV_PRODUCT_ID_REG);
+
+    uint32_t spi_errors = spi_error_count();
+    bool spi_error = spi_errors != spi_errors_seen;
+    spi_errors_seen = spi_errors;
+
+    sensor_fault_t fault = sensor_health_classify(product_id, inv_product_id,
+                                                  burst_fresh ? motion_burst_buffer : NULL,
+                                                  sizeof(motion_burst_buffer), spi_error);
+    burst_fresh = false;
+
+    bool reinit = sensor_health_report(&health, fault);
 
-    if (ret == ESP_OK)
+    sensor_unlock();
+
+    if (fault != SENSOR_FAULT_NONE)
     {
-        set_dpi(dpi);
+        ESP_LOGW(TAG, "health fault %d (id 0x%02x/0x%02x), total %lu", fault, product_id,
+                 inv_product_id, (unsigned long)health.faults);
     }
-    else
+    if (reinit)
+    {
+        ESP_LOGE(TAG, "sensor unhealthy, re-init #%lu", (unsigned long)health.reinits);
+        // the calibrated clock may be what broke, fall back and calibrate again next boot
+        spi_set_clock(spi_clock_steps[0]);
+        settings_set_spi_clock(0);
+        wake_paw3395();
+    }
+}
+
+void paw3395_get_health(sensor_health_t *out)
+{
+    sensor_lock();
+    *out = health;
+    sensor_unlock();
+}
+
+static bool spi_clock_probe(void *ctx, uint32_t clock_hz)
+{
+    (void)ctx;
+
+    if (clock_hz > PAW3395_SPI_CLOCK_MAX || spi_set_clock(clock_hz) != ESP_OK)
     {
-        set_dpi(1600);//默认dpi
+        return false;
     }
-}
\ No newline at end of file
+
+    for (int i = 0; i < CONFIG_PAW3395_SPI_CAL_ROUNDS; i++)
+    {
+        // alternate bit patterns through a register that is only latched by SET_RESOLUTION
+        uint8_t pattern = (i & 1 ? 0x55 : 0xAA) ^ (uint8_t)i;
+
+        if (paw3395_read(PAW3395_PRODUCT_ID_REG) != PAW3395_PRODUCT_ID ||
+            paw3395_read(PAW3395_INV_PRODUCT_ID_REG) != PAW3395_INV_PRODUCT_ID)
+        {
+            return false;
+        }
+        paw3395_write(RESOLUTION_X_LOW, pattern);
+        if (paw3395_read(RESOLUTION_X_LOW) != pattern)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+uint32_t paw3395_calibrate_spi(uint32_t cached_hz)
+{
+    uint32_t start_hz = spi_transport_config()->clock_hz;
+
+    sensor_lock();
+
+    paw3395_write(0x7F, 0x00);
+    uint8_t x_low = paw3395_read(RESOLUTION_X_LOW);
+
+    uint32_t hz = spi_transport_pick_clock(cached_hz, start_hz, spi_clock_steps,
+                                           sizeof(spi_clock_steps) / sizeof(spi_clock_steps[0]),
+                                           CONFIG_PAW3395_SPI_CAL_MARGIN, spi_clock_probe, NULL);
+
+    spi_set_clock(hz);
+    paw3395_write(RESOLUTION_X_LOW, x_low);
+
+    sensor_unlock();
+
+    ESP_LOGI(TAG, "SPI clock %lu Hz%s", (unsigned long)hz, hz == cached_hz ? " (cached)" : "");
+
+    return hz;
+}
@@ -1,21 +1,91 @@
 #ifndef PAW3395_H
 #define PAW3395_H
 
+#include "surface.h"
+#include "sensor_health.h"
+
 #define MOTION_BURST_ADR 0x16
 
-#define MOTION_CTRL 0x5C
+// resolution registers (SET_RESOLUTION, RESOLUTION_*, MOTION_CTRL) are in cpi.h
+
+#define PERFORMANCE 0x40
+
+#define PAW3395_SPI_CLOCK_MAX 10000000
+
+#define AXIS_CTRL 0x5B
+// our paw3395 is installed mirrored, so axis_x is inverted by default
+#define AXIS_CTRL_DEFAULT 0x20
 
-#define CPI_MIN 50
-#define CPI_MAX 26000
+// run modes, written to PERFORMANCE
+#define PAW3395_MODE_HIGH_PERFORMANCE 0
+#define PAW3395_MODE_LOW_POWER 1
+#define PAW3395_MODE_OFFICE 2
+#define PAW3395_MODE_CORDED_GAMING 3
 
-#define SET_RESOLUTION 0x47
-#define RESOLUTION_X_LOW 0x48
-#define RESOLUTION_X_HIGH 0x49
+/**
+ * @brief Create the sensor lock. Boot calls it before bringing up SPI, so the
+ *        calls below are safe even if the sensor never wakes: they then do
+ *        nothing (read_move() fails, paw3395_set_mode() returns ESP_ERR_INVALID_STATE).
+ */
+void paw3395_init(void);
 
 void wake_paw3395();
 
-void read_move(int16_t *x, int16_t *y);
+/**
+ * @brief Read one motion burst and add its deltas to *x, *y.
+ * @return ESP_ERR_INVALID_STATE if the surface gate dropped the sample (lift, low SQUAL),
+ *         ESP_FAIL on an SPI error or with the sensor down
+ */
+esp_err_t read_move(int16_t *x, int16_t *y);
+
+/**
+ * @brief Lift/SQUAL gating parameters, see surface.h.
+ */
+void paw3395_set_surface(const surface_params_t *params);
+
+void paw3395_get_surface(surface_params_t *params, surface_stats_t *stats);
+
+/**
+ * @brief Program independent X/Y resolution (clamped, CPI_STEP granular).
+ *        Atomic with respect to read_move(); no-op if unchanged.
+ */
+void paw3395_set_cpi(uint16_t x, uint16_t y);
+
+void paw3395_get_cpi(uint16_t *x, uint16_t *y);
 
+/**
+ * @brief Same resolution on both axes. Sensor only, stages and persistence live in main.c.
+ */
 void set_dpi(uint16_t new_dpi);
 
+uint16_t get_dpi(void);
+
+/**
+ * @brief Switch the sensor run mode live, returns ESP_ERR_INVALID_ARG for unknown modes.
+ */
+esp_err_t paw3395_set_mode(uint8_t mode);
+
+uint8_t paw3395_get_mode(void);
+
+/**
+ * @brief Write AXIS_CTRL (inversion/swap done by the sensor), kept across re-inits.
+ */
+void paw3395_set_axes(uint8_t axis_ctrl);
+
+/**
+ * @brief Validate product ID, last burst and SPI errors; re-init the sensor after
+ *        repeated failures. Call only while the sensor is idle, it costs a few register reads.
+ */
+void paw3395_health_check(void);
+
+void paw3395_get_health(sensor_health_t *out);
+
+/**
+ * @brief Find the fastest reliable SPI clock (product ID and register readback at
+ *        increasing clocks, one step of margin) and switch to it. cached_hz (0 = none)
+ *        is tried first and kept if it still passes.
+ * @return the clock in use
+ */
+uint32_t paw3395_calibrate_spi(uint32_t cached_hz);
+
 #endif
\ No newline at end of file
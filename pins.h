@@ -25,14 +25,15 @@
 #define WHEEL_ENC_A_GPIO   34
 #define WHEEL_ENC_B_GPIO   35
 
+// 调试用原始帧输出（UART1 TX，接任意 USB 串口模块）
+#define CAPTURE_UART_TX_GPIO 22
+
+// 电池电压检测（GPIO36/VP 为 ADC1 输入专用，外接 1:1 分压）
+#define BATTERY_ADC_GPIO   36
+
 // 使用的 SPI host：强制使用 VSPI_HOST（不要使用 SPI_HOST/flash）
 #ifndef PAW3395_SPI_HOST
 #define PAW3395_SPI_HOST   VSPI_HOST
 #endif
 
-// 报告率（Hz）
-#define MOUSE_REPORT_RATE_DEFAULT 150
-#define MOUSE_REPORT_RATE_MIN     100
-#define MOUSE_REPORT_RATE_MAX     150
-
 #endif // PINS_H
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <string.h>
+
+#include "predict.h"
+
+#define DT_MIN_US 1000
+#define DT_MAX_US 50000 // a longer gap is a new stroke, not slow motion
+
+void predict_default_params(predict_params_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->alpha = 128; // 0.5
+    p->beta = 43;   // alpha^2 / (2 - alpha), critically damped
+    p->max_lead = 64;
+}
+
+void predict_init(predict_t *pr, const predict_params_t *p)
+{
+    memset(pr, 0, sizeof(*pr));
+    pr->p = *p;
+}
+
+static int32_t div_round(int64_t n, int64_t d)
+{
+    return (int32_t)(n >= 0 ? (n + d / 2) / d : (n - d / 2) / d);
+}
+
+// one axis of the tracker, returns the lead in counts
+static int16_t track(const predict_params_t *p, int32_t *err, int32_t *vel, int32_t d, uint32_t dt_us,
+                     uint32_t lead_us)
+{
+    // the estimate moves with the velocity, the true position by d
+    int32_t pred = *err + div_round((int64_t)*vel * dt_us, 1000) - d * 256;
+    int32_t resid = -pred;
+
+    *err = pred + div_round((int64_t)resid * p->alpha, 256);
+    *vel += div_round((int64_t)resid * p->beta * 1000, (int64_t)dt_us * 256);
+
+    int32_t lead = div_round((int64_t)*vel * lead_us, 1000 * 256);
+    if (lead > p->max_lead)
+    {
+        lead = p->max_lead;
+    }
+    else if (lead < -(int32_t)p->max_lead)
+    {
+        lead = -(int32_t)p->max_lead;
+    }
+    // never lead against the motion just seen, that is a reversal the tracker has not caught up with
+    if ((d > 0 && lead < 0) || (d < 0 && lead > 0) || d == 0)
+    {
+        lead = 0;
+    }
+    return (int16_t)lead;
+}
+
+void predict_apply(predict_t *pr, int32_t *dx, int32_t *dy, uint32_t now_us, uint32_t lead_us)
+{
+    uint32_t dt = now_us - pr->last_us;
+    int16_t lead_x = 0, lead_y = 0;
+
+    pr->last_us = now_us;
+
+    if (lead_us == 0 || (*dx == 0 && *dy == 0) || !pr->tracking || dt > DT_MAX_US)
+    {
+        // stopped, disabled or a new stroke: start over from this report
+        pr->err_x = pr->err_y = 0;
+        pr->vel_x = pr->vel_y = 0;
+        pr->tracking = lead_us != 0 && (*dx != 0 || *dy != 0);
+        if (pr->tracking)
+        {
+            if (dt > DT_MAX_US)
+            {
+                dt = DT_MAX_US;
+            }
+            // first velocity straight from this report
+            pr->vel_x = div_round((int64_t)*dx * 256 * 1000, dt < DT_MIN_US ? DT_MIN_US : dt);
+            pr->vel_y = div_round((int64_t)*dy * 256 * 1000, dt < DT_MIN_US ? DT_MIN_US : dt);
+        }
+    }
+    else
+    {
+        if (dt < DT_MIN_US)
+        {
+            dt = DT_MIN_US;
+        }
+        lead_x = track(&pr->p, &pr->err_x, &pr->vel_x, *dx, dt, lead_us);
+        lead_y = track(&pr->p, &pr->err_y, &pr->vel_y, *dy, dt, lead_us);
+    }
+
+    *dx += lead_x - pr->lead_x;
+    *dy += lead_y - pr->lead_y;
+    pr->lead_x = lead_x;
+    pr->lead_y = lead_y;
+}
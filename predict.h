@@ -0,0 +1,59 @@
+#ifndef PREDICT_H
+#define PREDICT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Motion prediction on the report stream. No IDF dependency.
+ *
+ * An alpha-beta tracker follows the pointer velocity from report to report.
+ * Each report is shifted ahead by velocity * lead, the time until the host
+ * is expected to see it. The lead sent with the previous report is taken
+ * back in the next one, so the cursor only runs ahead while it moves: a
+ * report without motion drops the velocity and returns the whole lead,
+ * which is the overshoot correction.
+ *
+ * Units: position Q8 counts, velocity Q8 counts per millisecond.
+ */
+
+typedef struct
+{
+    uint16_t alpha;    // Q8 position gain
+    uint16_t beta;     // Q8 velocity gain
+    uint16_t max_lead; // counts per axis the cursor may run ahead
+} predict_params_t;
+
+typedef struct
+{
+    predict_params_t p;
+    int32_t err_x; // estimate - true position, Q8
+    int32_t err_y;
+    int32_t vel_x; // Q8 counts/ms
+    int32_t vel_y;
+    int16_t lead_x; // counts sent ahead of the true position
+    int16_t lead_y;
+    uint32_t last_us;
+    bool tracking;
+} predict_t;
+
+void predict_default_params(predict_params_t *p);
+
+void predict_init(predict_t *pr, const predict_params_t *p);
+
+/**
+ * @brief Shift one report ahead.
+ * @param dx, dy motion since the previous report, replaced by what to send
+ * @param lead_us how long until the host sees this report, 0 = no prediction
+ */
+void predict_apply(predict_t *pr, int32_t *dx, int32_t *dy, uint32_t now_us, uint32_t lead_us);
+
+/**
+ * @brief The cursor is ahead of the sensor and a report without motion must follow.
+ */
+static inline bool predict_pending(const predict_t *pr)
+{
+    return pr->lead_x != 0 || pr->lead_y != 0;
+}
+
+#endif
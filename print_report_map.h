@@ -0,0 +1,14 @@
+#ifndef PRINT_REPORT_MAP_H
+#define PRINT_REPORT_MAP_H
+
+#include <stdbool.h>
+#include "esp_hidd.h"
+
+/**
+ * @brief Parse a report map, log its reports and fields (debug level) and
+ *        any descriptor error.
+ * @return true if the descriptor is valid
+ */
+bool print_report_map_info(const esp_hid_raw_report_map_t *rm);
+
+#endif
@@ -0,0 +1,191 @@
+#include <string.h>
+
+#include "rate_ctl.h"
+
+#define BLE_ITVL_MIN 6     // 7.5 ms, the shortest BLE connection interval
+#define IDLE_ITVL 24       // 30 ms
+#define IDLE_LATENCY 4     // wake every 150 ms when there is nothing to send
+#define CONN_TIMEOUT 400   // 4 s
+#define CONN_GAP_US 500000 // before a request for a lower tier
+
+void rate_default_params(rate_params_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->min_hz = 100;
+    p->max_hz = 150;
+    p->slow_speed = 2;
+    p->fast_speed = 20;
+    p->boost_ms = 250;
+    p->idle_ms = 1000;
+    p->hold_ms = 2000;
+}
+
+void rate_ctl_init(rate_ctl_t *r, const rate_params_t *p, uint32_t now_us)
+{
+    memset(r, 0, sizeof(*r));
+    r->p = *p;
+    if (r->p.max_hz < r->p.min_hz)
+    {
+        r->p.max_hz = r->p.min_hz;
+    }
+    if (r->p.fast_speed <= r->p.slow_speed)
+    {
+        r->p.fast_speed = r->p.slow_speed + 1;
+    }
+    r->hz = r->p.min_hz;
+    r->last_us = now_us;
+    r->input_us = now_us;
+    r->tier_since_us = now_us;
+    r->tier = RATE_TIER_IDLE;
+}
+
+static void set_tier(rate_ctl_t *r, uint8_t tier, uint32_t now_us)
+{
+    if (tier != r->tier)
+    {
+        r->tier = tier;
+        r->tier_since_us = now_us;
+    }
+}
+
+uint32_t rate_ctl_update(rate_ctl_t *r, int32_t dx, int32_t dy, bool event, uint32_t now_us)
+{
+    uint32_t dt = now_us - r->last_us;
+    uint32_t ax = dx < 0 ? -dx : dx;
+    uint32_t ay = dy < 0 ? -dy : dy;
+    // octagonal distance, within 8% of the Euclidean one
+    uint32_t dist = ax > ay ? ax + ay / 2 : ay + ax / 2;
+
+    r->last_us = now_us;
+    if (dt < 1000)
+    {
+        dt = 1000;
+    }
+    if (dt > 100000)
+    {
+        dt = 100000; // a report after a pause: do not read it as slow motion
+    }
+
+    // rise within a report or two, decay over about eight
+    uint32_t inst = (uint32_t)(((uint64_t)dist * 16000) / dt);
+    if (inst > r->speed_q4)
+    {
+        r->speed_q4 += (inst - r->speed_q4 + 1) / 2;
+    }
+    else
+    {
+        r->speed_q4 -= (r->speed_q4 - inst) / 8;
+    }
+
+    if (dist || event)
+    {
+        r->input_us = now_us;
+    }
+    if (event)
+    {
+        r->boost_until_us = now_us + r->p.boost_ms * 1000u;
+    }
+
+    uint32_t slow = r->p.slow_speed * 16u;
+    uint32_t fast = r->p.fast_speed * 16u;
+    uint32_t span = r->p.max_hz - r->p.min_hz;
+    bool boost = (int32_t)(r->boost_until_us - now_us) > 0;
+
+    if (boost || r->speed_q4 >= fast)
+    {
+        r->hz = r->p.max_hz;
+    }
+    else if (r->speed_q4 <= slow)
+    {
+        r->hz = r->p.min_hz;
+    }
+    else
+    {
+        r->hz = r->p.min_hz + span * (r->speed_q4 - slow) / (fast - slow);
+    }
+
+    if (now_us - r->input_us >= r->p.idle_ms * 1000u)
+    {
+        set_tier(r, RATE_TIER_IDLE, now_us);
+    }
+    else
+    {
+        // fast once past the middle of the range, so the link follows early
+        set_tier(r, boost || r->hz * 2 >= r->p.min_hz + r->p.max_hz ? RATE_TIER_FAST : RATE_TIER_TRACK, now_us);
+    }
+
+    uint32_t interval = (1000000 + r->hz / 2) / r->hz;
+    // the radio drains one notification per connection event, faster reports only queue
+    return interval < r->link_us ? r->link_us : interval;
+}
+
+void rate_ctl_poll(rate_ctl_t *r, uint32_t now_us)
+{
+    if (now_us - r->input_us >= r->p.idle_ms * 1000u)
+    {
+        r->speed_q4 = 0;
+        r->hz = r->p.min_hz;
+        set_tier(r, RATE_TIER_IDLE, now_us);
+    }
+}
+
+static uint16_t itvl_units(uint32_t hz)
+{
+    uint32_t units = 800 / hz; // 1.25 ms units per report
+
+    return units < BLE_ITVL_MIN ? BLE_ITVL_MIN : (uint16_t)units;
+}
+
+void rate_ctl_conn_params(const rate_ctl_t *r, rate_tier_t tier, rate_conn_t *out)
+{
+    out->timeout = CONN_TIMEOUT;
+    out->latency = 0;
+
+    switch (tier)
+    {
+    case RATE_TIER_FAST:
+        out->itvl_min = BLE_ITVL_MIN;
+        out->itvl_max = itvl_units(r->p.max_hz);
+        break;
+    case RATE_TIER_TRACK:
+        out->itvl_min = itvl_units(r->p.max_hz);
+        out->itvl_max = itvl_units(r->p.min_hz);
+        break;
+    default:
+        out->itvl_min = IDLE_ITVL;
+        out->itvl_max = IDLE_ITVL;
+        out->latency = IDLE_LATENCY;
+        break;
+    }
+}
+
+bool rate_ctl_conn_due(rate_ctl_t *r, uint32_t now_us, rate_conn_t *out)
+{
+    if (r->conn_sent && r->tier == r->conn_tier)
+    {
+        return false;
+    }
+    // more demand is served at once, less only once it has lasted and not too soon after the last request;
+    // idle already means idle_ms without input
+    bool settled = r->tier == RATE_TIER_IDLE || now_us - r->tier_since_us >= r->p.hold_ms * 1000u;
+    if (r->conn_sent && r->tier < r->conn_tier && (!settled || now_us - r->conn_at_us < CONN_GAP_US))
+    {
+        return false;
+    }
+
+    rate_ctl_conn_params(r, (rate_tier_t)r->tier, out);
+    r->conn_tier = r->tier;
+    r->conn_at_us = now_us;
+    r->conn_sent = true;
+    return true;
+}
+
+void rate_ctl_conn_reset(rate_ctl_t *r)
+{
+    r->conn_sent = false;
+}
+
+void rate_ctl_set_link(rate_ctl_t *r, uint16_t itvl)
+{
+    r->link_us = itvl * 1250u;
+}
@@ -0,0 +1,109 @@
+#ifndef RATE_CTL_H
+#define RATE_CTL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Adaptive report rate. No IDF dependency.
+ *
+ * The report task feeds what each report carried; the controller answers
+ * with the interval until the next one. Pointer speed maps linearly from
+ * min_hz at slow_speed to max_hz at fast_speed, a button or wheel change
+ * holds max_hz for boost_ms, and without input for idle_ms the controller
+ * drops to the idle tier. Reports never go out faster than the connection
+ * interval in use, the radio sends one per event and the rest only queue.
+ *
+ * The tier also picks the BLE connection parameters, so the radio only runs
+ * fast while the reports do: rate_ctl_conn_due() hands out a parameter
+ * update when the tier changed, right away when demand goes up and only
+ * after hold_ms when it goes down.
+ *
+ * Units: speed in counts per millisecond, Q4 internally as in accel.h.
+ */
+
+// configurable report rate, Hz
+#define MOUSE_REPORT_RATE_DEFAULT 150
+#define MOUSE_REPORT_RATE_MIN 100
+#define MOUSE_REPORT_RATE_MAX 150
+
+typedef enum
+{
+    RATE_TIER_IDLE = 0,
+    RATE_TIER_TRACK, // slow, precise motion
+    RATE_TIER_FAST,  // fast motion or clicks
+} rate_tier_t;
+
+typedef struct
+{
+    uint16_t min_hz;
+    uint16_t max_hz;
+    uint16_t slow_speed; // counts/ms at or below which min_hz is used
+    uint16_t fast_speed; // counts/ms at or above which max_hz is used
+    uint16_t boost_ms;   // max_hz after a button or wheel change
+    uint16_t idle_ms;    // no input this long: idle tier
+    uint16_t hold_ms;    // a lower tier must last this long before the link follows
+} rate_params_t;
+
+/* BLE connection parameters in controller units */
+typedef struct
+{
+    uint16_t itvl_min; // 1.25 ms
+    uint16_t itvl_max; // 1.25 ms
+    uint16_t latency;  // connection events the peripheral may skip
+    uint16_t timeout;  // 10 ms
+} rate_conn_t;
+
+typedef struct
+{
+    rate_params_t p;
+    uint32_t speed_q4;
+    uint32_t hz;
+    uint32_t last_us;
+    uint32_t input_us;       // last report with content
+    uint32_t boost_until_us;
+    uint32_t tier_since_us;
+    uint32_t conn_at_us;
+    uint32_t link_us;        // connection interval in use, 0 if unknown
+    uint8_t tier;            // rate_tier_t
+    uint8_t conn_tier;       // tier of the last parameter request
+    bool conn_sent;
+} rate_ctl_t;
+
+void rate_default_params(rate_params_t *p);
+
+void rate_ctl_init(rate_ctl_t *r, const rate_params_t *p, uint32_t now_us);
+
+/**
+ * @brief Account one report.
+ * @param event a button or wheel change went out with it
+ * @return microseconds until the next report
+ */
+uint32_t rate_ctl_update(rate_ctl_t *r, int32_t dx, int32_t dy, bool event, uint32_t now_us);
+
+/**
+ * @brief Call when no report was due for a while; moves to the idle tier after idle_ms.
+ */
+void rate_ctl_poll(rate_ctl_t *r, uint32_t now_us);
+
+/**
+ * @brief Connection parameters to request now, if any.
+ */
+bool rate_ctl_conn_due(rate_ctl_t *r, uint32_t now_us, rate_conn_t *out);
+
+/**
+ * @brief Forget the last request, e.g. after a reconnect.
+ */
+void rate_ctl_conn_reset(rate_ctl_t *r);
+
+/**
+ * @brief The connection interval the central granted, 1.25 ms units; 0 if unknown.
+ */
+void rate_ctl_set_link(rate_ctl_t *r, uint16_t itvl);
+
+/**
+ * @brief Connection parameters for a tier.
+ */
+void rate_ctl_conn_params(const rate_ctl_t *r, rate_tier_t tier, rate_conn_t *out);
+
+#endif
@@ -0,0 +1,91 @@
+#include "sched_plan.h"
+
+void sched_plan_assign(sched_task_t *tasks, size_t n, uint8_t base_priority)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        if (tasks[i].fixed)
+        {
+            continue;
+        }
+
+        // rank among non-fixed tasks by deadline, ties keep table order
+        uint8_t longer = 0;
+        for (size_t j = 0; j < n; j++)
+        {
+            if (j == i || tasks[j].fixed)
+            {
+                continue;
+            }
+            if (tasks[j].deadline_us > tasks[i].deadline_us ||
+                (tasks[j].deadline_us == tasks[i].deadline_us && j > i))
+            {
+                longer++;
+            }
+        }
+        tasks[i].priority = base_priority + longer;
+    }
+}
+
+static bool interferes(const sched_task_t *hp, const sched_task_t *t)
+{
+    // same core, or unpinned tasks which may run anywhere
+    bool shares_core = hp->core == t->core || hp->core < 0 || t->core < 0;
+
+    return hp != t && shares_core && hp->priority >= t->priority && hp->period_us;
+}
+
+bool sched_plan_analyse(sched_task_t *tasks, size_t n)
+{
+    bool all_ok = true;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        sched_task_t *t = &tasks[i];
+        uint64_t r = t->wcet_us;
+        uint64_t prev = 0;
+
+        // iterate to the fixed point, give up past the deadline
+        while (r != prev && r <= t->deadline_us)
+        {
+            prev = r;
+            r = t->wcet_us;
+            for (size_t j = 0; j < n; j++)
+            {
+                const sched_task_t *hp = &tasks[j];
+                if (interferes(hp, t))
+                {
+                    r += ((prev + hp->period_us - 1) / hp->period_us) * hp->wcet_us;
+                }
+            }
+        }
+
+        t->ok = r <= t->deadline_us;
+        t->response_us = t->ok ? (uint32_t)r : UINT32_MAX;
+        all_ok &= t->ok;
+    }
+
+    return all_ok;
+}
+
+uint32_t sched_plan_load(const sched_task_t *tasks, size_t n, int core)
+{
+    uint64_t permille = 0;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        if (tasks[i].core == core && tasks[i].period_us)
+        {
+            permille += (uint64_t)tasks[i].wcet_us * 1000 / tasks[i].period_us;
+        }
+    }
+
+    return (uint32_t)((permille + 5) / 10);
+}
+
+uint32_t sched_stack_size(uint32_t used_bytes, uint8_t margin_pct)
+{
+    uint32_t size = used_bytes + used_bytes * margin_pct / 100;
+
+    return (size + 255) & ~255u;
+}
@@ -0,0 +1,78 @@
+#ifndef SCHED_PLAN_H
+#define SCHED_PLAN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Task placement and priorities from a latency budget. No IDF dependency,
+ * so a plan can be checked on the host before it is tried on the board.
+ *
+ * Each task has a period (or minimum inter-arrival time), a worst-case
+ * execution time and a deadline, the latency budget from wake-up to done.
+ * sched_plan_assign() gives the tasks that are not fixed (ours, not the BLE
+ * host) deadline-monotonic priorities: shorter budget, higher priority.
+ * sched_plan_analyse() runs fixed-priority response time analysis per core,
+ *   R = C + sum over higher priority tasks j on the core of ceil(R / T_j) * C_j
+ * and reports whether every task meets its budget.
+ */
+
+#define SCHED_ANY_CORE (-1) // not pinned, may run on (and interfere with) any core
+
+typedef struct
+{
+    const char *name;
+    int core;             // core id or SCHED_ANY_CORE
+    bool fixed;           // priority set by someone else (e.g. the NimBLE host)
+    uint8_t priority;     // output of sched_plan_assign() unless fixed
+    uint32_t period_us;
+    uint32_t wcet_us;
+    uint32_t deadline_us; // latency budget
+    uint32_t stack;       // bytes
+    // results of sched_plan_analyse()
+    uint32_t response_us; // UINT32_MAX = unbounded
+    bool ok;
+} sched_task_t;
+
+typedef struct
+{
+    uint32_t max_us;
+    uint32_t last_us;
+    uint64_t sum_us;
+    uint32_t count;
+} sched_latency_t;
+
+/**
+ * @brief Deadline-monotonic priorities base.. for the non-fixed tasks.
+ */
+void sched_plan_assign(sched_task_t *tasks, size_t n, uint8_t base_priority);
+
+/**
+ * @brief Response time analysis, fills response_us / ok.
+ * @return true if every task meets its deadline
+ */
+bool sched_plan_analyse(sched_task_t *tasks, size_t n);
+
+/**
+ * @brief Utilisation of one core, percent.
+ */
+uint32_t sched_plan_load(const sched_task_t *tasks, size_t n, int core);
+
+/**
+ * @brief Stack size for a measured peak use plus margin_pct, rounded up to 256 bytes.
+ */
+uint32_t sched_stack_size(uint32_t used_bytes, uint8_t margin_pct);
+
+static inline void sched_latency_record(sched_latency_t *l, uint32_t us)
+{
+    l->last_us = us;
+    if (us > l->max_us)
+    {
+        l->max_us = us;
+    }
+    l->sum_us += us;
+    l->count++;
+}
+
+#endif
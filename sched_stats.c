@@ -0,0 +1,120 @@
+#include <stdlib.h>
+
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#include "sched_stats.h"
+
+#ifndef CONFIG_SCHED_STATS_PERIOD_MS
+#define CONFIG_SCHED_STATS_PERIOD_MS 0 /* 0 = no periodic dump */
+#endif
+#ifndef CONFIG_SCHED_STACK_MARGIN
+#define CONFIG_SCHED_STACK_MARGIN 25 /* percent over the measured peak */
+#endif
+
+static const char *TAG = "sched";
+
+static const sched_task_t *stats_plan;
+static const sched_latency_t *stats_lat;
+static size_t stats_n;
+
+esp_err_t sched_task_create(TaskFunction_t fn, const sched_task_t *t, void *arg, TaskHandle_t *handle)
+{
+    BaseType_t core = tskNO_AFFINITY;
+
+#if portNUM_PROCESSORS > 1
+    if (t->core >= 0 && t->core < portNUM_PROCESSORS)
+    {
+        core = t->core;
+    }
+#endif
+
+    if (xTaskCreatePinnedToCore(fn, t->name, t->stack, arg, t->priority, handle, core) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+#if configGENERATE_RUN_TIME_STATS
+// CPU share since boot, percent of one core
+static void log_cpu(void)
+{
+    UBaseType_t count = uxTaskGetNumberOfTasks();
+    TaskStatus_t *st = malloc(count * sizeof(*st));
+    uint32_t total = 0;
+
+    if (st == NULL)
+    {
+        return;
+    }
+    count = uxTaskGetSystemState(st, count, &total);
+    total /= 100;
+
+    for (UBaseType_t i = 0; total && i < count; i++)
+    {
+        ESP_LOGI(TAG, "cpu %-16s %3lu%% (core %d)", st[i].pcTaskName, (unsigned long)(st[i].ulRunTimeCounter / total),
+                 st[i].xCoreID == tskNO_AFFINITY ? -1 : (int)st[i].xCoreID);
+    }
+    free(st);
+}
+#endif
+
+void sched_stats_dump(const sched_task_t *plan, const sched_latency_t *lat, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        const sched_task_t *t = &plan[i];
+        TaskHandle_t h = xTaskGetHandle(t->name);
+
+        // the IDF reports the high-water mark in bytes
+        uint32_t free_bytes = h ? uxTaskGetStackHighWaterMark(h) : 0;
+        uint32_t used = t->stack > free_bytes ? t->stack - free_bytes : 0;
+
+        ESP_LOGI(TAG, "%-16s core %2d prio %2u stack %lu/%lu (suggest %lu)", t->name, t->core, t->priority,
+                 (unsigned long)used, (unsigned long)t->stack,
+                 h ? (unsigned long)sched_stack_size(used, CONFIG_SCHED_STACK_MARGIN) : 0ul);
+
+        if (lat && lat[i].count)
+        {
+            const sched_latency_t *l = &lat[i];
+            ESP_LOGI(TAG, "%-16s latency avg %lu max %lu us, budget %lu us%s", t->name,
+                     (unsigned long)(l->sum_us / l->count), (unsigned long)l->max_us, (unsigned long)t->deadline_us,
+                     l->max_us > t->deadline_us ? " MISSED" : "");
+        }
+    }
+
+#if configGENERATE_RUN_TIME_STATS
+    log_cpu();
+#endif
+}
+
+static void sched_stats_task(void *pv)
+{
+    (void)pv;
+    for (;;)
+    {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_SCHED_STATS_PERIOD_MS));
+        sched_stats_dump(stats_plan, stats_lat, stats_n);
+    }
+}
+
+esp_err_t wake_sched_stats(const sched_task_t *plan, const sched_latency_t *lat, size_t n)
+{
+    if (CONFIG_SCHED_STATS_PERIOD_MS == 0)
+    {
+        return ESP_OK;
+    }
+
+    stats_plan = plan;
+    stats_lat = lat;
+    stats_n = n;
+
+    if (xTaskCreate(sched_stats_task, "sched_stats", 3072, NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
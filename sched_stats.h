@@ -0,0 +1,33 @@
+#ifndef SCHED_STATS_H
+#define SCHED_STATS_H
+
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "sched_plan.h"
+
+/*
+ * Runs a sched_plan_t on the board and reports how it holds up: per task
+ * stack high-water mark (with the stack size it suggests), CPU share and
+ * wake-up latency against the task's budget.
+ */
+
+/**
+ * @brief Create a task with the core, priority and stack of its plan entry.
+ */
+esp_err_t sched_task_create(TaskFunction_t fn, const sched_task_t *t, void *arg, TaskHandle_t *handle);
+
+/**
+ * @brief Log the plan next to what was measured. lat may be NULL.
+ */
+void sched_stats_dump(const sched_task_t *plan, const sched_latency_t *lat, size_t n);
+
+/**
+ * @brief Dump every CONFIG_SCHED_STATS_PERIOD_MS from an idle priority task,
+ *        does nothing when the period is 0. The tables must stay valid.
+ */
+esp_err_t wake_sched_stats(const sched_task_t *plan, const sched_latency_t *lat, size_t n);
+
+#endif
@@ -0,0 +1,65 @@
+#include <string.h>
+
+#include "sensor_health.h"
+
+void sensor_health_init(sensor_health_t *h, uint8_t strikes_max)
+{
+    memset(h, 0, sizeof(*h));
+    h->strikes_max = strikes_max;
+}
+
+static bool burst_stuck(const uint8_t *burst, size_t len)
+{
+    uint8_t all_or = 0;
+    uint8_t all_and = 0xFF;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        all_or |= burst[i];
+        all_and &= burst[i];
+    }
+
+    return all_or == 0x00 || all_and == 0xFF;
+}
+
+sensor_fault_t sensor_health_classify(uint8_t product_id, uint8_t inv_product_id,
+                                      const uint8_t *burst, size_t burst_len, bool spi_error)
+{
+    if (spi_error)
+    {
+        return SENSOR_FAULT_SPI;
+    }
+    if (product_id != PAW3395_PRODUCT_ID || inv_product_id != PAW3395_INV_PRODUCT_ID)
+    {
+        return SENSOR_FAULT_ID;
+    }
+    if (burst && burst_len && burst_stuck(burst, burst_len))
+    {
+        return SENSOR_FAULT_STUCK;
+    }
+
+    return SENSOR_FAULT_NONE;
+}
+
+bool sensor_health_report(sensor_health_t *h, sensor_fault_t fault)
+{
+    h->checks++;
+
+    if (fault == SENSOR_FAULT_NONE)
+    {
+        h->strikes = 0;
+        return false;
+    }
+
+    h->faults++;
+    h->last_fault = fault;
+
+    if (++h->strikes <= h->strikes_max)
+    {
+        return false;
+    }
+
+    h->strikes = 0;
+    h->reinits++;
+    return true;
+}
@@ -0,0 +1,55 @@
+#ifndef SENSOR_HEALTH_H
+#define SENSOR_HEALTH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * PAW3395 health checks. No IDF dependency.
+ *
+ * A check is run while the sensor is idle, never on the burst path: it reads
+ * PRODUCT_ID and INVERSE_PRODUCT_ID and looks at the last motion burst. A
+ * browned-out sensor or a floating MISO line reads back all 0x00 or all 0xFF,
+ * which no live sensor produces (Observation and shutter are never both zero).
+ * Consecutive failed checks beyond strikes_max ask for a re-init.
+ */
+
+#define PAW3395_PRODUCT_ID_REG 0x00
+#define PAW3395_INV_PRODUCT_ID_REG 0x5F
+#define PAW3395_PRODUCT_ID 0x51
+#define PAW3395_INV_PRODUCT_ID 0xAE
+
+typedef enum
+{
+    SENSOR_FAULT_NONE = 0,
+    SENSOR_FAULT_ID,    // product ID or its inverse wrong
+    SENSOR_FAULT_STUCK, // burst stuck at 0x00 or 0xFF
+    SENSOR_FAULT_SPI,   // SPI driver reported errors
+} sensor_fault_t;
+
+typedef struct
+{
+    uint8_t strikes_max; // consecutive failed checks tolerated
+    uint8_t strikes;
+    uint8_t last_fault; // sensor_fault_t
+    uint32_t checks;
+    uint32_t faults;
+    uint32_t reinits;
+} sensor_health_t;
+
+void sensor_health_init(sensor_health_t *h, uint8_t strikes_max);
+
+/**
+ * @brief Judge one check. burst may be NULL if no burst was read since the last check.
+ */
+sensor_fault_t sensor_health_classify(uint8_t product_id, uint8_t inv_product_id,
+                                      const uint8_t *burst, size_t burst_len, bool spi_error);
+
+/**
+ * @brief Record the result of a check.
+ * @return true if the sensor should be re-initialised now
+ */
+bool sensor_health_report(sensor_health_t *h, sensor_fault_t fault);
+
+#endif
@@ -0,0 +1,278 @@
+#include <string.h>
+
+#include "settings.h"
+
+static settings_backend_t backend;
+static settings_t ram;
+static uint32_t quiet;
+
+static bool dirty;          // RAM differs from flash
+static bool touched;        // a setter ran since the last poll
+static uint32_t last_touch; // poll time at which touched was seen
+
+static inline void lock(void)
+{
+    if (backend.lock)
+    {
+        backend.lock(backend.ctx);
+    }
+}
+
+static inline void unlock(void)
+{
+    if (backend.unlock)
+    {
+        backend.unlock(backend.ctx);
+    }
+}
+
+uint32_t settings_crc32(const uint8_t *data, size_t len)
+{
+    // bitwise CRC-32 (IEEE), only runs on load and commit so no table is kept
+    uint32_t crc = 0xFFFFFFFFu;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+
+    return ~crc;
+}
+
+void settings_defaults(settings_t *s)
+{
+    memset(s, 0, sizeof(*s));
+    s->dpi = 1600;
+    accel_default_params(&s->accel);
+    motion_xform_default_params(&s->xform);
+    cpi_stages_default(&s->cpi);
+    surface_default_params(&s->surface);
+    motion_filter_default_params(&s->filter);
+}
+
+size_t settings_encode(const settings_t *s, uint8_t *buf, size_t cap)
+{
+    if (cap < SETTINGS_BLOB_MAX)
+    {
+        return 0;
+    }
+
+    settings_header_t hdr = {
+        .magic = SETTINGS_MAGIC,
+        .version = SETTINGS_VERSION,
+        .length = sizeof(settings_t),
+        .crc = settings_crc32((const uint8_t *)s, sizeof(settings_t)),
+    };
+
+    memcpy(buf, &hdr, sizeof(hdr));
+    memcpy(buf + sizeof(hdr), s, sizeof(settings_t));
+
+    return SETTINGS_BLOB_MAX;
+}
+
+int settings_decode(const uint8_t *buf, size_t len, settings_t *s)
+{
+    settings_header_t hdr;
+
+    settings_defaults(s);
+
+    if (len < sizeof(hdr))
+    {
+        return SETTINGS_ERR_CORRUPT;
+    }
+    memcpy(&hdr, buf, sizeof(hdr));
+
+    if (hdr.magic != SETTINGS_MAGIC || hdr.version == 0 || hdr.version > SETTINGS_VERSION)
+    {
+        return SETTINGS_ERR_CORRUPT;
+    }
+    if (len < sizeof(hdr) + hdr.length)
+    {
+        return SETTINGS_ERR_CORRUPT;
+    }
+
+    const uint8_t *payload = buf + sizeof(hdr);
+    if (settings_crc32(payload, hdr.length) != hdr.crc)
+    {
+        return SETTINGS_ERR_CORRUPT;
+    }
+
+    // older layouts are a prefix of the current one
+    size_t n = hdr.length < sizeof(settings_t) ? hdr.length : sizeof(settings_t);
+    memcpy(s, payload, n);
+
+    if (hdr.version < 5)
+    {
+        // single DPI from before the stage table becomes the current stage
+        s->cpi.stage[s->cpi.current].x = s->dpi;
+        s->cpi.stage[s->cpi.current].y = s->dpi;
+    }
+    cpi_stages_sanitize(&s->cpi);
+
+    // a slot that does not validate is dropped, the player trusts stored programs
+    for (int i = 0; i < MACRO_SLOTS; i++)
+    {
+        macro_slot_t *m = &s->macros[i];
+        if (m->len > MACRO_CODE_MAX || (m->len && !macro_validate(m->code, m->len)))
+        {
+            memset(m, 0, sizeof(*m));
+        }
+    }
+
+    return SETTINGS_OK;
+}
+
+int settings_init(const settings_backend_t *be, uint32_t quiet_ms)
+{
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    size_t len = sizeof(blob);
+    int ret;
+
+    backend = *be;
+    quiet = quiet_ms;
+    dirty = false;
+    touched = false;
+
+    ret = backend.read(backend.ctx, blob, &len);
+    if (ret == SETTINGS_OK)
+    {
+        ret = settings_decode(blob, len, &ram);
+    }
+    else
+    {
+        settings_defaults(&ram);
+    }
+
+    return ret;
+}
+
+settings_t settings_get(void)
+{
+    lock();
+    settings_t s = ram;
+    unlock();
+
+    return s;
+}
+
+static void update(void *field, const void *value, size_t len)
+{
+    lock();
+    if (memcmp(field, value, len) != 0)
+    {
+        memcpy(field, value, len);
+        dirty = true;
+        touched = true;
+    }
+    unlock();
+}
+
+void settings_set_cpi(const cpi_stages_t *cpi)
+{
+    update(&ram.cpi, cpi, sizeof(*cpi));
+}
+
+void settings_set_report_rate(uint16_t hz)
+{
+    update(&ram.report_rate_hz, &hz, sizeof(hz));
+}
+
+void settings_set_debounce(uint16_t click_us, uint16_t scroll_us)
+{
+    update(&ram.click_debounce_us, &click_us, sizeof(click_us));
+    update(&ram.scroll_debounce_us, &scroll_us, sizeof(scroll_us));
+}
+
+void settings_set_sensor_mode(uint8_t mode)
+{
+    update(&ram.sensor_mode, &mode, sizeof(mode));
+}
+
+void settings_set_accel(const accel_params_t *accel)
+{
+    update(&ram.accel, accel, sizeof(*accel));
+}
+
+void settings_set_xform(const motion_xform_params_t *xform)
+{
+    update(&ram.xform, xform, sizeof(*xform));
+}
+
+void settings_set_surface(const surface_params_t *surface)
+{
+    update(&ram.surface, surface, sizeof(*surface));
+}
+
+void settings_set_spi_clock(uint32_t hz)
+{
+    update(&ram.spi_clock_hz, &hz, sizeof(hz));
+}
+
+void settings_set_filter(const motion_filter_params_t *filter)
+{
+    update(&ram.filter, filter, sizeof(*filter));
+}
+
+void settings_set_macro(uint8_t index, const macro_slot_t *macro)
+{
+    if (index < MACRO_SLOTS)
+    {
+        update(&ram.macros[index], macro, sizeof(*macro));
+    }
+}
+
+bool settings_dirty(void)
+{
+    return dirty;
+}
+
+int settings_flush(void)
+{
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    size_t len;
+
+    lock();
+    if (!dirty)
+    {
+        unlock();
+        return SETTINGS_OK;
+    }
+    len = settings_encode(&ram, blob, sizeof(blob));
+    dirty = false;
+    touched = false;
+    unlock();
+
+    int ret = backend.write(backend.ctx, blob, len);
+    if (ret != SETTINGS_OK)
+    {
+        // keep it pending, the next poll retries
+        lock();
+        dirty = true;
+        unlock();
+    }
+
+    return ret;
+}
+
+bool settings_poll(uint32_t now_ms)
+{
+    lock();
+    if (touched)
+    {
+        touched = false;
+        last_touch = now_ms;
+    }
+    bool due = dirty && (uint32_t)(now_ms - last_touch) >= quiet;
+    unlock();
+
+    if (due)
+    {
+        settings_flush();
+    }
+
+    return due;
+}
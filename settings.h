@@ -0,0 +1,151 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "accel.h"
+#include "motion_xform.h"
+#include "cpi.h"
+#include "surface.h"
+#include "motion_filter.h"
+#include "macro.h"
+
+/*
+ * RAM settings store with deferred, coalesced commits.
+ *
+ * Setters only touch the RAM copy and mark it dirty. settings_poll() writes one
+ * blob through the backend once no setter has run for quiet_ms, and
+ * settings_flush() forces it (before sleep). Nothing here blocks the input path.
+ *
+ * Blob layout (little endian):
+ *   settings_header_t | settings_t payload (header.length bytes)
+ * Fields are only ever appended to settings_t. An older, shorter payload is
+ * loaded as a prefix and the new fields keep their defaults.
+ */
+
+#define SETTINGS_MAGIC 0x5445534Du // "MSET"
+#define SETTINGS_VERSION 9
+
+#define SETTINGS_OK 0
+#define SETTINGS_ERR_NOT_FOUND -1
+#define SETTINGS_ERR_IO -2
+#define SETTINGS_ERR_CORRUPT -3
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length; // payload bytes following the header
+    uint32_t crc;    // crc32 of the payload
+} settings_header_t;
+
+/*
+ * 0 in a rate/debounce field means "use the firmware default".
+ * Not packed so members can be passed by pointer; explicit reserved bytes keep
+ * every field naturally aligned and the layout free of compiler padding.
+ */
+typedef struct
+{
+    uint16_t dpi; // version 1 only, superseded by cpi and migrated on load
+    // version 2
+    uint16_t report_rate_hz;
+    uint16_t click_debounce_us;
+    uint16_t scroll_debounce_us;
+    uint8_t sensor_mode;
+    uint8_t reserved0;
+    // version 3
+    accel_params_t accel;
+    // version 4
+    motion_xform_params_t xform;
+    // version 5
+    cpi_stages_t cpi;
+    // version 6
+    surface_params_t surface;
+    // version 7
+    uint16_t reserved1;
+    uint32_t spi_clock_hz; // calibrated sensor SPI clock, 0 = calibrate at boot
+    // version 8
+    motion_filter_params_t filter;
+    // version 9
+    macro_slot_t macros[MACRO_SLOTS];
+} settings_t;
+
+_Static_assert(sizeof(settings_t) == 10 + sizeof(accel_params_t) + sizeof(motion_xform_params_t) +
+                                         sizeof(cpi_stages_t) + sizeof(surface_params_t) + 6 +
+                                         sizeof(motion_filter_params_t) + MACRO_SLOTS * sizeof(macro_slot_t),
+               "settings_t has padding");
+
+#define SETTINGS_BLOB_MAX (sizeof(settings_header_t) + sizeof(settings_t))
+
+typedef struct
+{
+    // read at most *len bytes into buf, set *len to the stored size
+    int (*read)(void *ctx, uint8_t *buf, size_t *len);
+    int (*write)(void *ctx, const uint8_t *buf, size_t len);
+    // optional, guard the RAM copy against concurrent setters
+    void (*lock)(void *ctx);
+    void (*unlock)(void *ctx);
+    void *ctx;
+} settings_backend_t;
+
+void settings_defaults(settings_t *s);
+
+/**
+ * @brief Serialize s into buf, return the blob size.
+ */
+size_t settings_encode(const settings_t *s, uint8_t *buf, size_t cap);
+
+/**
+ * @brief Parse a blob into s. s is left at defaults for any field the blob does not carry.
+ */
+int settings_decode(const uint8_t *buf, size_t len, settings_t *s);
+
+/**
+ * @brief Bind the backend and load the stored blob, falling back to defaults.
+ * @return SETTINGS_OK or the reason defaults were used
+ */
+int settings_init(const settings_backend_t *backend, uint32_t quiet_ms);
+
+/**
+ * @brief Copy of the current RAM settings.
+ */
+settings_t settings_get(void);
+
+void settings_set_cpi(const cpi_stages_t *cpi);
+
+void settings_set_report_rate(uint16_t hz);
+
+void settings_set_debounce(uint16_t click_us, uint16_t scroll_us);
+
+void settings_set_sensor_mode(uint8_t mode);
+
+void settings_set_accel(const accel_params_t *accel);
+
+void settings_set_xform(const motion_xform_params_t *xform);
+
+void settings_set_surface(const surface_params_t *surface);
+
+void settings_set_spi_clock(uint32_t hz);
+
+void settings_set_filter(const motion_filter_params_t *filter);
+
+void settings_set_macro(uint8_t index, const macro_slot_t *macro);
+
+bool settings_dirty(void);
+
+/**
+ * @brief Call periodically from a low priority task; commits after the quiet period.
+ * @return true if a commit was attempted
+ */
+bool settings_poll(uint32_t now_ms);
+
+/**
+ * @brief Commit now if dirty.
+ */
+int settings_flush(void);
+
+uint32_t settings_crc32(const uint8_t *data, size_t len);
+
+#endif
@@ -0,0 +1,72 @@
+#include <string.h>
+
+#include "settings_flash_fake.h"
+
+static int fake_read(void *ctx, uint8_t *buf, size_t *len)
+{
+    settings_flash_fake_t *flash = ctx;
+    settings_header_t hdr;
+
+    flash->read_count++;
+
+    memcpy(&hdr, flash->sector, sizeof(hdr));
+    if (hdr.magic == 0xFFFFFFFFu)
+    {
+        return SETTINGS_ERR_NOT_FOUND; // erased
+    }
+
+    size_t stored = sizeof(hdr) + hdr.length;
+    if (stored > SETTINGS_FLASH_FAKE_SECTOR)
+    {
+        stored = SETTINGS_FLASH_FAKE_SECTOR;
+    }
+
+    memcpy(buf, flash->sector, stored < *len ? stored : *len);
+    *len = stored;
+
+    return SETTINGS_OK;
+}
+
+static int fake_write(void *ctx, const uint8_t *buf, size_t len)
+{
+    settings_flash_fake_t *flash = ctx;
+
+    if (len > SETTINGS_FLASH_FAKE_SECTOR)
+    {
+        return SETTINGS_ERR_IO;
+    }
+    if (flash->fail_writes > 0)
+    {
+        flash->fail_writes--;
+        return SETTINGS_ERR_IO;
+    }
+
+    memset(flash->sector, 0xFF, sizeof(flash->sector));
+    flash->erase_count++;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        flash->sector[i] &= buf[i];
+    }
+    flash->write_count++;
+    flash->bytes_written += len;
+
+    return SETTINGS_OK;
+}
+
+void settings_flash_fake_init(settings_flash_fake_t *flash)
+{
+    memset(flash, 0, sizeof(*flash));
+    memset(flash->sector, 0xFF, sizeof(flash->sector));
+}
+
+settings_backend_t settings_flash_fake_backend(settings_flash_fake_t *flash)
+{
+    settings_backend_t be = {
+        .read = fake_read,
+        .write = fake_write,
+        .ctx = flash,
+    };
+
+    return be;
+}
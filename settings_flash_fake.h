@@ -0,0 +1,33 @@
+#ifndef SETTINGS_FLASH_FAKE_H
+#define SETTINGS_FLASH_FAKE_H
+
+#include <stdint.h>
+
+#include "settings.h"
+
+/*
+ * Host-side settings backend modelling one NOR flash sector: a write erases the
+ * sector to 0xFF and then programs it, and programming can only clear bits.
+ * The counters are what wear tests look at.
+ */
+
+#define SETTINGS_FLASH_FAKE_SECTOR 4096
+
+typedef struct
+{
+    uint8_t sector[SETTINGS_FLASH_FAKE_SECTOR];
+    uint32_t erase_count;
+    uint32_t write_count;  // program operations
+    uint32_t bytes_written;
+    uint32_t read_count;
+    int fail_writes;       // > 0: fail that many upcoming writes
+} settings_flash_fake_t;
+
+void settings_flash_fake_init(settings_flash_fake_t *flash);
+
+/**
+ * @brief Backend bound to flash, pass it to settings_init().
+ */
+settings_backend_t settings_flash_fake_backend(settings_flash_fake_t *flash);
+
+#endif
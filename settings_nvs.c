@@ -0,0 +1,154 @@
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+
+#include "settings.h"
+#include "settings_nvs.h"
+
+static const char *TAG = "settings";
+
+#ifndef CONFIG_SETTINGS_QUIET_MS
+#define CONFIG_SETTINGS_QUIET_MS 3000 /* no change for this long before writing flash */
+#endif
+#ifndef CONFIG_SETTINGS_POLL_MS
+#define CONFIG_SETTINGS_POLL_MS 250
+#endif
+
+#define SETTINGS_NAMESPACE "storage"
+#define SETTINGS_KEY "settings"
+#define SETTINGS_LEGACY_DPI_KEY "dpi"
+
+static SemaphoreHandle_t settings_mutex;
+
+static int nvs_backend_read(void *ctx, uint8_t *buf, size_t *len)
+{
+    (void)ctx;
+    nvs_handle_t nvs_handle;
+
+    esp_err_t ret = nvs_open(SETTINGS_NAMESPACE, NVS_READONLY, &nvs_handle);
+    if (ret != ESP_OK)
+    {
+        return SETTINGS_ERR_NOT_FOUND;
+    }
+
+    ret = nvs_get_blob(nvs_handle, SETTINGS_KEY, buf, len);
+    nvs_close(nvs_handle);
+
+    if (ret == ESP_ERR_NVS_NOT_FOUND)
+    {
+        return SETTINGS_ERR_NOT_FOUND;
+    }
+
+    return ret == ESP_OK ? SETTINGS_OK : SETTINGS_ERR_IO;
+}
+
+static int nvs_backend_write(void *ctx, const uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    nvs_handle_t nvs_handle;
+
+    esp_err_t ret = nvs_open(SETTINGS_NAMESPACE, NVS_READWRITE, &nvs_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "NVS open failed: %s", esp_err_to_name(ret));
+        return SETTINGS_ERR_IO;
+    }
+
+    ret = nvs_set_blob(nvs_handle, SETTINGS_KEY, buf, len);
+    if (ret == ESP_OK)
+    {
+        ret = nvs_commit(nvs_handle);
+    }
+    nvs_close(nvs_handle);
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "NVS write failed: %s", esp_err_to_name(ret));
+        return SETTINGS_ERR_IO;
+    }
+
+    ESP_LOGI(TAG, "settings committed");
+
+    return SETTINGS_OK;
+}
+
+static void nvs_backend_lock(void *ctx)
+{
+    (void)ctx;
+    xSemaphoreTake(settings_mutex, portMAX_DELAY);
+}
+
+static void nvs_backend_unlock(void *ctx)
+{
+    (void)ctx;
+    xSemaphoreGive(settings_mutex);
+}
+
+static const settings_backend_t nvs_backend = {
+    .read = nvs_backend_read,
+    .write = nvs_backend_write,
+    .lock = nvs_backend_lock,
+    .unlock = nvs_backend_unlock,
+};
+
+/* firmware before the settings blob kept only a bare "dpi" u16 */
+static void import_legacy_dpi(void)
+{
+    nvs_handle_t nvs_handle;
+    uint16_t dpi;
+
+    if (nvs_open(SETTINGS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK)
+    {
+        return;
+    }
+
+    if (nvs_get_u16(nvs_handle, SETTINGS_LEGACY_DPI_KEY, &dpi) == ESP_OK)
+    {
+        ESP_LOGI(TAG, "import legacy dpi %u", dpi);
+        settings_t s = settings_get();
+        cpi_stages_set(&s.cpi, s.cpi.current, dpi, dpi, s.cpi.count);
+        settings_set_cpi(&s.cpi);
+    }
+    nvs_close(nvs_handle);
+}
+
+static void settings_task(void *pv)
+{
+    (void)pv;
+    for (;;)
+    {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_SETTINGS_POLL_MS));
+        settings_poll(xTaskGetTickCount() * portTICK_PERIOD_MS);
+    }
+}
+
+esp_err_t wake_settings(void)
+{
+    settings_mutex = xSemaphoreCreateMutex();
+    if (!settings_mutex)
+    {
+        ESP_LOGE(TAG, "xSemaphoreCreateMutex failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    int ret = settings_init(&nvs_backend, CONFIG_SETTINGS_QUIET_MS);
+    if (ret == SETTINGS_ERR_NOT_FOUND)
+    {
+        import_legacy_dpi();
+    }
+    else if (ret != SETTINGS_OK)
+    {
+        ESP_LOGW(TAG, "stored settings unreadable (%d), using defaults", ret);
+    }
+
+    if (xTaskCreate(settings_task, "settings_task", 2048, NULL, tskIDLE_PRIORITY, NULL) != pdPASS)
+    {
+        ESP_LOGE(TAG, "xTaskCreate settings_task failed");
+        return ESP_ERR_NO_MEM;
+    }
+
+    return ESP_OK;
+}
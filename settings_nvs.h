@@ -0,0 +1,12 @@
+#ifndef SETTINGS_NVS_H
+#define SETTINGS_NVS_H
+
+#include "esp_err.h"
+
+/**
+ * @brief Load settings from NVS and start the low priority commit task.
+ *        Must run after nvs_flash_init() and before anything reads settings.
+ */
+esp_err_t wake_settings(void);
+
+#endif
@@ -1,12 +1,443 @@
+#include <string.h>
+
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_rom_sys.h"
 #include "spi.h"
 #include "pins.h"
 
 static const char *TAG = "spi";
 
+#ifndef CONFIG_PAW3395_SPI_CLOCK_HZ
+#define CONFIG_PAW3395_SPI_CLOCK_HZ 4000000
+#endif
+#ifndef CONFIG_PAW3395_SPI_HW_CS
+#define CONFIG_PAW3395_SPI_HW_CS 1
+#endif
+#ifndef CONFIG_PAW3395_SPI_DMA
+#define CONFIG_PAW3395_SPI_DMA 1
+#endif
+#ifndef CONFIG_PAW3395_SPI_POLLING
+#define CONFIG_PAW3395_SPI_POLLING 1 /* frames are a few tens of us, cheaper than an ISR round trip */
+#endif
+
+// sensor timing, converted to SPI clocks whenever the clock changes
+#define PAW3395_READ_DELAY_NS 2000 // tSRAD
+#define PAW3395_CS_SETUP_NS 120    // tNCS-SCLK
+#define PAW3395_CS_HOLD_NS 1000    // tSCLK-NCS, conservative for writes
+#define SPI_CS_CLOCKS_MAX 16       // limit of cs_ena_pretrans/posttrans
+
 static spi_device_handle_t spi_handle;
+static volatile uint32_t spi_errors;
+
+static spi_transport_config_t cfg = {
+    .clock_hz = CONFIG_PAW3395_SPI_CLOCK_HZ,
+    .read_delay_ns = PAW3395_READ_DELAY_NS,
+    .flags = (CONFIG_PAW3395_SPI_HW_CS ? SPI_TRANSPORT_HW_CS : 0) |
+             (CONFIG_PAW3395_SPI_DMA ? SPI_TRANSPORT_DMA : 0) |
+             (CONFIG_PAW3395_SPI_POLLING ? SPI_TRANSPORT_POLLING : 0),
+};
+
+// DMA needs internal RAM, word aligned
+static DMA_ATTR WORD_ALIGNED_ATTR uint8_t rx_buf[SPI_TRANSPORT_READ_MAX];
+static DMA_ATTR WORD_ALIGNED_ATTR uint8_t tx_buf[SPI_TRANSPORT_READ_MAX];
+
+static spi_transaction_ext_t pending_trans;
+static bool pending;
+static uint8_t facade_reg;
+
+static inline bool hw_cs(void)
+{
+    return (cfg.flags & SPI_TRANSPORT_HW_CS) != 0;
+}
+
+static inline void cs_set(int level)
+{
+    // manual CS: same ~1 us setup/hold the sensor code used to spin for
+    if (level)
+    {
+        esp_rom_delay_us(1);
+    }
+    gpio_set_level(PAW3395_SPI_CS, level);
+    if (!level)
+    {
+        esp_rom_delay_us(1);
+    }
+}
+
+static esp_err_t transact(spi_transaction_t *t)
+{
+    esp_err_t ret;
+
+    if (cfg.flags & SPI_TRANSPORT_POLLING)
+    {
+        ret = spi_device_polling_transmit(spi_handle, t);
+    }
+    else
+    {
+        ret = spi_device_transmit(spi_handle, t);
+    }
+    if (ret != ESP_OK)
+    {
+        spi_errors++;
+    }
+
+    return ret;
+}
+
+// one full duplex transfer without CS handling, manual CS mode only
+static esp_err_t raw_transfer(const uint8_t *tx, uint8_t *rx, size_t len)
+{
+    spi_transaction_t t = {
+        .length = 8 * len,
+        .tx_buffer = tx,
+        .rx_buffer = rx,
+    };
+
+    return transact(&t);
+}
+
+static int tr_write(void *ctx, uint8_t reg, uint8_t data)
+{
+    (void)ctx;
+    esp_err_t ret;
+
+    if (pending)
+    {
+        return SPI_TRANSPORT_ERR_BUSY;
+    }
+
+    if (hw_cs())
+    {
+        spi_transaction_t t = {
+            .flags = SPI_TRANS_USE_TXDATA,
+            .addr = reg | 0x80,
+            .length = 8,
+            .tx_data = {data},
+        };
+        ret = transact(&t);
+    }
+    else
+    {
+        tx_buf[0] = reg | 0x80;
+        tx_buf[1] = data;
+        cs_set(0);
+        ret = raw_transfer(tx_buf, NULL, 2);
+        cs_set(1);
+    }
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Write command failed: 0x%02x %s", reg, esp_err_to_name(ret));
+        return SPI_TRANSPORT_ERR_IO;
+    }
+    return SPI_TRANSPORT_OK;
+}
+
+static void build_read(spi_transaction_ext_t *t, uint8_t reg, size_t len)
+{
+    memset(t, 0, sizeof(*t));
+    t->base.flags = SPI_TRANS_VARIABLE_DUMMY;
+    t->base.addr = reg & 0x7F;
+    t->base.rxlength = 8 * len;
+    t->base.rx_buffer = rx_buf;
+    t->dummy_bits = spi_transport_dummy_bits(cfg.clock_hz, cfg.read_delay_ns);
+}
+
+// manual CS: assert, send the address and wait tSRAD; the data phase follows
+static esp_err_t manual_read_head(uint8_t reg)
+{
+    tx_buf[0] = reg & 0x7F;
+    cs_set(0);
+    esp_err_t ret = raw_transfer(tx_buf, NULL, 1);
+    esp_rom_delay_us((cfg.read_delay_ns + 999) / 1000);
+    return ret;
+}
+
+static void build_manual_data(spi_transaction_ext_t *t, size_t len)
+{
+    memset(t, 0, sizeof(*t));
+    memset(tx_buf, 0, len);
+    t->base.length = 8 * len;
+    t->base.tx_buffer = tx_buf;
+    t->base.rx_buffer = rx_buf;
+}
+
+static int tr_read(void *ctx, uint8_t reg, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    spi_transaction_ext_t t;
+    esp_err_t ret;
+
+    if (len == 0 || len > SPI_TRANSPORT_READ_MAX)
+    {
+        return SPI_TRANSPORT_ERR_ARG;
+    }
+    if (pending)
+    {
+        return SPI_TRANSPORT_ERR_BUSY;
+    }
+
+    if (hw_cs())
+    {
+        build_read(&t, reg, len);
+        ret = transact(&t.base);
+    }
+    else
+    {
+        ret = manual_read_head(reg);
+        if (ret == ESP_OK)
+        {
+            build_manual_data(&t, len);
+            ret = transact(&t.base);
+        }
+        cs_set(1);
+    }
+
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Read failed: 0x%02x %s", reg, esp_err_to_name(ret));
+        return SPI_TRANSPORT_ERR_IO;
+    }
+
+    memcpy(buf, rx_buf, len);
+    return SPI_TRANSPORT_OK;
+}
+
+static int tr_read_begin(void *ctx, uint8_t reg, size_t len)
+{
+    (void)ctx;
+    esp_err_t ret;
+
+    if (len == 0 || len > SPI_TRANSPORT_READ_MAX)
+    {
+        return SPI_TRANSPORT_ERR_ARG;
+    }
+    if (pending)
+    {
+        return SPI_TRANSPORT_ERR_BUSY;
+    }
+
+    if (hw_cs())
+    {
+        build_read(&pending_trans, reg, len);
+    }
+    else
+    {
+        ret = manual_read_head(reg);
+        if (ret != ESP_OK)
+        {
+            cs_set(1);
+            return SPI_TRANSPORT_ERR_IO;
+        }
+        build_manual_data(&pending_trans, len);
+    }
+
+    ret = spi_device_queue_trans(spi_handle, &pending_trans.base, portMAX_DELAY);
+    if (ret != ESP_OK)
+    {
+        spi_errors++;
+        if (!hw_cs())
+        {
+            cs_set(1);
+        }
+        return SPI_TRANSPORT_ERR_IO;
+    }
+
+    pending = true;
+    return SPI_TRANSPORT_OK;
+}
+
+static int tr_read_end(void *ctx, uint8_t *buf, size_t len)
+{
+    (void)ctx;
+    spi_transaction_t *done;
+
+    if (!pending)
+    {
+        return SPI_TRANSPORT_ERR_BUSY;
+    }
+
+    esp_err_t ret = spi_device_get_trans_result(spi_handle, &done, portMAX_DELAY);
+    pending = false;
+    if (!hw_cs())
+    {
+        cs_set(1);
+    }
+    if (ret != ESP_OK)
+    {
+        spi_errors++;
+        return SPI_TRANSPORT_ERR_IO;
+    }
+
+    size_t got = (done->rxlength ? done->rxlength : done->length) / 8;
+    memcpy(buf, rx_buf, len < got ? len : got);
+    return SPI_TRANSPORT_OK;
+}
+
+static int tr_write_stream(void *ctx, uint8_t reg, const uint8_t *data, size_t len, uint32_t gap_ns)
+{
+    (void)ctx;
+    uint32_t gap_us = (gap_ns + 999) / 1000;
+    esp_err_t ret = ESP_OK;
+
+    if (pending)
+    {
+        return SPI_TRANSPORT_ERR_BUSY;
+    }
+
+    if (hw_cs())
+    {
+        // CS stays asserted across the byte transactions while the bus is held
+        ret = spi_device_acquire_bus(spi_handle, portMAX_DELAY);
+        if (ret != ESP_OK)
+        {
+            spi_errors++;
+            return SPI_TRANSPORT_ERR_IO;
+        }
+
+        spi_transaction_t head = {
+            .flags = SPI_TRANS_CS_KEEP_ACTIVE,
+            .addr = reg | 0x80,
+        };
+        ret = spi_device_polling_transmit(spi_handle, &head);
+
+        for (size_t i = 0; i < len && ret == ESP_OK; i++)
+        {
+            spi_transaction_ext_t t = {
+                .base = {
+                    .flags = SPI_TRANS_USE_TXDATA | SPI_TRANS_VARIABLE_ADDR |
+                             (i + 1 < len ? SPI_TRANS_CS_KEEP_ACTIVE : 0),
+                    .length = 8,
+                    .tx_data = {data[i]},
+                },
+                .address_bits = 0,
+            };
+            esp_rom_delay_us(gap_us);
+            ret = spi_device_polling_transmit(spi_handle, &t.base);
+        }
+
+        spi_device_release_bus(spi_handle);
+    }
+    else
+    {
+        tx_buf[0] = reg | 0x80;
+        cs_set(0);
+        ret = raw_transfer(tx_buf, NULL, 1);
+        for (size_t i = 0; i < len && ret == ESP_OK; i++)
+        {
+            tx_buf[0] = data[i]; // data may live in flash, DMA cannot read it
+            esp_rom_delay_us(gap_us);
+            ret = raw_transfer(tx_buf, NULL, 1);
+        }
+        cs_set(1);
+    }
+
+    if (ret != ESP_OK)
+    {
+        spi_errors++;
+        ESP_LOGE(TAG, "Stream to 0x%02x failed: %s", reg, esp_err_to_name(ret));
+        return SPI_TRANSPORT_ERR_IO;
+    }
+    return SPI_TRANSPORT_OK;
+}
+
+static void tr_reset_port(void *ctx)
+{
+    (void)ctx;
+
+    // with hardware CS the next frame asserts CS, which resets the port as well
+    if (!hw_cs())
+    {
+        gpio_set_level(PAW3395_SPI_CS, 1);
+        esp_rom_delay_us(1);
+        gpio_set_level(PAW3395_SPI_CS, 0);
+    }
+}
+
+static const spi_transport_t transport = {
+    .write = tr_write,
+    .read = tr_read,
+    .read_begin = tr_read_begin,
+    .read_end = tr_read_end,
+    .write_stream = tr_write_stream,
+    .reset_port = tr_reset_port,
+    .ctx = NULL,
+};
+
+static uint8_t cs_clocks(uint32_t clock_hz, uint32_t ns)
+{
+    uint8_t clocks = spi_transport_dummy_bits(clock_hz, ns);
+
+    if (clocks == 0)
+    {
+        return 1;
+    }
+    return clocks > SPI_CS_CLOCKS_MAX ? SPI_CS_CLOCKS_MAX : clocks;
+}
+
+static esp_err_t add_device(void)
+{
+    cfg.cs_pretrans = cs_clocks(cfg.clock_hz, PAW3395_CS_SETUP_NS);
+    cfg.cs_posttrans = cs_clocks(cfg.clock_hz, PAW3395_CS_HOLD_NS);
+
+    spi_device_interface_config_t dev_cfg = {
+        .mode = 3,
+        .clock_speed_hz = cfg.clock_hz,
+        .queue_size = 2,
+    };
+
+    if (hw_cs())
+    {
+        // address phase + dummy clocks (tSRAD) + data phase in a single frame
+        dev_cfg.address_bits = 8;
+        dev_cfg.spics_io_num = PAW3395_SPI_CS;
+        dev_cfg.cs_ena_pretrans = cfg.cs_pretrans;
+        dev_cfg.cs_ena_posttrans = cfg.cs_posttrans;
+        dev_cfg.flags = SPI_DEVICE_HALFDUPLEX;
+    }
+    else
+    {
+        dev_cfg.spics_io_num = -1; // handle manually
+    }
+
+    esp_err_t ret = spi_bus_add_device(SPI_HOST, &dev_cfg, &spi_handle);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGE(TAG, "SPI device add failed: %s", esp_err_to_name(ret));
+    }
+
+    return ret;
+}
+
+esp_err_t spi_set_clock(uint32_t clock_hz)
+{
+    if (pending)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (clock_hz == cfg.clock_hz)
+    {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = spi_bus_remove_device(spi_handle);
+    if (ret != ESP_OK)
+    {
+        return ret;
+    }
+
+    cfg.clock_hz = clock_hz;
+    ret = add_device();
+    if (ret == ESP_OK)
+    {
+        ESP_LOGD(TAG, "SPI clock %lu Hz", (unsigned long)clock_hz);
+    }
+
+    return ret;
+}
 
 esp_err_t wake_spi()
 {
@@ -21,69 +452,68 @@ esp_err_t wake_spi()
         .max_transfer_sz = 32,
     };
 
-    ret = spi_bus_initialize(SPI_HOST, &bus_cfg, SPI_DMA_DISABLED);
+    ret = spi_bus_initialize(SPI_HOST, &bus_cfg, (cfg.flags & SPI_TRANSPORT_DMA) ? SPI_DMA_CH_AUTO : SPI_DMA_DISABLED);
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "SPI bus initialize failed: %s", esp_err_to_name(ret));
         return ret;
     }
 
-    spi_device_interface_config_t dev_cfg = {
-        .command_bits = 0,
-        .address_bits = 0,
-        .dummy_bits = 0,
-        .mode = 3,
-        .clock_speed_hz = 4000000,
-        .spics_io_num = -1, // handle manually
-        .flags = 0,
-        .queue_size = 1,
-        .pre_cb = NULL,
-        .post_cb = NULL,
-    };
-
-    ret = spi_bus_add_device(SPI_HOST, &dev_cfg, &spi_handle);
+    ret = add_device();
     if (ret != ESP_OK)
     {
-        ESP_LOGE(TAG, "SPI device add failed: %s", esp_err_to_name(ret));
         return ret;
     }
 
-    gpio_set_direction(PAW3395_SPI_CS, GPIO_MODE_OUTPUT);
-    gpio_set_level(PAW3395_SPI_CS, 1);
+    if (!hw_cs())
+    {
+        gpio_set_direction(PAW3395_SPI_CS, GPIO_MODE_OUTPUT);
+        gpio_set_level(PAW3395_SPI_CS, 1);
+    }
 
-    ESP_LOGI(TAG, "SPI wake up.");
+    ESP_LOGI(TAG, "SPI wake up, %lu Hz, %s CS, %s, %s.", (unsigned long)cfg.clock_hz,
+             hw_cs() ? "hardware" : "manual", (cfg.flags & SPI_TRANSPORT_DMA) ? "DMA" : "no DMA",
+             (cfg.flags & SPI_TRANSPORT_POLLING) ? "polling" : "queued");
 
     return ret;
 }
 
-void spi_write_data(uint8_t reg, uint8_t data)
+const spi_transport_t *spi_transport(void)
 {
-    uint8_t tx_data[2] = {reg | 0x80, data};
+    return &transport;
+}
 
-    spi_transaction_t trans = {
-        .length = 16,
-        .tx_buffer = tx_data,
-        .rx_buffer = NULL,
-    };
+const spi_transport_config_t *spi_transport_config(void)
+{
+    return &cfg;
+}
 
-    esp_err_t ret = spi_device_transmit(spi_handle, &trans);
-    if (ret != ESP_OK)
+void spi_write_data(uint8_t reg, uint8_t data)
+{
+    if (hw_cs())
+    {
+        tr_write(NULL, reg, data);
+        return;
+    }
+
+    tx_buf[0] = reg | 0x80;
+    tx_buf[1] = data;
+    if (raw_transfer(tx_buf, NULL, 2) != ESP_OK)
     {
-        ESP_LOGE("TAG", "Write command failed: 0x%02x", reg);
+        ESP_LOGE(TAG, "Write command failed: 0x%02x", reg);
     }
 }
 
 void spi_send_read(uint8_t reg)
 {
-    uint8_t addr = reg & 0x7F;
-
-    spi_transaction_t trans = {
-        .length = 8,
-        .tx_buffer = &addr,
-        .rx_buffer = NULL,
-    };
+    if (hw_cs())
+    {
+        facade_reg = reg;
+        return;
+    }
 
-    esp_err_t ret = spi_device_transmit(spi_handle, &trans);
+    tx_buf[0] = reg & 0x7F;
+    esp_err_t ret = raw_transfer(tx_buf, NULL, 1);
     if (ret != ESP_OK)
     {
         ESP_LOGE(TAG, "Read command failed: 0x%02x %s", reg, esp_err_to_name(ret));
@@ -92,21 +522,26 @@ void spi_send_read(uint8_t reg)
 
 uint8_t spi_read_data()
 {
-    uint8_t dummy = 0x00;
-    uint8_t rx_data[1] = {0};
+    uint8_t data = 0;
 
-    spi_transaction_t trans = {
-        .length = 8,
-        .tx_buffer = &dummy,
-        .rx_buffer = rx_data,
-    };
+    if (hw_cs())
+    {
+        tr_read(NULL, facade_reg, &data, 1);
+        return data;
+    }
 
-    esp_err_t ret = spi_device_transmit(spi_handle, &trans);
+    tx_buf[0] = 0x00;
+    esp_err_t ret = raw_transfer(tx_buf, rx_buf, 1);
     if (ret != ESP_OK)
     {
-        ESP_LOGE("TAG", "Read data failed: %s", esp_err_to_name(ret));
+        ESP_LOGE(TAG, "Read data failed: %s", esp_err_to_name(ret));
         return 0;
     }
 
-    return rx_data[0];
-}
\ No newline at end of file
+    return rx_buf[0];
+}
+
+uint32_t spi_error_count(void)
+{
+    return spi_errors;
+}
@@ -1,6 +1,11 @@
 #ifndef SPI_H
 #define SPI_H
 
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "spi_transport.h"
+
 #define SPI_HOST SPI2_HOST
 
 /**
@@ -10,10 +15,34 @@
 */
 esp_err_t wake_spi();
 
+/**
+ * @brief Sensor transport on the bus set up by wake_spi(), see spi_transport.h.
+ */
+const spi_transport_t *spi_transport(void);
+
+const spi_transport_config_t *spi_transport_config(void);
+
+/**
+ * @brief Re-add the device at a new clock; CS setup/hold and the read delay are
+ *        recomputed in SPI clocks. No read may be pending.
+ */
+esp_err_t spi_set_clock(uint32_t clock_hz);
+
+/*
+ * Compatibility facade, the pre-transport byte API. The caller owns CS when
+ * CONFIG_PAW3395_SPI_HW_CS is 0. With hardware CS every call is a complete
+ * frame: spi_read_data() is a one byte read of the register last passed to
+ * spi_send_read().
+ */
 void spi_write_data(uint8_t reg, uint8_t data);
 
 void spi_send_read(uint8_t reg);
 
 uint8_t spi_read_data();
 
-#endif
\ No newline at end of file
+/**
+ * @brief Failed transactions since boot, never reset.
+ */
+uint32_t spi_error_count(void);
+
+#endif
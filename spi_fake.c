@@ -0,0 +1,173 @@
+#include <string.h>
+
+#include "spi_fake.h"
+
+void spi_fake_init(spi_fake_t *bus, const spi_transport_config_t *cfg)
+{
+    memset(bus, 0, sizeof(*bus));
+    bus->cfg = *cfg;
+    bus->burst_reg = 0x16; // PAW3395 MOTION_BURST
+}
+
+static bool fail_frame(spi_fake_t *bus)
+{
+    if (bus->fail_frames > 0)
+    {
+        bus->fail_frames--;
+        return true;
+    }
+    return false;
+}
+
+static void fill(spi_fake_t *bus, uint8_t reg, uint8_t *buf, size_t len)
+{
+    reg &= 0x7F;
+    if (reg == bus->burst_reg)
+    {
+        memcpy(buf, bus->burst, len);
+    }
+    else
+    {
+        memset(buf, 0, len);
+        buf[0] = bus->regs[reg];
+    }
+}
+
+static int fake_write(void *ctx, uint8_t reg, uint8_t data)
+{
+    spi_fake_t *bus = ctx;
+
+    if (bus->pending)
+    {
+        return SPI_TRANSPORT_ERR_BUSY;
+    }
+
+    bus->now_ns += spi_transport_write_ns(&bus->cfg) + bus->frame_overhead_ns;
+    bus->frames++;
+    if (fail_frame(bus))
+    {
+        return SPI_TRANSPORT_ERR_IO;
+    }
+
+    bus->regs[reg & 0x7F] = data;
+    bus->writes++;
+    bus->bytes += 2;
+    return SPI_TRANSPORT_OK;
+}
+
+static int fake_read(void *ctx, uint8_t reg, uint8_t *buf, size_t len)
+{
+    spi_fake_t *bus = ctx;
+
+    if (len == 0 || len > SPI_TRANSPORT_READ_MAX)
+    {
+        return SPI_TRANSPORT_ERR_ARG;
+    }
+    if (bus->pending)
+    {
+        return SPI_TRANSPORT_ERR_BUSY;
+    }
+
+    bus->now_ns += spi_transport_read_ns(&bus->cfg, len) + bus->frame_overhead_ns;
+    bus->frames++;
+    if (fail_frame(bus))
+    {
+        return SPI_TRANSPORT_ERR_IO;
+    }
+
+    fill(bus, reg, buf, len);
+    bus->reads++;
+    bus->bytes += 1 + len;
+    return SPI_TRANSPORT_OK;
+}
+
+static int fake_read_begin(void *ctx, uint8_t reg, size_t len)
+{
+    spi_fake_t *bus = ctx;
+
+    if (len == 0 || len > SPI_TRANSPORT_READ_MAX)
+    {
+        return SPI_TRANSPORT_ERR_ARG;
+    }
+    if (bus->pending)
+    {
+        return SPI_TRANSPORT_ERR_BUSY;
+    }
+
+    // queuing costs the caller only the overhead, the wire time runs in the background
+    bus->now_ns += bus->frame_overhead_ns;
+    bus->pending = true;
+    bus->pending_reg = reg;
+    bus->pending_len = len;
+    bus->pending_done_ns = bus->now_ns + spi_transport_read_ns(&bus->cfg, len);
+    return SPI_TRANSPORT_OK;
+}
+
+static int fake_read_end(void *ctx, uint8_t *buf, size_t len)
+{
+    spi_fake_t *bus = ctx;
+
+    if (!bus->pending)
+    {
+        return SPI_TRANSPORT_ERR_BUSY;
+    }
+
+    bus->pending = false;
+    if (bus->now_ns < bus->pending_done_ns)
+    {
+        bus->now_ns = bus->pending_done_ns; // caller blocks until the frame is done
+    }
+    bus->frames++;
+    if (fail_frame(bus))
+    {
+        return SPI_TRANSPORT_ERR_IO;
+    }
+
+    fill(bus, bus->pending_reg, buf, len < bus->pending_len ? len : bus->pending_len);
+    bus->reads++;
+    bus->bytes += 1 + bus->pending_len;
+    return SPI_TRANSPORT_OK;
+}
+
+static int fake_write_stream(void *ctx, uint8_t reg, const uint8_t *data, size_t len, uint32_t gap_ns)
+{
+    spi_fake_t *bus = ctx;
+    (void)reg;
+    (void)data;
+
+    if (bus->pending)
+    {
+        return SPI_TRANSPORT_ERR_BUSY;
+    }
+
+    bus->now_ns += spi_transport_stream_ns(&bus->cfg, len, gap_ns) + bus->frame_overhead_ns;
+    bus->frames++;
+    if (fail_frame(bus))
+    {
+        return SPI_TRANSPORT_ERR_IO;
+    }
+
+    bus->writes++;
+    bus->bytes += 1 + len;
+    bus->stream_bytes += len;
+    return SPI_TRANSPORT_OK;
+}
+
+static void fake_reset_port(void *ctx)
+{
+    (void)ctx;
+}
+
+spi_transport_t spi_fake_transport(spi_fake_t *bus)
+{
+    spi_transport_t t = {
+        .write = fake_write,
+        .read = fake_read,
+        .read_begin = fake_read_begin,
+        .read_end = fake_read_end,
+        .write_stream = fake_write_stream,
+        .reset_port = fake_reset_port,
+        .ctx = bus,
+    };
+    return t;
+}
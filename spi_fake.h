@@ -0,0 +1,48 @@
+#ifndef SPI_FAKE_H
+#define SPI_FAKE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "spi_transport.h"
+
+/*
+ * Host-side SPI transport modelling the sensor's register file and the bus
+ * timing. Every frame advances now_ns by its wire time from spi_transport.h
+ * plus frame_overhead_ns of driver cost, so tools/spi_timing.c can compare
+ * configurations (hardware vs manual CS, burst vs per-byte reads) on Linux.
+ *
+ * Reads of burst_reg return the burst buffer, other reads return regs[].
+ */
+
+#define SPI_FAKE_REGS 128
+
+typedef struct
+{
+    spi_transport_config_t cfg;
+    uint8_t regs[SPI_FAKE_REGS];
+    uint8_t burst_reg;
+    uint8_t burst[SPI_TRANSPORT_READ_MAX];
+    uint32_t frame_overhead_ns; // software cost per frame (driver, ISR or polling)
+    uint64_t now_ns;            // simulated time
+    uint32_t frames;
+    uint32_t writes;
+    uint32_t reads;
+    uint32_t bytes;
+    uint32_t stream_bytes; // payload of write_stream() frames
+    int fail_frames; // > 0: fail that many upcoming frames
+    // pending split read
+    bool pending;
+    uint8_t pending_reg;
+    size_t pending_len;
+    uint64_t pending_done_ns; // when the queued frame finishes on the wire
+} spi_fake_t;
+
+void spi_fake_init(spi_fake_t *bus, const spi_transport_config_t *cfg);
+
+/**
+ * @brief Transport bound to bus.
+ */
+spi_transport_t spi_fake_transport(spi_fake_t *bus);
+
+#endif
@@ -0,0 +1,88 @@
+#include "spi_transport.h"
+
+static uint32_t clocks_to_ns(uint32_t clock_hz, uint32_t clocks)
+{
+    if (clock_hz == 0)
+    {
+        return 0;
+    }
+    return (uint32_t)(((uint64_t)clocks * 1000000000u + clock_hz - 1) / clock_hz);
+}
+
+uint8_t spi_transport_dummy_bits(uint32_t clock_hz, uint32_t delay_ns)
+{
+    uint64_t bits = ((uint64_t)delay_ns * clock_hz + 999999999u) / 1000000000u;
+
+    return bits > UINT8_MAX ? UINT8_MAX : (uint8_t)bits;
+}
+
+static uint32_t cs_ns(const spi_transport_config_t *cfg)
+{
+    if (cfg->flags & SPI_TRANSPORT_HW_CS)
+    {
+        return clocks_to_ns(cfg->clock_hz, cfg->cs_pretrans + cfg->cs_posttrans);
+    }
+    return 0; // manual CS timing is software, not on the wire
+}
+
+uint32_t spi_transport_read_ns(const spi_transport_config_t *cfg, size_t data_bytes)
+{
+    uint32_t ns = clocks_to_ns(cfg->clock_hz, 8 + 8 * (uint32_t)data_bytes) + cs_ns(cfg);
+
+    if (cfg->flags & SPI_TRANSPORT_HW_CS)
+    {
+        ns += clocks_to_ns(cfg->clock_hz, spi_transport_dummy_bits(cfg->clock_hz, cfg->read_delay_ns));
+    }
+    else
+    {
+        ns += cfg->read_delay_ns;
+    }
+
+    return ns;
+}
+
+uint32_t spi_transport_write_ns(const spi_transport_config_t *cfg)
+{
+    return clocks_to_ns(cfg->clock_hz, 16) + cs_ns(cfg);
+}
+
+uint32_t spi_transport_stream_ns(const spi_transport_config_t *cfg, size_t len, uint32_t gap_ns)
+{
+    uint32_t byte_ns = clocks_to_ns(cfg->clock_hz, 8);
+
+    return byte_ns + (uint32_t)len * (gap_ns + byte_ns) + cs_ns(cfg);
+}
+
+uint32_t spi_transport_calibrate(const uint32_t *steps, size_t n, uint8_t margin,
+                                 spi_transport_probe_t probe, void *ctx)
+{
+    size_t passed = 0;
+
+    while (passed < n && probe(ctx, steps[passed]))
+    {
+        passed++;
+    }
+    if (passed == 0)
+    {
+        return 0;
+    }
+
+    size_t pick = passed - 1;
+    pick = pick > margin ? pick - margin : 0;
+
+    return steps[pick];
+}
+
+uint32_t spi_transport_pick_clock(uint32_t cached_hz, uint32_t fallback_hz, const uint32_t *steps, size_t n,
+                                  uint8_t margin, spi_transport_probe_t probe, void *ctx)
+{
+    // a cached result still has to pass one probe before it is trusted
+    if (cached_hz && probe(ctx, cached_hz))
+    {
+        return cached_hz;
+    }
+
+    uint32_t hz = spi_transport_calibrate(steps, n, margin, probe, ctx);
+
+    return hz ? hz : fallback_hz;
+}
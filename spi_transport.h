@@ -0,0 +1,94 @@
+#ifndef SPI_TRANSPORT_H
+#define SPI_TRANSPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Register-level SPI transport for the sensor. No IDF dependency, so the
+ * sensor code can run against spi.c on the target or spi_fake.c on the host.
+ *
+ * A read frame is: address byte, read_delay_ns of idle clock (PAW3395 tSRAD),
+ * then len data bytes, all under one CS assertion. With hardware CS the delay
+ * is sent as dummy clocks and the frame is a single transaction; with manual
+ * CS it is a GPIO toggle and a busy wait, as the driver always did.
+ *
+ * read_begin()/read_end() split a read so the caller can do other work while
+ * the frame is on the wire. Only one read may be pending.
+ */
+
+#define SPI_TRANSPORT_OK 0
+#define SPI_TRANSPORT_ERR_IO -1
+#define SPI_TRANSPORT_ERR_BUSY -2 // read_begin with a read pending, read_end without one
+#define SPI_TRANSPORT_ERR_ARG -3
+
+#define SPI_TRANSPORT_READ_MAX 16 // longest read frame, bytes
+
+// config flags
+#define SPI_TRANSPORT_HW_CS 0x01   // CS driven by the SPI peripheral
+#define SPI_TRANSPORT_DMA 0x02     // bus uses a DMA channel
+#define SPI_TRANSPORT_POLLING 0x04 // busy-poll transactions instead of sleeping on the ISR
+
+typedef struct
+{
+    uint32_t clock_hz;
+    uint16_t read_delay_ns; // address to first data byte
+    uint8_t cs_pretrans;    // hardware CS setup, SPI clocks (max 16)
+    uint8_t cs_posttrans;   // hardware CS hold, SPI clocks (max 16)
+    uint8_t flags;          // SPI_TRANSPORT_* flags
+} spi_transport_config_t;
+
+typedef struct
+{
+    int (*write)(void *ctx, uint8_t reg, uint8_t data);
+    int (*read)(void *ctx, uint8_t reg, uint8_t *buf, size_t len);
+    int (*read_begin)(void *ctx, uint8_t reg, size_t len);
+    int (*read_end)(void *ctx, uint8_t *buf, size_t len);
+    // one CS assertion: address, then each byte of data preceded by gap_ns of idle bus
+    int (*write_stream)(void *ctx, uint8_t reg, const uint8_t *data, size_t len, uint32_t gap_ns);
+    // toggle CS high then low to reset the sensor's serial port
+    void (*reset_port)(void *ctx);
+    void *ctx;
+} spi_transport_t;
+
+/**
+ * @brief Dummy clocks covering delay_ns at clock_hz, rounded up.
+ */
+uint8_t spi_transport_dummy_bits(uint32_t clock_hz, uint32_t delay_ns);
+
+/**
+ * @brief Wire time of a read frame with data_bytes of payload, CS setup/hold included.
+ */
+uint32_t spi_transport_read_ns(const spi_transport_config_t *cfg, size_t data_bytes);
+
+/**
+ * @brief Wire time of a two byte write frame.
+ */
+uint32_t spi_transport_write_ns(const spi_transport_config_t *cfg);
+
+/**
+ * @brief Wire time of a write_stream() of len bytes.
+ */
+uint32_t spi_transport_stream_ns(const spi_transport_config_t *cfg, size_t len, uint32_t gap_ns);
+
+/**
+ * @brief Returns true if the device works reliably at clock_hz.
+ */
+typedef bool (*spi_transport_probe_t)(void *ctx, uint32_t clock_hz);
+
+/**
+ * @brief Step up through steps (ascending) until a probe fails.
+ * @return the fastest passing step backed off by margin steps, 0 if even the first fails
+ */
+uint32_t spi_transport_calibrate(const uint32_t *steps, size_t n, uint8_t margin,
+                                 spi_transport_probe_t probe, void *ctx);
+
+/**
+ * @brief Boot-time clock choice: cached_hz (0 = none) if it still passes one probe,
+ *        otherwise spi_transport_calibrate(), otherwise fallback_hz.
+ */
+uint32_t spi_transport_pick_clock(uint32_t cached_hz, uint32_t fallback_hz, const uint32_t *steps, size_t n,
+                                  uint8_t margin, spi_transport_probe_t probe, void *ctx);
+
+#endif
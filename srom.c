@@ -0,0 +1,34 @@
+#include <string.h>
+
+#include "settings.h"
+#include "srom.h"
+
+int srom_image_parse(const uint8_t *blob, size_t len, srom_image_t *img)
+{
+    srom_header_t hdr;
+
+    if (len < sizeof(hdr))
+    {
+        return SROM_ERR_LENGTH;
+    }
+    memcpy(&hdr, blob, sizeof(hdr));
+
+    if (hdr.magic != SROM_MAGIC)
+    {
+        return SROM_ERR_MAGIC;
+    }
+    if (hdr.length == 0 || hdr.length > len - sizeof(hdr))
+    {
+        return SROM_ERR_LENGTH;
+    }
+    if (settings_crc32(blob + sizeof(hdr), hdr.length) != hdr.crc)
+    {
+        return SROM_ERR_CRC;
+    }
+
+    img->data = blob + sizeof(hdr);
+    img->length = hdr.length;
+    img->id = hdr.id;
+
+    return SROM_OK;
+}
@@ -0,0 +1,64 @@
+#ifndef SROM_H
+#define SROM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Sensor firmware (SROM) images. No IDF dependency.
+ *
+ * The image lives in the "srom" data partition and is used in place from the
+ * memory-mapped flash, never copied:
+ *   srom_header_t | payload (length bytes)
+ * crc32 (same polynomial as the settings blob) covers the payload and is
+ * checked before anything is sent to the sensor. After the upload the sensor
+ * runs its own check and reports SROM_SELF_TEST_OK.
+ *
+ * Register protocol (PixArt SROM download):
+ *   SROM_ENABLE <- 0x1D, wait 10 ms, SROM_ENABLE <- 0x18,
+ *   stream the payload to SROM_LOAD_BURST with >= 15 us between bytes,
+ *   SROM_ID then reads back the image id.
+ */
+
+#define SROM_MAGIC 0x4D4F5253u // "SROM"
+
+#define SROM_ENABLE 0x13
+#define SROM_ID 0x2A
+#define SROM_LOAD_BURST 0x62
+#define SROM_DATA_OUT_LOWER 0x25
+#define SROM_DATA_OUT_UPPER 0x26
+
+#define SROM_ENABLE_INIT 0x1D
+#define SROM_ENABLE_LOAD 0x18
+#define SROM_ENABLE_CRC 0x15
+#define SROM_SELF_TEST_OK 0xBEEF
+
+#define SROM_BYTE_GAP_NS 15000
+
+#define SROM_OK 0
+#define SROM_ERR_MAGIC -1
+#define SROM_ERR_LENGTH -2
+#define SROM_ERR_CRC -3
+
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t length; // payload bytes
+    uint32_t crc;    // crc32 of the payload
+    uint8_t id;      // expected SROM_ID after upload
+    uint8_t reserved[3];
+} srom_header_t;
+
+typedef struct
+{
+    const uint8_t *data;
+    uint32_t length;
+    uint8_t id;
+} srom_image_t;
+
+/**
+ * @brief Validate the blob at the start of a partition of size len, img points into it.
+ */
+int srom_image_parse(const uint8_t *blob, size_t len, srom_image_t *img);
+
+#endif
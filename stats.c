@@ -0,0 +1,63 @@
+#include <stdio.h>
+
+#include "stats.h"
+
+stats_core_t stats_cores[STATS_CORES];
+
+static const char *const names[STATS_COUNT] = {
+#define STATS_NAME(id, name) name,
+    STATS_COUNTERS(STATS_NAME)
+#undef STATS_NAME
+};
+
+void stats_snapshot(stats_snapshot_t *s)
+{
+    for (int i = 0; i < STATS_COUNT; i++)
+    {
+        uint32_t sum = 0;
+        for (int c = 0; c < STATS_CORES; c++)
+        {
+            sum += __atomic_load_n(&stats_cores[c].v[i], __ATOMIC_RELAXED);
+        }
+        s->v[i] = sum;
+    }
+}
+
+void stats_diff(const stats_snapshot_t *now, const stats_snapshot_t *then, stats_snapshot_t *out)
+{
+    for (int i = 0; i < STATS_COUNT; i++)
+    {
+        out->v[i] = now->v[i] - then->v[i];
+    }
+}
+
+const char *stats_name(stats_id_t id)
+{
+    return (unsigned)id < STATS_COUNT ? names[id] : "?";
+}
+
+size_t stats_format(const stats_snapshot_t *s, char *buf, size_t cap)
+{
+    size_t len = 0;
+
+    if (cap == 0)
+    {
+        return 0;
+    }
+    buf[0] = '\0';
+    for (int i = 0; i < STATS_COUNT; i++)
+    {
+        if (s->v[i] == 0)
+        {
+            continue;
+        }
+        int n = snprintf(buf + len, cap - len, "%s%s=%lu", len ? " " : "", names[i], (unsigned long)s->v[i]);
+        if (n < 0 || (size_t)n >= cap - len)
+        {
+            buf[len] = '\0'; // drop the counter that did not fit whole
+            break;
+        }
+        len += (size_t)n;
+    }
+    return len;
+}
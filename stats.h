@@ -0,0 +1,96 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#endif
+
+/*
+ * Event counters. No IDF dependency beyond the core id.
+ *
+ * Every core bumps its own copy with a relaxed atomic add: no lock, no
+ * interrupt masking, and a core never writes a cache line the other core
+ * reads on the hot path. Readers sum the copies into a snapshot; counters
+ * are free running uint32 and snapshots are compared with stats_diff(),
+ * which is wrap-safe.
+ */
+
+#define STATS_COUNTERS(X)                                                       \
+    X(REPORTS_SENT, "sent")        /* input reports handed to the HID stack */  \
+    X(REPORTS_DROPPED, "dropped")  /* refused by the stack or not connected */  \
+    X(REPORT_SPLITS, "split")      /* extra reports for motion past the field */ \
+    X(QUEUE_FULL, "qfull")         /* accumulator queue refused an item */      \
+    X(SPI_ERRORS, "spi")           /* failed motion burst reads */              \
+    X(RECONNECTS, "conn")          /* BLE connections */                        \
+    X(DEBOUNCE_REJECTS, "bounce")  /* edges inside a debounce window */         \
+    X(ENCODER_INVALID, "enc")      /* wheel transitions with a missed edge */   \
+    X(CAPTURE_DROPS, "capdrop")    /* raw capture frames the UART fell behind on */
+
+typedef enum
+{
+#define STATS_ENUM(id, name) STATS_##id,
+    STATS_COUNTERS(STATS_ENUM)
+#undef STATS_ENUM
+    STATS_COUNT
+} stats_id_t;
+
+#ifndef STATS_CORES
+#define STATS_CORES 2
+#endif
+#ifndef STATS_LINE
+#define STATS_LINE 64 // covers the 32 byte lines of the ESP32 and 64 of the host
+#endif
+
+#ifndef STATS_CORE_ID
+#ifdef ESP_PLATFORM
+#define STATS_CORE_ID() esp_cpu_get_core_id()
+#else
+#define STATS_CORE_ID() 0
+#endif
+#endif
+
+typedef struct
+{
+    uint32_t v[STATS_COUNT];
+} __attribute__((aligned(STATS_LINE))) stats_core_t;
+
+typedef struct
+{
+    uint32_t v[STATS_COUNT];
+} stats_snapshot_t;
+
+extern stats_core_t stats_cores[STATS_CORES];
+
+static inline void stats_add(stats_id_t id, uint32_t n)
+{
+    __atomic_fetch_add(&stats_cores[STATS_CORE_ID()].v[id], n, __ATOMIC_RELAXED);
+}
+
+static inline void stats_inc(stats_id_t id)
+{
+    stats_add(id, 1);
+}
+
+/**
+ * @brief Sum of all cores. Each counter is read atomically, the set is not.
+ */
+void stats_snapshot(stats_snapshot_t *s);
+
+/**
+ * @brief out = now - then, per counter.
+ */
+void stats_diff(const stats_snapshot_t *now, const stats_snapshot_t *then, stats_snapshot_t *out);
+
+const char *stats_name(stats_id_t id);
+
+/**
+ * @brief "name=value" for each counter that is not 0, space separated.
+ * @return length written, without the terminator
+ */
+size_t stats_format(const stats_snapshot_t *s, char *buf, size_t cap);
+
+#endif
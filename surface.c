@@ -0,0 +1,65 @@
+#include <string.h>
+
+#include "surface.h"
+
+void surface_parse_burst(const uint8_t raw[SURFACE_BURST_LEN], surface_burst_t *b)
+{
+    b->motion = raw[0];
+    b->observation = raw[1];
+    b->dx = (int16_t)(raw[2] | (raw[3] << 8));
+    b->dy = (int16_t)(raw[4] | (raw[5] << 8));
+    b->squal = raw[6];
+    b->raw_sum = raw[7];
+    b->raw_max = raw[8];
+    b->raw_min = raw[9];
+    b->shutter = (uint16_t)((raw[10] << 8) | raw[11]);
+}
+
+void surface_default_params(surface_params_t *p)
+{
+    memset(p, 0, sizeof(*p));
+    p->squal_min = 16;
+    p->settle = 2;
+}
+
+void surface_configure(surface_gate_t *g, const surface_params_t *p)
+{
+    g->params = *p;
+    g->lifted = false;
+    g->settle_left = 0;
+}
+
+bool surface_gate(surface_gate_t *g, const surface_burst_t *b)
+{
+    bool lifted = (b->motion & SURFACE_MOTION_LIFT) != 0;
+
+    g->stats.squal = b->squal;
+    g->stats.raw_sum = b->raw_sum;
+    g->stats.shutter = b->shutter;
+    g->stats.lifted = lifted;
+    g->stats.samples++;
+
+    if (lifted && !g->lifted)
+    {
+        g->stats.lift_count++;
+    }
+    if (!lifted && g->lifted)
+    {
+        g->settle_left = g->params.settle;
+    }
+    g->lifted = lifted;
+
+    if (lifted || b->squal < g->params.squal_min)
+    {
+        g->stats.gated++;
+        return false;
+    }
+    if (g->settle_left)
+    {
+        g->settle_left--;
+        g->stats.gated++;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,78 @@
+#ifndef SURFACE_H
+#define SURFACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * PAW3395 motion burst decoding and surface-quality gating. No IDF dependency.
+ *
+ * Burst layout (MOTION_BURST_ADR, 12 bytes):
+ *   [0] Motion  [1] Observation  [2..3] Delta_X  [4..5] Delta_Y  [6] SQUAL
+ *   [7] RawData_Sum  [8] Maximum_RawData  [9] Minimum_RawData
+ *   [10] Shutter_Upper  [11] Shutter_Lower
+ *
+ * Motion is dropped while the sensor reports lift, while SQUAL is below
+ * squal_min, and for settle samples after the mouse lands again, which is
+ * where the jitter on lift-off during fast swipes comes from.
+ */
+
+#define SURFACE_BURST_LEN 12
+
+#define SURFACE_MOTION_MOT 0x80
+#define SURFACE_MOTION_LIFT 0x08
+
+typedef struct
+{
+    uint8_t motion;
+    uint8_t observation;
+    int16_t dx;
+    int16_t dy;
+    uint8_t squal;
+    uint8_t raw_sum;
+    uint8_t raw_max;
+    uint8_t raw_min;
+    uint16_t shutter;
+} surface_burst_t;
+
+typedef struct
+{
+    uint8_t squal_min; // 0 = no SQUAL gating
+    uint8_t settle;    // samples dropped after landing
+} surface_params_t;
+
+typedef struct
+{
+    uint8_t squal; // last sample
+    uint8_t raw_sum;
+    uint16_t shutter;
+    uint8_t lifted;
+    uint16_t lift_count; // lift-off events
+    uint32_t gated;      // samples dropped
+    uint32_t samples;
+} surface_stats_t;
+
+typedef struct
+{
+    surface_params_t params;
+    bool lifted;
+    uint8_t settle_left;
+    surface_stats_t stats;
+} surface_gate_t;
+
+void surface_parse_burst(const uint8_t raw[SURFACE_BURST_LEN], surface_burst_t *b);
+
+void surface_default_params(surface_params_t *p);
+
+/**
+ * @brief Reset the gate with new parameters, statistics are kept.
+ */
+void surface_configure(surface_gate_t *g, const surface_params_t *p);
+
+/**
+ * @brief Feed one burst.
+ * @return true if its motion may be reported
+ */
+bool surface_gate(surface_gate_t *g, const surface_burst_t *b);
+
+#endif
@@ -0,0 +1,29 @@
+#include <string.h>
+
+#include "rate_ctl.h"
+#include "task_plan.h"
+
+void task_plan_init(sched_task_t *plan, int sensor_core, int host_core, uint8_t nimble_priority)
+{
+    const sched_task_t p[TASK_COUNT] = {
+        [TASK_MOVE] = {.name = "move_loop_task", .core = sensor_core, .stack = CONFIG_MOVE_TASK_STACK,
+                       .period_us = CONFIG_PAW3395_READ_INTERVAL * 1000,
+                       .wcet_us = CONFIG_MOVE_WCET_US, .deadline_us = CONFIG_MOVE_BUDGET_US},
+        // fed by the move task and the button/wheel ISRs, no faster than the sensor reads
+        [TASK_ACCUM] = {.name = "accum_loop_task", .core = sensor_core, .stack = CONFIG_ACCUM_TASK_STACK,
+                        .period_us = CONFIG_PAW3395_READ_INTERVAL * 1000,
+                        .wcet_us = CONFIG_ACCUM_WCET_US, .deadline_us = CONFIG_ACCUM_BUDGET_US},
+        // encoder edges can come about every millisecond when the wheel is flicked
+        [TASK_INPUT] = {.name = "input_loop_task", .core = sensor_core, .stack = CONFIG_INPUT_TASK_STACK,
+                        .period_us = 1000,
+                        .wcet_us = CONFIG_INPUT_WCET_US, .deadline_us = CONFIG_INPUT_BUDGET_US},
+        [TASK_REPORT] = {.name = "report_loop_task", .core = host_core, .stack = CONFIG_REPORT_TASK_STACK,
+                         .period_us = 1000000 / MOUSE_REPORT_RATE_MAX, // fastest it can be paced
+                         .wcet_us = CONFIG_REPORT_WCET_US, .deadline_us = CONFIG_REPORT_BUDGET_US},
+        // created by nimble_port_freertos_init(), only here for the analysis and the stats
+        [TASK_NIMBLE] = {.name = "nimble_host", .core = host_core, .fixed = true, .priority = nimble_priority,
+                         .period_us = 7500, .wcet_us = 1000, .deadline_us = 7500},
+    };
+
+    memcpy(plan, p, sizeof(p));
+}
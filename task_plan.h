@@ -0,0 +1,81 @@
+#ifndef TASK_PLAN_H
+#define TASK_PLAN_H
+
+#include <stdint.h>
+
+#include "sched_plan.h"
+
+/*
+ * The firmware's task plan: periods, worst-case run times, latency budgets
+ * and stacks of the tasks main.c creates, plus the NimBLE host they share a
+ * core with. No IDF dependency, so tools/sched_check.c analyses the same
+ * table app_main() does.
+ */
+
+#ifndef CONFIG_PAW3395_READ_INTERVAL
+#define CONFIG_PAW3395_READ_INTERVAL 5   /* ms */
+#endif
+
+/* Task stacks in bytes; sched_stats_dump() suggests sizes from the measured high-water marks */
+#ifndef CONFIG_MOVE_TASK_STACK
+#define CONFIG_MOVE_TASK_STACK 3072
+#endif
+#ifndef CONFIG_ACCUM_TASK_STACK
+#define CONFIG_ACCUM_TASK_STACK 3072
+#endif
+#ifndef CONFIG_REPORT_TASK_STACK
+#define CONFIG_REPORT_TASK_STACK 3584
+#endif
+#ifndef CONFIG_INPUT_TASK_STACK
+#define CONFIG_INPUT_TASK_STACK 2560
+#endif
+
+/* Latency budgets (wake-up to done) and worst-case run times in microseconds */
+#ifndef CONFIG_MOVE_BUDGET_US
+#define CONFIG_MOVE_BUDGET_US 1000   /* motion interrupt to first sample queued */
+#endif
+#ifndef CONFIG_MOVE_WCET_US
+#define CONFIG_MOVE_WCET_US 150      /* burst read plus xform/accel */
+#endif
+#ifndef CONFIG_ACCUM_BUDGET_US
+#define CONFIG_ACCUM_BUDGET_US 500   /* input queued to report task notified */
+#endif
+#ifndef CONFIG_ACCUM_WCET_US
+#define CONFIG_ACCUM_WCET_US 50
+#endif
+#ifndef CONFIG_REPORT_BUDGET_US
+#define CONFIG_REPORT_BUDGET_US 2000 /* notified to HID report handed to the stack */
+#endif
+#ifndef CONFIG_REPORT_WCET_US
+#define CONFIG_REPORT_WCET_US 300
+#endif
+#ifndef CONFIG_INPUT_BUDGET_US
+#define CONFIG_INPUT_BUDGET_US 500   /* button/wheel edge to decoded input queued */
+#endif
+#ifndef CONFIG_INPUT_WCET_US
+#define CONFIG_INPUT_WCET_US 40
+#endif
+#ifndef CONFIG_TASK_BASE_PRIORITY
+#define CONFIG_TASK_BASE_PRIORITY 5  /* above the boot-time helpers, well below the NimBLE host */
+#endif
+
+enum
+{
+    TASK_MOVE,
+    TASK_ACCUM,
+    TASK_INPUT,
+    TASK_REPORT,
+    TASK_NIMBLE,
+    TASK_COUNT
+};
+
+/**
+ * @brief Fill plan[TASK_COUNT]. The sensor path goes on sensor_core, the report
+ *        task stays on host_core with the NimBLE host it feeds (SCHED_ANY_CORE
+ *        for both on a single core). nimble_priority is the host's own,
+ *        configMAX_PRIORITIES - 4 with NimBLE's defaults. Priorities of the
+ *        other tasks are left to sched_plan_assign().
+ */
+void task_plan_init(sched_task_t *plan, int sensor_core, int host_core, uint8_t nimble_priority);
+
+#endif
@@ -0,0 +1,50 @@
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#include "telemetry.h"
+
+#ifndef CONFIG_TELEMETRY_PERIOD_MS
+#define CONFIG_TELEMETRY_PERIOD_MS 10000 /* 0 = no periodic dump */
+#endif
+
+#define TELEMETRY_LINE 160
+
+static const char *TAG = "telemetry";
+
+static void telemetry_task(void *pv)
+{
+    (void)pv;
+    stats_snapshot_t last, now, delta;
+    char line[TELEMETRY_LINE];
+
+    stats_snapshot(&last);
+    for (;;)
+    {
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_TELEMETRY_PERIOD_MS));
+        stats_snapshot(&now);
+        stats_diff(&now, &last, &delta);
+        last = now;
+
+        // quiet periods stay out of the log
+        if (stats_format(&delta, line, sizeof(line)))
+        {
+            ESP_LOGI(TAG, "+%d ms %s", CONFIG_TELEMETRY_PERIOD_MS, line);
+        }
+    }
+}
+
+esp_err_t wake_telemetry(void)
+{
+    if (CONFIG_TELEMETRY_PERIOD_MS == 0)
+    {
+        return ESP_OK;
+    }
+
+    if (xTaskCreate(telemetry_task, "telemetry", 2560, NULL, tskIDLE_PRIORITY + 1, NULL) != pdPASS)
+    {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
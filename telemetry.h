@@ -0,0 +1,18 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "esp_err.h"
+
+#include "stats.h"
+
+/*
+ * Periodic one-line dump of the stats.h counters: what changed since the
+ * previous line, e.g. "+10000 ms sent=1250 qfull=1". Runs just above idle.
+ */
+
+/**
+ * @brief Start the dump task every CONFIG_TELEMETRY_PERIOD_MS, does nothing when the period is 0.
+ */
+esp_err_t wake_telemetry(void);
+
+#endif
@@ -0,0 +1,165 @@
+/*
+ * Host benchmark of accel.c: the gain table against evaluating the curve per sample.
+ *
+ *   cc -O2 -I. tools/accel_bench.c accel.c -lm -o accel_bench && ./accel_bench
+ *
+ * For each curve:
+ *   lut ns     host time per accel_gain_lut() call, speed estimate included
+ *   direct ns  the same with accel_gain_direct(), what the table replaces
+ *   speedup    direct / lut
+ *   apply ns   a whole accel_apply() call
+ *   max err    largest gain difference table vs direct over every Q4 speed
+ *              up to max_speed, in Q8 (256 = 1.0)
+ *   rms err    the same, RMS
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "accel.h"
+
+#define SAMPLE_US 1000
+#define SAMPLES 1024
+#define BENCH_SAMPLES 2000000
+
+typedef struct
+{
+    const char *name;
+    uint8_t curve;
+} curve_case_t;
+
+static const curve_case_t curves[] = {
+    {"linear", ACCEL_CURVE_LINEAR},
+    {"power", ACCEL_CURVE_POWER},
+    {"sigmoid", ACCEL_CURVE_SIGMOID},
+    {"points", ACCEL_CURVE_POINTS},
+};
+
+static int16_t in_x[SAMPLES], in_y[SAMPLES];
+
+// deltas up to ~60 counts/ms in varied directions, 1 kHz reads
+static void gen_samples(void)
+{
+    for (int i = 0; i < SAMPLES; i++)
+    {
+        double v = 60.0 * (rand() / (double)RAND_MAX) * (rand() / (double)RAND_MAX);
+        double a = 2 * M_PI * rand() / (double)RAND_MAX;
+        in_x[i] = (int16_t)lround(v * cos(a) * SAMPLE_US / 1000.0);
+        in_y[i] = (int16_t)lround(v * sin(a) * SAMPLE_US / 1000.0);
+    }
+}
+
+static void setup(accel_t *a, uint8_t curve)
+{
+    accel_params_t p;
+    accel_default_params(&p);
+    p.curve = curve;
+    p.max_speed = 64;
+    p.exponent = 384; // 1.5
+    p.n_points = 4;
+    p.points[0] = (accel_point_t){2, 256};
+    p.points[1] = (accel_point_t){8, 320};
+    p.points[2] = (accel_point_t){24, 512};
+    p.points[3] = (accel_point_t){48, 768};
+    accel_init(a);
+    accel_configure(a, &p);
+}
+
+static double elapsed_ns(const struct timespec *t0, const struct timespec *t1)
+{
+    return (t1->tv_sec - t0->tv_sec) * 1e9 + (t1->tv_nsec - t0->tv_nsec);
+}
+
+static double bench_lut(const accel_t *a)
+{
+    struct timespec t0, t1;
+    volatile uint32_t sink = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        int k = i & (SAMPLES - 1);
+        sink += accel_gain_lut(a, accel_speed_q4(in_x[k], in_y[k], SAMPLE_US));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+    return elapsed_ns(&t0, &t1) / BENCH_SAMPLES;
+}
+
+static double bench_direct(const accel_t *a)
+{
+    struct timespec t0, t1;
+    volatile uint32_t sink = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        int k = i & (SAMPLES - 1);
+        sink += accel_gain_direct(&a->params, accel_speed_q4(in_x[k], in_y[k], SAMPLE_US));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+    return elapsed_ns(&t0, &t1) / BENCH_SAMPLES;
+}
+
+static double bench_apply(accel_t *a)
+{
+    struct timespec t0, t1;
+    volatile int32_t sink = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        int16_t x = in_x[i & (SAMPLES - 1)], y = in_y[i & (SAMPLES - 1)];
+        accel_apply(a, &x, &y, SAMPLE_US);
+        sink += x + y;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+    return elapsed_ns(&t0, &t1) / BENCH_SAMPLES;
+}
+
+static void table_error(const accel_t *a, int *max_err, double *rms_err)
+{
+    uint32_t top = (uint32_t)a->params.max_speed << 4;
+    double err2 = 0;
+
+    *max_err = 0;
+    for (uint32_t v = 0; v <= top; v++)
+    {
+        int d = abs((int)accel_gain_lut(a, v) - (int)accel_gain_direct(&a->params, v));
+        if (d > *max_err)
+        {
+            *max_err = d;
+        }
+        err2 += (double)d * d;
+    }
+    *rms_err = sqrt(err2 / (top + 1));
+}
+
+int main(void)
+{
+    static accel_t a;
+
+    srand(1);
+    gen_samples();
+
+    printf("%-8s %8s %10s %8s %9s %8s %8s\n", "curve", "lut ns", "direct ns", "speedup", "apply ns", "max err",
+           "rms err");
+    for (size_t i = 0; i < sizeof(curves) / sizeof(curves[0]); i++)
+    {
+        int max_err = 0;
+        double rms_err = 0;
+
+        setup(&a, curves[i].curve);
+        double lut = bench_lut(&a);
+        double direct = bench_direct(&a);
+        double apply = bench_apply(&a);
+        table_error(&a, &max_err, &rms_err);
+        printf("%-8s %8.1f %10.1f %7.1fx %9.1f %8d %8.2f\n", curves[i].name, lut, direct, direct / lut, apply, max_err,
+               rms_err);
+    }
+    return 0;
+}
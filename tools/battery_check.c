@@ -0,0 +1,245 @@
+/*
+ * Host check of battery_level.c: the oversampling filter, the discharge curve
+ * and battery_monitor_update(), which decides when battery_task() notifies.
+ *
+ *   cc -I. tools/battery_check.c battery_level.c -lm -o battery_check && ./battery_check
+ *
+ * Pin readings go through the divider of battery.c's defaults. Exits non-zero
+ * on the first broken expectation of each case.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "battery_level.h"
+
+#define OVERSAMPLE 16  // CONFIG_BATTERY_OVERSAMPLE
+#define FILTER_SHIFT 2 // CONFIG_BATTERY_FILTER_SHIFT
+#define HYSTERESIS 2   // CONFIG_BATTERY_HYSTERESIS
+#define DIVIDER_MUL 2  // CONFIG_BATTERY_DIVIDER_MUL
+#define DIVIDER_DIV 1  // CONFIG_BATTERY_DIVIDER_DIV
+
+static int failures;
+
+#define CHECK(cond, ...)                  \
+    do                                    \
+    {                                     \
+        if (!(cond))                      \
+        {                                 \
+            printf("FAIL: " __VA_ARGS__); \
+            printf("\n");                 \
+            failures++;                   \
+            return;                       \
+        }                                 \
+    } while (0)
+
+static uint32_t rng = 1;
+
+static int noise(int amp)
+{
+    rng = rng * 1103515245u + 12345u;
+    return (int)((rng >> 16) % (2 * amp + 1)) - amp;
+}
+
+static void check_oversample(void)
+{
+    uint16_t s[OVERSAMPLE];
+
+    for (int i = 0; i < OVERSAMPLE; i++)
+    {
+        s[i] = 1900;
+    }
+    CHECK(battery_oversample(s, OVERSAMPLE) == 1900, "flat input");
+
+    // one spike either way is trimmed off
+    s[3] = 0;
+    s[11] = 3300;
+    CHECK(battery_oversample(s, OVERSAMPLE) == 1900, "outliers moved the mean to %u", battery_oversample(s, OVERSAMPLE));
+
+    for (int i = 0; i < OVERSAMPLE; i++)
+    {
+        s[i] = (uint16_t)(1900 + (i % 2 ? 10 : -10));
+    }
+    CHECK(battery_oversample(s, OVERSAMPLE) == 1900, "symmetric noise gave %u", battery_oversample(s, OVERSAMPLE));
+
+    const uint16_t two[] = {1000, 2000};
+    CHECK(battery_oversample(two, 2) == 1500, "plain mean below 3 samples");
+    CHECK(battery_oversample(two, 0) == 0, "no samples");
+}
+
+static void check_filter(void)
+{
+    battery_filter_t f;
+
+    battery_filter_init(&f, FILTER_SHIFT);
+    CHECK(battery_filter_update(&f, 4000) == 4000, "first reading does not prime the filter");
+
+    // a 200 mV step: a quarter of what is left per period, then settle exactly
+    uint16_t mv = 4000;
+    int left = 200;
+    for (int k = 1; k <= 8; k++)
+    {
+        mv = battery_filter_update(&f, 3800);
+        left -= left / 4;
+        CHECK(abs(mv - (3800 + left)) <= 1, "step down period %d: %u, expected %d", k, mv, 3800 + left);
+    }
+    for (int k = 0; k < 40; k++)
+    {
+        mv = battery_filter_update(&f, 3800);
+    }
+    CHECK(mv == 3800, "settled down at %u", mv);
+    for (int k = 0; k < 40; k++)
+    {
+        mv = battery_filter_update(&f, 3900);
+    }
+    CHECK(mv == 3900, "settled up at %u", mv);
+
+    // +-30 mV of noise around 3700 comes out with an RMS under a third of that
+    double err2 = 0;
+    for (int k = 0; k < 540; k++)
+    {
+        mv = battery_filter_update(&f, (uint16_t)(3700 + noise(30)));
+        if (k >= 40)
+        {
+            err2 += (mv - 3700) * (mv - 3700);
+        }
+    }
+    CHECK(sqrt(err2 / 500) <= 10, "noise got through: %.1f mV RMS", sqrt(err2 / 500));
+}
+
+static void check_curve(void)
+{
+    const battery_curve_point_t *c = battery_curve_lipo;
+    size_t n = battery_curve_lipo_len;
+
+    for (size_t i = 0; i < n; i++)
+    {
+        CHECK(battery_curve_lookup(c, n, c[i].mv) == c[i].percent, "%u mV gave %u, curve says %u", c[i].mv,
+              battery_curve_lookup(c, n, c[i].mv), c[i].percent);
+    }
+    CHECK(battery_curve_lookup(c, n, 4350) == 100, "above full");
+    CHECK(battery_curve_lookup(c, n, 3000) == 0, "below empty");
+    CHECK(battery_curve_lookup(c, n, 3950) == 72, "3950 mV gave %u", battery_curve_lookup(c, n, 3950));
+    CHECK(battery_curve_lookup(c, n, 3400) == 3, "3400 mV gave %u", battery_curve_lookup(c, n, 3400));
+
+    uint8_t prev = 100;
+    for (uint16_t mv = 4300; mv >= 3200; mv--)
+    {
+        uint8_t p = battery_curve_lookup(c, n, mv);
+        CHECK(p <= prev, "curve rises from %u to %u at %u mV", prev, p, mv);
+        prev = p;
+    }
+}
+
+static unsigned notifies;
+
+// one sample period at cell voltage `mv`, +-`amp` mV of noise on every pin reading
+static bool step(battery_monitor_t *m, uint16_t mv, int amp)
+{
+    uint16_t pin[OVERSAMPLE];
+
+    for (int i = 0; i < OVERSAMPLE; i++)
+    {
+        pin[i] = (uint16_t)(mv * DIVIDER_DIV / DIVIDER_MUL + noise(amp));
+    }
+    if (battery_monitor_update(m, pin, OVERSAMPLE))
+    {
+        notifies++;
+        return true;
+    }
+    return false;
+}
+
+static void start(battery_monitor_t *m)
+{
+    battery_monitor_init(m, FILTER_SHIFT, HYSTERESIS, DIVIDER_MUL, DIVIDER_DIV);
+    notifies = 0;
+}
+
+// pin readings are scaled by the divider before the filter and the curve
+static void check_divider(void)
+{
+    battery_monitor_t m;
+    uint16_t pin[OVERSAMPLE];
+
+    for (int i = 0; i < OVERSAMPLE; i++)
+    {
+        pin[i] = 1900;
+    }
+    battery_monitor_init(&m, FILTER_SHIFT, HYSTERESIS, 2, 1);
+    battery_monitor_update(&m, pin, OVERSAMPLE);
+    CHECK(m.voltage_mv == 3800 && m.level == 50, "2:1 gave %u mV %u %%", m.voltage_mv, m.level);
+
+    battery_monitor_init(&m, FILTER_SHIFT, HYSTERESIS, 3, 2);
+    battery_monitor_update(&m, pin, OVERSAMPLE);
+    CHECK(m.voltage_mv == 2850 && m.level == 0, "3:2 gave %u mV %u %%", m.voltage_mv, m.level);
+
+    // a zero divisor is taken as 1 rather than dividing by it
+    battery_monitor_init(&m, FILTER_SHIFT, HYSTERESIS, 2, 0);
+    battery_monitor_update(&m, pin, OVERSAMPLE);
+    CHECK(m.voltage_mv == 3800, "2:0 gave %u mV", m.voltage_mv);
+}
+
+static void check_notify(void)
+{
+    battery_monitor_t m;
+
+    // boot always notifies, even at the initial 100 %
+    start(&m);
+    CHECK(step(&m, 4200, 0) && m.level == 100, "no notify at boot");
+    CHECK(!step(&m, 4200, 0), "notify without a change");
+
+    // 4250 -> 3050 mV over 3000 periods with ADC noise: the level only goes
+    // down, in steps wider than the band, and ends at 0
+    start(&m);
+    unsigned ups = 0;
+    uint8_t prev = 100;
+    for (int k = 0; k < 3000; k++)
+    {
+        if (step(&m, (uint16_t)(4250 - k * 1000 / 2500), 12) && k > 0)
+        {
+            if (m.level > prev)
+            {
+                ups++;
+            }
+            CHECK(m.level == 0 || m.level == 100 || abs((int)m.level - (int)prev) > HYSTERESIS,
+                  "step %u -> %u inside the band", prev, m.level);
+        }
+        prev = m.level;
+    }
+    CHECK(ups == 0, "level went up %u times while discharging", ups);
+    CHECK(m.level == 0, "ended at %u %%", m.level);
+    CHECK(notifies <= 100 / (HYSTERESIS + 1) + 2, "%u notifications for one discharge", notifies);
+
+    // sitting on a level boundary with noise: one notify, no flapping
+    start(&m);
+    for (int k = 0; k < 20; k++)
+    {
+        step(&m, 3775, 0);
+    }
+    unsigned before = notifies;
+    for (int k = 0; k < 2000; k++)
+    {
+        step(&m, 3775, 12);
+    }
+    CHECK(notifies == before, "%u notifications while idle at a boundary", notifies - before);
+
+    // charging back up reaches 100 exactly
+    for (int k = 0; k < 200; k++)
+    {
+        step(&m, 4210, 12);
+    }
+    CHECK(m.level == 100, "charged to %u %%", m.level);
+}
+
+int main(void)
+{
+    check_oversample();
+    check_filter();
+    check_curve();
+    check_divider();
+    check_notify();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,312 @@
+/*
+ * Host decoder for the blog.h binary log, and a self-test of the ring.
+ *
+ *   cc -O2 -I. tools/blog_decode.c blog.c -lpthread -o blog_decode
+ *   idf.py monitor | ./blog_decode          (or ./blog_decode capture.txt)
+ *   ./blog_decode --selftest
+ *
+ * "@B" lines become "[seconds] c<core> text"; everything else, including
+ * ESP_LOG output, passes through untouched. Sequence gaps are reported as
+ * lost records, a sequence going backwards as a device restart.
+ *
+ * The self-test runs on any Linux box: every format in the table against
+ * its argument count, encode/decode round trips, a ring lapped several
+ * times, and writers racing the reader, checking that every record read is
+ * intact and that read + lost adds up to what was written.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "blog.h"
+
+#define LINE_MAX_LEN 512
+
+static int failures;
+
+#define CHECK(cond)                                                                                                    \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(cond))                                                                                                   \
+        {                                                                                                              \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);                                   \
+            failures++;                                                                                                \
+        }                                                                                                              \
+    } while (0)
+
+static int decode(FILE *in)
+{
+    char line[LINE_MAX_LEN];
+    char text[LINE_MAX_LEN];
+    uint32_t next = 0;
+    blog_rec_t rec;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        if (!blog_decode_line(line, &rec))
+        {
+            fputs(line, stdout);
+            continue;
+        }
+
+        if (next != 0 && rec.seq < next)
+        {
+            printf("-- restart --\n");
+        }
+        else if (next != 0 && rec.seq > next)
+        {
+            printf("-- %lu records lost --\n", (unsigned long)(rec.seq - next));
+        }
+        next = rec.seq + 1;
+
+        if (!blog_format(&rec, text, sizeof(text)))
+        {
+            printf("[%4lu.%06lu] c%u id %u with %u args, not in this build's table\n", (unsigned long)(rec.t_us / 1000000),
+                   (unsigned long)(rec.t_us % 1000000), rec.core, rec.id, rec.nargs);
+            continue;
+        }
+        printf("[%4lu.%06lu] c%u %s\n", (unsigned long)(rec.t_us / 1000000), (unsigned long)(rec.t_us % 1000000),
+               rec.core, text);
+    }
+    return 0;
+}
+
+static unsigned conversions(const char *f)
+{
+    unsigned n = 0;
+    for (; *f; f++)
+    {
+        if (*f == '%')
+        {
+            if (f[1] == '%')
+            {
+                f++;
+                continue;
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+static void test_formats(void)
+{
+    char text[LINE_MAX_LEN];
+
+    for (uint16_t id = 0; id < BLOG_EVENT_COUNT; id++)
+    {
+        unsigned want = conversions(blog_format_str(id));
+        blog_rec_t rec = {.id = id, .arg = {1, 2, 3, 4}};
+
+        CHECK(want <= BLOG_ARGS_MAX);
+        rec.nargs = (uint8_t)want;
+        CHECK(blog_format(&rec, text, sizeof(text)));
+        if (want > 0)
+        {
+            rec.nargs = (uint8_t)(want - 1);
+            CHECK(!blog_format(&rec, text, sizeof(text)));
+        }
+    }
+
+    blog_rec_t rec = {.id = BLOG_GAP_CONNECT, .nargs = 2, .arg = {(uint32_t)-14, 7}};
+    CHECK(blog_format(&rec, text, sizeof(text)));
+    CHECK(strcmp(text, "gap connect; status -14 handle 7") == 0);
+
+    rec = (blog_rec_t){.id = BLOG_HID_DATA, .nargs = 4, .arg = {0x01020304, 0xa0b0c0d0, 0, 0xffffffff}};
+    CHECK(blog_format(&rec, text, sizeof(text)));
+    CHECK(strcmp(text, "  01020304 a0b0c0d0 00000000 ffffffff") == 0);
+
+    // truncation keeps the buffer terminated
+    CHECK(blog_format(&rec, text, 8));
+    CHECK(strlen(text) == 7);
+
+    rec.id = BLOG_EVENT_COUNT;
+    CHECK(!blog_format(&rec, text, sizeof(text)));
+}
+
+static void test_lines(void)
+{
+    char line[BLOG_LINE_MAX];
+    char prefixed[BLOG_LINE_MAX + 16];
+    blog_rec_t out;
+
+    srand(1);
+    for (int i = 0; i < 10000; i++)
+    {
+        blog_rec_t rec = {
+            .seq = (uint32_t)rand() * 7u,
+            .t_us = (uint32_t)rand() * 13u,
+            .id = (uint16_t)(rand() % BLOG_EVENT_COUNT),
+            .nargs = (uint8_t)(rand() % (BLOG_ARGS_MAX + 1)),
+            .core = (uint8_t)(rand() & 1),
+        };
+        for (uint8_t a = 0; a < rec.nargs; a++)
+        {
+            rec.arg[a] = (uint32_t)rand() ^ (uint32_t)rand() << 16;
+        }
+
+        size_t len = blog_encode_line(&rec, line, sizeof(line));
+        CHECK(len == strlen(line) && line[len - 1] == '\n');
+        CHECK(blog_decode_line(line, &out));
+        CHECK(memcmp(&rec, &out, sizeof(rec)) == 0);
+
+        // the monitor may glue text in front of a line
+        snprintf(prefixed, sizeof(prefixed), "\x1b[0m%s", line);
+        CHECK(blog_decode_line(prefixed, &out));
+        CHECK(memcmp(&rec, &out, sizeof(rec)) == 0);
+
+        // a line cut short by a UART drop is rejected, not misread
+        line[len - 3] = '\0';
+        CHECK(!blog_decode_line(line, &out));
+    }
+
+    CHECK(!blog_decode_line("I (123) nimble: setting ble device\n", &out));
+    CHECK(!blog_decode_line("@B01000000zz\n", &out));
+    CHECK(blog_encode_line(&out, line, BLOG_LINE_MAX - 1) == 0);
+}
+
+static blog_ring_t ring;
+
+static void test_wrap(void)
+{
+    const uint32_t total = 3 * CONFIG_BLOG_RING_LEN + 5;
+    uint32_t cursor = 0, lost = 0, read = 0;
+    blog_rec_t rec;
+
+    memset(&ring, 0, sizeof(ring));
+    for (uint32_t i = 0; i < total; i++)
+    {
+        blog_write(&ring, BLOG_CPI, i * 10, 0, (const uint32_t[]){i, ~i}, 2);
+    }
+    while (blog_read(&ring, &cursor, &rec, &lost))
+    {
+        uint32_t i = total - CONFIG_BLOG_RING_LEN + read;
+        CHECK(rec.seq == i + 1 && rec.t_us == i * 10 && rec.arg[0] == i && rec.arg[1] == ~i && rec.nargs == 2);
+        read++;
+    }
+    CHECK(read == CONFIG_BLOG_RING_LEN);
+    CHECK(lost == total - CONFIG_BLOG_RING_LEN);
+    CHECK(cursor == total);
+
+    // caught up: nothing more until the next write, which comes out alone
+    CHECK(!blog_read(&ring, &cursor, &rec, &lost));
+    blog_write(&ring, BLOG_HID_START, 0, 1, NULL, 0);
+    CHECK(blog_read(&ring, &cursor, &rec, &lost) && rec.id == BLOG_HID_START && rec.nargs == 0 && rec.core == 1);
+    CHECK(!blog_read(&ring, &cursor, &rec, &lost));
+
+    // a claimed but unpublished slot holds the reader back instead of being skipped
+    uint32_t head = ring.head;
+    ring.head++;
+    ring.rec[head & (CONFIG_BLOG_RING_LEN - 1)].seq = 0;
+    CHECK(!blog_read(&ring, &cursor, &rec, &lost) && cursor == head);
+    ring.rec[head & (CONFIG_BLOG_RING_LEN - 1)].seq = head + 1;
+    CHECK(blog_read(&ring, &cursor, &rec, &lost) && cursor == head + 1);
+}
+
+#define WRITERS 2
+#define PER_WRITER 2000000
+
+static volatile int writers_done;
+
+static void *writer(void *arg)
+{
+    uint32_t core = (uint32_t)(uintptr_t)arg;
+
+    for (uint32_t i = 0; i < PER_WRITER; i++)
+    {
+        // the third and fourth words are functions of the first two, so a torn copy shows
+        uint32_t a[BLOG_ARGS_MAX] = {core, i, i * 2654435761u ^ core, ~i};
+        blog_write(&ring, BLOG_HID_DATA, i, (uint8_t)core, a, BLOG_ARGS_MAX);
+        if (i % 97 == 0)
+        {
+            sched_yield(); // let the reader in, even on one CPU
+        }
+    }
+    __atomic_fetch_add(&writers_done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+static void test_race(void)
+{
+    pthread_t tid[WRITERS];
+    uint32_t cursor = 0, lost = 0, read = 0, torn = 0;
+    uint32_t last[WRITERS] = {0};
+    int order = 1;
+    blog_rec_t rec;
+
+    memset(&ring, 0, sizeof(ring));
+    for (uintptr_t i = 0; i < WRITERS; i++)
+    {
+        pthread_create(&tid[i], NULL, writer, (void *)i);
+    }
+
+    for (;;)
+    {
+        int done = __atomic_load_n(&writers_done, __ATOMIC_ACQUIRE) == WRITERS;
+        while (blog_read(&ring, &cursor, &rec, &lost))
+        {
+            uint32_t core = rec.arg[0], i = rec.arg[1];
+            if (core >= WRITERS || rec.core != core || rec.t_us != i || rec.arg[2] != (i * 2654435761u ^ core) ||
+                rec.arg[3] != ~i || rec.nargs != BLOG_ARGS_MAX)
+            {
+                torn++;
+                continue;
+            }
+            // per writer, records come out in the order they went in
+            if (read > 0 && last[core] != 0 && i <= last[core])
+            {
+                order = 0;
+            }
+            last[core] = i;
+            read++;
+        }
+        if (done)
+        {
+            break;
+        }
+        sched_yield();
+    }
+    for (int i = 0; i < WRITERS; i++)
+    {
+        pthread_join(tid[i], NULL);
+    }
+
+    printf("race: %u written, %lu read, %lu lost, %lu torn\n", WRITERS * PER_WRITER, (unsigned long)read,
+           (unsigned long)lost, (unsigned long)torn);
+    CHECK(torn == 0);
+    CHECK(order);
+    CHECK(read + lost == WRITERS * PER_WRITER);
+}
+
+static int selftest(void)
+{
+    test_formats();
+    test_lines();
+    test_wrap();
+    test_race();
+    printf("%s (%d failed checks)\n", failures ? "FAIL" : "ok", failures);
+    return failures ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "--selftest") == 0)
+    {
+        return selftest();
+    }
+    if (argc > 1)
+    {
+        FILE *in = fopen(argv[1], "r");
+        if (in == NULL)
+        {
+            perror(argv[1]);
+            return 1;
+        }
+        int rc = decode(in);
+        fclose(in);
+        return rc;
+    }
+    return decode(stdin);
+}
@@ -0,0 +1,295 @@
+/*
+ * Host recorder for the raw capture stream (capture.h frames).
+ *
+ *   cc -O2 -I. tools/capture_rec.c capture.c -o capture_rec
+ *   ./capture_rec [-b baud] [-r raw.csv] [-s seconds] /dev/ttyUSB1 trace.txt
+ *
+ * Start streaming with config command 0x26 (on = 1) first. The input may be
+ * a serial port, set to raw at the given baud (default 2000000), or a file
+ * of bytes captured some other way ("-" for stdin).
+ *
+ * trace.txt gets the deltas that passed the surface gate in 1 ms bins, one
+ * "dx dy" pair per line: the trace format predict_sim and friends replay.
+ * Pauses longer than IDLE_MAX_MS are shortened to that. -r writes every
+ * frame with its raw burst fields as CSV. A summary goes to stderr at the
+ * end: frames, frames lost (sequence gaps, device drops and line errors
+ * alike), CRC errors and bytes skipped while resyncing.
+ *
+ * Runs until end of input, -s seconds of device time, or Ctrl-C.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "capture.h"
+
+#define IDLE_MAX_MS 250
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+
+static speed_t baud_flag(long baud)
+{
+    switch (baud)
+    {
+    case 115200:
+        return B115200;
+    case 230400:
+        return B230400;
+    case 460800:
+        return B460800;
+    case 921600:
+        return B921600;
+    case 1000000:
+        return B1000000;
+    case 1500000:
+        return B1500000;
+    case 2000000:
+        return B2000000;
+    case 3000000:
+        return B3000000;
+    default:
+        return 0;
+    }
+}
+
+static int open_input(const char *path, long baud)
+{
+    if (strcmp(path, "-") == 0)
+    {
+        return STDIN_FILENO;
+    }
+
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0)
+    {
+        perror(path);
+        return -1;
+    }
+    if (!isatty(fd))
+    {
+        return fd;
+    }
+
+    struct termios tio;
+    speed_t speed = baud_flag(baud);
+    if (speed == 0 || tcgetattr(fd, &tio) != 0)
+    {
+        fprintf(stderr, "%s: cannot set %ld baud\n", path, baud);
+        close(fd);
+        return -1;
+    }
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, speed);
+    cfsetospeed(&tio, speed);
+    tio.c_cc[VMIN] = 1;
+    tio.c_cc[VTIME] = 0;
+    if (tcsetattr(fd, TCSANOW, &tio) != 0)
+    {
+        perror(path);
+        close(fd);
+        return -1;
+    }
+    tcflush(fd, TCIFLUSH);
+    return fd;
+}
+
+typedef struct
+{
+    FILE *out;
+    bool started;
+    uint32_t last_us;
+    uint64_t bin_us;  // device time of the open bin's start
+    uint64_t now_us;  // device time of the last frame, wraps of t_us unrolled
+    uint64_t lines;
+    int32_t dx, dy;
+} trace_t;
+
+static void trace_frame(trace_t *t, const capture_frame_t *f, bool after_loss)
+{
+    if (!t->started)
+    {
+        t->started = true;
+        t->last_us = f->t_us;
+        t->bin_us = 0;
+        t->now_us = 0;
+    }
+    t->now_us += (uint32_t)(f->t_us - t->last_us);
+    t->last_us = f->t_us;
+
+    // close the bins up to this frame, a long pause counts as IDLE_MAX_MS of rest;
+    // a gap from lost frames keeps its length, motion or not
+    if (!after_loss && t->now_us - t->bin_us >= (uint64_t)(IDLE_MAX_MS + 1) * 1000)
+    {
+        fprintf(t->out, "%d %d\n", t->dx, t->dy);
+        t->dx = t->dy = 0;
+        for (int i = 1; i < IDLE_MAX_MS; i++)
+        {
+            fputs("0 0\n", t->out);
+        }
+        t->lines += IDLE_MAX_MS;
+        t->bin_us = t->now_us - t->now_us % 1000;
+    }
+    while (t->now_us - t->bin_us >= 1000)
+    {
+        fprintf(t->out, "%d %d\n", t->dx, t->dy);
+        t->dx = t->dy = 0;
+        t->bin_us += 1000;
+        t->lines++;
+    }
+    t->dx += f->dx;
+    t->dy += f->dy;
+}
+
+static void trace_close(trace_t *t)
+{
+    if (t->started)
+    {
+        fprintf(t->out, "%d %d\n", t->dx, t->dy);
+        t->lines++;
+    }
+}
+
+static void raw_frame(FILE *raw, const capture_frame_t *f)
+{
+    const uint8_t *b = f->raw;
+    fprintf(raw, "%u,%lu,%u,%d,%d,0x%02x,0x%02x,%d,%d,%u,%u,%u,%u,%u\n", f->seq, (unsigned long)f->t_us, f->flags,
+            f->dx, f->dy, b[0], b[1], (int16_t)(b[2] | b[3] << 8), (int16_t)(b[4] | b[5] << 8), b[6], b[7], b[8], b[9],
+            (unsigned)(b[10] << 8 | b[11]));
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: capture_rec [-b baud] [-r raw.csv] [-s seconds] <port|file|-> <trace.txt>\n");
+}
+
+int main(int argc, char **argv)
+{
+    long baud = 2000000;
+    double seconds = 0;
+    const char *raw_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:r:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            baud = strtol(optarg, NULL, 10);
+            break;
+        case 'r':
+            raw_path = optarg;
+            break;
+        case 's':
+            seconds = strtod(optarg, NULL);
+            break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (argc - optind != 2)
+    {
+        usage();
+        return 2;
+    }
+
+    int fd = open_input(argv[optind], baud);
+    if (fd < 0)
+    {
+        return 1;
+    }
+    trace_t trace = {.out = fopen(argv[optind + 1], "w")};
+    if (trace.out == NULL)
+    {
+        perror(argv[optind + 1]);
+        return 1;
+    }
+    FILE *raw = NULL;
+    if (raw_path)
+    {
+        raw = fopen(raw_path, "w");
+        if (raw == NULL)
+        {
+            perror(raw_path);
+            return 1;
+        }
+        fprintf(raw, "seq,t_us,flags,dx,dy,motion,observation,raw_dx,raw_dy,squal,raw_sum,raw_max,raw_min,shutter\n");
+    }
+
+    struct sigaction sa = {.sa_handler = on_signal};
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    capture_decoder_t dec = {0};
+    capture_frame_t f;
+    uint8_t buf[4096];
+    uint64_t frames = 0, lost = 0, gated = 0;
+    uint16_t next_seq = 0;
+
+    while (!stop)
+    {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0)
+        {
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        for (ssize_t i = 0; i < n && !stop; i++)
+        {
+            if (!capture_decode(&dec, buf[i], &f))
+            {
+                continue;
+            }
+            uint16_t gap = frames > 0 ? (uint16_t)(f.seq - next_seq) : 0;
+            lost += gap;
+            next_seq = (uint16_t)(f.seq + 1);
+            frames++;
+            if (!(f.flags & CAPTURE_FLAG_PASS))
+            {
+                gated++;
+            }
+
+            trace_frame(&trace, &f, gap != 0);
+            if (raw)
+            {
+                raw_frame(raw, &f);
+            }
+            if (seconds > 0 && trace.now_us >= seconds * 1e6)
+            {
+                stop = 1;
+            }
+        }
+    }
+    trace_close(&trace);
+
+    double span = trace.now_us / 1e6;
+    fprintf(stderr, "%llu frames in %.3f s (%.0f/s), %llu lost, %llu gated, %lu bad crc, %lu bytes skipped\n",
+            (unsigned long long)frames, span, span > 0 ? frames / span : 0.0, (unsigned long long)lost,
+            (unsigned long long)gated, (unsigned long)dec.bad_crc, (unsigned long)dec.skipped);
+    fprintf(stderr, "%s: %llu lines of 1 ms\n", argv[optind + 1], (unsigned long long)trace.lines);
+
+    fclose(trace.out);
+    if (raw)
+    {
+        fclose(raw);
+    }
+    if (fd != STDIN_FILENO)
+    {
+        close(fd);
+    }
+    return 0;
+}
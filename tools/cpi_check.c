@@ -0,0 +1,215 @@
+/*
+ * Host check of cpi.c: every CPI step through the PAW3395 resolution
+ * registers and back, and the stage table rules.
+ *
+ *   cc -I. tools/cpi_check.c cpi.c spi_fake.c spi_transport.c -o cpi_check && ./cpi_check
+ *
+ * cpi_program(), the sequence paw3395_set_cpi() runs, writes into the
+ * register file of spi_fake.c and the result is read back from it. Exits
+ * non-zero if a value does not survive the round trip, MOTION_CTRL does not
+ * select per-axis resolution exactly when X and Y differ, or a stored table
+ * sanitizes into something the firmware cannot run.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpi.h"
+#include "spi_fake.h"
+
+static int failures;
+
+#define CHECK(cond, ...)                  \
+    do                                    \
+    {                                     \
+        if (!(cond))                      \
+        {                                 \
+            printf("FAIL: " __VA_ARGS__); \
+            printf("\n");                 \
+            failures++;                   \
+            return;                       \
+        }                                 \
+    } while (0)
+
+static spi_fake_t bus;
+static spi_transport_t spi;
+
+static unsigned gaps;
+
+static void count_gap(void)
+{
+    gaps++;
+}
+
+// clears the latch first so a sequence that stops short shows
+static int set_cpi(uint16_t x, uint16_t y)
+{
+    bus.regs[SET_RESOLUTION] = 0;
+    return cpi_program(&spi, x, y, count_gap);
+}
+
+static uint16_t get_cpi(uint8_t reg_low)
+{
+    uint8_t low, high;
+
+    spi.read(spi.ctx, reg_low, &low, 1);
+    spi.read(spi.ctx, reg_low + 1, &high, 1);
+    return cpi_decode(low, high);
+}
+
+// every legal step, X and Y set to different values so a swapped register shows
+static void check_steps(void)
+{
+    unsigned steps = 0;
+
+    for (uint32_t cpi = CPI_MIN; cpi <= CPI_MAX; cpi += CPI_STEP, steps++)
+    {
+        uint16_t other = (uint16_t)(CPI_MAX + CPI_MIN - cpi);
+        uint8_t low, high;
+
+        CHECK(cpi_clamp((uint16_t)cpi) == cpi, "step %u not a fixed point of cpi_clamp", (unsigned)cpi);
+        cpi_encode((uint16_t)cpi, &low, &high);
+        CHECK((high & ~0x0F) == 0, "%u sets reserved RESOLUTION_HIGH bits: 0x%02x", (unsigned)cpi, high);
+        uint32_t reg = (uint32_t)(high << 8 | low);
+        CHECK((reg + 1) * CPI_STEP == cpi, "%u encodes as 0x%x", (unsigned)cpi, (unsigned)reg);
+
+        CHECK(set_cpi((uint16_t)cpi, other) == SPI_TRANSPORT_OK, "program %u failed", (unsigned)cpi);
+        CHECK(bus.regs[SET_RESOLUTION] == 0x01, "SET_RESOLUTION not written");
+        CHECK(get_cpi(RESOLUTION_X_LOW) == cpi, "X %u reads back as %u", (unsigned)cpi, get_cpi(RESOLUTION_X_LOW));
+        CHECK(get_cpi(RESOLUTION_Y_LOW) == other, "Y %u reads back as %u", other, get_cpi(RESOLUTION_Y_LOW));
+        CHECK(bus.regs[MOTION_CTRL] == (cpi == other ? 0 : MOTION_CTRL_RES_XY_SEL), "%u/%u MOTION_CTRL 0x%02x",
+              (unsigned)cpi, other, bus.regs[MOTION_CTRL]);
+    }
+    CHECK(steps == (CPI_MAX - CPI_MIN) / CPI_STEP + 1, "%u steps", steps);
+}
+
+// RES_XY_SEL follows whether the axes differ, in both directions
+static void check_motion_ctrl(void)
+{
+    unsigned writes = bus.writes;
+
+    gaps = 0;
+    CHECK(set_cpi(800, 1600) == SPI_TRANSPORT_OK, "program 800/1600");
+    CHECK(bus.regs[MOTION_CTRL] == MOTION_CTRL_RES_XY_SEL, "800/1600 MOTION_CTRL 0x%02x", bus.regs[MOTION_CTRL]);
+    CHECK(bus.regs[0x7F] == 0x00, "left bank 0x%02x", bus.regs[0x7F]);
+    CHECK(bus.writes - writes == 7 && gaps == 7, "%u writes %u gaps", bus.writes - writes, gaps);
+
+    CHECK(set_cpi(1600, 1600) == SPI_TRANSPORT_OK, "program 1600/1600");
+    CHECK(bus.regs[MOTION_CTRL] == 0x00, "equal axes MOTION_CTRL 0x%02x", bus.regs[MOTION_CTRL]);
+    CHECK(get_cpi(RESOLUTION_X_LOW) == 1600, "X %u", get_cpi(RESOLUTION_X_LOW));
+
+    // values equal only after clamping count as equal
+    CHECK(set_cpi(1610, 1590) == SPI_TRANSPORT_OK, "program 1610/1590");
+    CHECK(bus.regs[MOTION_CTRL] == 0x00, "1610/1590 MOTION_CTRL 0x%02x", bus.regs[MOTION_CTRL]);
+
+    // a failed frame stops the sequence before the latch
+    bus.fail_frames = 1;
+    CHECK(set_cpi(400, 800) == SPI_TRANSPORT_ERR_IO, "failed write not reported");
+    CHECK(bus.regs[SET_RESOLUTION] == 0, "latched after a failed write");
+}
+
+// values off the grid round to the nearest step, out of range clamps
+static void check_clamp(void)
+{
+    CHECK(cpi_clamp(0) == CPI_MIN, "0 -> %u", cpi_clamp(0));
+    CHECK(cpi_clamp(CPI_MIN - 1) == CPI_MIN, "below min");
+    CHECK(cpi_clamp(74) == 50 && cpi_clamp(75) == 100, "rounding at half a step");
+    CHECK(cpi_clamp(1624) == 1600 && cpi_clamp(1625) == 1650, "rounding 1624/1625");
+    CHECK(cpi_clamp(CPI_MAX + 1) == CPI_MAX && cpi_clamp(UINT16_MAX) == CPI_MAX, "above max");
+
+    // the 4 reserved bits of RESOLUTION_HIGH are ignored on decode
+    CHECK(cpi_decode(0xFF, 0xFF) == cpi_decode(0xFF, 0x0F), "reserved bits decoded");
+}
+
+static void check_stages(void)
+{
+    cpi_stages_t s;
+
+    cpi_stages_default(&s);
+    CHECK(s.count >= 1 && s.count <= CPI_STAGES_MAX && s.current < s.count, "default count %u current %u", s.count,
+          s.current);
+    for (uint8_t i = 0; i < CPI_STAGES_MAX; i++)
+    {
+        CHECK(s.stage[i].x >= CPI_MIN && s.stage[i].y >= CPI_MIN, "default stage %u unset", i);
+        CHECK(cpi_clamp(s.stage[i].x) == s.stage[i].x, "default stage %u off the grid", i);
+    }
+
+    // raising the count onto a stage nobody set still gives a usable CPI
+    cpi_stages_default(&s);
+    CHECK(cpi_stages_set(&s, 0, 400, 400, CPI_STAGES_MAX), "raise count");
+    CHECK(cpi_stages_select(&s, CPI_STAGES_MAX - 1), "select last stage");
+    CHECK(cpi_stages_current(&s).x >= CPI_MIN, "last stage is %u CPI", cpi_stages_current(&s).x);
+
+    CHECK(!cpi_stages_set(&s, CPI_STAGES_MAX, 400, 400, CPI_STAGES_MAX), "index past the table");
+    CHECK(!cpi_stages_set(&s, 2, 400, 400, 2), "index past count");
+    CHECK(!cpi_stages_set(&s, 0, 400, 400, 0), "count 0");
+    CHECK(!cpi_stages_select(&s, CPI_STAGES_MAX), "select past count");
+
+    // lowering count pulls current back in range
+    cpi_stages_select(&s, 4);
+    CHECK(cpi_stages_set(&s, 0, 400, 400, 2) && s.current == 1, "current %u after count 2", s.current);
+
+    // next wraps within count
+    cpi_stages_next(&s);
+    CHECK(s.current == 0, "next from the last stage gave %u", s.current);
+}
+
+// tables as they come out of storage
+static void check_sanitize(void)
+{
+    cpi_stages_t s, def;
+
+    cpi_stages_default(&def);
+
+    // unused stages left at 0 by older firmware
+    memset(&s, 0, sizeof(s));
+    s.count = 2;
+    s.stage[0] = (cpi_xy_t){800, 800};
+    s.stage[1] = (cpi_xy_t){1637, 30000};
+    cpi_stages_sanitize(&s);
+    CHECK(s.count == 2 && s.stage[0].x == 800, "used stage changed");
+    CHECK(s.stage[1].x == 1650 && s.stage[1].y == CPI_MAX, "stage 1 %u,%u", s.stage[1].x, s.stage[1].y);
+    for (uint8_t i = 2; i < CPI_STAGES_MAX; i++)
+    {
+        CHECK(s.stage[i].x == def.stage[i].x && s.stage[i].y == def.stage[i].y, "unset stage %u is %u,%u", i,
+              s.stage[i].x, s.stage[i].y);
+    }
+
+    // current out of range
+    s.current = 7;
+    cpi_stages_sanitize(&s);
+    CHECK(s.current == 0, "current %u", s.current);
+
+    // a count the table cannot hold falls back to the defaults
+    s.count = CPI_STAGES_MAX + 1;
+    cpi_stages_sanitize(&s);
+    CHECK(memcmp(&s, &def, sizeof(s)) == 0, "bad count not reset");
+    s.count = 0;
+    cpi_stages_sanitize(&s);
+    CHECK(memcmp(&s, &def, sizeof(s)) == 0, "count 0 not reset");
+
+    // every stage survives the register round trip after sanitizing
+    for (uint8_t i = 0; i < CPI_STAGES_MAX; i++)
+    {
+        CHECK(set_cpi(s.stage[i].x, s.stage[i].y) == SPI_TRANSPORT_OK, "program stage %u", i);
+        CHECK(get_cpi(RESOLUTION_X_LOW) == s.stage[i].x && get_cpi(RESOLUTION_Y_LOW) == s.stage[i].y,
+              "stage %u does not round trip", i);
+    }
+}
+
+int main(void)
+{
+    spi_transport_config_t cfg = {.clock_hz = 10000000, .flags = SPI_TRANSPORT_HW_CS};
+
+    spi_fake_init(&bus, &cfg);
+    spi = spi_fake_transport(&bus);
+
+    check_steps();
+    check_motion_ctrl();
+    check_clamp();
+    check_stages();
+    check_sanitize();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,199 @@
+/*
+ * Host benchmark of motion_filter.c: cost per sample and what each chain does to motion.
+ *
+ *   cc -O2 -I. tools/filter_bench.c motion_filter.c -lm -o filter_bench && ./filter_bench
+ *
+ * Samples come every SAMPLE_US as from move_loop_task. For each chain:
+ *   ns/sample  host time per motion_filter_apply() call
+ *   leak       counts that got through from a sensor at rest with +-1 jitter
+ *   lag        delay of the filtered path behind the clean one on noisy
+ *              strokes, the best fitting shift (ms)
+ *   error      RMS distance from the clean path after that shift (counts)
+ *   lost       counts missing at the end of all strokes after the flush
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "motion_filter.h"
+
+#define SAMPLE_US 5000
+#define STROKE_SAMPLES 4000
+#define SHIFT_MAX 8 // samples
+#define BENCH_SAMPLES 2000000
+
+typedef struct
+{
+    const char *name;
+    uint8_t stages;
+} chain_t;
+
+static const chain_t chains[] = {
+    {"off", 0},
+    {"deadzone", MOTION_FILTER_DEADZONE},
+    {"average", MOTION_FILTER_AVERAGE},
+    {"1 euro", MOTION_FILTER_ONE_EURO},
+    {"dz+1 euro", MOTION_FILTER_DEADZONE | MOTION_FILTER_ONE_EURO},
+    {"all", MOTION_FILTER_DEADZONE | MOTION_FILTER_AVERAGE | MOTION_FILTER_ONE_EURO},
+};
+
+static int16_t stroke_x[STROKE_SAMPLES], stroke_y[STROKE_SAMPLES];
+static double clean_x[STROKE_SAMPLES], clean_y[STROKE_SAMPLES];
+static double out_x[STROKE_SAMPLES], out_y[STROKE_SAMPLES];
+static bool stroke_end[STROKE_SAMPLES];
+
+static int jitter(void)
+{
+    int r = rand() % 10;
+    return r == 0 ? -1 : r == 1 ? 1 : 0;
+}
+
+// strokes of 0.2..8 counts/ms in varied directions with +-1 count sensor noise
+static void gen_strokes(void)
+{
+    double fx = 0, fy = 0, nx_prev = 0, ny_prev = 0;
+    int len = 0, k = 0, n = 0;
+
+    for (int i = 0; i < STROKE_SAMPLES; i++, k++)
+    {
+        if (k >= len)
+        {
+            k = 0;
+            len = 20 + (n * 37) % 80;
+            n++;
+        }
+        double peak = (0.2 + (n * 3) % 8) * SAMPLE_US / 1000.0;
+        double v = peak * sin(M_PI * k / len);
+        double a = n * 2.3;
+        fx += v * cos(a);
+        fy += v * sin(a);
+        clean_x[i] = fx;
+        clean_y[i] = fy;
+        // noise on the position, so the deltas carry it as jitter
+        double nx = round(fx) + jitter();
+        double ny = round(fy) + jitter();
+        stroke_x[i] = (int16_t)(nx - nx_prev);
+        stroke_y[i] = (int16_t)(ny - ny_prev);
+        nx_prev = nx;
+        ny_prev = ny;
+        stroke_end[i] = k == len - 1;
+    }
+}
+
+static void setup(motion_filter_t *f, uint8_t stages)
+{
+    motion_filter_params_t p;
+    motion_filter_default_params(&p);
+    p.stages = stages;
+    motion_filter_configure(f, &p);
+}
+
+static double bench(uint8_t stages)
+{
+    static int16_t in[1024][2];
+    motion_filter_t f;
+    struct timespec t0, t1;
+    volatile int32_t sink = 0;
+
+    for (int i = 0; i < 1024; i++)
+    {
+        in[i][0] = stroke_x[i];
+        in[i][1] = stroke_y[i];
+    }
+    setup(&f, stages);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        int16_t x = in[i & 1023][0], y = in[i & 1023][1];
+        motion_filter_apply(&f, &x, &y, SAMPLE_US);
+        sink += x + y;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / BENCH_SAMPLES;
+}
+
+static long leak(uint8_t stages)
+{
+    motion_filter_t f;
+    long total = 0;
+
+    setup(&f, stages);
+    srand(1);
+    // bursts of jitter as the motion pin would report them, a flush after each
+    for (int burst = 0; burst < 200; burst++)
+    {
+        int16_t x, y;
+        for (int i = 0; i < 10; i++)
+        {
+            x = (int16_t)jitter();
+            y = (int16_t)jitter();
+            motion_filter_apply(&f, &x, &y, SAMPLE_US);
+            total += labs(x) + labs(y);
+        }
+        motion_filter_flush(&f, &x, &y);
+        total += labs(x) + labs(y);
+    }
+    return total;
+}
+
+static void quality(uint8_t stages, int *lag_ms, double *err, double *lost)
+{
+    motion_filter_t f;
+    double hx = 0, hy = 0;
+
+    setup(&f, stages);
+    for (int i = 0; i < STROKE_SAMPLES; i++)
+    {
+        int16_t x = stroke_x[i], y = stroke_y[i];
+        motion_filter_apply(&f, &x, &y, SAMPLE_US);
+        hx += x;
+        hy += y;
+        if ((stroke_end[i] || i == STROKE_SAMPLES - 1) && motion_filter_flush(&f, &x, &y))
+        {
+            hx += x;
+            hy += y;
+        }
+        out_x[i] = hx;
+        out_y[i] = hy;
+    }
+
+    double best = INFINITY;
+    for (int shift = 0; shift <= SHIFT_MAX; shift++)
+    {
+        double err2 = 0;
+        for (int i = SHIFT_MAX; i < STROKE_SAMPLES; i++)
+        {
+            double ex = out_x[i] - clean_x[i - shift];
+            double ey = out_y[i] - clean_y[i - shift];
+            err2 += ex * ex + ey * ey;
+        }
+        if (err2 < best)
+        {
+            best = err2;
+            *lag_ms = shift * SAMPLE_US / 1000;
+        }
+    }
+    *err = sqrt(best / (STROKE_SAMPLES - SHIFT_MAX));
+    *lost = hypot(clean_x[STROKE_SAMPLES - 1] - out_x[STROKE_SAMPLES - 1],
+                  clean_y[STROKE_SAMPLES - 1] - out_y[STROKE_SAMPLES - 1]);
+}
+
+int main(void)
+{
+    srand(1);
+    gen_strokes();
+
+    printf("%-10s %10s %6s %6s %7s %6s\n", "chain", "ns/sample", "leak", "lag", "error", "lost");
+    for (size_t i = 0; i < sizeof(chains) / sizeof(chains[0]); i++)
+    {
+        int lag_ms = 0;
+        double err = 0, lost = 0;
+        quality(chains[i].stages, &lag_ms, &err, &lost);
+        printf("%-10s %10.1f %6ld %6d %7.2f %6.1f\n", chains[i].name, bench(chains[i].stages), leak(chains[i].stages),
+               lag_ms, err, lost);
+    }
+    return 0;
+}
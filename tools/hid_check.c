@@ -0,0 +1,90 @@
+/*
+ * Host check of the HID report map and the generated packer.
+ *
+ *   cc -I. tools/hid_check.c hid_desc.c mouse_hid.c -o hid_check && ./hid_check
+ *
+ * Add -DCONFIG_MOUSE_HID_XY_BITS=12 / -DCONFIG_MOUSE_HID_PAN=1 to check other
+ * report layouts. Exits non-zero if the descriptor is invalid or does not
+ * decode what mouse_hid_pack() encodes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "config_proto.h"
+#include "hid_desc.h"
+#include "mouse_hid.h"
+
+static int failures;
+
+#define CHECK(cond, ...)                  \
+    do                                    \
+    {                                     \
+        if (!(cond))                      \
+        {                                 \
+            printf("FAIL: " __VA_ARGS__); \
+            printf("\n");                 \
+            failures++;                   \
+        }                                 \
+    } while (0)
+
+static int32_t get(const hid_layout_t *l, const uint8_t *rpt, uint16_t page, uint16_t usage)
+{
+    unsigned index;
+    const hid_field_t *f = hid_layout_find(l, MOUSE_HID_REPORT_ID, HID_REPORT_INPUT, page, usage, &index);
+
+    CHECK(f != NULL, "no field for page %04x usage %04x", page, usage);
+    return f ? hid_field_get(f, rpt, index) : 0;
+}
+
+static void roundtrip(const hid_layout_t *l, uint32_t buttons, int32_t x, int32_t y, int32_t wheel)
+{
+    mouse_hid_report_t r = {.buttons = buttons, .x = x, .y = y, .wheel = wheel};
+    uint8_t rpt[MOUSE_HID_REPORT_LEN];
+    int32_t x_exp = x > MOUSE_HID_XY_MAX ? MOUSE_HID_XY_MAX : x < -MOUSE_HID_XY_MAX ? -MOUSE_HID_XY_MAX : x;
+    int32_t y_exp = y > MOUSE_HID_XY_MAX ? MOUSE_HID_XY_MAX : y < -MOUSE_HID_XY_MAX ? -MOUSE_HID_XY_MAX : y;
+
+    mouse_hid_pack(&r, rpt);
+
+    for (uint16_t b = 1; b <= 5; b++)
+    {
+        CHECK(get(l, rpt, HID_PAGE_BUTTON, b) == (int32_t)((buttons >> (b - 1)) & 1), "button %u", b);
+    }
+    CHECK(get(l, rpt, HID_PAGE_DESKTOP, HID_USAGE_X) == x_exp, "x %ld", (long)x);
+    CHECK(get(l, rpt, HID_PAGE_DESKTOP, HID_USAGE_Y) == y_exp, "y %ld", (long)y);
+    CHECK(get(l, rpt, HID_PAGE_DESKTOP, HID_USAGE_WHEEL) == wheel, "wheel %ld", (long)wheel);
+}
+
+int main(void)
+{
+    static hid_layout_t l;
+    hid_desc_err_t err = hid_desc_parse(mouse_hid_report_map, mouse_hid_report_map_len, &l);
+
+    if (err != HID_DESC_OK)
+    {
+        printf("FAIL: report map invalid at byte %zu: %s\n", l.err_offset, hid_desc_err_str(err));
+        return 1;
+    }
+
+    for (size_t i = 0; i < l.n_fields; i++)
+    {
+        const hid_field_t *f = &l.fields[i];
+        printf("id %u type %u bit %3u %2ux%-2u page %04x usage %04x..%04x [%ld, %ld]\n", f->report_id, f->type,
+               f->bit_offset, f->size, f->count, f->usage_page, f->usage, f->usage_max, (long)f->logical_min,
+               (long)f->logical_max);
+    }
+
+    CHECK(hid_layout_report_len(&l, MOUSE_HID_REPORT_ID, HID_REPORT_INPUT) == MOUSE_HID_REPORT_LEN,
+          "mouse input report length");
+    CHECK(hid_layout_report_len(&l, CONFIG_REPORT_ID, HID_REPORT_FEATURE) == CONFIG_REPORT_LEN,
+          "config feature report length");
+    CHECK(hid_layout_report_len(&l, CONFIG_REPORT_ID, HID_REPORT_OUTPUT) == CONFIG_REPORT_LEN,
+          "config output report length");
+
+    roundtrip(&l, 0x00, 0, 0, 0);
+    roundtrip(&l, 0x15, 1, -1, 1);
+    roundtrip(&l, 0x1F, MOUSE_HID_XY_MAX, -MOUSE_HID_XY_MAX, -127);
+    roundtrip(&l, 0x0A, 30000, -30000, 127); // clamped by the packer
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,421 @@
+/*
+ * Fuzz harness for the button, wheel and DPI switch path: timed GPIO edges
+ * through input_ring into input_capture.c, consumed the way main.c's
+ * input_loop_task does it.
+ *
+ *   libFuzzer  clang -g -O1 -fsanitize=fuzzer,address,undefined -DINPUT_FUZZ_LIBFUZZER -I. \
+ *                  tools/input_fuzz.c input_capture.c -o input_fuzz
+ *              ./input_fuzz corpus/
+ *   AFL++      afl-clang-fast -O2 -I. tools/input_fuzz.c input_capture.c -o input_fuzz
+ *              afl-fuzz -i seeds -o findings ./input_fuzz
+ *   plain      cc -O2 -I. tools/input_fuzz.c input_capture.c -o input_fuzz
+ *              ./input_fuzz [file...]     run inputs (stdin with no files)
+ *              ./input_fuzz -b [seconds]  random inputs, decoded events per second
+ *
+ * Input: a 6 byte header, then 2 byte ops.
+ *   header  click debounce us (u16 LE), scroll debounce us (u16 LE),
+ *           consumer wake-up latency (x 8 us), cycle counter start (<< 24)
+ *   op      [line | flags] [dt]: after dt * dt us (up to 65 ms), line 0..5
+ *           (left, right, middle, DPI, encoder A, encoder B) toggles; line 6
+ *           keeps the consumer off the CPU for dt * dt * 4 us; line 7 only
+ *           lets time pass. OP_COALESCE: the edge lands before the ISR of
+ *           the previous one read the pins, so it gets no snapshot of its
+ *           own. Other bits are ignored.
+ *
+ * Checked, abort() on failure:
+ *   - after the lines settle, the buttons the host holds match the pins
+ *   - the decoder's encoder phase matches the lines
+ *   - with no scroll debounce and every edge snapshotted, the host's net
+ *     wheel count is the net quadrature count of the edges
+ *   - wheel steps and DPI presses never outnumber the edges behind them
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "input_capture.h"
+
+/* pins.h and main.c */
+#define PIN_LEFT 26
+#define PIN_RIGHT 33
+#define PIN_MIDDLE 25
+#define PIN_DPI 32
+#define PIN_ENC_A 34
+#define PIN_ENC_B 35
+#define CPU_MHZ 240
+
+#define INPUT_BATCH 16
+#define INPUT_IDLE_US 1000000
+#define INPUT_PENDING_US 5000
+
+#define HEADER_LEN 6
+#define OP_LINE 0x07
+#define OP_COALESCE 0x08
+#define LINE_BLOCK 6
+#define LINE_IDLE 7
+#define SETTLE_US 300000 // longer than any debounce window plus a few consumer wake-ups
+
+static const uint8_t line_gpio[6] = {PIN_LEFT, PIN_RIGHT, PIN_MIDDLE, PIN_DPI, PIN_ENC_A, PIN_ENC_B};
+
+static const input_config_t input_cfg = {
+    .buttons = {{.gpio = PIN_LEFT, .bit = 0}, {.gpio = PIN_RIGHT, .bit = 1}, {.gpio = PIN_MIDDLE, .bit = 2}},
+    .n_buttons = 3,
+    .enc_a = PIN_ENC_A,
+    .enc_b = PIN_ENC_B,
+    .dpi_gpio = PIN_DPI,
+};
+
+typedef struct
+{
+    uint64_t decoded; // button changes, wheel steps and DPI presses handed on
+    uint64_t edges;
+    uint64_t snapshots;
+    uint64_t runs;    // consumer passes
+} totals_t;
+
+static totals_t totals;
+
+typedef struct
+{
+    // the hardware
+    uint64_t pins;
+    uint64_t t_us;
+    uint32_t cycle0;
+    bool unsnapped;       // coalesced edge still waiting for a snapshot
+    bool coalesced;       // an encoder snapshot may hold two edges
+    int64_t quad_net;     // net quadrature count of the edges
+    uint64_t wheel_edges;
+    uint64_t dpi_edges;
+
+    // the firmware
+    input_ring_t ring;
+    input_decoder_t dec;
+    uint16_t click_us, scroll_us;
+    uint32_t latency_us;
+    uint64_t wake_at;     // consumer's next run
+    uint64_t blocked_until;
+    uint32_t overruns_seen;
+
+    // the host
+    uint8_t buttons;
+    int64_t wheel;
+    uint64_t wheel_steps;
+    uint64_t dpi_presses;
+} rig_t;
+
+static uint32_t cycles(const rig_t *r, uint64_t t_us) { return r->cycle0 + (uint32_t)(t_us * CPU_MHZ); }
+
+static bool low(uint64_t pins, uint8_t gpio) { return !((pins >> gpio) & 1); }
+
+static uint8_t enc_lines(uint64_t pins) { return (uint8_t)(((pins >> PIN_ENC_A) & 1) << 1 | ((pins >> PIN_ENC_B) & 1)); }
+
+static void fail(const rig_t *r, const char *what)
+{
+    fprintf(stderr, "input_fuzz: %s at %llu us (click %u us, scroll %u us, pins 0x%llx, host buttons 0x%x, "
+                    "decoder buttons 0x%x, host wheel %lld, quadrature %lld, overruns %lu)\n",
+            what, (unsigned long long)r->t_us, r->click_us, r->scroll_us, (unsigned long long)r->pins, r->buttons,
+            r->dec.buttons, (long long)r->wheel, (long long)r->quad_net, (unsigned long)r->ring.overruns);
+    abort();
+}
+
+/* input_loop_task(), one pass */
+static void consume(rig_t *r)
+{
+    uint32_t per_us = CPU_MHZ;
+    input_snap_t snaps[INPUT_BATCH];
+    input_events_t ev = {0};
+    size_t n;
+
+    input_decoder_set_debounce(&r->dec, r->click_us * per_us, r->scroll_us * per_us);
+    while ((n = input_ring_pop(&r->ring, snaps, INPUT_BATCH)) > 0)
+    {
+        input_decode(&r->dec, snaps, n, &ev);
+    }
+    if (r->ring.overruns != r->overruns_seen)
+    {
+        input_snap_t live = {.pins = r->pins, .cycles = cycles(r, r->t_us)};
+        r->overruns_seen = r->ring.overruns;
+        input_decode(&r->dec, &live, 1, &ev);
+    }
+    input_decoder_tick(&r->dec, cycles(r, r->t_us), &ev);
+    totals.runs++;
+
+    if (ev.buttons_changed)
+    {
+        totals.decoded += (uint64_t)__builtin_popcount(ev.buttons ^ r->buttons);
+        r->buttons = ev.buttons;
+    }
+    r->wheel += ev.vertical;
+    r->wheel_steps += (uint64_t)(ev.vertical < 0 ? -ev.vertical : ev.vertical);
+    r->dpi_presses += ev.dpi_presses;
+    totals.decoded += (uint64_t)(ev.vertical < 0 ? -ev.vertical : ev.vertical) + ev.dpi_presses;
+
+    r->wake_at = r->t_us + (input_decoder_pending(&r->dec) ? INPUT_PENDING_US : INPUT_IDLE_US);
+}
+
+/* move time forward, running the consumer whenever it would have run */
+static void advance(rig_t *r, uint64_t to_us)
+{
+    for (;;)
+    {
+        uint64_t run = r->wake_at > r->blocked_until ? r->wake_at : r->blocked_until;
+        if (run > to_us)
+        {
+            break;
+        }
+        r->t_us = run;
+        consume(r);
+    }
+    r->t_us = to_us;
+}
+
+/* on_input() */
+static void snapshot(rig_t *r)
+{
+    totals.snapshots++;
+    r->unsnapped = false;
+    if (input_ring_push(&r->ring, r->pins, cycles(r, r->t_us)))
+    {
+        // the ring was empty: notify, the task gets the CPU after the latency
+        uint64_t at = r->t_us + r->latency_us;
+        if (at < r->wake_at)
+        {
+            r->wake_at = at;
+        }
+    }
+}
+
+static void edge(rig_t *r, uint8_t line, bool coalesce)
+{
+    uint8_t gpio = line_gpio[line];
+    uint8_t from = enc_lines(r->pins);
+
+    r->pins ^= 1ull << gpio;
+    totals.edges++;
+
+    if (gpio == PIN_ENC_A || gpio == PIN_ENC_B)
+    {
+        // a single line moved, so this is always a valid quadrature step
+        static const int8_t step[16] = {[0x2] = 1, [0xB] = 1, [0xD] = 1, [0x4] = 1,
+                                        [0x1] = -1, [0x7] = -1, [0xE] = -1, [0x8] = -1};
+        r->quad_net += step[from << 2 | enc_lines(r->pins)];
+        r->wheel_edges++;
+        if (coalesce)
+        {
+            r->coalesced = true;
+        }
+    }
+    if (gpio == PIN_DPI && low(r->pins, PIN_DPI))
+    {
+        r->dpi_edges++;
+    }
+
+    // the ISR of a coalesced edge reads the pins later, with the next edge in them
+    if (coalesce)
+    {
+        r->unsnapped = true;
+        return;
+    }
+    snapshot(r);
+}
+
+static void check_settled(rig_t *r)
+{
+    for (uint8_t i = 0; i < input_cfg.n_buttons; i++)
+    {
+        bool down = low(r->pins, input_cfg.buttons[i].gpio);
+        if (down != ((r->buttons >> input_cfg.buttons[i].bit) & 1))
+        {
+            fail(r, "stuck button");
+        }
+    }
+    if (r->dec.enc != enc_lines(r->pins))
+    {
+        fail(r, "encoder phase out of step with the lines");
+    }
+    if (r->scroll_us == 0 && !r->coalesced && r->ring.overruns == 0 && r->wheel != r->quad_net)
+    {
+        fail(r, "net wheel count differs from the quadrature count");
+    }
+}
+
+static void run_input(const uint8_t *data, size_t size)
+{
+    rig_t r;
+
+    if (size < HEADER_LEN)
+    {
+        return;
+    }
+    memset(&r, 0, sizeof(r));
+    r.click_us = (uint16_t)(data[0] | data[1] << 8);
+    r.scroll_us = (uint16_t)(data[2] | data[3] << 8);
+    r.latency_us = data[4] * 8u;
+    r.cycle0 = (uint32_t)data[5] << 24;
+    r.pins = ~0ull; // pulled up, nothing pressed
+    r.wake_at = INPUT_IDLE_US;
+    input_decoder_init(&r.dec, &input_cfg, r.pins);
+
+    for (size_t i = HEADER_LEN; i + 1 < size; i += 2)
+    {
+        uint8_t line = data[i] & OP_LINE;
+        uint64_t dt = (uint64_t)data[i + 1] * data[i + 1];
+
+        advance(&r, r.t_us + dt);
+        if (line == LINE_BLOCK)
+        {
+            uint64_t until = r.t_us + dt * 4;
+            if (until > r.blocked_until)
+            {
+                r.blocked_until = until;
+            }
+        }
+        else if (line != LINE_IDLE)
+        {
+            edge(&r, line, (data[i] & OP_COALESCE) != 0);
+        }
+        if (r.wheel_steps > r.wheel_edges)
+        {
+            fail(&r, "more wheel steps than encoder edges");
+        }
+        if (r.dpi_presses > r.dpi_edges)
+        {
+            fail(&r, "more DPI presses than switch closures");
+        }
+    }
+
+    // the last edge's ISR runs whatever happens after it
+    if (r.unsnapped)
+    {
+        snapshot(&r);
+    }
+    advance(&r, (r.blocked_until > r.t_us ? r.blocked_until : r.t_us) + SETTLE_US);
+    check_settled(&r);
+}
+
+#ifdef INPUT_FUZZ_LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    run_input(data, size);
+    return 0;
+}
+
+#else
+
+static uint8_t *read_all(FILE *f, size_t *len)
+{
+    size_t cap = 4096, n = 0;
+    uint8_t *buf = malloc(cap);
+    size_t got;
+
+    while (buf && (got = fread(buf + n, 1, cap - n, f)) > 0)
+    {
+        n += got;
+        if (n == cap)
+        {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+    }
+    *len = n;
+    return buf;
+}
+
+static uint64_t rng = 0x9E3779B97F4A7C15ull;
+
+static uint8_t rng_byte(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 7;
+    rng ^= rng << 17;
+    return (uint8_t)(rng >> 24);
+}
+
+/* random inputs shaped like use: bursts of bounce on one line, then quiet */
+static size_t random_input(uint8_t *buf, size_t cap)
+{
+    size_t n = HEADER_LEN;
+
+    buf[0] = (uint8_t)(50000 & 0xFF);
+    buf[1] = (uint8_t)(50000 >> 8);
+    buf[2] = (uint8_t)(20000 & 0xFF);
+    buf[3] = (uint8_t)(20000 >> 8);
+    buf[4] = rng_byte() & 0x3F;
+    buf[5] = rng_byte();
+    while (n + 2 <= cap)
+    {
+        uint8_t line = rng_byte() % 6;
+        uint8_t bounces = rng_byte() & 7;
+        for (uint8_t b = 0; b < 2 * bounces + 1 && n + 2 <= cap; b++)
+        {
+            buf[n++] = line | (rng_byte() < 16 ? OP_COALESCE : 0);
+            buf[n++] = b == 0 ? rng_byte() : rng_byte() & 0x0F; // bounce within ~200 us
+        }
+    }
+    return n;
+}
+
+static void bench(double seconds)
+{
+    uint8_t buf[2048];
+    struct timespec t0, t1;
+    double wall = 0;
+    uint64_t inputs = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    while (wall < seconds)
+    {
+        for (int i = 0; i < 64; i++, inputs++)
+        {
+            run_input(buf, random_input(buf, sizeof(buf)));
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        wall = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    }
+    printf("%llu inputs in %.2f s: %.0f edges/s, %.0f snapshots/s, %.0f consumer passes/s, %.0f decoded events/s\n",
+           (unsigned long long)inputs, wall, totals.edges / wall, totals.snapshots / wall, totals.runs / wall,
+           totals.decoded / wall);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "-b") == 0)
+    {
+        bench(argc > 2 ? atof(argv[2]) : 5.0);
+        return 0;
+    }
+
+#ifdef __AFL_HAVE_MANUAL_CONTROL
+    __AFL_INIT();
+#endif
+    if (argc < 2)
+    {
+        size_t len;
+        uint8_t *data = read_all(stdin, &len);
+        run_input(data, len);
+        free(data);
+        return 0;
+    }
+    for (int i = 1; i < argc; i++)
+    {
+        FILE *f = fopen(argv[i], "rb");
+        size_t len;
+        if (f == NULL)
+        {
+            perror(argv[i]);
+            return 1;
+        }
+        uint8_t *data = read_all(f, &len);
+        fclose(f);
+        run_input(data, len);
+        free(data);
+    }
+    printf("%d inputs, %llu edges, %llu decoded events, invariants held\n", argc - 1,
+           (unsigned long long)totals.edges, (unsigned long long)totals.decoded);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,316 @@
+/*
+ * Host check of the macro interpreter on a virtual clock, the macro config
+ * commands and macro slots in the settings blob.
+ *
+ *   cc -I. tools/macro_check.c macro.c config_proto.c settings.c accel.c motion_xform.c cpi.c \
+ *      surface.c motion_filter.c -lm -o macro_check && ./macro_check
+ *
+ * Steps run late on purpose, as the esp_timer callback does under load: the
+ * deadlines a program returns must still sit on its own schedule. Exits
+ * non-zero on the first broken expectation of each case.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_proto.h"
+#include "macro.h"
+#include "settings.h"
+
+#define T0 1000000u // start of every program, us
+#define LATE 300u   // how late each step runs
+
+static int failures;
+
+#define CHECK(cond, ...)                  \
+    do                                    \
+    {                                     \
+        if (!(cond))                      \
+        {                                 \
+            printf("FAIL: " __VA_ARGS__); \
+            printf("\n");                 \
+            failures++;                   \
+            return;                       \
+        }                                 \
+    } while (0)
+
+static void check_validate(void)
+{
+    const uint8_t ok[] = {MACRO_OP_PRESS, 1, MACRO_OP_WAIT, 10, 0, MACRO_OP_RELEASE, 1, MACRO_OP_END};
+    const uint8_t no_end[] = {MACRO_OP_PRESS, 1, MACRO_OP_RELEASE, 1};
+    const uint8_t cut[] = {MACRO_OP_MOVE, 1, 0, 2};
+    const uint8_t unknown[] = {0x42, MACRO_OP_END};
+
+    CHECK(macro_validate(ok, sizeof(ok)), "valid program rejected");
+    CHECK(!macro_validate(no_end, sizeof(no_end)), "program without END accepted");
+    CHECK(!macro_validate(cut, sizeof(cut)), "truncated MOVE accepted");
+    CHECK(!macro_validate(unknown, sizeof(unknown)), "unknown op accepted");
+    CHECK(!macro_validate(ok, 0), "empty program accepted");
+}
+
+// a click: press, hold 10 ms, release, then move and scroll 500 us later
+static void check_click(void)
+{
+    const uint8_t code[] = {
+        MACRO_OP_PRESS, 0x01, MACRO_OP_WAIT, 10, 0, MACRO_OP_RELEASE, 0x01, MACRO_OP_WAIT_US, 0xF4, 0x01,
+        MACRO_OP_MOVE, 3, 0, 0xFC, 0xFF, MACRO_OP_SCROLL, 0xFF, MACRO_OP_END,
+    };
+    macro_player_t p;
+    macro_output_t out = {0};
+
+    macro_player_init(&p);
+    CHECK(!macro_running(&p), "idle player running");
+    macro_start(&p, code, sizeof(code), T0);
+
+    uint64_t next = macro_step(&p, T0, &out);
+    CHECK(next == T0 + 10000, "hold ends at %llu", (unsigned long long)next);
+    CHECK(out.changed && out.buttons == 0x01, "press not reported");
+
+    // early wake: nothing due
+    memset(&out, 0, sizeof(out));
+    next = macro_step(&p, T0 + 9999, &out);
+    CHECK(next == T0 + 10000 && !out.changed && out.buttons == 0x01, "step before the deadline did something");
+
+    memset(&out, 0, sizeof(out));
+    next = macro_step(&p, T0 + 10000 + LATE, &out);
+    CHECK(next == T0 + 10500, "WAIT_US measured from the late step: %llu", (unsigned long long)next);
+    CHECK(out.changed && out.buttons == 0, "release not reported");
+    CHECK(out.x == 0 && out.y == 0 && out.vertical == 0, "move ran before its wait");
+
+    memset(&out, 0, sizeof(out));
+    next = macro_step(&p, T0 + 10500 + LATE, &out);
+    CHECK(next == MACRO_IDLE && !macro_running(&p), "program did not end");
+    CHECK(out.changed && out.x == 3 && out.y == -4 && out.vertical == -1, "move/scroll %d,%d,%d", out.x, out.y,
+          out.vertical);
+}
+
+// a program of 1 ms waits, every step late: deadlines stay on the 1 ms grid
+static void check_drift(void)
+{
+    uint8_t code[MACRO_CODE_MAX];
+    size_t len = 0;
+    macro_player_t p;
+
+    for (int i = 0; i < 50; i++)
+    {
+        code[len++] = MACRO_OP_WAIT_US;
+        code[len++] = 1000 & 0xFF;
+        code[len++] = 1000 >> 8;
+        if (len + 4 > sizeof(code))
+        {
+            break;
+        }
+    }
+    code[len++] = MACRO_OP_END;
+    size_t waits = (len - 1) / 3;
+    CHECK(macro_validate(code, len), "generated program invalid");
+
+    macro_player_init(&p);
+    macro_start(&p, code, len, T0);
+    uint64_t next = T0;
+    for (size_t k = 1; k <= waits; k++)
+    {
+        macro_output_t out = {0};
+        next = macro_step(&p, next + LATE, &out);
+        CHECK(next == T0 + k * 1000, "deadline %zu drifted to %llu", k, (unsigned long long)next);
+    }
+    macro_output_t out = {0};
+    CHECK(macro_step(&p, next, &out) == MACRO_IDLE, "program did not end after %zu waits", waits);
+}
+
+// buttons a program leaves pressed are released at END, a restart drops them too
+static void check_release(void)
+{
+    const uint8_t hold[] = {MACRO_OP_PRESS, 0x06, MACRO_OP_WAIT, 5, 0, MACRO_OP_END};
+    const uint8_t other[] = {MACRO_OP_WAIT, 1, 0, MACRO_OP_END};
+    macro_player_t p;
+    macro_output_t out = {0};
+
+    macro_player_init(&p);
+    macro_start(&p, hold, sizeof(hold), T0);
+    macro_step(&p, T0, &out);
+    CHECK(out.buttons == 0x06, "press lost");
+
+    memset(&out, 0, sizeof(out));
+    CHECK(macro_step(&p, T0 + 5000, &out) == MACRO_IDLE, "program did not end");
+    CHECK(out.changed && out.buttons == 0, "END left buttons 0x%02x", out.buttons);
+
+    macro_start(&p, hold, sizeof(hold), T0);
+    memset(&out, 0, sizeof(out));
+    macro_step(&p, T0, &out);
+    macro_start(&p, other, sizeof(other), T0 + 1000);
+    memset(&out, 0, sizeof(out));
+    CHECK(macro_step(&p, T0 + 1000, &out) == T0 + 2000, "replacement not started");
+    CHECK(out.changed && out.buttons == 0, "replaced program left buttons 0x%02x", out.buttons);
+}
+
+static void check_slots(void)
+{
+    const uint8_t code[] = {MACRO_OP_SCROLL, 1, MACRO_OP_END};
+    const uint8_t bad[] = {MACRO_OP_SCROLL, 1};
+    macro_slot_t slots[MACRO_SLOTS];
+
+    memset(slots, 0, sizeof(slots));
+    CHECK(!macro_slot_set(slots, MACRO_SLOTS, 0x03, code, sizeof(code)), "slot index not checked");
+    CHECK(!macro_slot_set(slots, 0, 0x03, bad, sizeof(bad)), "invalid program stored");
+    CHECK(!macro_slot_set(slots, 0, 0x03, code, MACRO_CODE_MAX + 1), "oversized program stored");
+    CHECK(macro_slot_set(slots, 1, 0x05, code, sizeof(code)), "valid program refused");
+
+    CHECK(macro_match_chord(slots, 0x05) == 1, "chord 0x05 not matched");
+    CHECK(macro_match_chord(slots, 0x07) == -1, "superset of the chord matched");
+    CHECK(macro_match_chord(slots, 0x04) == -1, "single button matched");
+
+    CHECK(macro_slot_set(slots, 1, 0x05, code, 0), "clearing refused");
+    CHECK(macro_match_chord(slots, 0x05) == -1, "cleared slot still matches");
+}
+
+/* ------------------------------------------------------------ config commands */
+
+static macro_slot_t dev_slots[MACRO_SLOTS];
+static uint8_t dev_staged[MACRO_CODE_MAX];
+static int dev_played = -1;
+
+static int dev_write_macro(uint8_t offset, const uint8_t *data, uint8_t n)
+{
+    memcpy(dev_staged + offset, data, n);
+    return CONFIG_STATUS_OK;
+}
+
+static int dev_store_macro(uint8_t slot, uint8_t chord, uint8_t len)
+{
+    return macro_slot_set(dev_slots, slot, chord, dev_staged, len) ? CONFIG_STATUS_OK : CONFIG_STATUS_BAD_VALUE;
+}
+
+static int dev_clear_macro(uint8_t slot)
+{
+    return macro_slot_set(dev_slots, slot, 0, dev_staged, 0) ? CONFIG_STATUS_OK : CONFIG_STATUS_BAD_VALUE;
+}
+
+static int dev_play_macro(uint8_t slot)
+{
+    if (!dev_slots[slot].len)
+    {
+        return CONFIG_STATUS_BAD_VALUE;
+    }
+    dev_played = slot;
+    return CONFIG_STATUS_OK;
+}
+
+static int dev_get_macro(uint8_t slot, macro_slot_t *macro)
+{
+    *macro = dev_slots[slot];
+    return CONFIG_STATUS_OK;
+}
+
+static const config_ops_t dev_ops = {
+    .write_macro = dev_write_macro,
+    .store_macro = dev_store_macro,
+    .clear_macro = dev_clear_macro,
+    .play_macro = dev_play_macro,
+    .get_macro = dev_get_macro,
+};
+
+static int request(const uint8_t *req, size_t len, uint8_t *rsp)
+{
+    if (config_proto_handle(&dev_ops, req, len, rsp, CONFIG_REPORT_LEN) != CONFIG_REPORT_LEN)
+    {
+        return -1;
+    }
+    return rsp[2];
+}
+
+static void check_config(void)
+{
+    // 23 bytes: two chunks to stage
+    const uint8_t code[] = {
+        MACRO_OP_PRESS, 1, MACRO_OP_WAIT, 20, 0,    MACRO_OP_RELEASE, 1,   MACRO_OP_WAIT, 20, 0, MACRO_OP_PRESS, 1,
+        MACRO_OP_WAIT,  20, 0, MACRO_OP_RELEASE, 1, MACRO_OP_MOVE, 0x10, 0, 0x10, 0, MACRO_OP_END,
+    };
+    uint8_t req[CONFIG_REPORT_LEN], rsp[CONFIG_REPORT_LEN];
+    const size_t chunk = CONFIG_REPORT_LEN - 4;
+
+    for (size_t off = 0; off < sizeof(code); off += chunk)
+    {
+        size_t n = sizeof(code) - off < chunk ? sizeof(code) - off : chunk;
+        req[0] = CONFIG_CMD_WRITE_MACRO;
+        req[1] = (uint8_t)off;
+        req[2] = (uint8_t)off;
+        req[3] = (uint8_t)n;
+        memcpy(req + 4, code + off, n);
+        CHECK(request(req, 4 + n, rsp) == CONFIG_STATUS_OK, "write at %zu", off);
+    }
+
+    const uint8_t store[] = {CONFIG_CMD_STORE_MACRO, 9, 2, 0x03, sizeof(code)};
+    CHECK(request(store, sizeof(store), rsp) == CONFIG_STATUS_OK, "store");
+    CHECK(rsp[0] == (CONFIG_CMD_STORE_MACRO | CONFIG_RSP_FLAG) && rsp[1] == 9, "store response header");
+    CHECK(rsp[3] == 2 && rsp[4] == 0x03 && rsp[5] == sizeof(code), "store echoes slot %u chord %u len %u", rsp[3],
+          rsp[4], rsp[5]);
+    CHECK(memcmp(rsp + 6, code, CONFIG_RSP_PAYLOAD - 3) == 0, "store echoes the program");
+
+    // read the program back in pieces
+    uint8_t back[MACRO_CODE_MAX];
+    size_t got = 0;
+    while (got < sizeof(code))
+    {
+        const uint8_t get[] = {CONFIG_CMD_GET_MACRO, 0, 2, (uint8_t)got};
+        CHECK(request(get, sizeof(get), rsp) == CONFIG_STATUS_OK, "get at %zu", got);
+        size_t n = sizeof(code) - got < CONFIG_RSP_PAYLOAD - 3 ? sizeof(code) - got : CONFIG_RSP_PAYLOAD - 3;
+        memcpy(back + got, rsp + 6, n);
+        got += n;
+    }
+    CHECK(memcmp(back, code, sizeof(code)) == 0, "program read back differs");
+
+    const uint8_t play[] = {CONFIG_CMD_PLAY_MACRO, 0, 2};
+    CHECK(request(play, sizeof(play), rsp) == CONFIG_STATUS_OK && dev_played == 2, "play");
+
+    const uint8_t clear[] = {CONFIG_CMD_CLEAR_MACRO, 0, 2};
+    CHECK(request(clear, sizeof(clear), rsp) == CONFIG_STATUS_OK && dev_slots[2].len == 0, "clear");
+    CHECK(request(play, sizeof(play), rsp) == CONFIG_STATUS_BAD_VALUE, "empty slot played");
+
+    const uint8_t overflow[] = {CONFIG_CMD_WRITE_MACRO, 0, MACRO_CODE_MAX - 4, 8, 1, 2, 3, 4, 5, 6, 7, 8};
+    CHECK(request(overflow, sizeof(overflow), rsp) == CONFIG_STATUS_BAD_VALUE, "write past the buffer");
+
+    // staged bytes no longer end in END
+    const uint8_t garbage[] = {CONFIG_CMD_WRITE_MACRO, 0, 0, 2, 0x42, 0x42};
+    CHECK(request(garbage, sizeof(garbage), rsp) == CONFIG_STATUS_OK, "write garbage");
+    const uint8_t store_bad[] = {CONFIG_CMD_STORE_MACRO, 0, 1, 0x03, 2};
+    CHECK(request(store_bad, sizeof(store_bad), rsp) == CONFIG_STATUS_BAD_VALUE, "invalid program stored");
+
+    const uint8_t bad_slot[] = {CONFIG_CMD_PLAY_MACRO, 0, MACRO_SLOTS};
+    CHECK(request(bad_slot, sizeof(bad_slot), rsp) == CONFIG_STATUS_BAD_VALUE, "slot index not checked");
+}
+
+/* ------------------------------------------------------------ persistence */
+
+static void check_settings(void)
+{
+    const uint8_t code[] = {MACRO_OP_PRESS, 2, MACRO_OP_WAIT, 30, 0, MACRO_OP_RELEASE, 2, MACRO_OP_END};
+    settings_t s, back;
+    uint8_t blob[SETTINGS_BLOB_MAX];
+
+    settings_defaults(&s);
+    CHECK(macro_slot_set(s.macros, 3, 0x06, code, sizeof(code)), "slot set");
+    size_t len = settings_encode(&s, blob, sizeof(blob));
+    CHECK(len && settings_decode(blob, len, &back) == SETTINGS_OK, "decode");
+    CHECK(memcmp(back.macros, s.macros, sizeof(s.macros)) == 0, "macro slots changed in the blob");
+
+    // a damaged program with a valid CRC is dropped on load
+    s.macros[3].code[sizeof(code) - 1] = 0x42;
+    len = settings_encode(&s, blob, sizeof(blob));
+    CHECK(settings_decode(blob, len, &back) == SETTINGS_OK, "decode damaged");
+    CHECK(back.macros[3].len == 0 && back.macros[3].chord == 0, "invalid stored program kept");
+}
+
+int main(void)
+{
+    check_validate();
+    check_click();
+    check_drift();
+    check_release();
+    check_slots();
+    check_config();
+    check_settings();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,1628 @@
+/*
+ * Deterministic discrete-event simulation of the whole mouse, for timing regressions.
+ *
+ *   cc -O2 -I. tools/mouse_sim.c input_capture.c surface.c motion_filter.c motion_xform.c accel.c \
+ *      rate_ctl.c sched_plan.c spi_fake.c spi_transport.c -lm -o mouse_sim
+ *   ./mouse_sim [-s seed] [-t seconds] [-c conn ms] [-l loss %] [-b bounce ms] [-L lift %]
+ *               [-e SPI error %] [-w] [-v]
+ *
+ * A seeded user moves, clicks and scrolls for the simulated time; the same
+ * seed and options give the same run and the same digest, so a change in
+ * the digest or the report means the firmware's timing changed.
+ *
+ * Modelled:
+ *   sensor    frame clock (-F fps), motion counts, MOTION pin held low until
+ *             a burst read, 12-byte bursts through spi_fake.c for the wire time,
+ *             -L % of strokes ending in a lift (LIFT status, no SQUAL), -e %
+ *             of burst reads failing on the bus
+ *   GPIO      buttons and the wheel encoder, every edge with -b ms of contact
+ *             bounce, snapshots into the real input_ring
+ *   tasks     move, accum, input and report tasks of main.c plus the NimBLE
+ *             host, with the priorities sched_plan_assign() gives them,
+ *             fixed-priority preemptive per core on a FreeRTOS tick (-T Hz);
+ *             ISRs steal time from whatever runs on the sensor core
+ *   BLE       a central with its own interval (-c, 0 = follow the requests
+ *             from rate_ctl), up to -p notifications per connection event,
+ *             -l % of packets lost and retried, supervision timeout and
+ *             reconnect, a stack buffer of -q reports
+ *
+ * The decisions come from the firmware's own modules: input_capture.c
+ * decodes and debounces, surface.c gates, motion_filter.c, motion_xform.c
+ * and accel.c shape motion, rate_ctl.c paces reports. The task bodies of
+ * main.c need FreeRTOS, so they are mirrored here step for step; keep
+ * sim_move/sim_accum/sim_input/sim_report in line with main.c.
+ *
+ * Task costs are estimates, not measurements (COST_* below). Latency is
+ * from the physical event (first sensor frame of unreported motion, first
+ * contact of a press, first detent of a scroll) to the report reaching the
+ * central. Worst task response times are wake-up to blocking again, next to
+ * what sched_plan_analyse() promises.
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "accel.h"
+#include "input_capture.h"
+#include "motion_filter.h"
+#include "motion_xform.h"
+#include "mouse_hid.h"
+#include "rate_ctl.h"
+#include "sched_plan.h"
+#include "spi_fake.h"
+#include "surface.h"
+
+/* main.c defaults */
+#define READ_INTERVAL_MS 5
+#define HEALTH_PERIOD_MS 2000
+#define CLICK_DEBOUNCE_US 50000
+#define SCROLL_DEBOUNCE_US 20000
+#define REPORT_RATE_HZ 150 // MOUSE_REPORT_RATE_DEFAULT
+#define RATE_MAX_HZ 150
+#define RATE_MIN_HZ 100
+#define RATE_POLL_MS 500
+#define INPUT_BATCH 16
+#define INPUT_IDLE_MS 1000
+#define INPUT_PENDING_MS 5
+#define ACCUM_QUEUE_LEN 32
+#define TASK_BASE_PRIORITY 5
+#define MAX_PRIORITIES 25
+#define CPU_MHZ 240
+
+/* pins.h */
+#define PIN_LEFT 26
+#define PIN_RIGHT 33
+#define PIN_MIDDLE 25
+#define PIN_DPI 32
+#define PIN_ENC_A 34
+#define PIN_ENC_B 35
+#define PIN_MOTION 27
+
+/* CPU time per step, ns */
+#define COST_ISR 2000
+#define COST_MOVE 40000      // gate, filter, xform, accel, queue send after the SPI read
+#define COST_HEALTH 60000
+#define COST_ACCUM 15000
+#define COST_INPUT 10000
+#define COST_INPUT_SNAP 1000 // per decoded snapshot
+#define COST_REPORT 25000    // take the accumulator, rate_ctl
+#define COST_HID_SEND 120000 // esp_hidd_dev_input_set down to the stack buffer
+#define COST_HOST_EVENT 150000
+#define COST_HOST_PACKET 30000
+
+#define SPI_OVERHEAD_NS 15000
+
+#define US 1000ull
+#define MS 1000000ull
+#define SEC 1000000000ull
+
+typedef uint64_t sim_t; // ns
+
+/* ------------------------------------------------------------------------- options */
+
+static struct
+{
+    uint64_t seed;
+    double seconds;
+    double conn_ms;   // 0 = follow the peripheral's requests
+    double loss;      // per packet
+    double bounce_ms; // contact bounce per switch edge
+    double lift;      // strokes followed by lifting the mouse
+    double spi_err;   // burst reads failing on the bus
+    uint32_t fps;
+    uint32_t tick_hz;
+    uint32_t per_event;
+    uint32_t stack_buf;
+    bool wheel_only;
+    bool verbose;
+} opt = {
+    .seed = 1,
+    .seconds = 600,
+    .conn_ms = 0,
+    .loss = 0.01,
+    .bounce_ms = 2,
+    .lift = 0.2,
+    .fps = 10000,
+    .tick_hz = 1000,
+    .per_event = 3,
+    .stack_buf = 12,
+};
+
+/* ------------------------------------------------------------------------- random */
+
+static uint64_t rng_state;
+
+static uint64_t rng_u64(void)
+{
+    // xorshift64*
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 2685821657736338717ull;
+}
+
+static double rng_unit(void) { return (rng_u64() >> 11) * (1.0 / 9007199254740992.0); }
+
+static double rng_range(double lo, double hi) { return lo + (hi - lo) * rng_unit(); }
+
+static double rng_exp(double mean) { return -mean * log(1.0 - rng_unit()); }
+
+/* ------------------------------------------------------------------------- events */
+
+typedef enum
+{
+    EV_USER,       // next user action
+    EV_FRAME,      // sensor frame
+    EV_PIN,        // a = pin, b = level
+    EV_TASK_DONE,  // a = task, b = generation
+    EV_TASK_WAKE,  // a = task, b = generation
+    EV_CONN,       // connection event
+    EV_RECONNECT,
+    EV_BUTTON_UP,  // a = pin
+    EV_WHEEL_STEP, // a = steps left, b = direction
+} ev_kind_t;
+
+typedef struct
+{
+    sim_t t;
+    uint64_t seq; // ties go in scheduling order, so runs repeat exactly
+    uint32_t kind;
+    uint32_t a;
+    uint64_t b;
+} event_t;
+
+static event_t *heap;
+static size_t heap_len, heap_cap;
+static uint64_t ev_seq, ev_count;
+static sim_t now;
+
+static bool ev_before(const event_t *x, const event_t *y) { return x->t < y->t || (x->t == y->t && x->seq < y->seq); }
+
+static void ev_at(sim_t t, ev_kind_t kind, uint32_t a, uint64_t b)
+{
+    if (heap_len == heap_cap)
+    {
+        heap_cap = heap_cap ? heap_cap * 2 : 1024;
+        heap = realloc(heap, heap_cap * sizeof(*heap));
+        if (heap == NULL)
+        {
+            abort();
+        }
+    }
+    size_t i = heap_len++;
+    event_t e = {.t = t < now ? now : t, .seq = ev_seq++, .kind = kind, .a = a, .b = b};
+    while (i > 0 && ev_before(&e, &heap[(i - 1) / 2]))
+    {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = e;
+}
+
+static event_t ev_pop(void)
+{
+    event_t top = heap[0], last = heap[--heap_len];
+    size_t i = 0;
+    for (;;)
+    {
+        size_t c = 2 * i + 1;
+        if (c >= heap_len)
+        {
+            break;
+        }
+        if (c + 1 < heap_len && ev_before(&heap[c + 1], &heap[c]))
+        {
+            c++;
+        }
+        if (!ev_before(&heap[c], &last))
+        {
+            break;
+        }
+        heap[i] = heap[c];
+        i = c;
+    }
+    heap[i] = last;
+    return top;
+}
+
+/* ------------------------------------------------------------------------- measurements */
+
+typedef struct
+{
+    uint32_t *v; // us
+    size_t n, cap;
+} samples_t;
+
+static void sample(samples_t *s, sim_t ns)
+{
+    if (s->n == s->cap)
+    {
+        s->cap = s->cap ? s->cap * 2 : 4096;
+        s->v = realloc(s->v, s->cap * sizeof(*s->v));
+        if (s->v == NULL)
+        {
+            abort();
+        }
+    }
+    s->v[s->n++] = (uint32_t)(ns / US);
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void samples_print(const char *name, samples_t *s)
+{
+    if (s->n == 0)
+    {
+        printf("  %-8s %9s\n", name, "-");
+        return;
+    }
+    qsort(s->v, s->n, sizeof(*s->v), cmp_u32);
+    printf("  %-8s %9zu %9.2f %9.2f %9.2f %9.2f\n", name, s->n, s->v[s->n / 2] / 1000.0,
+           s->v[(size_t)(s->n * 0.99)] / 1000.0, s->v[(size_t)(s->n * 0.999)] / 1000.0, s->v[s->n - 1] / 1000.0);
+}
+
+static struct
+{
+    samples_t motion, button, wheel;
+    uint64_t presses, releases, detents, scrolls; // physical
+    uint64_t scrolls_lost;
+    int64_t net_wheel;                   // physical, signed steps
+    int64_t sensor_x, sensor_y;          // counts the sensor produced
+    uint64_t strokes;
+    uint64_t queue_full, ring_overruns, bounces, enc_invalid;
+    uint64_t reports, splits, stack_full, not_connected, flushed;
+    uint64_t packets, retries, conn_events, disconnects, conn_updates;
+    uint64_t move_wakes, reads, gated_reads, spi_errors, lifts;
+    int64_t gated_x, gated_y; // counts the surface gate dropped
+    uint64_t digest;
+} m = {.digest = 1469598103934665603ull};
+
+static void digest(uint64_t v)
+{
+    // FNV-1a over what the central saw
+    for (int i = 0; i < 8; i++, v >>= 8)
+    {
+        m.digest = (m.digest ^ (v & 0xFF)) * 1099511628211ull;
+    }
+}
+
+/* ------------------------------------------------------------------------- tasks and cores */
+
+enum
+{
+    TASK_MOVE,
+    TASK_ACCUM,
+    TASK_INPUT,
+    TASK_REPORT,
+    TASK_NIMBLE,
+    TASK_COUNT
+};
+
+#define SENSOR_CORE 1
+#define HOST_CORE 0
+#define CORES 2
+
+// main.c's task_plan, without the stacks
+static sched_task_t plan[TASK_COUNT] = {
+    [TASK_MOVE] = {.name = "move", .core = SENSOR_CORE, .period_us = READ_INTERVAL_MS * 1000, .wcet_us = 150,
+                   .deadline_us = 1000},
+    [TASK_ACCUM] = {.name = "accum", .core = SENSOR_CORE, .period_us = READ_INTERVAL_MS * 1000, .wcet_us = 50,
+                    .deadline_us = 500},
+    [TASK_INPUT] = {.name = "input", .core = SENSOR_CORE, .period_us = 1000, .wcet_us = 40, .deadline_us = 500},
+    [TASK_REPORT] = {.name = "report", .core = HOST_CORE, .period_us = 1000000 / RATE_MAX_HZ, .wcet_us = 300,
+                     .deadline_us = 2000},
+    [TASK_NIMBLE] = {.name = "nimble", .core = HOST_CORE, .fixed = true, .priority = MAX_PRIORITIES - 4,
+                     .period_us = 7500, .wcet_us = 1000, .deadline_us = 7500},
+};
+
+typedef struct task task_t;
+typedef void (*step_fn_t)(task_t *t);
+
+typedef enum
+{
+    BLOCK_NONE,
+    BLOCK_NOTIFY,
+    BLOCK_DELAY,
+    BLOCK_QUEUE,
+} block_t;
+
+struct task
+{
+    int id;
+    int core;
+    uint8_t prio;
+    bool ready;
+    sim_t remaining; // CPU time left in the current step
+    step_fn_t next;  // runs when the step is done
+    block_t block;
+    uint32_t notify;
+    bool timed_out;
+    uint64_t gen;    // invalidates stale done/wake events
+    sim_t woke;      // for response times
+    sim_t response_max;
+    uint64_t runs;
+};
+
+typedef struct
+{
+    task_t *running;
+    sim_t started;
+    sim_t busy;
+} core_t;
+
+static task_t tasks[TASK_COUNT];
+static core_t cores[CORES];
+
+static sim_t tick_ns(void) { return SEC / opt.tick_hz; }
+
+static uint32_t ms_to_ticks(uint32_t ms) { return (uint32_t)((uint64_t)ms * opt.tick_hz / 1000); }
+
+static void core_schedule(int c);
+
+// stop the clock on the running step, so it can be preempted or charged
+static void core_pause(core_t *core)
+{
+    task_t *t = core->running;
+    if (t)
+    {
+        sim_t ran = now - core->started;
+        t->remaining = t->remaining > ran ? t->remaining - ran : 0;
+        core->busy += ran;
+        t->gen++;
+        core->running = NULL;
+    }
+}
+
+static void core_schedule(int c)
+{
+    core_t *core = &cores[c];
+    task_t *best = NULL;
+
+    for (int i = 0; i < TASK_COUNT; i++)
+    {
+        task_t *t = &tasks[i];
+        if (t->core == c && t->ready && (best == NULL || t->prio > best->prio))
+        {
+            best = t;
+        }
+    }
+    if (best == core->running)
+    {
+        return;
+    }
+    core_pause(core);
+    if (best)
+    {
+        core->running = best;
+        core->started = now;
+        ev_at(now + best->remaining, EV_TASK_DONE, (uint32_t)best->id, best->gen);
+    }
+}
+
+// an ISR on this core: the running step takes that much longer
+static void core_charge(int c, sim_t ns)
+{
+    core_t *core = &cores[c];
+    task_t *t = core->running;
+    if (t)
+    {
+        core_pause(core);
+        t->remaining += ns;
+        core->running = t;
+        core->started = now;
+        ev_at(now + t->remaining, EV_TASK_DONE, (uint32_t)t->id, t->gen);
+    }
+}
+
+static void run(task_t *t, sim_t cost, step_fn_t next)
+{
+    t->ready = true;
+    t->block = BLOCK_NONE;
+    t->remaining = cost;
+    t->next = next;
+}
+
+static void block_until(task_t *t, block_t why, sim_t wake, step_fn_t next)
+{
+    if (t->woke)
+    {
+        // job done: from the wake-up to blocking again
+        if (now - t->woke > t->response_max)
+        {
+            t->response_max = now - t->woke;
+        }
+        t->woke = 0;
+    }
+    t->ready = false;
+    t->block = why;
+    t->remaining = 0;
+    t->next = next;
+    t->timed_out = false;
+    t->gen++;
+    if (wake != UINT64_MAX)
+    {
+        ev_at(wake, EV_TASK_WAKE, (uint32_t)t->id, t->gen);
+    }
+}
+
+static sim_t tick_deadline(uint32_t ticks)
+{
+    return (now / tick_ns() + ticks) * tick_ns();
+}
+
+static void wake(task_t *t, bool timed_out)
+{
+    // a delay running out releases the next periodic job, a timeout does not
+    if (!timed_out || t->block == BLOCK_DELAY)
+    {
+        t->woke = now;
+    }
+    t->ready = true;
+    t->block = BLOCK_NONE;
+    t->timed_out = timed_out;
+    t->gen++;
+    core_schedule(t->core);
+}
+
+/* vTaskDelay() */
+static void delay_ticks(task_t *t, uint32_t ticks, step_fn_t next)
+{
+    if (ticks == 0)
+    {
+        run(t, 0, next);
+        return;
+    }
+    block_until(t, BLOCK_DELAY, tick_deadline(ticks), next);
+}
+
+/* ulTaskNotifyTake(pdTRUE, ticks), UINT32_MAX = portMAX_DELAY */
+static void notify_take(task_t *t, uint32_t ticks, step_fn_t next)
+{
+    if (t->notify)
+    {
+        t->notify = 0;
+        t->timed_out = false;
+        run(t, 0, next);
+        return;
+    }
+    if (ticks == 0)
+    {
+        t->timed_out = true;
+        run(t, 0, next);
+        return;
+    }
+    block_until(t, BLOCK_NOTIFY, ticks == UINT32_MAX ? UINT64_MAX : tick_deadline(ticks), next);
+}
+
+static void notify_give(task_t *t)
+{
+    if (t->block == BLOCK_NOTIFY)
+    {
+        t->notify = 0;
+        wake(t, false);
+    }
+    else
+    {
+        t->notify++;
+    }
+}
+
+/* ------------------------------------------------------------------------- firmware state, as in main.c */
+
+typedef struct
+{
+    int16_t x, y;
+    int8_t vertical;
+    bool has_buttons;
+    uint8_t buttons;
+    sim_t origin; // physical event behind it, 0 = none
+} accum_item_t;
+
+static struct
+{
+    accum_item_t buf[ACCUM_QUEUE_LEN];
+    uint32_t head, tail;
+} accum_queue;
+
+static int16_t accum_x, accum_y;
+static int8_t accum_vertical;
+static uint8_t buttons;
+static sim_t accum_origin;  // oldest physical event in the accumulator
+static uint8_t motion_level = 1;
+
+static input_ring_t input_ring;
+static input_decoder_t input_decoder;
+static const input_config_t input_cfg = {
+    .buttons = {{.gpio = PIN_LEFT, .bit = 0}, {.gpio = PIN_RIGHT, .bit = 1}, {.gpio = PIN_MIDDLE, .bit = 2}},
+    .n_buttons = 3,
+    .enc_a = PIN_ENC_A,
+    .enc_b = PIN_ENC_B,
+    .dpi_gpio = PIN_DPI,
+};
+
+static surface_gate_t surface;
+static motion_filter_t motion_filter;
+static motion_xform_t xform;
+static accel_t accel;
+static rate_ctl_t rate_ctl;
+static spi_fake_t spi_bus;
+static spi_transport_t spi;
+
+static uint64_t pins = ~0ull; // pulled up, active low; MOTION idles high
+
+static uint32_t cycles(sim_t t) { return (uint32_t)(t * CPU_MHZ / 1000); }
+
+static uint32_t now_us(void) { return (uint32_t)(now / US); }
+
+static void accum_send(const accum_item_t *item)
+{
+    if (accum_queue.head - accum_queue.tail >= ACCUM_QUEUE_LEN)
+    {
+        m.queue_full++;
+        return;
+    }
+    accum_queue.buf[accum_queue.head++ % ACCUM_QUEUE_LEN] = *item;
+    if (tasks[TASK_ACCUM].block == BLOCK_QUEUE)
+    {
+        wake(&tasks[TASK_ACCUM], false);
+    }
+}
+
+/* ------------------------------------------------------------------------- BLE link and central */
+
+typedef struct
+{
+    uint8_t buttons;
+    int16_t x, y;
+    int8_t wheel;
+    sim_t origin_motion, origin_button, origin_wheel;
+} hid_report_t;
+
+static struct
+{
+    bool connected;
+    uint16_t itvl;        // 1.25 ms units
+    uint16_t req_itvl;    // pending request, 0 = none
+    sim_t supervision;    // timeout
+    sim_t last_ok;        // last event with a packet through
+    hid_report_t *buf;
+    uint32_t head, tail;
+    // central side
+    uint8_t host_buttons;
+    int64_t host_x, host_y, host_wheel;
+    uint64_t host_wheel_steps;
+} ble;
+
+// presses and detents waiting to show up at the central, for latency and loss
+#define PENDING_MAX 4096
+#define PENDING_AGE (500 * MS) // older than this: swallowed by the firmware, not late
+
+typedef struct
+{
+    sim_t t[PENDING_MAX];
+    uint32_t head, tail;
+    uint64_t unmatched;
+} pending_t;
+
+static pending_t press_fifo[3];
+static sim_t scroll_start; // first detent of a scroll not yet seen by the central
+
+static void fifo_push(pending_t *f, sim_t t)
+{
+    if (f->head - f->tail < PENDING_MAX)
+    {
+        f->t[f->head++ % PENDING_MAX] = t;
+    }
+}
+
+static bool fifo_pop(pending_t *f, sim_t at, sim_t *t)
+{
+    while (f->head != f->tail)
+    {
+        *t = f->t[f->tail++ % PENDING_MAX];
+        if (at - *t < PENDING_AGE)
+        {
+            return true;
+        }
+        f->unmatched++;
+    }
+    return false;
+}
+
+static uint64_t fifo_lost(const pending_t *f) { return f->unmatched + (f->head - f->tail); }
+
+static bool ble_mounted(void) { return ble.connected; }
+
+static uint16_t ble_conn_itvl(void) { return ble.connected ? ble.itvl : 0; }
+
+static void ble_conn_params(uint16_t itvl_min, uint16_t itvl_max, uint16_t latency, uint16_t timeout)
+{
+    (void)itvl_max;
+    (void)latency;
+    if (ble.connected && opt.conn_ms == 0)
+    {
+        ble.req_itvl = itvl_min; // most centrals take the shortest interval offered
+        ble.supervision = (sim_t)timeout * 10 * MS;
+        m.conn_updates++;
+    }
+}
+
+/* ble_hid_mouse_report(): into the stack's buffer, or refused */
+static void ble_hid_mouse_report(uint8_t btns, int16_t x, int16_t y, int8_t vertical, sim_t origin)
+{
+    if (ble.head - ble.tail >= opt.stack_buf)
+    {
+        m.stack_full++;
+        return;
+    }
+    hid_report_t *r = &ble.buf[ble.head++ % opt.stack_buf];
+    *r = (hid_report_t){.buttons = btns, .x = x, .y = y, .wheel = vertical};
+    if (x || y)
+    {
+        r->origin_motion = origin;
+    }
+    m.reports++;
+}
+
+static void central_receive(const hid_report_t *r, sim_t at)
+{
+    for (int b = 0; b < 3; b++)
+    {
+        uint8_t mask = 1u << b;
+        sim_t t;
+        if ((r->buttons & mask) && !(ble.host_buttons & mask) && fifo_pop(&press_fifo[b], at, &t))
+        {
+            sample(&m.button, at - t);
+        }
+    }
+    // detents inside the scroll debounce never count, so latency is taken per scroll
+    if (r->wheel && scroll_start)
+    {
+        sample(&m.wheel, at - scroll_start);
+        scroll_start = 0;
+    }
+    if (r->origin_motion)
+    {
+        sample(&m.motion, at - r->origin_motion);
+    }
+    ble.host_buttons = r->buttons;
+    ble.host_x += r->x;
+    ble.host_y += r->y;
+    ble.host_wheel += r->wheel;
+    ble.host_wheel_steps += (uint64_t)(r->wheel < 0 ? -r->wheel : r->wheel);
+    digest(at / US);
+    digest((uint64_t)r->buttons << 48 | (uint64_t)(uint16_t)r->x << 32 | (uint64_t)(uint16_t)r->y << 16 |
+           (uint8_t)r->wheel);
+}
+
+static void link_connect(void)
+{
+    ble.connected = true;
+    ble.itvl = opt.conn_ms ? (uint16_t)lround(opt.conn_ms / 1.25) : 24; // 30 ms until the first update
+    ble.req_itvl = 0;
+    ble.supervision = 4 * SEC;
+    ble.last_ok = now;
+    ev_at(now + ble.itvl * 1250 * US, EV_CONN, 0, 0);
+}
+
+static void on_conn_event(void)
+{
+    task_t *host = &tasks[TASK_NIMBLE];
+    uint32_t sent = 0;
+
+    if (!ble.connected)
+    {
+        return;
+    }
+    m.conn_events++;
+
+    // the first exchange goes out even with nothing queued, losing it is what
+    // runs into the supervision timeout; a lost packet waits for the next event
+    bool through = false;
+    while (sent < opt.per_event)
+    {
+        if (rng_unit() < opt.loss)
+        {
+            if (ble.head != ble.tail)
+            {
+                m.retries++;
+            }
+            break;
+        }
+        through = true;
+        if (ble.head == ble.tail)
+        {
+            break;
+        }
+        // packets inside one event are about 0.4 ms apart
+        central_receive(&ble.buf[ble.tail++ % opt.stack_buf], now + sent * 400 * US);
+        m.packets++;
+        sent++;
+    }
+    if (through)
+    {
+        ble.last_ok = now;
+    }
+    else if (now - ble.last_ok >= ble.supervision)
+    {
+        // supervision timeout: what was queued is gone
+        m.disconnects++;
+        m.flushed += ble.head - ble.tail;
+        ble.tail = ble.head;
+        ble.connected = false;
+        ev_at(now + (sim_t)rng_range(0.5, 2.0) * SEC, EV_RECONNECT, 0, 0);
+        return;
+    }
+
+    // the host task handles the event on the host core
+    if (host->block == BLOCK_NOTIFY)
+    {
+        host->notify = sent;
+        wake(host, false);
+    }
+    else
+    {
+        host->notify += sent + 1;
+    }
+
+    if (ble.req_itvl)
+    {
+        ble.itvl = ble.req_itvl;
+        ble.req_itvl = 0;
+    }
+    ev_at(now + ble.itvl * 1250 * US, EV_CONN, 0, 0);
+}
+
+static void sim_nimble_wait(task_t *t);
+
+static void sim_nimble(task_t *t)
+{
+    notify_take(t, UINT32_MAX, sim_nimble_wait);
+}
+
+static void sim_nimble_wait(task_t *t)
+{
+    t->runs++;
+    run(t, COST_HOST_EVENT + (sim_t)t->notify * COST_HOST_PACKET, sim_nimble);
+    t->notify = 0;
+}
+
+/* ------------------------------------------------------------------------- sensor */
+
+static struct
+{
+    bool stroke;
+    sim_t start, dur;
+    double ax, ay;       // stroke vector, counts
+    int64_t done_x, done_y; // counts emitted so far in this stroke
+    int32_t acc_x, acc_y;   // not read yet
+    sim_t origin;           // first frame behind acc
+    bool frames;            // frame clock running
+    sim_t lift_until;       // off the pad: no tracking, lift status keeps MOTION asserted
+} sensor;
+
+static void pin_set(int pin, int level);
+
+static void sensor_frame(void)
+{
+    if (now < sensor.lift_until)
+    {
+        if ((pins >> PIN_MOTION) & 1)
+        {
+            pin_set(PIN_MOTION, 0);
+        }
+        ev_at(now + SEC / opt.fps, EV_FRAME, 0, 0);
+        return;
+    }
+
+    double tau = sensor.stroke ? (double)(now - sensor.start) / sensor.dur : 1.0;
+    if (tau >= 1.0)
+    {
+        tau = 1.0;
+    }
+    // minimum-jerk stroke
+    double s = tau * tau * tau * (10 - 15 * tau + 6 * tau * tau);
+    int64_t px = (int64_t)floor(sensor.ax * s), py = (int64_t)floor(sensor.ay * s);
+    int32_t dx = (int32_t)(px - sensor.done_x), dy = (int32_t)(py - sensor.done_y);
+
+    sensor.done_x = px;
+    sensor.done_y = py;
+    if (dx || dy)
+    {
+        if (sensor.acc_x == 0 && sensor.acc_y == 0)
+        {
+            sensor.origin = now;
+        }
+        sensor.acc_x += dx;
+        sensor.acc_y += dy;
+        m.sensor_x += dx;
+        m.sensor_y += dy;
+        if ((pins >> PIN_MOTION) & 1)
+        {
+            pin_set(PIN_MOTION, 0);
+        }
+    }
+    if (tau >= 1.0)
+    {
+        // some strokes end with the mouse lifted to reposition it
+        if (sensor.stroke && opt.lift > 0 && rng_unit() < opt.lift)
+        {
+            sensor.stroke = false;
+            sensor.lift_until = now + (sim_t)(rng_range(80, 300) * MS);
+            m.lifts++;
+            ev_at(now + SEC / opt.fps, EV_FRAME, 0, 0);
+            return;
+        }
+        sensor.stroke = false;
+        sensor.frames = false;
+        return;
+    }
+    ev_at(now + SEC / opt.fps, EV_FRAME, 0, 0);
+}
+
+// the burst read: deltas clip at 16 bits like the sensor's registers
+static void sensor_burst(uint8_t raw[SURFACE_BURST_LEN], sim_t *origin)
+{
+    int32_t dx = sensor.acc_x < INT16_MIN ? INT16_MIN : sensor.acc_x > INT16_MAX ? INT16_MAX : sensor.acc_x;
+    int32_t dy = sensor.acc_y < INT16_MIN ? INT16_MIN : sensor.acc_y > INT16_MAX ? INT16_MAX : sensor.acc_y;
+
+    memset(raw, 0, SURFACE_BURST_LEN);
+    raw[0] = (dx || dy) ? SURFACE_MOTION_MOT : 0;
+    if (now < sensor.lift_until)
+    {
+        raw[0] = SURFACE_MOTION_MOT | SURFACE_MOTION_LIFT;
+    }
+    raw[2] = (uint8_t)dx;
+    raw[3] = (uint8_t)(dx >> 8);
+    raw[4] = (uint8_t)dy;
+    raw[5] = (uint8_t)(dy >> 8);
+    raw[6] = now < sensor.lift_until ? 0 : 90; // SQUAL on a good pad
+    raw[10] = 0x01;
+    *origin = sensor.origin;
+    sensor.acc_x = sensor.acc_y = 0;
+    sensor.origin = 0;
+}
+
+/* ------------------------------------------------------------------------- GPIO and ISRs */
+
+static void on_move(void)
+{
+    motion_level = (pins >> PIN_MOTION) & 1;
+    core_charge(SENSOR_CORE, COST_ISR);
+    if (motion_level == 0)
+    {
+        m.move_wakes++;
+    }
+    notify_give(&tasks[TASK_MOVE]);
+}
+
+static void on_input(void)
+{
+    core_charge(SENSOR_CORE, COST_ISR);
+    if (input_ring_push(&input_ring, pins, cycles(now)))
+    {
+        notify_give(&tasks[TASK_INPUT]);
+    }
+}
+
+static void pin_set(int pin, int level)
+{
+    uint64_t mask = 1ull << pin;
+    if (((pins & mask) != 0) == (level != 0))
+    {
+        return;
+    }
+    pins = level ? pins | mask : pins & ~mask;
+    if (pin == PIN_MOTION)
+    {
+        on_move();
+    }
+    else
+    {
+        on_input();
+    }
+}
+
+// a switch edge: settles at level after a few random chatters inside bounce_ms
+static void switch_edge(int pin, int level)
+{
+    sim_t t = now;
+    if (opt.bounce_ms > 0)
+    {
+        int chatters = (int)rng_range(0, 6);
+        sim_t span = (sim_t)(rng_unit() * opt.bounce_ms * MS);
+        for (int i = 0; i < chatters; i++)
+        {
+            ev_at(t + span * i / (chatters + 1), EV_PIN, (uint32_t)pin, (uint64_t)((i & 1) ? !level : level));
+        }
+        t += span;
+    }
+    ev_at(t, EV_PIN, (uint32_t)pin, (uint64_t)level);
+}
+
+/* ------------------------------------------------------------------------- user */
+
+static const int button_pins[3] = {PIN_LEFT, PIN_RIGHT, PIN_MIDDLE};
+static uint8_t enc_phase = 2; // gray code position of the wheel, both lines high
+static bool scrolling;
+
+static void user_next(void)
+{
+    double r = rng_unit();
+
+    if (!opt.wheel_only && r < 0.55 && !sensor.stroke && now >= sensor.lift_until)
+    {
+        // a stroke: 10 to 4000 counts in 30 to 600 ms, longer strokes take longer
+        double len = exp(rng_range(log(10), log(4000)));
+        double dir = rng_range(0, 2 * M_PI);
+        sensor.stroke = true;
+        sensor.start = now;
+        sensor.dur = (sim_t)((0.03 + 0.57 * len / 4000 * rng_range(0.5, 1.5)) * SEC);
+        sensor.ax = len * cos(dir);
+        sensor.ay = len * sin(dir);
+        sensor.done_x = sensor.done_y = 0;
+        m.strokes++;
+        if (!sensor.frames)
+        {
+            sensor.frames = true;
+            ev_at(now + (sim_t)rng_range(0, SEC / opt.fps), EV_FRAME, 0, 0);
+        }
+    }
+    else if (!opt.wheel_only && r < 0.80)
+    {
+        int b = rng_unit() < 0.8 ? 0 : rng_unit() < 0.7 ? 1 : 2;
+        if (!((pins >> button_pins[b]) & 1))
+        {
+            goto next; // still held
+        }
+        m.presses++;
+        fifo_push(&press_fifo[b], now);
+        switch_edge(button_pins[b], 0);
+        ev_at(now + (sim_t)rng_range(40, 250) * MS, EV_BUTTON_UP, (uint32_t)button_pins[b], 0);
+    }
+    else if (!scrolling)
+    {
+        // a scroll: a few slow notches or a flick
+        int steps = 1 + (int)rng_exp(4);
+        scrolling = true;
+        m.scrolls++;
+        if (scroll_start && now - scroll_start >= PENDING_AGE)
+        {
+            m.scrolls_lost++; // every detent of it fell inside the debounce
+            scroll_start = 0;
+        }
+        if (scroll_start == 0)
+        {
+            scroll_start = now;
+        }
+        ev_at(now, EV_WHEEL_STEP, (uint32_t)steps, rng_unit() < 0.5 ? 1 : 0);
+    }
+next:
+    ev_at(now + (sim_t)(rng_exp(0.35) * SEC), EV_USER, 0, 0);
+}
+
+static void wheel_step(uint32_t left, bool up)
+{
+    // A << 1 | B in the order input_capture.c counts as +1
+    static const uint8_t gray[4] = {0, 2, 3, 1};
+    uint8_t from = gray[enc_phase];
+    enc_phase = (uint8_t)((enc_phase + (up ? 1 : 3)) & 3);
+    uint8_t to = gray[enc_phase];
+
+    // one line changes per step
+    if ((from ^ to) & 2)
+    {
+        switch_edge(PIN_ENC_A, (to >> 1) & 1);
+    }
+    else
+    {
+        switch_edge(PIN_ENC_B, to & 1);
+    }
+    m.detents++;
+    m.net_wheel += up ? 1 : -1;
+
+    if (left > 1)
+    {
+        // slow notches about 80 ms apart, flicks down to 4 ms
+        double gap_ms = left > 6 ? rng_range(4, 15) : rng_range(40, 120);
+        ev_at(now + (sim_t)(gap_ms * MS), EV_WHEEL_STEP, left - 1, up);
+    }
+    else
+    {
+        scrolling = false;
+    }
+}
+
+/* ------------------------------------------------------------------------- move task, main.c move_loop_task() */
+
+static sim_t read_origin;
+static uint8_t burst_raw[SURFACE_BURST_LEN];
+static uint32_t last_read_us;
+static bool draining;
+static bool read_failed; // read_move() == ESP_FAIL
+
+static void sim_move(task_t *t);
+static void sim_move_wait(task_t *t);
+static void sim_move_read(task_t *t);
+static void sim_move_compute(task_t *t);
+static void sim_move_after_delay(task_t *t);
+
+static sim_t spi_read_cost(void)
+{
+    uint8_t dummy[SURFACE_BURST_LEN];
+    spi_bus.now_ns = now;
+    spi.read(spi.ctx, 0x16, dummy, SURFACE_BURST_LEN);
+    return spi_bus.now_ns - now + SPI_OVERHEAD_NS;
+}
+
+static void sim_move(task_t *t)
+{
+    notify_take(t, ms_to_ticks(HEALTH_PERIOD_MS), sim_move_wait);
+}
+
+static void sim_move_health(task_t *t) { sim_move(t); }
+
+static void sim_move_wait(task_t *t)
+{
+    if (t->timed_out)
+    {
+        run(t, COST_HEALTH + 2 * spi_read_cost(), sim_move_health);
+        return;
+    }
+    last_read_us = now_us() - READ_INTERVAL_MS * 1000;
+    draining = motion_level != 0;
+    run(t, spi_read_cost(), sim_move_read);
+}
+
+// the burst is on the wire: take what the sensor accumulated until now
+static void sim_move_read(task_t *t)
+{
+    m.reads++;
+    read_failed = opt.spi_err > 0 && rng_unit() < opt.spi_err;
+    if (read_failed)
+    {
+        // nothing was read, the sensor keeps its counts and MOTION stays low
+        m.spi_errors++;
+        run(t, 0, sim_move_compute);
+        return;
+    }
+    sensor_burst(burst_raw, &read_origin);
+    // MOTION releases with the read unless a frame came in meanwhile
+    if (sensor.acc_x == 0 && sensor.acc_y == 0)
+    {
+        pin_set(PIN_MOTION, 1);
+    }
+    run(t, COST_MOVE, sim_move_compute);
+}
+
+static void motion_emit(int16_t x, int16_t y, uint32_t dt_us, sim_t origin)
+{
+    motion_xform_apply(&xform, &x, &y);
+    accel_apply(&accel, &x, &y, dt_us);
+    if (x != 0 || y != 0)
+    {
+        accum_item_t it = {.x = x, .y = y, .origin = origin};
+        accum_send(&it);
+    }
+}
+
+static void sim_move_backoff(task_t *t) { delay_ticks(t, ms_to_ticks(READ_INTERVAL_MS), sim_move_after_delay); }
+
+static void sim_move_compute(task_t *t)
+{
+    if (!read_failed)
+    {
+        // a gated sample (ESP_ERR_INVALID_STATE) is a read without motion
+        surface_burst_t burst;
+        surface_parse_burst(burst_raw, &burst);
+        bool pass = surface_gate(&surface, &burst);
+        uint32_t us = now_us();
+
+        if (!pass)
+        {
+            m.gated_reads++;
+            m.gated_x += burst.dx;
+            m.gated_y += burst.dy;
+        }
+        else if (burst.dx || burst.dy)
+        {
+            int16_t x = burst.dx, y = burst.dy;
+            motion_filter_apply(&motion_filter, &x, &y, us - last_read_us);
+            motion_emit(x, y, us - last_read_us, read_origin);
+        }
+        last_read_us = us;
+    }
+    else if (!draining)
+    {
+        // SPI error inside the loop: 10 ms back-off before the usual interval
+        delay_ticks(t, ms_to_ticks(10), sim_move_backoff);
+        return;
+    }
+
+    if (draining)
+    {
+        int16_t x, y;
+        if (motion_filter_flush(&motion_filter, &x, &y))
+        {
+            motion_emit(x, y, READ_INTERVAL_MS * 1000, read_origin);
+        }
+        motion_xform_reset(&xform);
+        accel_reset(&accel);
+        sim_move(t);
+        return;
+    }
+    delay_ticks(t, ms_to_ticks(READ_INTERVAL_MS), sim_move_after_delay);
+}
+
+static void sim_move_after_delay(task_t *t)
+{
+    // while (motion_level == 0) read again, else one last drain read
+    draining = motion_level != 0;
+    run(t, spi_read_cost(), sim_move_read);
+}
+
+/* ------------------------------------------------------------------------- accum task */
+
+static void sim_accum(task_t *t);
+
+static void sim_accum_done(task_t *t)
+{
+    accum_item_t item = accum_queue.buf[accum_queue.tail++ % ACCUM_QUEUE_LEN];
+
+    // int16 += int16 as in main.c, wraps on overflow
+    accum_x = (int16_t)(accum_x + item.x);
+    accum_y = (int16_t)(accum_y + item.y);
+    accum_vertical = (int8_t)(accum_vertical + item.vertical);
+    if (item.has_buttons)
+    {
+        buttons = item.buttons;
+    }
+    if (item.origin && (accum_origin == 0 || item.origin < accum_origin))
+    {
+        accum_origin = item.origin;
+    }
+    notify_give(&tasks[TASK_REPORT]);
+    sim_accum(t);
+}
+
+static void sim_accum_recv(task_t *t) { run(t, COST_ACCUM, sim_accum_done); }
+
+static void sim_accum(task_t *t)
+{
+    if (accum_queue.head != accum_queue.tail)
+    {
+        run(t, 0, sim_accum_recv);
+        return;
+    }
+    block_until(t, BLOCK_QUEUE, UINT64_MAX, sim_accum_recv);
+}
+
+/* ------------------------------------------------------------------------- input task */
+
+static void sim_input(task_t *t);
+
+static uint32_t overruns_seen;
+
+static void sim_input_done(task_t *t)
+{
+    input_snap_t snaps[INPUT_BATCH];
+    input_events_t ev = {0};
+    size_t n;
+    uint32_t per_us = CPU_MHZ;
+
+    input_decoder_set_debounce(&input_decoder, CLICK_DEBOUNCE_US * per_us, SCROLL_DEBOUNCE_US * per_us);
+    while ((n = input_ring_pop(&input_ring, snaps, INPUT_BATCH)) > 0)
+    {
+        input_decode(&input_decoder, snaps, n, &ev);
+    }
+    if (input_ring.overruns != overruns_seen)
+    {
+        input_snap_t live = {.pins = pins, .cycles = cycles(now)};
+        overruns_seen = input_ring.overruns;
+        input_decode(&input_decoder, &live, 1, &ev);
+    }
+    input_decoder_tick(&input_decoder, cycles(now), &ev);
+
+    m.bounces += ev.bounces;
+    m.enc_invalid += ev.enc_invalid;
+    if (ev.buttons_changed || ev.vertical)
+    {
+        accum_item_t item = {.vertical = ev.vertical};
+        if (ev.buttons_changed)
+        {
+            item.has_buttons = true;
+            item.buttons = ev.buttons;
+        }
+        accum_send(&item);
+    }
+
+    uint32_t wait = input_decoder_pending(&input_decoder) ? ms_to_ticks(INPUT_PENDING_MS) : ms_to_ticks(INPUT_IDLE_MS);
+    notify_take(t, wait ? wait : 1, sim_input);
+}
+
+static void sim_input(task_t *t)
+{
+    uint32_t queued = input_ring.head - input_ring.tail;
+    run(t, COST_INPUT + (sim_t)queued * COST_INPUT_SNAP, sim_input_done);
+}
+
+/* ------------------------------------------------------------------------- report task */
+
+static uint8_t send_buttons;
+static int32_t send_x, send_y;
+static int8_t send_vertical;
+static sim_t send_origin;
+
+static void sim_report(task_t *t);
+static void sim_report_wake(task_t *t);
+
+static void rate_sync(uint32_t us)
+{
+    uint16_t max_hz = REPORT_RATE_HZ;
+    if (rate_ctl.p.max_hz != max_hz)
+    {
+        rate_params_t p;
+        rate_default_params(&p);
+        p.min_hz = RATE_MIN_HZ < max_hz ? RATE_MIN_HZ : max_hz;
+        p.max_hz = max_hz;
+        rate_ctl_init(&rate_ctl, &p, us);
+    }
+}
+
+static void rate_link(uint32_t us)
+{
+    rate_conn_t c;
+    if (!ble_mounted())
+    {
+        rate_ctl_conn_reset(&rate_ctl);
+        return;
+    }
+    if (rate_ctl_conn_due(&rate_ctl, us, &c))
+    {
+        ble_conn_params(c.itvl_min, c.itvl_max, c.latency, c.timeout);
+    }
+}
+
+static uint32_t report_pace(uint8_t btns, int16_t x, int16_t y, int8_t vertical)
+{
+    static uint8_t last_btns;
+    uint32_t us = now_us();
+    bool event = btns != last_btns || vertical != 0;
+
+    last_btns = btns;
+    rate_sync(us);
+    rate_ctl_set_link(&rate_ctl, ble_conn_itvl());
+    uint32_t pace = rate_ctl_update(&rate_ctl, x, y, event, us);
+    rate_link(us);
+    return (pace + 500) / 1000;
+}
+
+static int16_t clamp_xy(int32_t v)
+{
+    return v > MOUSE_HID_XY_MAX ? MOUSE_HID_XY_MAX : v < -MOUSE_HID_XY_MAX ? -MOUSE_HID_XY_MAX : (int16_t)v;
+}
+
+static void sim_report(task_t *t)
+{
+    notify_take(t, ms_to_ticks(RATE_POLL_MS), sim_report_wake);
+}
+
+static void sim_report_idle(task_t *t)
+{
+    uint32_t us = now_us();
+    rate_sync(us);
+    rate_ctl_poll(&rate_ctl, us);
+    rate_link(us);
+    sim_report(t);
+}
+
+static void sim_report_split(task_t *t);
+
+// take the accumulator, then report_send()
+static void sim_report_take(task_t *t)
+{
+    send_buttons = buttons;
+    send_x = accum_x;
+    send_y = accum_y;
+    send_vertical = accum_vertical;
+    send_origin = accum_origin;
+    accum_x = accum_y = 0;
+    accum_vertical = 0;
+    accum_origin = 0;
+    run(t, COST_HID_SEND, sim_report_split);
+}
+
+static void sim_report_wake(task_t *t)
+{
+    if (t->timed_out)
+    {
+        run(t, COST_REPORT / 2, sim_report_idle);
+        return;
+    }
+    run(t, COST_REPORT, sim_report_take);
+}
+
+// the do/while of report_send(): more to send after the delay
+static void sim_report_next(task_t *t)
+{
+    if (send_x != 0 || send_y != 0 || send_vertical != 0)
+    {
+        run(t, COST_HID_SEND, sim_report_split);
+        return;
+    }
+    sim_report(t);
+}
+
+static void sim_report_split(task_t *t)
+{
+    int16_t x = clamp_xy(send_x), y = clamp_xy(send_y);
+    uint32_t wait_ms;
+
+    if (ble_mounted())
+    {
+        ble_hid_mouse_report(send_buttons, x, y, send_vertical, send_origin);
+        wait_ms = report_pace(send_buttons, x, y, send_vertical);
+    }
+    else
+    {
+        m.not_connected++;
+        wait_ms = 20;
+    }
+    send_x -= x;
+    send_y -= y;
+    send_vertical = 0;
+    if (send_x != 0 || send_y != 0)
+    {
+        m.splits++;
+    }
+    delay_ticks(t, ms_to_ticks(wait_ms), sim_report_next);
+}
+
+/* ------------------------------------------------------------------------- main loop */
+
+static void setup(void)
+{
+    rng_state = opt.seed * 0x9E3779B97F4A7C15ull + 1;
+
+    sched_plan_assign(plan, TASK_COUNT, TASK_BASE_PRIORITY);
+    sched_plan_analyse(plan, TASK_COUNT);
+    static const step_fn_t entry[TASK_COUNT] = {sim_move, sim_accum, sim_input, sim_report, sim_nimble};
+    for (int i = 0; i < TASK_COUNT; i++)
+    {
+        tasks[i] = (task_t){.id = i, .core = plan[i].core, .prio = plan[i].priority};
+        run(&tasks[i], 0, entry[i]);
+    }
+
+    spi_transport_config_t cfg = {.clock_hz = 10000000, .flags = SPI_TRANSPORT_HW_CS};
+    spi_fake_init(&spi_bus, &cfg);
+    spi = spi_fake_transport(&spi_bus);
+
+    surface_params_t sp;
+    surface_default_params(&sp);
+    surface_configure(&surface, &sp);
+    motion_filter_params_t fp;
+    motion_filter_default_params(&fp);
+    motion_filter_configure(&motion_filter, &fp);
+    motion_xform_params_t xp;
+    motion_xform_default_params(&xp);
+    motion_xform_configure(&xform, &xp, false);
+    accel_init(&accel);
+
+    input_decoder_init(&input_decoder, &input_cfg, pins);
+    ble.buf = calloc(opt.stack_buf, sizeof(*ble.buf));
+
+    ev_at((sim_t)(rng_range(0.5, 1.5) * SEC), EV_RECONNECT, 0, 0);
+    ev_at(2 * SEC, EV_USER, 0, 0);
+    for (int c = 0; c < CORES; c++)
+    {
+        core_schedule(c);
+    }
+}
+
+static void dispatch(const event_t *e)
+{
+    switch (e->kind)
+    {
+    case EV_USER:
+        user_next();
+        break;
+    case EV_FRAME:
+        sensor_frame();
+        break;
+    case EV_PIN:
+        pin_set((int)e->a, (int)e->b);
+        break;
+    case EV_BUTTON_UP:
+        m.releases++;
+        switch_edge((int)e->a, 1);
+        break;
+    case EV_WHEEL_STEP:
+        wheel_step(e->a, e->b != 0);
+        break;
+    case EV_CONN:
+        on_conn_event();
+        break;
+    case EV_RECONNECT:
+        link_connect();
+        break;
+    case EV_TASK_WAKE:
+    {
+        task_t *t = &tasks[e->a];
+        if (t->gen == e->b && !t->ready)
+        {
+            wake(t, true);
+        }
+        break;
+    }
+    case EV_TASK_DONE:
+    {
+        task_t *t = &tasks[e->a];
+        core_t *core = &cores[t->core];
+        if (core->running != t || t->gen != e->b)
+        {
+            break; // preempted or charged since
+        }
+        core->busy += now - core->started;
+        core->running = NULL;
+        t->remaining = 0;
+        t->gen++;
+        t->ready = false; // the step ends in run() or a block
+        t->next(t);
+        core_schedule(t->core);
+        break;
+    }
+    }
+}
+
+static void usage(void)
+{
+    fprintf(stderr, "usage: mouse_sim [-s seed] [-t seconds] [-c conn ms, 0 = follow] [-l loss %%] [-b bounce ms]\n"
+                    "                 [-L lift %%] [-e SPI error %%] [-F sensor fps] [-T tick Hz] [-p packets/event] [-q stack buffer] [-w] [-v]\n");
+}
+
+int main(int argc, char **argv)
+{
+    int o;
+    while ((o = getopt(argc, argv, "s:t:c:l:b:L:e:F:T:p:q:wvh")) != -1)
+    {
+        switch (o)
+        {
+        case 's':
+            opt.seed = strtoull(optarg, NULL, 0);
+            break;
+        case 't':
+            opt.seconds = atof(optarg);
+            break;
+        case 'c':
+            opt.conn_ms = atof(optarg);
+            break;
+        case 'l':
+            opt.loss = atof(optarg) / 100;
+            break;
+        case 'b':
+            opt.bounce_ms = atof(optarg);
+            break;
+        case 'L':
+            opt.lift = atof(optarg) / 100;
+            break;
+        case 'e':
+            opt.spi_err = atof(optarg) / 100;
+            break;
+        case 'F':
+            opt.fps = (uint32_t)atoi(optarg);
+            break;
+        case 'T':
+            opt.tick_hz = (uint32_t)atoi(optarg);
+            break;
+        case 'p':
+            opt.per_event = (uint32_t)atoi(optarg);
+            break;
+        case 'q':
+            opt.stack_buf = (uint32_t)atoi(optarg);
+            break;
+        case 'w':
+            opt.wheel_only = true;
+            break;
+        case 'v':
+            opt.verbose = true;
+            break;
+        default:
+            usage();
+            return 2;
+        }
+    }
+    if (opt.fps == 0 || opt.tick_hz == 0 || opt.per_event == 0 || opt.stack_buf == 0 || opt.seconds <= 0)
+    {
+        usage();
+        return 2;
+    }
+
+    struct timespec w0, w1;
+    clock_gettime(CLOCK_MONOTONIC, &w0);
+
+    setup();
+    sim_t end = (sim_t)(opt.seconds * SEC);
+    sim_t next_progress = 600 * SEC;
+    while (heap_len > 0 && heap[0].t <= end)
+    {
+        event_t e = ev_pop();
+        now = e.t;
+        ev_count++;
+        dispatch(&e);
+        if (opt.verbose && now >= next_progress)
+        {
+            fprintf(stderr, "%.0f s simulated\n", now / 1e9);
+            next_progress += 600 * SEC;
+        }
+    }
+    now = end;
+
+    clock_gettime(CLOCK_MONOTONIC, &w1);
+    double wall = (w1.tv_sec - w0.tv_sec) + (w1.tv_nsec - w0.tv_nsec) / 1e9;
+
+    printf("seed %llu, %.0f s simulated in %.2f s (%.0fx), %llu events\n", (unsigned long long)opt.seed, opt.seconds,
+           wall, opt.seconds / wall, (unsigned long long)ev_count);
+    printf("link: %s interval, %.1f%% loss, %u per event, %u buffered, %.1f ms bounce, %u fps, %u Hz tick\n",
+           opt.conn_ms ? "fixed" : "requested", opt.loss * 100, opt.per_event, opt.stack_buf, opt.bounce_ms, opt.fps,
+           opt.tick_hz);
+
+    printf("\nlatency to the central (ms)\n  %-8s %9s %9s %9s %9s %9s\n", "", "count", "p50", "p99", "p99.9", "max");
+    samples_print("motion", &m.motion);
+    samples_print("button", &m.button);
+    samples_print("wheel", &m.wheel);
+
+    // unmatched presses and detents never reached the central
+    uint64_t lost_presses = 0;
+    for (int b = 0; b < 3; b++)
+    {
+        lost_presses += fifo_lost(&press_fifo[b]);
+    }
+    printf("\ndelivery\n");
+    printf("  motion   sensor %lld,%lld  gated %lld,%lld  central %lld,%lld  (%llu strokes, %llu lifts)\n",
+           (long long)m.sensor_x, (long long)m.sensor_y, (long long)m.gated_x, (long long)m.gated_y,
+           (long long)ble.host_x, (long long)ble.host_y, (unsigned long long)m.strokes, (unsigned long long)m.lifts);
+    printf("  reads    %llu, %llu gated, %llu SPI errors\n", (unsigned long long)m.reads,
+           (unsigned long long)m.gated_reads, (unsigned long long)m.spi_errors);
+    printf("  buttons  %llu presses, %llu never arrived, central ends with 0x%02x\n", (unsigned long long)m.presses,
+           (unsigned long long)lost_presses, ble.host_buttons);
+    printf("  wheel    %llu detents in %llu scrolls (%llu never arrived), net %lld; central %llu steps, net %lld\n",
+           (unsigned long long)m.detents, (unsigned long long)m.scrolls, (unsigned long long)m.scrolls_lost,
+           (long long)m.net_wheel,
+           (unsigned long long)ble.host_wheel_steps, (long long)ble.host_wheel);
+
+    printf("\nfirmware\n");
+    printf("  reads %llu (%llu motion wakes), accum queue full %llu, input ring overruns %lu\n",
+           (unsigned long long)m.reads, (unsigned long long)m.move_wakes, (unsigned long long)m.queue_full,
+           (unsigned long)input_ring.overruns);
+    printf("  bounces rejected %llu, encoder resyncs %llu\n", (unsigned long long)m.bounces,
+           (unsigned long long)m.enc_invalid);
+    printf("  reports %llu (%llu splits), stack buffer full %llu, dropped while disconnected %llu\n",
+           (unsigned long long)m.reports, (unsigned long long)m.splits, (unsigned long long)m.stack_full,
+           (unsigned long long)m.not_connected);
+    printf("  link: %llu events, %llu packets, %llu retried, %llu interval updates, %llu disconnects (%llu reports "
+           "flushed)\n",
+           (unsigned long long)m.conn_events, (unsigned long long)m.packets, (unsigned long long)m.retries,
+           (unsigned long long)m.conn_updates, (unsigned long long)m.disconnects, (unsigned long long)m.flushed);
+
+    printf("\ntasks     core prio  budget us  analysed us  worst us\n");
+    for (int i = 0; i < TASK_COUNT; i++)
+    {
+        printf("  %-7s %4d %4u %10lu %12lu %9.0f\n", plan[i].name, plan[i].core, plan[i].priority,
+               (unsigned long)plan[i].deadline_us, (unsigned long)plan[i].response_us,
+               tasks[i].response_max / 1000.0);
+    }
+    for (int c = 0; c < CORES; c++)
+    {
+        printf("  core %d busy %.2f%%\n", c, 100.0 * cores[c].busy / end);
+    }
+
+    printf("\ndigest %016llx\n", (unsigned long long)m.digest);
+    return 0;
+}
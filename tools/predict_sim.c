@@ -0,0 +1,246 @@
+/*
+ * Host evaluation of predict.c: perceived latency against position error.
+ *
+ *   cc -I. tools/predict_sim.c predict.c -lm -o predict_sim
+ *   ./predict_sim [trace.txt]
+ *
+ * A 1 kHz motion trace (built in, or one "dx dy" pair per line) is reported
+ * every REPORT_MS and each report reaches the host at the next connection
+ * event. For every lead the table shows:
+ *   latency   the delay of the host cursor against the sensor, the shift of
+ *             the true path that fits the host path best (ms), negative
+ *             when the cursor runs ahead
+ *   fit err   RMS distance left after that shift, the shape error (counts)
+ *   overshoot how far the cursor ran past the point where motion stopped,
+ *             worst case (counts)
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "predict.h"
+
+#define TRACE_MAX 60000
+#define REPORT_MS 8
+#define CONN_ITVL_US 7500
+#define SHIFT_MAX_MS 40
+
+typedef struct
+{
+    int16_t dx, dy;
+} sample_t;
+
+static sample_t trace[TRACE_MAX];
+static int trace_len;
+
+static double true_x[TRACE_MAX], true_y[TRACE_MAX];
+static double host_x[TRACE_MAX], host_y[TRACE_MAX];
+
+static void add_stroke(int *t, double peak, double angle, int len)
+{
+    double fx = 0, fy = 0;
+    for (int i = 0; i < len && *t < TRACE_MAX; i++, (*t)++)
+    {
+        double v = peak * sin(M_PI * i / len);
+        double nx = fx + v * cos(angle);
+        double ny = fy + v * sin(angle);
+        trace[*t].dx = (int16_t)(lround(nx) - lround(fx));
+        trace[*t].dy = (int16_t)(lround(ny) - lround(fy));
+        fx = nx;
+        fy = ny;
+    }
+}
+
+static void gen_strokes(void)
+{
+    // aiming: strokes of 1..12 counts/ms in varied directions, pauses between
+    int t = 0;
+    memset(trace, 0, sizeof(trace));
+    for (int i = 0; t < 10000; i++)
+    {
+        add_stroke(&t, 1.0 + (i * 7) % 12, i * 2.3, 120 + (i * 53) % 200);
+        t += 150;
+    }
+    trace_len = t;
+}
+
+static void gen_circles(void)
+{
+    // steady circles, 6 counts/ms, radius ~380 counts
+    double fx = 0, fy = 0;
+    memset(trace, 0, sizeof(trace));
+    for (int t = 0; t < 10000; t++)
+    {
+        double a = t / 400.0;
+        double nx = fx + 6.0 * cos(a);
+        double ny = fy + 6.0 * sin(a);
+        trace[t].dx = (int16_t)(lround(nx) - lround(fx));
+        trace[t].dy = (int16_t)(lround(ny) - lround(fy));
+        fx = nx;
+        fy = ny;
+    }
+    trace_len = 10000;
+}
+
+static void gen_flicks(void)
+{
+    // fast flicks with an immediate way back, the worst case for overshoot
+    int t = 0;
+    memset(trace, 0, sizeof(trace));
+    while (t < 10000)
+    {
+        add_stroke(&t, 40.0, 0.1, 100);
+        add_stroke(&t, 25.0, M_PI + 0.1, 120);
+        t += 300;
+    }
+    trace_len = t;
+}
+
+static int load_trace(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    int dx, dy;
+    if (f == NULL)
+    {
+        perror(path);
+        return -1;
+    }
+    trace_len = 0;
+    while (trace_len < TRACE_MAX && fscanf(f, "%d %d", &dx, &dy) == 2)
+    {
+        trace[trace_len].dx = (int16_t)dx;
+        trace[trace_len].dy = (int16_t)dy;
+        trace_len++;
+    }
+    fclose(f);
+    return trace_len > 0 ? 0 : -1;
+}
+
+typedef struct
+{
+    int latency_ms;
+    double fit_err;
+    double overshoot;
+} result_t;
+
+static result_t run(uint32_t lead_us)
+{
+    predict_t pr;
+    predict_params_t p;
+    result_t res = {0};
+    double tx = 0, ty = 0, hx = 0, hy = 0;
+    int32_t acc_x = 0, acc_y = 0;
+    int32_t queued_x = 0, queued_y = 0;
+    double dir_x = 0, dir_y = 0; // last direction of motion
+    int still_ms = 0;
+
+    predict_default_params(&p);
+    predict_init(&pr, &p);
+
+    for (int ms = 0; ms < trace_len; ms++)
+    {
+        uint32_t now = (uint32_t)ms * 1000;
+
+        tx += trace[ms].dx;
+        ty += trace[ms].dy;
+        acc_x += trace[ms].dx;
+        acc_y += trace[ms].dy;
+        if (trace[ms].dx || trace[ms].dy)
+        {
+            double n = hypot(trace[ms].dx, trace[ms].dy);
+            dir_x = trace[ms].dx / n;
+            dir_y = trace[ms].dy / n;
+            still_ms = 0;
+        }
+        else
+        {
+            still_ms++;
+        }
+
+        // report task as in main.c: motion, or a pending correction, at most every REPORT_MS
+        if (ms % REPORT_MS == 0 && (acc_x || acc_y || predict_pending(&pr)))
+        {
+            int32_t x = acc_x, y = acc_y;
+            predict_apply(&pr, &x, &y, now, lead_us);
+            queued_x += x;
+            queued_y += y;
+            acc_x = acc_y = 0;
+        }
+        if (now % CONN_ITVL_US < 1000)
+        {
+            hx += queued_x;
+            hy += queued_y;
+            queued_x = queued_y = 0;
+        }
+
+        true_x[ms] = tx;
+        true_y[ms] = ty;
+        host_x[ms] = hx;
+        host_y[ms] = hy;
+
+        // past the stop point along the last direction, once the sensor has been still a while
+        if (still_ms > REPORT_MS)
+        {
+            double over = (hx - tx) * dir_x + (hy - ty) * dir_y;
+            if (over > res.overshoot)
+            {
+                res.overshoot = over;
+            }
+        }
+    }
+
+    double best = INFINITY;
+    for (int shift = -SHIFT_MAX_MS; shift <= SHIFT_MAX_MS; shift++)
+    {
+        double err2 = 0;
+        for (int ms = SHIFT_MAX_MS; ms < trace_len - SHIFT_MAX_MS; ms++)
+        {
+            double ex = host_x[ms] - true_x[ms - shift];
+            double ey = host_y[ms] - true_y[ms - shift];
+            err2 += ex * ex + ey * ey;
+        }
+        if (err2 < best)
+        {
+            best = err2;
+            res.latency_ms = shift;
+        }
+    }
+    res.fit_err = sqrt(best / (trace_len - 2 * SHIFT_MAX_MS));
+    return res;
+}
+
+static void report(const char *name)
+{
+    static const uint32_t leads_us[] = {0, 4000, 8000, 12000, 16000};
+
+    for (size_t i = 0; i < sizeof(leads_us) / sizeof(leads_us[0]); i++)
+    {
+        result_t r = run(leads_us[i]);
+        printf("%-10s %6u %9d %9.2f %10.1f\n", name, (unsigned)(leads_us[i] / 1000), r.latency_ms, r.fit_err,
+               r.overshoot);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    printf("%-10s %6s %9s %9s %10s\n", "trace", "lead", "latency", "fit err", "overshoot");
+
+    if (argc > 1)
+    {
+        if (load_trace(argv[1]) != 0)
+        {
+            return 1;
+        }
+        report(argv[1]);
+        return 0;
+    }
+
+    gen_strokes();
+    report("strokes");
+    gen_circles();
+    report("circles");
+    gen_flicks();
+    report("flicks");
+    return 0;
+}
@@ -0,0 +1,228 @@
+/*
+ * Host simulation of the report pacing: fixed rate against rate_ctl.c.
+ *
+ *   cc -I. tools/rate_sim.c rate_ctl.c -lm -o rate_sim && ./rate_sim
+ *
+ * Canned 1 kHz sensor traces run through both pacers. For each the table
+ * shows HID notifications per second, connection events the radio attends
+ * per second (connection interval and peripheral latency as requested by
+ * the pacer, applied instantly), and the cursor error: distance between the
+ * pointer position the host has seen and the true one, RMS and peak, in
+ * sensor counts. The peak is split: the first second starts from the idle
+ * link for the adaptive pacer and shows what waking costs.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "rate_ctl.h"
+
+#define TRACE_MS 10000
+#define FIXED_INTERVAL_MS 7 // MOUSE_REPORT_RATE_DEFAULT in whole ms, as main.c paces it
+#define FIXED_ITVL 6        // 7.5 ms, what centrals usually grant a mouse
+#define WARMUP_MS 1000
+
+typedef struct
+{
+    int16_t dx, dy;
+    bool click; // button edge this millisecond
+} sample_t;
+
+static sample_t trace[TRACE_MS];
+
+typedef void (*gen_fn)(void);
+
+static void gen_idle_clicks(void)
+{
+    memset(trace, 0, sizeof(trace));
+    for (int t = 500; t < TRACE_MS; t += 4000)
+    {
+        trace[t].click = true;
+        trace[t + 90].click = true;
+    }
+}
+
+static void gen_precise(void)
+{
+    // slow drawing strokes, 0.3..1.5 counts/ms, short pauses between
+    double fx = 0, fy = 0;
+    memset(trace, 0, sizeof(trace));
+    for (int t = 0; t < TRACE_MS; t++)
+    {
+        if (t % 2000 > 1700)
+        {
+            continue;
+        }
+        double v = 0.9 + 0.6 * sin(t / 300.0);
+        double a = t / 700.0;
+        double nx = fx + v * cos(a);
+        double ny = fy + v * sin(a);
+        trace[t].dx = (int16_t)(lround(nx) - lround(fx));
+        trace[t].dy = (int16_t)(lround(ny) - lround(fy));
+        fx = nx;
+        fy = ny;
+    }
+}
+
+static void gen_flicks(void)
+{
+    // 150 ms flicks peaking at 40 counts/ms, a click after each
+    memset(trace, 0, sizeof(trace));
+    for (int start = 300; start + 200 < TRACE_MS; start += 800)
+    {
+        int dir = (start / 800) % 2 ? 1 : -1;
+        for (int t = 0; t < 150; t++)
+        {
+            trace[start + t].dx = (int16_t)(dir * 40.0 * sin(M_PI * t / 150.0));
+            trace[start + t].dy = (int16_t)(8.0 * sin(M_PI * t / 150.0));
+        }
+        trace[start + 180].click = true;
+        trace[start + 230].click = true;
+    }
+}
+
+static void gen_mixed(void)
+{
+    sample_t tmp[TRACE_MS];
+    gen_precise();
+    memcpy(tmp, trace, sizeof(tmp));
+    gen_flicks();
+    for (int t = 0; t < TRACE_MS; t++)
+    {
+        if (t >= TRACE_MS / 2)
+        {
+            trace[t] = tmp[t];
+        }
+    }
+}
+
+typedef struct
+{
+    double reports_s;
+    double events_s;
+    double rms;
+    double peak;
+    double wake_peak; // first second, the adaptive link starts out idle
+} result_t;
+
+static result_t run(bool adaptive)
+{
+    rate_ctl_t rc;
+    rate_params_t p;
+    result_t res = {0};
+    long true_x = 0, true_y = 0, host_x = 0, host_y = 0;
+    long acc_x = 0, acc_y = 0;
+    bool pending_event = false;
+    unsigned reports = 0, events = 0;
+    double err2 = 0;
+
+    uint32_t next_report_us = 0;
+    uint32_t itvl = FIXED_ITVL, latency = 0, skipped = 0;
+    uint32_t next_event_us = 0;
+    long queued = 0; // notifications waiting for a connection event
+    long queued_x = 0, queued_y = 0;
+
+    rate_default_params(&p);
+    rate_ctl_init(&rc, &p, 0);
+
+    for (uint32_t ms = 0; ms < TRACE_MS; ms++)
+    {
+        uint32_t now = ms * 1000;
+        const sample_t *s = &trace[ms];
+
+        true_x += s->dx;
+        true_y += s->dy;
+        acc_x += s->dx;
+        acc_y += s->dy;
+        pending_event |= s->click;
+
+        // report task: send when there is something and the pace allows
+        if ((acc_x || acc_y || pending_event) && (int32_t)(now - next_report_us) >= 0)
+        {
+            uint32_t interval_us = FIXED_INTERVAL_MS * 1000;
+            if (adaptive)
+            {
+                interval_us = rate_ctl_update(&rc, acc_x, acc_y, pending_event, now);
+            }
+            queued++;
+            queued_x += acc_x;
+            queued_y += acc_y;
+            acc_x = acc_y = 0;
+            pending_event = false;
+            reports++;
+            next_report_us = now + interval_us;
+        }
+        else if (adaptive && ms % 500 == 0)
+        {
+            rate_ctl_poll(&rc, now);
+        }
+
+        rate_conn_t c;
+        if (adaptive && rate_ctl_conn_due(&rc, now, &c))
+        {
+            itvl = c.itvl_max;
+            latency = c.latency;
+            rate_ctl_set_link(&rc, itvl);
+        }
+
+        // radio: a connection event every interval, skippable only with nothing queued
+        if ((int32_t)(now - next_event_us) >= 0)
+        {
+            next_event_us = now + itvl * 1250;
+            if (queued || skipped >= latency)
+            {
+                events++;
+                skipped = 0;
+                host_x += queued_x;
+                host_y += queued_y;
+                queued = queued_x = queued_y = 0;
+            }
+            else
+            {
+                skipped++;
+            }
+        }
+
+        double e = hypot((double)(true_x - host_x), (double)(true_y - host_y));
+        err2 += e * e;
+        double *peak = ms < WARMUP_MS ? &res.wake_peak : &res.peak;
+        if (e > *peak)
+        {
+            *peak = e;
+        }
+    }
+
+    res.reports_s = reports * 1000.0 / TRACE_MS;
+    res.events_s = events * 1000.0 / TRACE_MS;
+    res.rms = sqrt(err2 / TRACE_MS);
+    return res;
+}
+
+int main(void)
+{
+    static const struct
+    {
+        const char *name;
+        gen_fn gen;
+    } traces[] = {
+        {"idle+clicks", gen_idle_clicks},
+        {"precise", gen_precise},
+        {"flicks", gen_flicks},
+        {"mixed", gen_mixed},
+    };
+
+    printf("%-12s %-8s %9s %9s %8s %8s %8s\n", "trace", "pacer", "reports/s", "events/s", "rms err", "peak err",
+           "wake err");
+    for (size_t i = 0; i < sizeof(traces) / sizeof(traces[0]); i++)
+    {
+        traces[i].gen();
+        for (int adaptive = 0; adaptive < 2; adaptive++)
+        {
+            result_t r = run(adaptive);
+            printf("%-12s %-8s %9.1f %9.1f %8.2f %8.1f %8.1f\n", traces[i].name, adaptive ? "adaptive" : "fixed",
+                   r.reports_s, r.events_s, r.rms, r.peak, r.wake_peak);
+        }
+    }
+    return 0;
+}
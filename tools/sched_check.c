@@ -0,0 +1,124 @@
+/*
+ * Host check of sched_plan.c on the firmware's task plan: the priorities
+ * sched_plan_assign() hands out and the response times sched_plan_analyse()
+ * promises, on two cores and on one.
+ *
+ *   cc -I. tools/sched_check.c sched_plan.c task_plan.c -o sched_check && ./sched_check
+ *
+ * The plan comes from task_plan_init() with the CONFIG_* defaults of
+ * task_plan.h, so a change to the firmware's table shows up here. Response
+ * times are worked out by hand in the comments. Exits non-zero on the first
+ * broken expectation of each case.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sched_plan.h"
+#include "task_plan.h"
+
+#define NIMBLE_PRIORITY 21 // configMAX_PRIORITIES - 4 with IDF's 25
+
+static int failures;
+
+#define CHECK(cond, ...)                  \
+    do                                    \
+    {                                     \
+        if (!(cond))                      \
+        {                                 \
+            printf("FAIL: " __VA_ARGS__); \
+            printf("\n");                 \
+            failures++;                   \
+            return;                       \
+        }                                 \
+    } while (0)
+
+static sched_task_t plan[TASK_COUNT];
+
+// the firmware's placement on two cores (1, 0) or on one (SCHED_ANY_CORE)
+static void make_plan(int sensor_core, int host_core)
+{
+    task_plan_init(plan, sensor_core, host_core, NIMBLE_PRIORITY);
+    sched_plan_assign(plan, TASK_COUNT, CONFIG_TASK_BASE_PRIORITY);
+}
+
+// shortest budget first, accum and input tie at 500 us and keep table order
+static void check_priorities(void)
+{
+    make_plan(1, 0);
+    CHECK(plan[TASK_ACCUM].priority == 8, "accum prio %u", plan[TASK_ACCUM].priority);
+    CHECK(plan[TASK_INPUT].priority == 7, "input prio %u", plan[TASK_INPUT].priority);
+    CHECK(plan[TASK_MOVE].priority == 6, "move prio %u", plan[TASK_MOVE].priority);
+    CHECK(plan[TASK_REPORT].priority == CONFIG_TASK_BASE_PRIORITY, "report prio %u", plan[TASK_REPORT].priority);
+    CHECK(plan[TASK_NIMBLE].priority == NIMBLE_PRIORITY, "fixed nimble moved to %u", plan[TASK_NIMBLE].priority);
+
+    // the base only shifts the ranks
+    sched_plan_assign(plan, TASK_COUNT, 10);
+    CHECK(plan[TASK_ACCUM].priority == 13 && plan[TASK_REPORT].priority == 10, "base 10 gave %u..%u",
+          plan[TASK_REPORT].priority, plan[TASK_ACCUM].priority);
+}
+
+static void check_dual_core(void)
+{
+    make_plan(1, 0);
+    CHECK(sched_plan_analyse(plan, TASK_COUNT), "plan misses on two cores");
+
+    // core 1: accum alone, input behind accum, move behind both: 150 + 50 + 40
+    CHECK(plan[TASK_ACCUM].response_us == 50, "accum %u us", plan[TASK_ACCUM].response_us);
+    CHECK(plan[TASK_INPUT].response_us == 90, "input %u us", plan[TASK_INPUT].response_us);
+    CHECK(plan[TASK_MOVE].response_us == 240, "move %u us", plan[TASK_MOVE].response_us);
+    // core 0: the host runs a connection event over the report task
+    CHECK(plan[TASK_NIMBLE].response_us == 1000, "nimble %u us", plan[TASK_NIMBLE].response_us);
+    CHECK(plan[TASK_REPORT].response_us == 1300, "report %u us", plan[TASK_REPORT].response_us);
+
+    CHECK(sched_plan_load(plan, TASK_COUNT, 1) == 8, "core 1 at %u%%", sched_plan_load(plan, TASK_COUNT, 1));
+    CHECK(sched_plan_load(plan, TASK_COUNT, 0) == 18, "core 0 at %u%%", sched_plan_load(plan, TASK_COUNT, 0));
+}
+
+// the report budget holds a whole connection event: up to 1000 us of
+// report work fits in 2000, a microsecond more does not
+static void check_report_margin(void)
+{
+    make_plan(1, 0);
+    plan[TASK_REPORT].wcet_us = 1000;
+    CHECK(sched_plan_analyse(plan, TASK_COUNT), "1000 us report does not fit");
+    CHECK(plan[TASK_REPORT].response_us == 2000, "report %u us", plan[TASK_REPORT].response_us);
+
+    plan[TASK_REPORT].wcet_us = 1001;
+    CHECK(!sched_plan_analyse(plan, TASK_COUNT), "1001 us report fits");
+    CHECK(!plan[TASK_REPORT].ok && plan[TASK_REPORT].response_us == UINT32_MAX, "report %u us, ok %d",
+          plan[TASK_REPORT].response_us, plan[TASK_REPORT].ok);
+    CHECK(plan[TASK_MOVE].ok && plan[TASK_NIMBLE].ok, "miss spilled onto other tasks");
+}
+
+// on a single core the NimBLE host lands on the sensor path: accum, input and
+// move all wait out a connection event and miss, the report task still fits
+static void check_single_core(void)
+{
+    make_plan(SCHED_ANY_CORE, SCHED_ANY_CORE);
+    CHECK(!sched_plan_analyse(plan, TASK_COUNT), "single core plan passes");
+    CHECK(!plan[TASK_ACCUM].ok && !plan[TASK_INPUT].ok && !plan[TASK_MOVE].ok, "sensor path ok %d %d %d",
+          plan[TASK_ACCUM].ok, plan[TASK_INPUT].ok, plan[TASK_MOVE].ok);
+    CHECK(plan[TASK_NIMBLE].ok && plan[TASK_NIMBLE].response_us == 1000, "nimble %u us",
+          plan[TASK_NIMBLE].response_us);
+    // 300 + 1000 + 150 + 50 + 40, then input a second time
+    CHECK(plan[TASK_REPORT].ok && plan[TASK_REPORT].response_us == 1580, "report %u us",
+          plan[TASK_REPORT].response_us);
+}
+
+static void check_stack_size(void)
+{
+    CHECK(sched_stack_size(3000, 25) == 3840, "3000 + 25%% gave %u", sched_stack_size(3000, 25));
+    CHECK(sched_stack_size(2048, 0) == 2048, "exact multiple rounded up");
+}
+
+int main(void)
+{
+    check_priorities();
+    check_dual_core();
+    check_report_margin();
+    check_single_core();
+    check_stack_size();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
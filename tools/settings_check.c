@@ -0,0 +1,208 @@
+/*
+ * Host check of settings.c on the NOR flash model: how many erase/program
+ * cycles a burst of setter calls costs.
+ *
+ *   cc -I. tools/settings_check.c settings.c settings_flash_fake.c accel.c motion_xform.c cpi.c \
+ *      surface.c motion_filter.c macro.c -lm -o settings_check && ./settings_check
+ *
+ * Time is driven by hand: settings_poll() runs every POLL_MS as the settings
+ * task does, with the quiet period of settings_nvs.c. Exits non-zero on the
+ * first broken expectation of each case.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "settings.h"
+#include "settings_flash_fake.h"
+
+#define QUIET_MS 3000 // CONFIG_SETTINGS_QUIET_MS
+#define POLL_MS 250   // CONFIG_SETTINGS_POLL_MS
+
+static int failures;
+
+#define CHECK(cond, ...)                  \
+    do                                    \
+    {                                     \
+        if (!(cond))                      \
+        {                                 \
+            printf("FAIL: " __VA_ARGS__); \
+            printf("\n");                 \
+            failures++;                   \
+            return;                       \
+        }                                 \
+    } while (0)
+
+static settings_flash_fake_t flash;
+static uint32_t now_ms;
+
+static void start(uint32_t t0)
+{
+    settings_flash_fake_init(&flash);
+    settings_backend_t be = settings_flash_fake_backend(&flash);
+    settings_init(&be, QUIET_MS);
+    now_ms = t0;
+}
+
+// poll as the settings task would until `ms` have passed, return the commits attempted
+static unsigned run(uint32_t ms)
+{
+    unsigned commits = 0;
+
+    for (uint32_t end = now_ms + ms; (int32_t)(end - now_ms) > 0;)
+    {
+        now_ms += POLL_MS;
+        commits += settings_poll(now_ms);
+    }
+    return commits;
+}
+
+// what api_set_dpi() stores: both axes of the current stage
+static void set_dpi(uint16_t dpi)
+{
+    settings_t s = settings_get();
+    cpi_stages_set(&s.cpi, s.cpi.current, dpi, dpi, s.cpi.count);
+    settings_set_cpi(&s.cpi);
+}
+
+static uint16_t stored_dpi(void)
+{
+    settings_t s;
+    settings_backend_t be = settings_flash_fake_backend(&flash);
+    uint8_t blob[SETTINGS_BLOB_MAX];
+    size_t len = sizeof(blob);
+
+    if (be.read(be.ctx, blob, &len) != SETTINGS_OK || settings_decode(blob, len, &s) != SETTINGS_OK)
+    {
+        return 0;
+    }
+    return cpi_stages_current(&s.cpi).x;
+}
+
+static void check_empty(void)
+{
+    settings_backend_t be;
+
+    settings_flash_fake_init(&flash);
+    be = settings_flash_fake_backend(&flash);
+    CHECK(settings_init(&be, QUIET_MS) == SETTINGS_ERR_NOT_FOUND, "erased sector not reported");
+    CHECK(!settings_dirty(), "defaults marked dirty");
+    now_ms = 0;
+    CHECK(run(60000) == 0 && flash.erase_count == 0, "idle minute wrote flash");
+}
+
+// the DPI button held down: a change every 100 ms for 20 s, one commit after it stops
+static void check_dpi_burst(void)
+{
+    start(0);
+    for (int i = 0; i < 200; i++)
+    {
+        set_dpi((uint16_t)(400 + (i % 8) * 400));
+        CHECK(run(100) == 0, "commit %d ms into the burst", i * 100);
+    }
+    uint16_t last = (uint16_t)(400 + (199 % 8) * 400);
+    uint32_t stop = now_ms;
+
+    CHECK(flash.erase_count == 0 && flash.write_count == 0, "flash touched during the burst");
+    CHECK(run(QUIET_MS - POLL_MS) == 0, "commit before the quiet period");
+    CHECK(run(2 * POLL_MS) == 1, "no single commit after the quiet period");
+    CHECK(now_ms - stop <= QUIET_MS + POLL_MS, "commit %u ms after the last change", (unsigned)(now_ms - stop));
+    CHECK(flash.erase_count == 1 && flash.write_count == 1, "%u erases %u writes for the burst", flash.erase_count,
+          flash.write_count);
+    CHECK(stored_dpi() == last, "stored %u, last set %u", stored_dpi(), last);
+    CHECK(flash.bytes_written == SETTINGS_BLOB_MAX, "%u bytes for one blob", flash.bytes_written);
+
+    CHECK(run(60000) == 0 && flash.erase_count == 1, "rewrote a clean store");
+}
+
+// setting the stored value again is not a change
+static void check_same_value(void)
+{
+    start(0);
+    set_dpi(1200);
+    run(QUIET_MS + POLL_MS);
+    CHECK(flash.write_count == 1, "first commit");
+    for (int i = 0; i < 50; i++)
+    {
+        set_dpi(1200);
+        run(POLL_MS);
+    }
+    CHECK(!settings_dirty() && flash.write_count == 1, "unchanged value committed again");
+}
+
+// changes further apart than the quiet period each get their own commit
+static void check_spaced(void)
+{
+    start(0);
+    for (int i = 0; i < 10; i++)
+    {
+        set_dpi((uint16_t)(800 + i * 50));
+        run(QUIET_MS + 2 * POLL_MS);
+    }
+    CHECK(flash.erase_count == 10 && flash.write_count == 10, "%u erases %u writes for 10 spaced changes",
+          flash.erase_count, flash.write_count);
+}
+
+// a failed program stays pending and is retried on the next poll, without an extra erase
+static void check_retry(void)
+{
+    start(0);
+    set_dpi(2000);
+    flash.fail_writes = 1;
+    CHECK(run(QUIET_MS + POLL_MS) >= 1, "no commit attempted");
+    CHECK(flash.write_count == 0 && settings_dirty(), "failed write lost the change");
+    CHECK(run(POLL_MS) == 1, "no retry on the next poll");
+    CHECK(flash.erase_count == 1 && flash.write_count == 1 && !settings_dirty(), "%u erases %u writes after retry",
+          flash.erase_count, flash.write_count);
+    CHECK(stored_dpi() == 2000, "stored %u after retry", stored_dpi());
+}
+
+// settings_flush() before sleep: immediate when dirty, free when clean
+static void check_flush(void)
+{
+    start(0);
+    set_dpi(3000);
+    CHECK(settings_flush() == SETTINGS_OK && flash.write_count == 1, "flush did not write");
+    CHECK(settings_flush() == SETTINGS_OK && flash.write_count == 1, "clean flush wrote");
+    CHECK(run(QUIET_MS + POLL_MS) == 0, "poll committed a flushed store");
+}
+
+// the tick counter wraps, the quiet period must not
+static void check_wrap(void)
+{
+    start(UINT32_MAX - 1000);
+    set_dpi(600);
+    run(POLL_MS);
+    CHECK(flash.write_count == 0, "committed right away across the wrap");
+    run(QUIET_MS);
+    CHECK(flash.write_count == 1, "%u writes across the wrap", flash.write_count);
+}
+
+// what was committed is what the next boot loads
+static void check_reload(void)
+{
+    start(0);
+    set_dpi(4550);
+    run(QUIET_MS + POLL_MS);
+
+    settings_backend_t be = settings_flash_fake_backend(&flash);
+    CHECK(settings_init(&be, QUIET_MS) == SETTINGS_OK, "stored blob not loaded");
+    settings_t s = settings_get();
+    CHECK(cpi_stages_current(&s.cpi).x == 4550, "reloaded %u", cpi_stages_current(&s.cpi).x);
+    CHECK(!settings_dirty(), "load marked dirty");
+}
+
+int main(void)
+{
+    check_empty();
+    check_dpi_burst();
+    check_same_value();
+    check_spaced();
+    check_retry();
+    check_flush();
+    check_wrap();
+    check_reload();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,158 @@
+/*
+ * Host check of the boot-time SPI clock choice in spi_transport.c, with a
+ * probe shaped like paw3395.c's spi_clock_probe() running on spi_fake.c.
+ *
+ *   cc -I. tools/spi_cal_check.c spi_fake.c spi_transport.c -o spi_cal_check && ./spi_cal_check
+ *
+ * The fake sensor answers its product ID and reads back what was written up
+ * to limit_hz; above that every frame fails. Exits non-zero on the first
+ * broken expectation of each case.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sensor_health.h"
+#include "spi_fake.h"
+
+#define RESOLUTION_X_LOW 0x48 // scratch register, only latched by SET_RESOLUTION
+#define CAL_ROUNDS 4          // CONFIG_PAW3395_SPI_CAL_ROUNDS, fewer to keep counts small
+#define CAL_MARGIN 1          // CONFIG_PAW3395_SPI_CAL_MARGIN
+#define START_HZ 4000000      // CONFIG_PAW3395_SPI_CLOCK_HZ
+#define PROBE_FRAMES (CAL_ROUNDS * 4)
+
+static int failures;
+
+#define CHECK(cond, ...)                  \
+    do                                    \
+    {                                     \
+        if (!(cond))                      \
+        {                                 \
+            printf("FAIL: " __VA_ARGS__); \
+            printf("\n");                 \
+            failures++;                   \
+            return;                       \
+        }                                 \
+    } while (0)
+
+// spi_clock_steps in paw3395.c
+static const uint32_t steps[] = {4000000, 5000000, 8000000, 10000000};
+#define STEP_COUNT (sizeof(steps) / sizeof(steps[0]))
+
+static spi_fake_t bus;
+static spi_transport_t spi;
+static uint32_t limit_hz; // fastest clock the fake sensor keeps up with
+static unsigned probes;
+
+static void start(uint32_t limit)
+{
+    spi_transport_config_t cfg = {.clock_hz = START_HZ, .flags = SPI_TRANSPORT_HW_CS};
+
+    spi_fake_init(&bus, &cfg);
+    bus.regs[PAW3395_PRODUCT_ID_REG] = PAW3395_PRODUCT_ID;
+    bus.regs[PAW3395_INV_PRODUCT_ID_REG] = PAW3395_INV_PRODUCT_ID;
+    spi = spi_fake_transport(&bus);
+    limit_hz = limit;
+    probes = 0;
+}
+
+static uint8_t rd(uint8_t reg)
+{
+    uint8_t b = 0;
+
+    spi.read(spi.ctx, reg, &b, 1);
+    return b;
+}
+
+// the rounds of spi_clock_probe(): both IDs and a pattern readback each
+static bool probe(void *ctx, uint32_t clock_hz)
+{
+    (void)ctx;
+
+    probes++;
+    bus.cfg.clock_hz = clock_hz;
+    bus.fail_frames = clock_hz > limit_hz ? PROBE_FRAMES : 0;
+
+    for (int i = 0; i < CAL_ROUNDS; i++)
+    {
+        uint8_t pattern = (i & 1 ? 0x55 : 0xAA) ^ (uint8_t)i;
+
+        if (rd(PAW3395_PRODUCT_ID_REG) != PAW3395_PRODUCT_ID ||
+            rd(PAW3395_INV_PRODUCT_ID_REG) != PAW3395_INV_PRODUCT_ID)
+        {
+            return false;
+        }
+        if (spi.write(spi.ctx, RESOLUTION_X_LOW, pattern) != SPI_TRANSPORT_OK || rd(RESOLUTION_X_LOW) != pattern)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t pick(uint32_t cached_hz)
+{
+    return spi_transport_pick_clock(cached_hz, START_HZ, steps, STEP_COUNT, CAL_MARGIN, probe, NULL);
+}
+
+// no cache: step up until a probe fails, then back off one step
+static void check_calibrate(void)
+{
+    start(8000000);
+    uint32_t hz = pick(0);
+    CHECK(hz == 5000000, "good to 8 MHz picked %lu", (unsigned long)hz);
+    CHECK(probes == 4, "%u probes, expected 4, 5, 8 and a failing 10", probes);
+
+    start(10000000);
+    hz = pick(0);
+    CHECK(hz == 8000000 && probes == 4, "good to 10 MHz picked %lu after %u probes", (unsigned long)hz, probes);
+
+    // the margin never backs off past the slowest step
+    start(4000000);
+    hz = pick(0);
+    CHECK(hz == 4000000 && probes == 2, "good to 4 MHz picked %lu after %u probes", (unsigned long)hz, probes);
+}
+
+// the sensor fails even the slowest step: keep the clock the bus came up with
+static void check_fallback(void)
+{
+    start(1000000);
+    uint32_t hz = pick(0);
+    CHECK(hz == START_HZ, "dead sensor picked %lu", (unsigned long)hz);
+    CHECK(probes == 1, "%u probes after the first step failed", probes);
+
+    // a cached clock that no longer works ends up there too
+    start(1000000);
+    hz = pick(8000000);
+    CHECK(hz == START_HZ && probes == 2, "dead sensor with a cache picked %lu after %u probes", (unsigned long)hz,
+          probes);
+}
+
+// a cached clock that passes one probe is used as is, without calibrating
+static void check_cached(void)
+{
+    start(10000000);
+    uint32_t hz = pick(8000000);
+    CHECK(hz == 8000000, "cached 8 MHz replaced by %lu", (unsigned long)hz);
+    CHECK(probes == 1 && bus.frames == PROBE_FRAMES, "cache took %u probes, %u frames", probes, bus.frames);
+
+    // the cache is kept even where calibrating would now pick another clock
+    start(10000000);
+    hz = pick(5000000);
+    CHECK(hz == 5000000 && probes == 1, "cached 5 MHz gave %lu after %u probes", (unsigned long)hz, probes);
+
+    // a stale cache above what the sensor does is recalibrated
+    start(8000000);
+    hz = pick(10000000);
+    CHECK(hz == 5000000, "stale 10 MHz cache gave %lu", (unsigned long)hz);
+    CHECK(probes == 5, "%u probes, expected the cache and a full calibration", probes);
+}
+
+int main(void)
+{
+    check_calibrate();
+    check_fallback();
+    check_cached();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,221 @@
+/*
+ * Host timing check of spi_transport.c through spi_fake.c: what one motion
+ * read costs with hardware vs manual CS, as one burst vs per-byte reads, and
+ * how much of it a split read hides behind other work.
+ *
+ *   cc -I. tools/spi_timing.c spi_fake.c spi_transport.c -o spi_timing && ./spi_timing
+ *
+ * Times are the fake bus clock: wire time from spi_transport.h plus a per
+ * frame driver cost. With manual CS spi.c runs the address and the data phase
+ * as two transactions and waits 1 us on each CS edge, which the fake charges
+ * as frame overhead. Prints a table, then exits non-zero on the first broken
+ * expectation of each case.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "spi_fake.h"
+
+#define READ_DELAY_NS 2000 // PAW3395_READ_DELAY_NS, tSRAD
+#define CS_SETUP_NS 120    // PAW3395_CS_SETUP_NS
+#define CS_HOLD_NS 1000    // PAW3395_CS_HOLD_NS
+#define CS_CLOCKS_MAX 16   // SPI_CS_CLOCKS_MAX
+#define DRIVER_NS 1500     // polling transaction setup and teardown
+#define CS_GPIO_NS 2000    // manual CS: the two 1 us waits in cs_set()
+#define MOTION_BURST 0x16
+#define MOTION 0x02
+#define BURST_LEN 12
+#define REPORT_WORK_NS 10000 // report building overlapped with a split read
+
+static int failures;
+
+#define CHECK(cond, ...)                  \
+    do                                    \
+    {                                     \
+        if (!(cond))                      \
+        {                                 \
+            printf("FAIL: " __VA_ARGS__); \
+            printf("\n");                 \
+            failures++;                   \
+            return;                       \
+        }                                 \
+    } while (0)
+
+static const uint32_t clocks[] = {4000000, 10000000};
+#define CLOCK_COUNT (sizeof(clocks) / sizeof(clocks[0]))
+
+static spi_fake_t bus;
+static spi_transport_t spi;
+
+// CS setup/hold in SPI clocks, as add_device() in spi.c
+static uint8_t cs_clocks(uint32_t clock_hz, uint32_t ns)
+{
+    uint8_t n = spi_transport_dummy_bits(clock_hz, ns);
+
+    if (n == 0)
+    {
+        return 1;
+    }
+    return n > CS_CLOCKS_MAX ? CS_CLOCKS_MAX : n;
+}
+
+static void setup(uint32_t clock_hz, bool hw_cs)
+{
+    spi_transport_config_t cfg = {
+        .clock_hz = clock_hz,
+        .read_delay_ns = READ_DELAY_NS,
+        .cs_pretrans = cs_clocks(clock_hz, CS_SETUP_NS),
+        .cs_posttrans = cs_clocks(clock_hz, CS_HOLD_NS),
+        .flags = SPI_TRANSPORT_POLLING | (hw_cs ? SPI_TRANSPORT_HW_CS : 0),
+    };
+
+    spi_fake_init(&bus, &cfg);
+    bus.frame_overhead_ns = hw_cs ? DRIVER_NS : 2 * DRIVER_NS + CS_GPIO_NS;
+    spi = spi_fake_transport(&bus);
+}
+
+// one motion read, all bytes in a single frame
+static uint64_t burst_ns(uint32_t clock_hz, bool hw_cs)
+{
+    uint8_t buf[BURST_LEN];
+
+    setup(clock_hz, hw_cs);
+    spi.read(spi.ctx, MOTION_BURST, buf, BURST_LEN);
+    return bus.now_ns;
+}
+
+// the same bytes one register at a time, as the driver used to
+static uint64_t per_byte_ns(uint32_t clock_hz, bool hw_cs)
+{
+    uint8_t b;
+
+    setup(clock_hz, hw_cs);
+    for (int i = 0; i < BURST_LEN; i++)
+    {
+        spi.read(spi.ctx, (uint8_t)(MOTION + i), &b, 1);
+    }
+    return bus.now_ns;
+}
+
+// a burst split around work_ns of report building
+static uint64_t split_ns(uint32_t clock_hz, bool hw_cs, uint32_t work_ns)
+{
+    uint8_t buf[BURST_LEN];
+
+    setup(clock_hz, hw_cs);
+    spi.read_begin(spi.ctx, MOTION_BURST, BURST_LEN);
+    bus.now_ns += work_ns;
+    spi.read_end(spi.ctx, buf, BURST_LEN);
+    return bus.now_ns;
+}
+
+static void print_table(void)
+{
+    printf("%-7s %6s %9s %9s %9s %9s\n", "cs", "MHz", "burst us", "byte us", "+work us", "split us");
+    for (int hw = 1; hw >= 0; hw--)
+    {
+        for (size_t c = 0; c < CLOCK_COUNT; c++)
+        {
+            printf("%-7s %6lu %9.2f %9.2f %9.2f %9.2f\n", hw ? "hw" : "manual", (unsigned long)(clocks[c] / 1000000),
+                   burst_ns(clocks[c], hw) / 1000.0, per_byte_ns(clocks[c], hw) / 1000.0,
+                   (burst_ns(clocks[c], hw) + REPORT_WORK_NS) / 1000.0,
+                   split_ns(clocks[c], hw, REPORT_WORK_NS) / 1000.0);
+        }
+    }
+}
+
+// the fake advances by exactly the spi_transport.h wire time plus overhead
+static void check_wire_time(void)
+{
+    for (int hw = 0; hw <= 1; hw++)
+    {
+        for (size_t c = 0; c < CLOCK_COUNT; c++)
+        {
+            uint64_t ns = burst_ns(clocks[c], hw);
+            uint64_t want = spi_transport_read_ns(&bus.cfg, BURST_LEN) + bus.frame_overhead_ns;
+            CHECK(ns == want && bus.frames == 1, "%s CS %lu Hz burst: %llu ns in %u frames, expected %llu",
+                  hw ? "hw" : "manual", (unsigned long)clocks[c], (unsigned long long)ns, bus.frames,
+                  (unsigned long long)want);
+
+            ns = per_byte_ns(clocks[c], hw);
+            want = BURST_LEN * (uint64_t)(spi_transport_read_ns(&bus.cfg, 1) + bus.frame_overhead_ns);
+            CHECK(ns == want && bus.frames == BURST_LEN, "%s CS %lu Hz per byte: %llu ns in %u frames, expected %llu",
+                  hw ? "hw" : "manual", (unsigned long)clocks[c], (unsigned long long)ns, bus.frames,
+                  (unsigned long long)want);
+        }
+    }
+}
+
+// a burst waits tSRAD once, per-byte reads wait it for every byte
+static void check_burst(void)
+{
+    for (int hw = 0; hw <= 1; hw++)
+    {
+        for (size_t c = 0; c < CLOCK_COUNT; c++)
+        {
+            uint64_t burst = burst_ns(clocks[c], hw);
+            uint64_t bytes = per_byte_ns(clocks[c], hw);
+            // address and data byte at 8 clocks each, the rest is CS and tSRAD
+            uint32_t idle = spi_transport_read_ns(&bus.cfg, 1) - (uint32_t)(16000000000ull / clocks[c]);
+            CHECK(idle >= READ_DELAY_NS, "%s CS %lu Hz: read frame waits %lu ns for tSRAD", hw ? "hw" : "manual",
+                  (unsigned long)clocks[c], (unsigned long)idle);
+            CHECK(bytes - burst >= (BURST_LEN - 1) * (uint64_t)(READ_DELAY_NS + bus.frame_overhead_ns),
+                  "%s CS %lu Hz: burst %llu ns only %llu ns under per byte", hw ? "hw" : "manual",
+                  (unsigned long)clocks[c], (unsigned long long)burst, (unsigned long long)(bytes - burst));
+        }
+    }
+}
+
+// hardware CS spends its setup/hold on the wire, which is still cheaper than
+// a second transaction and the GPIO waits; a faster clock helps both
+static void check_hw_cs(void)
+{
+    for (size_t c = 0; c < CLOCK_COUNT; c++)
+    {
+        CHECK(burst_ns(clocks[c], true) < burst_ns(clocks[c], false), "%lu Hz: hw CS burst %llu ns, manual %llu ns",
+              (unsigned long)clocks[c], (unsigned long long)burst_ns(clocks[c], true),
+              (unsigned long long)burst_ns(clocks[c], false));
+        CHECK(per_byte_ns(clocks[c], true) < per_byte_ns(clocks[c], false),
+              "%lu Hz: hw CS per byte %llu ns, manual %llu ns", (unsigned long)clocks[c],
+              (unsigned long long)per_byte_ns(clocks[c], true), (unsigned long long)per_byte_ns(clocks[c], false));
+    }
+    for (int hw = 0; hw <= 1; hw++)
+    {
+        CHECK(burst_ns(clocks[1], hw) < burst_ns(clocks[0], hw), "%s CS burst no faster at %lu Hz",
+              hw ? "hw" : "manual", (unsigned long)clocks[1]);
+    }
+}
+
+// a split read costs the caller the overhead and whichever is longer of the
+// frame and the work done meanwhile
+static void check_split(void)
+{
+    static const uint32_t work[] = {0, 5000, REPORT_WORK_NS, 50000};
+
+    for (size_t c = 0; c < CLOCK_COUNT; c++)
+    {
+        for (size_t w = 0; w < sizeof(work) / sizeof(work[0]); w++)
+        {
+            uint64_t ns = split_ns(clocks[c], true, work[w]);
+            uint32_t wire = spi_transport_read_ns(&bus.cfg, BURST_LEN);
+            uint64_t want = bus.frame_overhead_ns + (wire > work[w] ? wire : work[w]);
+            CHECK(ns == want, "%lu Hz, %lu ns of work: split took %llu ns, expected %llu", (unsigned long)clocks[c],
+                  (unsigned long)work[w], (unsigned long long)ns, (unsigned long long)want);
+            CHECK(ns <= burst_ns(clocks[c], true) + work[w], "%lu Hz: split slower than read then work",
+                  (unsigned long)clocks[c]);
+        }
+    }
+}
+
+int main(void)
+{
+    print_table();
+
+    check_wire_time();
+    check_burst();
+    check_hw_cs();
+    check_split();
+
+    printf("%s\n", failures ? "FAILED" : "ok");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
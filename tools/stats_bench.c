@@ -0,0 +1,132 @@
+/*
+ * Host micro-benchmark of the stats.h counters on the hot path.
+ *
+ *   cc -O2 -I. tools/stats_bench.c stats.c -lpthread -o stats_bench && ./stats_bench
+ *
+ * Two threads stand in for the two cores. Each variant bumps one counter
+ * ITERATIONS times per thread:
+ *   plain      non-atomic increment of a private variable, the floor
+ *   stats_inc  relaxed atomic add on the thread's own stats_cores[] copy
+ *   shared     relaxed atomic add on one counter both threads write
+ *   adjacent   stats_inc with both copies squeezed into one cache line,
+ *              what STATS_LINE alignment avoids
+ * The host is not an Xtensa core; the ratios carry over, the ns do not.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+
+static __thread int bench_core;
+#define STATS_CORE_ID() bench_core
+
+#include "stats.h"
+
+#define ITERATIONS 50000000
+#define THREADS 2
+
+typedef enum
+{
+    VARIANT_PLAIN,
+    VARIANT_STATS,
+    VARIANT_SHARED,
+    VARIANT_ADJACENT,
+} variant_t;
+
+static uint32_t shared_counter;
+static uint32_t adjacent[THREADS] __attribute__((aligned(64)));
+static volatile uint32_t plain_sink[THREADS * 16];
+
+typedef struct
+{
+    int core;
+    variant_t variant;
+} job_t;
+
+static void *worker(void *arg)
+{
+    const job_t *job = arg;
+    bench_core = job->core;
+
+    switch (job->variant)
+    {
+    case VARIANT_PLAIN:
+    {
+        uint32_t v = 0;
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            v++;
+            __asm__ volatile("" : "+r"(v)); // keep the loop
+        }
+        plain_sink[job->core * 16] = v;
+        break;
+    }
+    case VARIANT_STATS:
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            stats_inc(STATS_REPORTS_SENT);
+        }
+        break;
+    case VARIANT_SHARED:
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            __atomic_fetch_add(&shared_counter, 1, __ATOMIC_RELAXED);
+        }
+        break;
+    case VARIANT_ADJACENT:
+        for (int i = 0; i < ITERATIONS; i++)
+        {
+            __atomic_fetch_add(&adjacent[job->core], 1, __ATOMIC_RELAXED);
+        }
+        break;
+    }
+    return NULL;
+}
+
+static double run(variant_t variant, int threads)
+{
+    pthread_t tid[THREADS];
+    job_t jobs[THREADS];
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < threads; i++)
+    {
+        jobs[i] = (job_t){.core = i, .variant = variant};
+        pthread_create(&tid[i], NULL, worker, &jobs[i]);
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        pthread_join(tid[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ITERATIONS;
+}
+
+int main(void)
+{
+    static const struct
+    {
+        const char *name;
+        variant_t variant;
+    } variants[] = {
+        {"plain", VARIANT_PLAIN},
+        {"stats_inc", VARIANT_STATS},
+        {"shared", VARIANT_SHARED},
+        {"adjacent", VARIANT_ADJACENT},
+    };
+    stats_snapshot_t s;
+
+    printf("%-10s %12s %12s\n", "variant", "ns (1 core)", "ns (2 cores)");
+    for (size_t i = 0; i < sizeof(variants) / sizeof(variants[0]); i++)
+    {
+        double one = run(variants[i].variant, 1);
+        double two = run(variants[i].variant, THREADS);
+        printf("%-10s %12.2f %12.2f\n", variants[i].name, one, two);
+    }
+
+    // the snapshot sums both copies: 3 runs of stats_inc, one of them on two threads
+    stats_snapshot(&s);
+    printf("snapshot sent=%lu (expect %lu)\n", (unsigned long)s.v[STATS_REPORTS_SENT],
+           (unsigned long)(3ul * ITERATIONS));
+    return 0;
+}
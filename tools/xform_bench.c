@@ -0,0 +1,186 @@
+/*
+ * Host benchmark of motion_xform.c: cost per sample and how far each setting
+ * moves the pointer from the exact transform.
+ *
+ *   cc -O2 -I. tools/xform_bench.c motion_xform.c -lm -o xform_bench && ./xform_bench
+ *
+ * Strokes come as integer sensor deltas every SAMPLE_US, the transform is
+ * reset after each one as move_loop_task does when motion stops. For each case:
+ *   ns/sample  host time per motion_xform_apply() call
+ *   error      RMS distance from the exact (floating point) rotation of the
+ *              same deltas, counts; snapping shows up here by design
+ *   lost       distance from the exact path at the end of all strokes, counts
+ *   snapped    samples that had their off axis locked to zero
+ *
+ * "handoff" switches between 0 and 15 degrees every stroke the way
+ * api_set_xform() does: the next transform is built aside and copied in by
+ * the move task between bursts, so the live one is never half configured.
+ */
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "motion_xform.h"
+
+#define SAMPLE_US 5000
+#define STROKE_SAMPLES 4000
+#define BENCH_SAMPLES 2000000
+#define HANDOFF 0x7FFF // rotation marker for the handoff case
+
+typedef struct
+{
+    const char *name;
+    int16_t rotation; // tenths of a degree
+    uint8_t snap_deg;
+    uint8_t axes; // applied in software
+} case_t;
+
+static const case_t cases[] = {
+    {"off", 0, 0, 0},
+    {"rot 1.5", 15, 0, 0},
+    {"rot 15", 150, 0, 0},
+    {"rot -45", -450, 0, 0},
+    {"rot 90", 900, 0, 0},
+    {"snap 5", 0, 5, 0},
+    {"rot15+snap", 150, 5, 0},
+    {"soft axes", 0, 0, MOTION_XFORM_INVERT_X | MOTION_XFORM_SWAP_XY},
+    {"handoff", HANDOFF, 0, 0},
+};
+
+static int16_t stroke_x[STROKE_SAMPLES], stroke_y[STROKE_SAMPLES];
+static bool stroke_start[STROKE_SAMPLES], stroke_end[STROKE_SAMPLES];
+
+// strokes of 0.2..8 counts/ms, every fourth one close to an axis
+static void gen_strokes(void)
+{
+    double fx = 0, fy = 0;
+    long px = 0, py = 0;
+    int len = 0, k = 0, n = 0;
+    double a = 0;
+
+    for (int i = 0; i < STROKE_SAMPLES; i++, k++)
+    {
+        if (k >= len)
+        {
+            k = 0;
+            len = 20 + (n * 37) % 80;
+            a = n % 4 == 0 ? (n % 8 == 0 ? 0.03 : M_PI / 2 - 0.05) : n * 2.3;
+            n++;
+        }
+        double peak = (0.2 + (n * 3) % 8) * SAMPLE_US / 1000.0;
+        double v = peak * sin(M_PI * k / len);
+        fx += v * cos(a);
+        fy += v * sin(a);
+        stroke_x[i] = (int16_t)(lround(fx) - px);
+        stroke_y[i] = (int16_t)(lround(fy) - py);
+        px += stroke_x[i];
+        py += stroke_y[i];
+        stroke_start[i] = k == 0;
+        stroke_end[i] = k == len - 1;
+    }
+}
+
+static void setup(motion_xform_t *t, const case_t *c, int16_t rotation)
+{
+    motion_xform_params_t p;
+    motion_xform_default_params(&p);
+    p.rotation = rotation;
+    p.axes = c->axes;
+    p.snap_deg = c->snap_deg;
+    motion_xform_configure(t, &p, c->axes != 0);
+}
+
+static double bench(const case_t *c)
+{
+    motion_xform_t t;
+    struct timespec t0, t1;
+    volatile int32_t sink = 0;
+
+    setup(&t, c, c->rotation == HANDOFF ? 150 : c->rotation);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < BENCH_SAMPLES; i++)
+    {
+        int16_t x = stroke_x[i % STROKE_SAMPLES], y = stroke_y[i % STROKE_SAMPLES];
+        motion_xform_apply(&t, &x, &y);
+        sink += x + y;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+    return ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / BENCH_SAMPLES;
+}
+
+static void quality(const case_t *c, double *err, double *lost, double *snapped)
+{
+    motion_xform_t live, next;
+    bool pending = false;
+    int16_t rotation = c->rotation == HANDOFF ? 0 : c->rotation;
+    double ex = 0, ey = 0, err2 = 0;
+    long hx = 0, hy = 0, locked = 0;
+
+    setup(&live, c, rotation);
+    for (int i = 0; i < STROKE_SAMPLES; i++)
+    {
+        if (stroke_start[i] && pending)
+        {
+            live = next;
+            pending = false;
+        }
+
+        double dx = stroke_x[i], dy = stroke_y[i];
+        if (c->axes & MOTION_XFORM_INVERT_X)
+        {
+            dx = -dx;
+        }
+        if (c->axes & MOTION_XFORM_SWAP_XY)
+        {
+            double tmp = dx;
+            dx = dy;
+            dy = tmp;
+        }
+        double rad = live.params.rotation * M_PI / 1800.0;
+        ex += dx * cos(rad) - dy * sin(rad);
+        ey += dx * sin(rad) + dy * cos(rad);
+
+        int16_t x = stroke_x[i], y = stroke_y[i];
+        motion_xform_apply(&live, &x, &y);
+        hx += x;
+        hy += y;
+        if (live.snap != MOTION_SNAP_NONE)
+        {
+            locked++;
+        }
+        err2 += (hx - ex) * (hx - ex) + (hy - ey) * (hy - ey);
+
+        if (stroke_end[i])
+        {
+            motion_xform_reset(&live);
+            if (c->rotation == HANDOFF)
+            {
+                rotation = rotation ? 0 : 150;
+                setup(&next, c, rotation);
+                pending = true;
+            }
+        }
+    }
+
+    *err = sqrt(err2 / STROKE_SAMPLES);
+    *lost = hypot(hx - ex, hy - ey);
+    *snapped = 100.0 * locked / STROKE_SAMPLES;
+}
+
+int main(void)
+{
+    gen_strokes();
+
+    printf("%-10s %10s %7s %6s %8s\n", "case", "ns/sample", "error", "lost", "snapped");
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        double err = 0, lost = 0, snapped = 0;
+        quality(&cases[i], &err, &lost, &snapped);
+        printf("%-10s %10.1f %7.2f %6.1f %7.1f%%\n", cases[i].name, bench(&cases[i]), err, lost, snapped);
+    }
+    return 0;
+}